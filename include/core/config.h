@@ -8,6 +8,16 @@
 
 namespace ft {
 
+// OCG等按会话限流的柜台，一个Gateway可以同时登录多个会话
+struct TradeSessionConfig {
+  std::string comp_id{""};
+  std::string password{""};
+  std::string new_password{""};  // 不为空时登录后修改密码
+  std::string rsa_pubkey_file{""};
+  uint32_t msg_limit_per_sec = 0;
+  uint32_t msg_burst = 1;  // 最多允许连续发出的消息数
+};
+
 class Config {
  public:
   std::string api{""};
@@ -20,14 +30,23 @@ class Config {
   std::string app_id{""};
   std::vector<std::string> subscription_list{};
 
+  // 多账户时用于按交易所路由订单，为空表示作为默认账户
+  std::vector<std::string> exchanges{};
+
   bool cancel_outstanding_orders_on_startup = true;
 
+  // 登录及查询等请求等待柜台回报的超时时间
+  uint64_t request_timeout_ms = 10000;
+
   uint64_t throttle_rate_limit_period_ms = 0;
   uint64_t throttle_rate_order_limit = 0;
   uint64_t throttle_rate_volume_limit = 0;
 
   int key_of_cmd_queue = 0;  // <= 0 means not to use order queue
 
+  // 行情源超过这个时间没有行情则认为中断，0表示不检测
+  uint64_t md_stall_timeout_ms = 3000;
+
   std::string arg0{""};
   std::string arg1{""};
   std::string arg2{""};
@@ -38,6 +57,17 @@ class Config {
   std::string arg7{""};
   std::string arg8{""};
 
+  // 同一个TradingEngine中管理的多个账户，每个账户有独立的Gateway、持仓及
+  // 风控，未填写的字段继承顶层配置。为空表示只使用顶层配置中的单个账户
+  std::vector<Config> accounts{};
+
+  // 同一个Gateway同时登录的多个会话，目前只有ocg-bss使用
+  std::vector<TradeSessionConfig> sessions{};
+
+  // 额外的行情源，只登录行情服务器，与各个账户的行情一起仲裁后发布。未填写
+  // 的字段继承顶层配置
+  std::vector<Config> md_sources{};
+
  public:
   void show() const {
     printf("Config:\n");
@@ -51,8 +81,14 @@ class Config {
     printf("  subscription_list: ");
     for (const auto& ticker : subscription_list) printf("%s ", ticker.c_str());
     printf("\n");
+    if (!exchanges.empty()) {
+      printf("  exchanges: ");
+      for (const auto& exchange : exchanges) printf("%s ", exchange.c_str());
+      printf("\n");
+    }
     printf("  cancel_outstanding_orders_on_startup: %s\n",
            cancel_outstanding_orders_on_startup ? "true" : "false");
+    printf("  request_timeout_ms: %lu\n", request_timeout_ms);
     if (!arg0.empty()) printf("  arg0: %s\n", arg0.c_str());
     if (!arg1.empty()) printf("  arg1: %s\n", arg1.c_str());
     if (!arg2.empty()) printf("  arg2: %s\n", arg2.c_str());
@@ -62,6 +98,21 @@ class Config {
     if (!arg6.empty()) printf("  arg6: %s\n", arg6.c_str());
     if (!arg7.empty()) printf("  arg7: %s\n", arg7.c_str());
     if (!arg8.empty()) printf("  arg8: %s\n", arg8.c_str());
+    for (const auto& session : sessions) {
+      printf("  session %s: msg_limit_per_sec:%u msg_burst:%u\n",
+             session.comp_id.c_str(), session.msg_limit_per_sec,
+             session.msg_burst);
+    }
+    for (const auto& account : accounts) {
+      printf("Account %s@%s:\n", account.investor_id.c_str(),
+             account.api.c_str());
+      account.show();
+    }
+    for (const auto& source : md_sources) {
+      printf("MdSource %s@%s:\n", source.quote_server_address.c_str(),
+             source.api.c_str());
+      source.show();
+    }
   }
 };
 
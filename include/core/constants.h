@@ -6,6 +6,7 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <string_view>
 
 namespace ft {
 
@@ -34,6 +35,33 @@ inline const std::string SSE = "SH";
 // 深圳证券交易所-A股
 inline const std::string SZE = "SZ";
 
+/*
+ * 交易所的数值标识，在加载合约表时由上面的字符串简称解析得到，
+ * 报单等热路径上使用数值比较，避免字符串比较
+ */
+enum class Exchange : uint8_t {
+  UNKNOWN = 0,
+  SHFE,
+  INE,
+  CFFEX,
+  CZCE,
+  DCE,
+  SSE,
+  SZE,
+};
+
+inline Exchange to_exchange(std::string_view exchange) {
+  if (exchange == SHFE) return Exchange::SHFE;
+  if (exchange == INE) return Exchange::INE;
+  if (exchange == CFFEX) return Exchange::CFFEX;
+  if (exchange == CZCE) return Exchange::CZCE;
+  if (exchange == DCE) return Exchange::DCE;
+  if (exchange == SSE) return Exchange::SSE;
+  if (exchange == SZE) return Exchange::SZE;
+
+  return Exchange::UNKNOWN;
+}
+
 /*
  * 订单价格类型
  * 订单价格类型还需要继续细分
@@ -3,7 +3,11 @@
 #ifndef FT_INCLUDE_CORE_CONTRACT_H_
 #define FT_INCLUDE_CORE_CONTRACT_H_
 
+#include <cstdint>
 #include <string>
+#include <string_view>
+
+#include "core/constants.h"
 
 namespace ft {
 
@@ -20,28 +24,50 @@ enum SpecTickerIndex : uint32_t {
   ALL_TICKERS = UINT32_MAX,
 };
 
-struct Contract {
-  std::string ticker;
-  std::string exchange;
-  std::string name;
-  ProductType product_type;
-  int size;
+/*
+ * 合约的交易参数，风控、报单等热路径只需要访问这部分数据
+ * 每个合约的参数正好占一个cache line，而Contract中的字符串等描述信息
+ * 只在初始化、日志等冷路径中使用
+ */
+struct alignas(64) ContractParams {
   double price_tick;
-
   double long_margin_rate;
   double short_margin_rate;
 
+  int size;
   int max_market_order_volume;
   int min_market_order_volume;
   int max_limit_order_volume;
   int min_limit_order_volume;
 
+  uint32_t index;  // local index
+  ProductType product_type;
+  Exchange exchange_id;  // 由exchange解析得到，加载合约表时填充
+};
+
+static_assert(sizeof(ContractParams) == 64);
+
+/*
+ * ticker、exchange及name引用外部的存储，都以'\0'结尾。ContractTable中的
+ * 合约引用二进制合约表的映射或驻留在表中的字符串，在进程生命周期内有效；
+ * 在表外构造的Contract(如柜台查询合约的回调)由构造方保证字符串的生命周期
+ *
+ * 数值字段都在params中，只有这一份，ContractTable::get_params直接返回
+ * 合约表中的params。冷数据在前，params正好占第二个cache line
+ */
+struct Contract {
+  std::string_view ticker;
+  std::string_view exchange;
+  std::string_view name;
+
   int delivery_year;
   int delivery_month;
 
-  uint32_t index;  // local index
+  ContractParams params;
 };
 
+static_assert(sizeof(Contract) == 128);
+
 inline std::string to_string(ProductType product) {
   if (product == ProductType::FUTURES) return "Futures";
   if (product == ProductType::OPTIONS) return "Options";
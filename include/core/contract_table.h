@@ -3,23 +3,35 @@
 #ifndef FT_INCLUDE_CORE_CONTRACT_TABLE_H_
 #define FT_INCLUDE_CORE_CONTRACT_TABLE_H_
 
+#include <fcntl.h>
 #include <fmt/format.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
+#include <algorithm>
+#include <cstring>
 #include <fstream>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include "core/constants.h"
 #include "core/contract.h"
+#include "core/price.h"
+#include "utils/perfect_hash.h"
+#include "utils/string_pool.h"
 #include "utils/string_utils.h"
 
 namespace ft {
 
+// 合约中的字符串驻留在strings中，strings需要比contracts活得更久
 inline bool load_contracts(const std::string& file,
-                           std::vector<Contract>* contracts) {
+                           std::vector<Contract>* contracts,
+                           StringPool* strings) {
   std::ifstream ifs(file);
   std::string line;
   std::vector<std::string> fields;
@@ -36,21 +48,21 @@ inline bool load_contracts(const std::string& file,
     if (fields.size() != 14) return false;
 
     std::size_t index = 0;
-    contract.ticker = std::move(fields[index++]);
-    contract.exchange = std::move(fields[index++]);
-    contract.name = std::move(fields[index++]);
-    contract.product_type = string2product(fields[index++]);
-    contract.size = std::stoi(fields[index++]);
-    contract.price_tick = std::stod(fields[index++]);
-    contract.long_margin_rate = std::stod(fields[index++]);
-    contract.short_margin_rate = std::stod(fields[index++]);
-    contract.max_market_order_volume = std::stoi(fields[index++]);
-    contract.min_market_order_volume = std::stoi(fields[index++]);
-    contract.max_limit_order_volume = std::stoi(fields[index++]);
-    contract.min_limit_order_volume = std::stoi(fields[index++]);
+    contract.ticker = strings->intern(fields[index++]);
+    contract.exchange = strings->intern(fields[index++]);
+    contract.name = strings->intern(fields[index++]);
+    contract.params.product_type = string2product(fields[index++]);
+    contract.params.size = std::stoi(fields[index++]);
+    contract.params.price_tick = std::stod(fields[index++]);
+    contract.params.long_margin_rate = std::stod(fields[index++]);
+    contract.params.short_margin_rate = std::stod(fields[index++]);
+    contract.params.max_market_order_volume = std::stoi(fields[index++]);
+    contract.params.min_market_order_volume = std::stoi(fields[index++]);
+    contract.params.max_limit_order_volume = std::stoi(fields[index++]);
+    contract.params.min_limit_order_volume = std::stoi(fields[index++]);
     contract.delivery_year = std::stoi(fields[index++]);
     contract.delivery_month = std::stoi(fields[index++]);
-    contracts->emplace_back(std::move(contract));
+    contracts->emplace_back(contract);
   }
 
   return true;
@@ -86,14 +98,14 @@ inline void store_contracts(const std::string& file,
     //    << contract.max_limit_order_volume << ','
     //    << contract.min_limit_order_volume << ',' << contract.delivery_year
     //    << ',' << contract.delivery_month << '\n';
+    auto& p = contract.params;
     line = fmt::format(
         "{},{},{},{},{},{},{},{},{},{},{},{},{},{}\n", contract.ticker,
-        contract.exchange, contract.name, to_string(contract.product_type),
-        contract.size, contract.price_tick, contract.long_margin_rate,
-        contract.short_margin_rate, contract.max_market_order_volume,
-        contract.min_market_order_volume, contract.max_limit_order_volume,
-        contract.min_limit_order_volume, contract.delivery_year,
-        contract.delivery_month);
+        contract.exchange, contract.name, to_string(p.product_type), p.size,
+        p.price_tick, p.long_margin_rate, p.short_margin_rate,
+        p.max_market_order_volume, p.min_market_order_volume,
+        p.max_limit_order_volume, p.min_limit_order_volume,
+        contract.delivery_year, contract.delivery_month);
 
     // ss >> line;
     ofs << line;
@@ -103,18 +115,278 @@ inline void store_contracts(const std::string& file,
   ofs.close();
 }
 
+/*
+ * 二进制合约表，由contract-collector生成，CSV仍然作为交换格式
+ * 布局：ContractFileHeader | ContractRecord * num_contracts |
+ *       uint32_t displacements[num_buckets] | uint32_t slots[num_slots]
+ * 所有字段定长，加载时直接mmap，不需要逐行解析；ticker索引为预先构建好的
+ * 完美哈希，加载时无需重新计算
+ */
+inline constexpr char kContractFileMagic[8] = {'F', 'T', 'C', 'O',
+                                               'N', 'T', 'R', '\0'};
+inline constexpr uint32_t kContractFileVersion = 1;
+
+struct ContractFileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t record_size;
+  uint32_t num_contracts;
+  uint32_t num_buckets;
+  uint32_t num_slots;
+  uint32_t reserved;
+};
+
+struct ContractRecord {
+  char ticker[32];
+  char exchange[8];
+  char name[64];
+  double price_tick;
+  double long_margin_rate;
+  double short_margin_rate;
+  int32_t product_type;
+  int32_t size;
+  int32_t max_market_order_volume;
+  int32_t min_market_order_volume;
+  int32_t max_limit_order_volume;
+  int32_t min_limit_order_volume;
+  int32_t delivery_year;
+  int32_t delivery_month;
+};
+
+static_assert(sizeof(ContractFileHeader) == 32);
+static_assert(sizeof(ContractRecord) == 160);
+
+inline bool store_contracts_binary(const std::string& file,
+                                   const std::vector<Contract>& contracts) {
+  std::vector<std::string_view> tickers;
+  for (const auto& contract : contracts) tickers.emplace_back(contract.ticker);
+
+  PerfectHashIndex index;
+  if (!index.build(tickers)) return false;
+
+  std::vector<ContractRecord> records(contracts.size());
+  for (std::size_t i = 0; i < contracts.size(); ++i) {
+    auto& contract = contracts[i];
+    auto& record = records[i];
+    memset(&record, 0, sizeof(record));
+
+    if (contract.ticker.size() >= sizeof(record.ticker) ||
+        contract.exchange.size() >= sizeof(record.exchange))
+      return false;
+
+    memcpy(record.ticker, contract.ticker.data(), contract.ticker.size());
+    memcpy(record.exchange, contract.exchange.data(), contract.exchange.size());
+    // 名称只用于展示，超长时截断
+    memcpy(record.name, contract.name.data(),
+           std::min(contract.name.size(), sizeof(record.name) - 1));
+    record.price_tick = contract.params.price_tick;
+    record.long_margin_rate = contract.params.long_margin_rate;
+    record.short_margin_rate = contract.params.short_margin_rate;
+    record.product_type =
+        static_cast<int32_t>(contract.params.product_type);
+    record.size = contract.params.size;
+    record.max_market_order_volume = contract.params.max_market_order_volume;
+    record.min_market_order_volume = contract.params.min_market_order_volume;
+    record.max_limit_order_volume = contract.params.max_limit_order_volume;
+    record.min_limit_order_volume = contract.params.min_limit_order_volume;
+    record.delivery_year = contract.delivery_year;
+    record.delivery_month = contract.delivery_month;
+  }
+
+  ContractFileHeader header{};
+  memcpy(header.magic, kContractFileMagic, sizeof(header.magic));
+  header.version = kContractFileVersion;
+  header.record_size = sizeof(ContractRecord);
+  header.num_contracts = contracts.size();
+  header.num_buckets = index.displacements().size();
+  header.num_slots = index.slots().size();
+
+  std::ofstream ofs(file, std::ios_base::binary | std::ios_base::trunc);
+  if (!ofs) return false;
+  ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  ofs.write(reinterpret_cast<const char*>(records.data()),
+            records.size() * sizeof(ContractRecord));
+  ofs.write(reinterpret_cast<const char*>(index.displacements().data()),
+            index.displacements().size() * sizeof(uint32_t));
+  ofs.write(reinterpret_cast<const char*>(index.slots().data()),
+            index.slots().size() * sizeof(uint32_t));
+  return static_cast<bool>(ofs);
+}
+
+/*
+ * 合约表文件的只读映射
+ * 格式检测直接读取映射的文件头，二进制格式的记录及完美哈希索引都在映射上
+ * 原地访问，因此映射需要在使用期间一直保持
+ */
+class ContractFile {
+ public:
+  ContractFile() = default;
+  ContractFile(const ContractFile&) = delete;
+  ContractFile& operator=(const ContractFile&) = delete;
+  ~ContractFile() { close(); }
+
+  bool open(const std::string& file) {
+    close();
+
+    int fd = ::open(file.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+      ::close(fd);
+      return false;
+    }
+
+    // 空文件不能mmap，当作非二进制格式处理
+    size_ = st.st_size;
+    if (size_ > 0) {
+      void* addr = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (addr == MAP_FAILED) {
+        ::close(fd);
+        size_ = 0;
+        return false;
+      }
+      base_ = reinterpret_cast<const char*>(addr);
+    }
+
+    ::close(fd);
+    return true;
+  }
+
+  void close() {
+    if (base_) munmap(const_cast<char*>(base_), size_);
+    base_ = nullptr;
+    size_ = 0;
+  }
+
+  bool is_binary() const {
+    return size_ >= sizeof(ContractFileHeader) &&
+           memcmp(base_, kContractFileMagic, sizeof(kContractFileMagic)) == 0;
+  }
+
+  // 文件可能被截断或损坏，所有长度、偏移及槽位值都要对照文件大小校验，
+  // 校验通过后才能原地访问
+  bool validate() const {
+    if (!is_binary()) return false;
+
+    auto& h = header();
+    if (h.version != kContractFileVersion ||
+        h.record_size != sizeof(ContractRecord) || h.num_buckets == 0 ||
+        h.num_slots == 0 || (h.num_slots & (h.num_slots - 1)) != 0)
+      return false;
+
+    uint64_t expected =
+        sizeof(ContractFileHeader) +
+        static_cast<uint64_t>(h.num_contracts) * sizeof(ContractRecord) +
+        (static_cast<uint64_t>(h.num_buckets) + h.num_slots) * sizeof(uint32_t);
+    if (size_ < expected) return false;
+
+    auto slot = slots();
+    for (uint32_t i = 0; i < h.num_slots; ++i) {
+      if (slot[i] > h.num_contracts) return false;
+    }
+
+    auto record = records();
+    for (uint32_t i = 0; i < h.num_contracts; ++i) {
+      auto& r = record[i];
+      if (!memchr(r.ticker, '\0', sizeof(r.ticker)) ||
+          !memchr(r.exchange, '\0', sizeof(r.exchange)) ||
+          !memchr(r.name, '\0', sizeof(r.name)) || r.product_type < 0 ||
+          r.product_type > static_cast<int32_t>(ProductType::UNKNOWN))
+        return false;
+    }
+
+    return true;
+  }
+
+  const ContractFileHeader& header() const {
+    return *reinterpret_cast<const ContractFileHeader*>(base_);
+  }
+
+  const ContractRecord* records() const {
+    return reinterpret_cast<const ContractRecord*>(base_ +
+                                                   sizeof(ContractFileHeader));
+  }
+
+  const uint32_t* displacements() const {
+    return reinterpret_cast<const uint32_t*>(records() +
+                                             header().num_contracts);
+  }
+
+  const uint32_t* slots() const {
+    return displacements() + header().num_buckets;
+  }
+
+ private:
+  const char* base_ = nullptr;
+  std::size_t size_ = 0;
+};
+
+// 文件必须已经通过validate。合约的字符串及index都直接引用映射，不做拷贝，
+// 映射需要比contracts活得更久
+inline void load_contracts_binary(const ContractFile& file,
+                                  std::vector<Contract>* contracts,
+                                  PerfectHashIndex* index) {
+  auto& header = file.header();
+  auto records = file.records();
+  contracts->reserve(contracts->size() + header.num_contracts);
+  Contract contract;
+  for (uint32_t i = 0; i < header.num_contracts; ++i) {
+    auto& record = records[i];
+    contract.ticker = std::string_view(record.ticker);
+    contract.exchange = std::string_view(record.exchange);
+    contract.name = std::string_view(record.name);
+    contract.params.product_type =
+        static_cast<ProductType>(record.product_type);
+    contract.params.size = record.size;
+    contract.params.price_tick = record.price_tick;
+    contract.params.long_margin_rate = record.long_margin_rate;
+    contract.params.short_margin_rate = record.short_margin_rate;
+    contract.params.max_market_order_volume = record.max_market_order_volume;
+    contract.params.min_market_order_volume = record.min_market_order_volume;
+    contract.params.max_limit_order_volume = record.max_limit_order_volume;
+    contract.params.min_limit_order_volume = record.min_limit_order_volume;
+    contract.delivery_year = record.delivery_year;
+    contract.delivery_month = record.delivery_month;
+    contracts->emplace_back(contract);
+  }
+
+  if (index)
+    index->attach(file.displacements(), header.num_buckets, file.slots(),
+                  header.num_slots);
+}
+
 class ContractTable {
  public:
+  // 文件头为二进制合约表的magic时按二进制格式加载，否则按CSV解析
+  // 二进制格式的映射在进程生命周期内一直保持，ticker索引直接在映射上查找
   static bool init(const std::string& file) {
     static bool is_inited = false;
 
     if (!is_inited) {
-      if (!load_contracts(file, &contracts)) return false;
+      if (!contract_file.open(file)) return false;
 
+      if (contract_file.is_binary()) {
+        if (!contract_file.validate()) return false;
+        load_contracts_binary(contract_file, &contracts, &ticker_index);
+      } else {
+        // CSV格式不需要保留映射
+        contract_file.close();
+        if (!load_contracts(file, &contracts, &strings)) return false;
+
+        std::vector<std::string_view> tickers;
+        for (const auto& contract : contracts)
+          tickers.emplace_back(contract.ticker);
+        if (!ticker_index.build(tickers)) return false;
+      }
+
+      // ticker_index从1开始，0表示不对应任何合约
       for (std::size_t i = 0; i < contracts.size(); ++i) {
-        auto& contract = contracts[i];
-        contract.index = i + 1;
-        ticker2contract.emplace(contract.ticker, &contract);
+        auto& p = contracts[i].params;
+        p.index = i + 1;
+        p.exchange_id = to_exchange(contracts[i].exchange);
+        // 整数价格以price_tick为单位，不能为0
+        if (p.price_tick <= 0) p.price_tick = kDefaultPriceTick;
       }
 
       is_inited = true;
@@ -123,10 +395,17 @@ class ContractTable {
     return true;
   }
 
-  static const Contract* get_by_ticker(const std::string& ticker) {
-    auto iter = ticker2contract.find(ticker);
-    if (iter == ticker2contract.end()) return nullptr;
-    return iter->second;
+  // 查找过程不会构造std::string，可以直接传入柜台回调中的char*
+  static const Contract* get_by_ticker(std::string_view ticker) {
+    auto contract = get_by_index(ticker_index.lookup(ticker));
+    if (!contract || contract->ticker != ticker) return nullptr;
+    return contract;
+  }
+
+  // 柜台结构体中的定长字段不一定以'\0'结尾，按数组长度截断
+  template <std::size_t N>
+  static const Contract* get_by_ticker(const char (&ticker)[N]) {
+    return get_by_ticker(std::string_view(ticker, strnlen(ticker, N)));
   }
 
   static const Contract* get_by_index(uint32_t ticker_index) {
@@ -134,11 +413,30 @@ class ContractTable {
     return &contracts[ticker_index - 1];
   }
 
+  // 热路径只访问params所在的cache line
+  static const ContractParams* get_params(uint32_t ticker_index) {
+    if (ticker_index == 0 || ticker_index > contracts.size()) return nullptr;
+    return &contracts[ticker_index - 1].params;
+  }
+
+  // 更新运行时查询到的保证金率
+  static bool update_margin_rate(uint32_t ticker_index, double long_rate,
+                                 double short_rate) {
+    if (ticker_index == 0 || ticker_index > contracts.size()) return false;
+
+    auto& p = contracts[ticker_index - 1].params;
+    p.long_margin_rate = long_rate;
+    p.short_margin_rate = short_rate;
+    return true;
+  }
+
   static std::size_t size() { return contracts.size(); }
 
  private:
   inline static std::vector<Contract> contracts;
-  inline static std::unordered_map<std::string, Contract*> ticker2contract;
+  inline static ContractFile contract_file;  // 二进制格式时合约及索引引用此映射
+  inline static StringPool strings;          // CSV格式时合约的字符串
+  inline static PerfectHashIndex ticker_index;
 };
 
 }  // namespace ft
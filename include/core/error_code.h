@@ -21,10 +21,13 @@ enum ErrorCode : int {
   ERR_POSITION_NOT_ENOUGH,
   ERR_FUND_NOT_ENOUGH,
   ERR_THROTTLE_RATE_LIMIT,
+  ERR_ETF_NOT_ALLOWED,
+  ERR_CASH_SUBSTITUTION_EXCEEDED,
 
   ERR_SEND_FAILED,
 
   ERR_REJECTED,
+  ERR_AMEND_REJECTED,
   ERR_COUNT
 };
 
@@ -35,8 +38,11 @@ inline const char* error_code_str(int error_code) {
       "ERR_POSITION_NOT_ENOUGH",
       "ERR_FUND_NOT_ENOUGH",
       "ERR_THROTTLE_RATE_LIMIT",
+      "ERR_ETF_NOT_ALLOWED",
+      "ERR_CASH_SUBSTITUTION_EXCEEDED",
       "ERR_SEND_FAILED",
       "ERR_REJECTED",
+      "ERR_AMEND_REJECTED",
   };
 
   if (error_code < 0 || error_code >= ERR_COUNT) return "UNKNOWN_ERROR_CODE";
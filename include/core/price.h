@@ -0,0 +1,34 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef FT_INCLUDE_CORE_PRICE_H_
+#define FT_INCLUDE_CORE_PRICE_H_
+
+#include <cmath>
+#include <cstdint>
+
+namespace ft {
+
+/*
+ * 以合约的price_tick为单位的整数价格
+ *
+ * 合法的价格总是price_tick的整数倍，TradingEngine内部的订单、行情快照及
+ * 模拟撮合都使用整数价格，比较时不再需要误差，也可以直接作为价格档位的
+ * 下标。只在Gateway与柜台之间、TradingEngine与策略之间转换为浮点价格
+ */
+using TickPrice = int64_t;
+
+// 合约表中没有填写price_tick时(如部分基金)使用，为A股最小的价格变动单位
+inline constexpr double kDefaultPriceTick = 0.001;
+
+// 不是price_tick整数倍的价格按四舍五入取最近的价位
+inline TickPrice to_tick_price(double price, double price_tick) {
+  return std::llround(price / price_tick);
+}
+
+inline double to_real_price(TickPrice price, double price_tick) {
+  return price * price_tick;
+}
+
+}  // namespace ft
+
+#endif  // FT_INCLUDE_CORE_PRICE_H_
@@ -9,11 +9,10 @@
 #include <string>
 
 #include "core/contract.h"
+#include "core/price.h"
 
 namespace ft {
 
-using StrategyIdType = char[16];
-
 /*
  * 这部分是TradingEngine和Gateway之间的交互协议
  */
@@ -21,27 +20,36 @@ using StrategyIdType = char[16];
 // 这个是TradingEngine发给Gateway的下单信息
 struct OrderReq {
   uint64_t engine_order_id;
+  // 风控、报单等热路径只通过params访问合约的交易参数，
+  // contract只在日志等冷路径中使用
+  const ContractParams* params;
   const Contract* contract;
   uint32_t type;
   uint32_t direction;
   uint32_t offset;
   int volume;
-  double price;
+  TickPrice price;  // 以params->price_tick为单位，由Gateway转换
   uint32_t flags;
+
+  double real_price() const {
+    return to_real_price(price, params->price_tick);
+  }
 } __attribute__((packed));
 
 /*
  * 这部分是Strategy和TradingEngine之间的交互协议
- * Strategy通过IPC向TradingEngine发送交易相关指令
+ * Strategy通过IPC向TradingEngine发送交易相关指令，IPC上传输的是
+ * wire_protocol.h中定义的二进制消息，TradingEngine解码后得到TraderCommand
  */
 
-inline const uint32_t TRADER_CMD_MAGIC = 0x1709394;
-
 enum TraderCmdType {
   CMD_NEW_ORDER = 1,
   CMD_CANCEL_ORDER,
   CMD_CANCEL_TICKER,
   CMD_CANCEL_ALL,
+  CMD_SUBSCRIBE,
+  CMD_UNSUBSCRIBE,
+  CMD_AMEND_ORDER,
 };
 
 struct TraderOrderReq {
@@ -65,23 +73,40 @@ struct TraderCancelTickerReq {
   uint32_t ticker_index;
 } __attribute__((packed));
 
+// 订阅及退订行情，TradingEngine按strategy_id对每个合约计数
+struct TraderSubscribeReq {
+  uint32_t ticker_index;
+} __attribute__((packed));
+
+// volume为改单后的委托总量，包括已经成交的部分
+struct TraderAmendReq {
+  uint64_t order_id;
+  int volume;
+  double price;
+} __attribute__((packed));
+
 struct TraderCommand {
-  uint32_t magic;
   uint32_t type;
-  StrategyIdType strategy_id;
+  uint32_t strategy_id;  // 0表示不需要回报
+  // TradingEngine管理多个账户时指定由哪个账户执行，为0时新订单按合约所在的
+  // 交易所路由。order_id只在账户内唯一，多账户时撤单及改单必须指定账户
+  uint64_t account_id;
   union {
     TraderOrderReq order_req;
     TraderCancelReq cancel_req;
     TraderCancelTickerReq cancel_ticker_req;
+    TraderSubscribeReq subscribe_req;
+    TraderAmendReq amend_req;
   };
 } __attribute__((packed));
 
 /*
- *
+ * TradingEngine推送给策略的订单回报，由wire_protocol.h中的
+ * WireOrderResponse解码得到
  */
 struct OrderResponse {
   uint32_t user_order_id;
-  uint32_t order_id;
+  uint64_t order_id;
   uint32_t ticker_index;
   uint32_t direction;
   uint32_t offset;
@@ -94,6 +119,23 @@ struct OrderResponse {
   double this_traded_price;
 } __attribute__((packed));
 
+/*
+ * 改单成功的回报，由WireOrderAmended解码得到。volume及price为改单后的
+ * 委托总量(包括已成交部分)及价格
+ */
+struct OrderAmendedResponse {
+  uint32_t user_order_id;
+  uint64_t order_id;
+  uint32_t ticker_index;
+  uint32_t direction;
+  uint32_t offset;
+  int volume;
+  int traded_volume;
+  double price;
+
+  bool completed;
+} __attribute__((packed));
+
 }  // namespace ft
 
 #endif  // FT_INCLUDE_CORE_PROTOCOL_H_
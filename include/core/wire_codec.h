@@ -0,0 +1,157 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef FT_INCLUDE_CORE_WIRE_CODEC_H_
+#define FT_INCLUDE_CORE_WIRE_CODEC_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "core/protocol.h"
+#include "core/wire_protocol.h"
+
+namespace ft {
+
+/*
+ * 把多条记录追加到同一个消息中，finish时填写消息头
+ *
+ * 消息的最大长度为kWireMaxMessageSize，append返回false时调用方应当先把
+ * 已有的记录发送出去，reset之后再追加
+ */
+class WireWriter {
+ public:
+  explicit WireWriter(uint8_t msg_type) : msg_type_(msg_type) { reset(); }
+
+  template <class Record>
+  bool append(const Record& record) {
+    WireRecordHeader record_header{Record::kType, sizeof(Record)};
+    if (length_ + sizeof(record_header) + sizeof(record) > sizeof(buf_))
+      return false;
+
+    memcpy(buf_ + length_, &record_header, sizeof(record_header));
+    length_ += sizeof(record_header);
+    memcpy(buf_ + length_, &record, sizeof(record));
+    length_ += sizeof(record);
+    ++count_;
+    return true;
+  }
+
+  // 返回的数据在下一次append或reset之前有效，长度为size()
+  const char* finish(uint32_t strategy_id, uint64_t seq) {
+    WireHeader header{};
+    header.magic = kWireMagic;
+    header.version = kWireVersion;
+    header.msg_type = msg_type_;
+    header.length = length_;
+    header.count = count_;
+    header.strategy_id = strategy_id;
+    header.seq = seq;
+    memcpy(buf_, &header, sizeof(header));
+    return buf_;
+  }
+
+  void reset() {
+    length_ = sizeof(WireHeader);
+    count_ = 0;
+  }
+
+  bool empty() const { return count_ == 0; }
+
+  std::size_t size() const { return length_; }
+
+ private:
+  char buf_[kWireMaxMessageSize];
+  uint8_t msg_type_;
+  uint16_t length_;
+  uint16_t count_;
+};
+
+/*
+ * 校验消息头并逐条遍历记录，不认识的记录类型由调用方跳过
+ */
+class WireReader {
+ public:
+  // 魔数、版本或长度不对时返回false
+  bool parse(const char* data, std::size_t size) {
+    if (size < sizeof(WireHeader)) return false;
+    memcpy(&header_, data, sizeof(header_));
+    if (header_.magic != kWireMagic || header_.version != kWireVersion ||
+        header_.length < sizeof(WireHeader) || header_.length > size)
+      return false;
+
+    data_ = data;
+    offset_ = sizeof(WireHeader);
+    remaining_ = header_.count;
+    return true;
+  }
+
+  const WireHeader& header() const { return header_; }
+
+  // 没有更多记录或者记录被截断时返回false
+  bool next(uint8_t* type, const char** body, std::size_t* length) {
+    if (remaining_ == 0 ||
+        offset_ + sizeof(WireRecordHeader) > header_.length)
+      return false;
+
+    WireRecordHeader record_header;
+    memcpy(&record_header, data_ + offset_, sizeof(record_header));
+    offset_ += sizeof(record_header);
+    if (offset_ + record_header.length > header_.length) return false;
+
+    *type = record_header.type;
+    *body = data_ + offset_;
+    *length = record_header.length;
+    offset_ += record_header.length;
+    --remaining_;
+    return true;
+  }
+
+  // 较新版本的发送方可能在记录末尾追加字段，只读取已知的部分
+  template <class Record>
+  static bool get(const char* body, std::size_t length, Record* record) {
+    if (length < sizeof(Record)) return false;
+    memcpy(record, body, sizeof(Record));
+    return true;
+  }
+
+ private:
+  WireHeader header_{};
+  const char* data_ = nullptr;
+  std::size_t offset_ = 0;
+  uint16_t remaining_ = 0;
+};
+
+inline OrderResponse to_order_response(const WireOrderResponse& wire) {
+  OrderResponse rsp{};
+  rsp.user_order_id = wire.user_order_id;
+  rsp.order_id = wire.order_id;
+  rsp.ticker_index = wire.ticker_index;
+  rsp.direction = wire.direction;
+  rsp.offset = wire.offset;
+  rsp.original_volume = wire.original_volume;
+  rsp.traded_volume = wire.traded_volume;
+  rsp.completed = wire.completed;
+  rsp.error_code = wire.error_code;
+  rsp.this_traded = wire.this_traded;
+  rsp.this_traded_price = wire.this_traded_price;
+  return rsp;
+}
+
+inline OrderAmendedResponse to_order_amended_response(
+    const WireOrderAmended& wire) {
+  OrderAmendedResponse rsp{};
+  rsp.user_order_id = wire.user_order_id;
+  rsp.order_id = wire.order_id;
+  rsp.ticker_index = wire.ticker_index;
+  rsp.direction = wire.direction;
+  rsp.offset = wire.offset;
+  rsp.volume = wire.volume;
+  rsp.traded_volume = wire.traded_volume;
+  rsp.price = wire.price;
+  rsp.completed = wire.completed;
+  return rsp;
+}
+
+}  // namespace ft
+
+#endif  // FT_INCLUDE_CORE_WIRE_CODEC_H_
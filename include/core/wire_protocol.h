@@ -0,0 +1,167 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+//
+// 由protocol/codegen.py根据protocol/wire_protocol.yml生成，不要直接修改
+
+#ifndef FT_INCLUDE_CORE_WIRE_PROTOCOL_H_
+#define FT_INCLUDE_CORE_WIRE_PROTOCOL_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "core/constants.h"
+
+namespace ft {
+
+inline constexpr uint16_t kWireMagic = 0x4654;
+inline constexpr uint8_t kWireVersion = 1;
+inline constexpr std::size_t kWireMaxMessageSize = 1024;
+
+enum WireMsgType : uint8_t {
+  WIRE_COMMANDS = 1,
+  WIRE_RESPONSES = 2,
+};
+
+enum WireRecordType : uint8_t {
+  WIRE_NEW_ORDER = 1,
+  WIRE_CANCEL_ORDER = 2,
+  WIRE_CANCEL_TICKER = 3,
+  WIRE_CANCEL_ALL = 4,
+  WIRE_SUBSCRIBE = 5,
+  WIRE_UNSUBSCRIBE = 6,
+  WIRE_AMEND_ORDER = 7,
+  WIRE_ORDER_RESPONSE = 16,
+  WIRE_ORDER_AMENDED = 17,
+};
+
+struct WireHeader {
+  uint16_t magic;
+  uint8_t version;
+  uint8_t msg_type;
+  uint16_t length;
+  uint16_t count;
+  uint32_t strategy_id;
+  uint64_t seq;
+} __attribute__((packed));
+
+struct WireRecordHeader {
+  uint8_t type;
+  uint8_t length;
+} __attribute__((packed));
+
+struct WireNewOrder {
+  static constexpr uint8_t kType = WIRE_NEW_ORDER;
+
+  uint64_t account_id;
+  uint32_t user_order_id;
+  uint32_t ticker_index;
+  uint8_t direction;
+  uint8_t offset;
+  uint8_t order_type;
+  uint8_t without_check;
+  uint32_t flags;
+  int32_t volume;
+  double price;
+} __attribute__((packed));
+
+struct WireCancelOrder {
+  static constexpr uint8_t kType = WIRE_CANCEL_ORDER;
+
+  uint64_t account_id;
+  uint64_t order_id;
+} __attribute__((packed));
+
+struct WireCancelTicker {
+  static constexpr uint8_t kType = WIRE_CANCEL_TICKER;
+
+  uint64_t account_id;
+  uint32_t ticker_index;
+} __attribute__((packed));
+
+struct WireCancelAll {
+  static constexpr uint8_t kType = WIRE_CANCEL_ALL;
+
+  uint64_t account_id;
+} __attribute__((packed));
+
+struct WireSubscribe {
+  static constexpr uint8_t kType = WIRE_SUBSCRIBE;
+
+  uint32_t ticker_index;
+} __attribute__((packed));
+
+struct WireUnsubscribe {
+  static constexpr uint8_t kType = WIRE_UNSUBSCRIBE;
+
+  uint32_t ticker_index;
+} __attribute__((packed));
+
+struct WireAmendOrder {
+  static constexpr uint8_t kType = WIRE_AMEND_ORDER;
+
+  uint64_t account_id;
+  uint64_t order_id;
+  int32_t volume;
+  double price;
+} __attribute__((packed));
+
+struct WireOrderResponse {
+  static constexpr uint8_t kType = WIRE_ORDER_RESPONSE;
+
+  uint64_t order_id;
+  uint32_t user_order_id;
+  uint32_t ticker_index;
+  uint8_t direction;
+  uint8_t offset;
+  uint8_t completed;
+  uint8_t reserved;
+  int32_t original_volume;
+  int32_t traded_volume;
+  int32_t this_traded;
+  int32_t error_code;
+  double this_traded_price;
+} __attribute__((packed));
+
+struct WireOrderAmended {
+  static constexpr uint8_t kType = WIRE_ORDER_AMENDED;
+
+  uint64_t order_id;
+  uint32_t user_order_id;
+  uint32_t ticker_index;
+  uint8_t direction;
+  uint8_t offset;
+  uint8_t completed;
+  uint8_t reserved;
+  int32_t volume;
+  int32_t traded_volume;
+  double price;
+} __attribute__((packed));
+
+static_assert(sizeof(WireHeader) == 20);
+static_assert(sizeof(WireRecordHeader) == 2);
+static_assert(sizeof(WireNewOrder) == 36);
+static_assert(sizeof(WireCancelOrder) == 16);
+static_assert(sizeof(WireCancelTicker) == 12);
+static_assert(sizeof(WireCancelAll) == 8);
+static_assert(sizeof(WireSubscribe) == 4);
+static_assert(sizeof(WireUnsubscribe) == 4);
+static_assert(sizeof(WireAmendOrder) == 28);
+static_assert(sizeof(WireOrderResponse) == 44);
+static_assert(sizeof(WireOrderAmended) == 36);
+
+static_assert(Direction::BUY == 1);
+static_assert(Direction::SELL == 2);
+static_assert(Direction::PURCHASE == 4);
+static_assert(Direction::REDEEM == 5);
+static_assert(Offset::OPEN == 1);
+static_assert(Offset::CLOSE == 2);
+static_assert(Offset::CLOSE_TODAY == 4);
+static_assert(Offset::CLOSE_YESTERDAY == 8);
+static_assert(OrderType::MARKET == 1);
+static_assert(OrderType::LIMIT == 2);
+static_assert(OrderType::BEST == 3);
+static_assert(OrderType::FAK == 4);
+static_assert(OrderType::FOK == 5);
+
+}  // namespace ft
+
+#endif  // FT_INCLUDE_CORE_WIRE_PROTOCOL_H_
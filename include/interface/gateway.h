@@ -7,6 +7,7 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "core/config.h"
 #include "core/protocol.h"
@@ -14,6 +15,16 @@
 
 namespace ft {
 
+/*
+ * Gateway::query_batch的查询类型，可按位组合
+ */
+namespace QueryType {
+inline const uint32_t ACCOUNT = 1 << 0;
+inline const uint32_t POSITIONS = 1 << 1;
+inline const uint32_t TRADES = 1 << 2;
+inline const uint32_t MARGIN_RATES = 1 << 3;
+}  // namespace QueryType
+
 /*
  * Gateway的开发需要遵循以下规则：
  *
@@ -42,6 +53,45 @@ class Gateway {
 
   virtual bool cancel_order(uint64_t order_id) { return false; }
 
+  /*
+   * begin_batch与end_batch之间的下单、撤单请求可以合并后再一起发出，
+   * end_batch返回前应当全部发出。不支持合并发送的Gateway不需要实现
+   */
+  virtual void begin_batch() {}
+
+  virtual void end_batch() {}
+
+  /*
+   * 最近一秒发出的消息数与交易所流速限制之比，策略可据此控制下单节奏。
+   * 接近1时新的请求可能要排队等待发出，没有流速限制的Gateway返回0
+   */
+  virtual double send_utilization() { return 0.0; }
+
+  /*
+   * 改单，order为改单后的订单请求，volume为包括已成交部分在内的委托总量。
+   * 结果通过on_order_amended或on_order_amend_rejected回调
+   *
+   * 交易所不支持改单的Gateway不需要实现，supports_amend返回false时
+   * AccountEngine以先撤单、撤单成功后再按新的价格及数量下单的方式模拟
+   */
+  virtual bool supports_amend() const { return false; }
+
+  virtual bool amend_order(uint64_t order_id, const OrderReq& order) {
+    return false;
+  }
+
+  /*
+   * 运行时订阅或退订行情，tickers中的合约都属于这个Gateway支持的交易所。
+   * 断线重连后应当恢复当前的订阅。不支持的Gateway返回false
+   */
+  virtual bool subscribe(const std::vector<std::string>& tickers) {
+    return false;
+  }
+
+  virtual bool unsubscribe(const std::vector<std::string>& tickers) {
+    return false;
+  }
+
   virtual bool query_contract(const std::string& ticker,
                               const std::string& exchange) {
     return true;
@@ -60,6 +110,20 @@ class Gateway {
   virtual bool query_margin_rate(const std::string& ticker) { return true; }
 
   virtual bool query_commision_rate(const std::string& ticker) { return true; }
+
+  /*
+   * 批量查询，types为QueryType的组合。支持并发请求的Gateway同时发出各个
+   * 查询并等待全部完成，各个查询的回调之间没有先后顺序保证；默认实现按
+   * 账户、持仓、成交、保证金率的顺序依次调用上面的同步查询接口
+   */
+  virtual bool query_batch(uint32_t types) {
+    if ((types & QueryType::ACCOUNT) && !query_account()) return false;
+    if ((types & QueryType::POSITIONS) && !query_positions()) return false;
+    if ((types & QueryType::TRADES) && !query_trades()) return false;
+    if ((types & QueryType::MARGIN_RATES) && !query_margin_rate(""))
+      return false;
+    return true;
+  }
 };
 
 using __GATEWAY_CREATE_FUNC = std::function<Gateway*()>;
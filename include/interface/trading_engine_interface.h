@@ -3,12 +3,17 @@
 #ifndef FT_INCLUDE_CORE_TRADING_ENGINE_INTERFACE_H_
 #define FT_INCLUDE_CORE_TRADING_ENGINE_INTERFACE_H_
 
+#include <fmt/format.h>
+
+#include <cstring>
 #include <string>
+#include <string_view>
 
 #include "core/account.h"
 #include "core/contract.h"
 #include "core/position.h"
 #include "core/tick_data.h"
+#include "utils/encoding.h"
 
 namespace ft {
 
@@ -29,9 +34,19 @@ struct OrderTradedRsp {
   double amount;
 };
 
+/*
+ * 柜台返回的错误信息，指向柜台回调中的缓冲区，只在回调期间有效
+ * CTP返回的是GB2312编码的文本，只有在真正输出时才转换为UTF-8，
+ * 避免每次拒单都进行编码转换及构造std::string
+ */
+struct ReasonText {
+  const char* text = "";
+  bool is_gb2312 = false;
+};
+
 struct OrderRejectedRsp {
   uint64_t engine_order_id;
-  std::string reason;
+  ReasonText reason;
 };
 
 struct OrderCanceledRsp {
@@ -41,13 +56,42 @@ struct OrderCanceledRsp {
 
 struct OrderCancelRejectedRsp {
   uint64_t engine_order_id;
-  std::string reason;
+  ReasonText reason;
+};
+
+/*
+ * 改单成功，订单的委托总量及价格以AccountEngine发出的改单请求为准。部分
+ * 交易所改单后订单号会变化，order_id为0表示不变
+ */
+struct OrderAmendedRsp {
+  uint64_t engine_order_id;
+  uint64_t order_id;
+};
+
+struct OrderAmendRejectedRsp {
+  uint64_t engine_order_id;
+  ReasonText reason;
+};
+
+/*
+ * 断线重连后Gateway从柜台查询到的订单最终状态，用于补齐断线期间丢失的回报
+ * trades是该订单当日的全部成交，按成交时间排序，只在回调期间有效
+ */
+struct OrderSyncRsp {
+  uint64_t engine_order_id;
+  uint64_t order_id;
+  bool accepted;
+  bool rejected;
+  int canceled_volume;
+  const OrderTradedRsp* trades;
+  int num_trades;
+  ReasonText reason;
 };
 
 class TradingEngineInterface {
  public:
   /*
-   * 查询到合约时回调
+   * 查询到合约时回调，contract中的字符串只在回调期间有效
    */
   virtual void on_query_contract(Contract* contract) {}
 
@@ -92,8 +136,49 @@ class TradingEngineInterface {
    * 撤单被拒时回调
    */
   virtual void on_order_cancel_rejected(OrderCancelRejectedRsp* rsp) {}
+
+  /*
+   * 改单成功时回调
+   */
+  virtual void on_order_amended(OrderAmendedRsp* rsp) {}
+
+  /*
+   * 改单被拒时回调，订单保持改单前的状态
+   */
+  virtual void on_order_amend_rejected(OrderAmendRejectedRsp* rsp) {}
+
+  /*
+   * 交易通道断开时回调，此时已经发出的订单在重连后需要与柜台同步
+   */
+  virtual void on_disconnected() {}
+
+  /*
+   * 断线重连后对每个本进程发出且柜台有记录的订单回调一次，引擎需要与自己
+   * 记录的订单状态对比，补上断线期间遗漏的回报。还没有到达交易所的订单
+   * accepted及rejected都为false，只表示柜台已经收到
+   */
+  virtual void on_order_synced(OrderSyncRsp* rsp) {}
+
+  /*
+   * 断线重连后的订单同步全部完成时回调，断线前发出而没有通过on_order_synced
+   * 返回的订单没能到达柜台，引擎应当按拒单处理。重连后发出的订单可能不在
+   * 查询结果中，不能按拒单处理
+   */
+  virtual void on_order_sync_finished() {}
 };
 
 }  // namespace ft
 
+template <>
+struct fmt::formatter<ft::ReasonText> : fmt::formatter<std::string_view> {
+  template <class FormatContext>
+  auto format(const ft::ReasonText& reason, FormatContext& ctx) {
+    const char* text = reason.text ? reason.text : "";
+    if (reason.is_gb2312)
+      return fmt::formatter<std::string_view>::format(
+          ft::gb2312_to_utf8(text), ctx);
+    return fmt::formatter<std::string_view>::format(text, ctx);
+  }
+};
+
 #endif  // FT_INCLUDE_CORE_TRADING_ENGINE_INTERFACE_H_
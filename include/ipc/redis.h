@@ -120,6 +120,19 @@ class RedisSession {
     }
   }
 
+  /*
+   * 在已经开始接收订阅消息之后增减订阅时使用。只发出命令不等待确认，
+   * 确认消息与订阅的消息一起由get_sub_reply读出，调用方需要跳过类型不是
+   * message的回复
+   */
+  void subscribe_nowait(const std::vector<std::string>& topics) {
+    send_nowait("subscribe", topics);
+  }
+
+  void unsubscribe_nowait(const std::vector<std::string>& topics) {
+    send_nowait("unsubscribe", topics);
+  }
+
   RedisReply get_sub_reply() {
     redisReply* reply;
     auto status = redisGetReply(ctx_, reinterpret_cast<void**>(&reply));
@@ -147,6 +160,18 @@ class RedisSession {
   }
 
  private:
+  void send_nowait(const char* cmd, const std::vector<std::string>& topics) {
+    if (topics.empty()) return;
+
+    for (const auto& topic : topics)
+      redisAppendCommand(ctx_, "%s %s", cmd, topic.c_str());
+
+    int done = 0;
+    while (!done) {
+      if (redisBufferWrite(ctx_, &done) != REDIS_OK) return;
+    }
+  }
+
   redisContext* ctx_ = nullptr;
 };
 
@@ -6,6 +6,7 @@
 #include <fmt/format.h>
 
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "core/contract_table.h"
@@ -14,11 +15,16 @@
 
 namespace ft {
 
+// TradingEngine向策略推送订单回报的topic
+inline std::string order_rsp_topic(uint32_t strategy_id) {
+  return fmt::format("rsp-{}", strategy_id);
+}
+
 class RedisMdPusher {
  public:
   RedisMdPusher() {}
 
-  void push(const std::string& ticker, const TickData& tick) {
+  void push(std::string_view ticker, const TickData& tick) {
     redis_.publish(fmt::format("quote-{}", ticker), &tick, sizeof(tick));
   }
 
@@ -30,17 +36,30 @@ class RedisTERspPuller {
  public:
   RedisTERspPuller() {}
 
-  void subscribe_order_rsp(const std::string strategy_id) {
-    redis_.subscribe({strategy_id});
+  // 策略运行过程中也可以增减订阅，因此都不等待确认，由pull的调用方跳过
+  void subscribe_order_rsp(uint32_t strategy_id) {
+    redis_.subscribe_nowait({order_rsp_topic(strategy_id)});
   }
 
   void subscribe_md(const std::vector<std::string> ticker_vec) {
-    for (const auto& ticker : ticker_vec)
-      redis_.subscribe({fmt::format("quote-{}", ticker)});
+    redis_.subscribe_nowait(to_topics(ticker_vec));
+  }
+
+  void unsubscribe_md(const std::vector<std::string> ticker_vec) {
+    redis_.unsubscribe_nowait(to_topics(ticker_vec));
   }
 
   RedisReply pull() { return redis_.get_sub_reply(); }
 
+ private:
+  static std::vector<std::string> to_topics(
+      const std::vector<std::string>& ticker_vec) {
+    std::vector<std::string> topics;
+    for (const auto& ticker : ticker_vec)
+      topics.emplace_back(fmt::format("quote-{}", ticker));
+    return topics;
+  }
+
  private:
   RedisSession redis_;
 };
@@ -4,6 +4,7 @@
 #define FT_INCLUDE_IPC_REDIS_POSITION_HELPER_H_
 
 #include <string>
+#include <string_view>
 
 #include "core/position.h"
 #include "fmt/format.h"
@@ -20,7 +21,7 @@ class RedisPositionGetter {
     pos_key_prefix_ = fmt::format("pos-{}-", account_abbreviation_);
   }
 
-  bool get(const std::string& ticker, Position* pos) const {
+  bool get(std::string_view ticker, Position* pos) const {
     auto reply = redis_.get(fmt::format("{}{}", pos_key_prefix_, ticker));
     if (!reply) return false;
 
@@ -39,7 +40,7 @@ class RedisPositionSetter : public RedisPositionGetter {
  public:
   RedisPositionSetter() {}
 
-  bool get(const std::string& ticker, Position* pos) const {
+  bool get(std::string_view ticker, Position* pos) const {
     auto reply = redis_.get(fmt::format("{}{}", pos_key_prefix_, ticker));
     if (!reply) return false;
 
@@ -47,7 +48,7 @@ class RedisPositionSetter : public RedisPositionGetter {
     return true;
   }
 
-  void set(const std::string& ticker, const Position& pos) {
+  void set(std::string_view ticker, const Position& pos) {
     redis_.set(fmt::format("{}{}", pos_key_prefix_, ticker), &pos, sizeof(pos));
   }
 
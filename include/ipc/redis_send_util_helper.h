@@ -0,0 +1,49 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef FT_INCLUDE_IPC_REDIS_SEND_UTIL_HELPER_H_
+#define FT_INCLUDE_IPC_REDIS_SEND_UTIL_HELPER_H_
+
+#include <string>
+
+#include "fmt/format.h"
+#include "ipc/redis.h"
+
+namespace ft {
+
+/*
+ * 账户最近一秒的发送量与柜台流速限制之比，由TradingEngine定时写入，
+ * 策略据此控制下单节奏。key为send_util-<账户前4位>
+ */
+class RedisSendUtilGetter {
+ public:
+  RedisSendUtilGetter() {}
+
+  void set_account(uint64_t account) {
+    key_ = fmt::format("send_util-{}", std::to_string(account).substr(0, 4));
+  }
+
+  // 没有写入过(如TradingEngine未启动)时返回0
+  double get() const {
+    auto reply = redis_.get(key_);
+    if (!reply || reply->len != sizeof(double)) return 0.0;
+
+    return *reinterpret_cast<const double*>(reply->str);
+  }
+
+ protected:
+  RedisSession redis_;
+  std::string key_;
+};
+
+class RedisSendUtilSetter : public RedisSendUtilGetter {
+ public:
+  RedisSendUtilSetter() {}
+
+  void set(double utilization) {
+    redis_.set(key_, &utilization, sizeof(utilization));
+  }
+};
+
+}  // namespace ft
+
+#endif  // FT_INCLUDE_IPC_REDIS_SEND_UTIL_HELPER_H_
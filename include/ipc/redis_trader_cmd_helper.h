@@ -5,7 +5,9 @@
 
 #include <fmt/format.h>
 
+#include <algorithm>
 #include <string>
+#include <vector>
 
 #include "core/contract_table.h"
 #include "core/protocol.h"
@@ -22,8 +24,9 @@ class RedisTraderCmdPusher {
     trader_cmd_topic_ = fmt::format("trader_cmd-{}", account_abbreviation_);
   }
 
-  void push(const TraderCommand& cmd) {
-    redis_.publish(trader_cmd_topic_, &cmd, sizeof(cmd));
+  // data为wire_protocol.h中定义的消息
+  void push(const void* data, std::size_t size) {
+    redis_.publish(trader_cmd_topic_, data, size);
   }
 
   std::string get_topic() const { return trader_cmd_topic_; }
@@ -39,21 +42,28 @@ class RedisTraderCmdPuller {
  public:
   RedisTraderCmdPuller() {}
 
-  void set_account(uint64_t account) {
-    account_abbreviation_ = std::to_string(account).substr(0, 4);
-    trader_cmd_topic_ = fmt::format("trader_cmd-{}", account_abbreviation_);
-    redis_.subscribe({trader_cmd_topic_});
+  void set_account(uint64_t account) { add_account(account); }
+
+  // TradingEngine管理多个账户时需要同时订阅每个账户的topic，账户简称相同的
+  // 只订阅一次
+  void add_account(uint64_t account) {
+    auto topic =
+        fmt::format("trader_cmd-{}", std::to_string(account).substr(0, 4));
+    if (std::find(topics_.begin(), topics_.end(), topic) != topics_.end())
+      return;
+
+    redis_.subscribe({topic});
+    topics_.emplace_back(topic);
   }
 
   RedisReply pull() { return redis_.get_sub_reply(); }
 
-  std::string get_topic() const { return trader_cmd_topic_; }
+  const std::vector<std::string>& get_topics() const { return topics_; }
 
  private:
   RedisSession redis_;
 
-  std::string account_abbreviation_;
-  std::string trader_cmd_topic_;
+  std::vector<std::string> topics_;
 };
 
 }  // namespace ft
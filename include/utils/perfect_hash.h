@@ -0,0 +1,154 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef FT_INCLUDE_UTILS_PERFECT_HASH_H_
+#define FT_INCLUDE_UTILS_PERFECT_HASH_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace ft {
+
+/*
+ * 静态键集合上的完美哈希（hash and displace）
+ * 键先被分配到某个桶，每个桶搜索一个位移值使桶内所有键落在互不冲突的槽位上，
+ * 查找时只需计算两次哈希，没有冲突链也没有内存分配
+ *
+ * 槽位中保存keys[i]对应的值i+1，0表示空槽，重复的键以第一个为准。
+ * 由于不在集合中的键也会落到某个槽位，
+ * 调用方需要自行比较原始键以确认命中
+ *
+ * 索引既可以由build在内部构建，也可以通过attach直接引用外部内存
+ * （如mmap的合约表文件），后者不做任何拷贝，调用方需保证内存的生命周期
+ */
+class PerfectHashIndex {
+ public:
+  PerfectHashIndex() = default;
+  PerfectHashIndex(const PerfectHashIndex&) = delete;
+  PerfectHashIndex& operator=(const PerfectHashIndex&) = delete;
+
+  bool build(const std::vector<std::string_view>& keys) {
+    uint32_t num_keys = keys.size();
+    uint32_t num_buckets = num_keys / 2 + 1;
+    uint32_t num_slots = 1;
+    while (num_slots < num_keys + num_keys / 4 + 1) num_slots <<= 1;
+
+    // 槽位不够时放大一倍重新构建，正常情况下一次即可成功
+    for (int retry = 0; retry < 4; ++retry, num_slots <<= 1) {
+      if (try_build(keys, num_buckets, num_slots)) {
+        displacement_ptr_ = displacements_.data();
+        num_buckets_ = num_buckets;
+        slot_ptr_ = slots_.data();
+        return true;
+      }
+    }
+
+    slot_ptr_ = nullptr;
+    return false;
+  }
+
+  // num_slots必须是2的幂，slots中的值由调用方保证不越界
+  void attach(const uint32_t* displacements, uint32_t num_buckets,
+              const uint32_t* slots, uint32_t num_slots) {
+    displacements_.clear();
+    slots_.clear();
+    displacement_ptr_ = displacements;
+    num_buckets_ = num_buckets;
+    slot_ptr_ = slots;
+    slot_mask_ = num_slots - 1;
+  }
+
+  uint32_t lookup(std::string_view key) const {
+    if (!slot_ptr_) return 0;
+
+    uint32_t bucket = hash(key, 0) % num_buckets_;
+    return slot_ptr_[hash(key, displacement_ptr_[bucket]) & slot_mask_];
+  }
+
+  // 仅对build构建的索引有效
+  const std::vector<uint32_t>& displacements() const { return displacements_; }
+
+  const std::vector<uint32_t>& slots() const { return slots_; }
+
+  static uint64_t hash(std::string_view key, uint64_t seed) {
+    uint64_t h = 14695981039346656037ULL ^ (seed * 0x9e3779b97f4a7c15ULL);
+    for (char c : key) {
+      h ^= static_cast<uint8_t>(c);
+      h *= 1099511628211ULL;
+    }
+
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return h;
+  }
+
+ private:
+  bool try_build(const std::vector<std::string_view>& keys,
+                 uint32_t num_buckets, uint32_t num_slots) {
+    std::vector<std::vector<uint32_t>> buckets(num_buckets);
+    for (uint32_t i = 0; i < keys.size(); ++i) {
+      auto& bucket = buckets[hash(keys[i], 0) % num_buckets];
+      // 重复的键只保留第一个
+      if (std::find_if(bucket.begin(), bucket.end(), [&](uint32_t k) {
+            return keys[k] == keys[i];
+          }) == bucket.end())
+        bucket.emplace_back(i);
+    }
+
+    std::vector<uint32_t> order(num_buckets);
+    for (uint32_t i = 0; i < num_buckets; ++i) order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+      return buckets[a].size() > buckets[b].size();
+    });
+
+    displacements_.assign(num_buckets, 0);
+    slots_.assign(num_slots, 0);
+    slot_mask_ = num_slots - 1;
+
+    std::vector<uint32_t> positions;
+    for (uint32_t b : order) {
+      auto& bucket = buckets[b];
+      if (bucket.empty()) break;
+
+      bool placed = false;
+      for (uint32_t d = 1; d < (1U << 20) && !placed; ++d) {
+        positions.clear();
+        placed = true;
+        for (uint32_t key_idx : bucket) {
+          uint32_t pos = hash(keys[key_idx], d) & slot_mask_;
+          if (slots_[pos] != 0 ||
+              std::find(positions.begin(), positions.end(), pos) !=
+                  positions.end()) {
+            placed = false;
+            break;
+          }
+          positions.emplace_back(pos);
+        }
+
+        if (placed) {
+          displacements_[b] = d;
+          for (std::size_t i = 0; i < bucket.size(); ++i)
+            slots_[positions[i]] = bucket[i] + 1;
+        }
+      }
+
+      if (!placed) return false;
+    }
+
+    return true;
+  }
+
+ private:
+  std::vector<uint32_t> displacements_;
+  std::vector<uint32_t> slots_;
+  const uint32_t* displacement_ptr_ = nullptr;
+  const uint32_t* slot_ptr_ = nullptr;
+  uint32_t num_buckets_ = 0;
+  uint32_t slot_mask_ = 0;
+};
+
+}  // namespace ft
+
+#endif  // FT_INCLUDE_UTILS_PERFECT_HASH_H_
@@ -0,0 +1,106 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef FT_INCLUDE_UTILS_RECONNECTOR_H_
+#define FT_INCLUDE_UTILS_RECONNECTOR_H_
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace ft {
+
+/*
+ * 断线重连的后台线程
+ *
+ * start之后在后台线程中反复调用task，直到task返回true或者stop被调用，
+ * 每次失败后的等待时间从min_interval开始翻倍，最长为max_interval。
+ * 重新登录需要阻塞等待柜台的回报，不能在API的回调线程中完成，因此放到
+ * 这个线程中执行。task执行期间又一次调用start时，不会启动新的线程，而是
+ * 重置等待时间并在当前task结束后立即再执行一次
+ */
+class Reconnector {
+ public:
+  using Interval = std::chrono::milliseconds;
+
+  explicit Reconnector(Interval min_interval = Interval(500),
+                       Interval max_interval = Interval(30000))
+      : min_interval_(min_interval), max_interval_(max_interval) {}
+
+  ~Reconnector() { stop(); }
+
+  Reconnector(const Reconnector&) = delete;
+  Reconnector& operator=(const Reconnector&) = delete;
+
+  void start(std::function<bool()> task) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (is_stopped_) return;
+
+    if (is_running_) {
+      is_kicked_ = true;
+      cv_.notify_all();
+      return;
+    }
+
+    // 上一轮重连已经结束，线程即将退出
+    if (thread_.joinable()) thread_.join();
+    is_running_ = true;
+    is_kicked_ = false;
+    thread_ = std::thread([this, task = std::move(task)] { run(task); });
+  }
+
+  // 不能在task中调用
+  void stop() {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      is_stopped_ = true;
+      cv_.notify_all();
+    }
+    if (thread_.joinable()) thread_.join();
+  }
+
+ private:
+  void run(const std::function<bool()>& task) {
+    auto interval = min_interval_;
+    for (;;) {
+      bool ok = task();
+
+      std::unique_lock<std::mutex> lock(mutex_);
+      if (is_stopped_ || (ok && !is_kicked_)) break;
+
+      if (!ok) {
+        cv_.wait_for(lock, interval,
+                     [this] { return is_stopped_ || is_kicked_; });
+        if (is_stopped_) break;
+      }
+
+      if (is_kicked_) {
+        is_kicked_ = false;
+        interval = min_interval_;
+      } else {
+        interval = std::min(interval * 2, max_interval_);
+      }
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    is_running_ = false;
+  }
+
+ private:
+  Interval min_interval_;
+  Interval max_interval_;
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::thread thread_;
+  bool is_running_ = false;
+  bool is_kicked_ = false;
+  bool is_stopped_ = false;
+};
+
+}  // namespace ft
+
+#endif  // FT_INCLUDE_UTILS_RECONNECTOR_H_
@@ -0,0 +1,122 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef FT_INCLUDE_UTILS_REQUEST_TRACKER_H_
+#define FT_INCLUDE_UTILS_REQUEST_TRACKER_H_
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace ft {
+
+/*
+ * 按req_id跟踪柜台API中请求与回报的对应关系
+ *
+ * 发出请求前先调用add登记，回报线程在收到最后一个回报时调用done或error，
+ * 发起请求的线程通过wait等待结果。不同req_id的请求互不影响，因此可以先
+ * 发出多个请求再通过wait_all一起等待。等待线程睡眠在条件变量上，不会空转，
+ * 超时后返回false并注销该请求，之后迟到的回报会被忽略。没有线程等待的请求
+ * 在fail_all时直接注销，之后再wait也会返回false
+ */
+class RequestTracker {
+ public:
+  using Timeout = std::chrono::milliseconds;
+
+  void add(int req_id) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    pending_[req_id] = Entry{};
+  }
+
+  // 请求未能发出时注销
+  void remove(int req_id) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    pending_.erase(req_id);
+  }
+
+  void done(int req_id) { complete(req_id, DONE); }
+
+  void error(int req_id) { complete(req_id, FAILED); }
+
+  // 连接断开或析构时调用，使所有未完成的请求失败，唤醒等待的线程。
+  // 有线程等待的请求由等待线程注销，其余的请求在这里直接注销，
+  // 避免每次断线都在pending_中留下永远不会被取走的结果
+  void fail_all() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (auto iter = pending_.begin(); iter != pending_.end();) {
+      auto& entry = iter->second;
+      if (entry.waiters == 0) {
+        iter = pending_.erase(iter);
+        continue;
+      }
+
+      if (entry.status == PENDING) entry.status = FAILED;
+      ++iter;
+    }
+    cv_.notify_all();
+  }
+
+  bool is_pending(int req_id) const {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto iter = pending_.find(req_id);
+    return iter != pending_.end() && iter->second.status == PENDING;
+  }
+
+  // 请求成功完成返回true，失败、超时或者未登记返回false
+  bool wait(int req_id, Timeout timeout) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto iter = pending_.find(req_id);
+    if (iter == pending_.end()) return false;
+
+    // 等待期间其他线程可能登记新的请求导致rehash，每次都重新查找
+    ++iter->second.waiters;
+    cv_.wait_for(lock, timeout, [&] {
+      return pending_.find(req_id)->second.status != PENDING;
+    });
+    iter = pending_.find(req_id);
+    bool ok = iter->second.status == DONE;
+    pending_.erase(iter);
+    return ok;
+  }
+
+  // 所有请求共享同一个超时时间，只有全部成功才返回true。无论结果如何，
+  // 返回时所有请求都已注销
+  bool wait_all(const std::vector<int>& req_ids, Timeout timeout) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    bool ok = true;
+    for (int req_id : req_ids) {
+      auto remaining = std::chrono::duration_cast<Timeout>(
+          deadline - std::chrono::steady_clock::now());
+      if (!wait(req_id, std::max(remaining, Timeout(0)))) ok = false;
+    }
+    return ok;
+  }
+
+ private:
+  enum Status { PENDING, DONE, FAILED };
+
+  struct Entry {
+    Status status = PENDING;
+    int waiters = 0;
+  };
+
+  void complete(int req_id, Status status) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto iter = pending_.find(req_id);
+    if (iter == pending_.end() || iter->second.status != PENDING) return;
+
+    iter->second.status = status;
+    cv_.notify_all();
+  }
+
+ private:
+  mutable std::mutex mutex_;
+  std::condition_variable cv_;
+  std::unordered_map<int, Entry> pending_;
+};
+
+}  // namespace ft
+
+#endif  // FT_INCLUDE_UTILS_REQUEST_TRACKER_H_
@@ -0,0 +1,30 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef FT_INCLUDE_UTILS_STRING_POOL_H_
+#define FT_INCLUDE_UTILS_STRING_POOL_H_
+
+#include <string>
+#include <string_view>
+#include <unordered_set>
+
+namespace ft {
+
+/*
+ * 字符串驻留，相同的内容只保存一份
+ * 返回的string_view在池的生命周期内一直有效，并且以'\0'结尾
+ */
+class StringPool {
+ public:
+  std::string_view intern(std::string_view str) {
+    return *strings_.emplace(str).first;
+  }
+
+  void clear() { strings_.clear(); }
+
+ private:
+  std::unordered_set<std::string> strings_;
+};
+
+}  // namespace ft
+
+#endif  // FT_INCLUDE_UTILS_STRING_POOL_H_
@@ -0,0 +1,231 @@
+#!/usr/bin/env python3
+# Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+"""
+根据wire_protocol.yml生成C++及Python的协议代码
+
+    python3 protocol/codegen.py [--check]
+
+--check只检查生成的文件是否与schema一致，不一致时返回非0
+"""
+
+import os
+import re
+import sys
+
+import yaml
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+SCHEMA = os.path.join(ROOT, 'protocol', 'wire_protocol.yml')
+CPP_OUT = os.path.join(ROOT, 'include', 'core', 'wire_protocol.h')
+PY_OUT = os.path.join(ROOT, 'python', 'ft', 'wire_protocol.py')
+
+# 类型名: (C++类型, struct格式, 字节数)
+TYPES = {
+    'u8': ('uint8_t', 'B', 1),
+    'u16': ('uint16_t', 'H', 2),
+    'u32': ('uint32_t', 'I', 4),
+    'u64': ('uint64_t', 'Q', 8),
+    'i32': ('int32_t', 'i', 4),
+    'i64': ('int64_t', 'q', 8),
+    'f64': ('double', 'd', 8),
+}
+
+BANNER = '由protocol/codegen.py根据protocol/wire_protocol.yml生成，不要直接修改'
+
+
+def upper_snake(name):
+    return re.sub(r'(?<!^)(?=[A-Z])', '_', name).upper()
+
+
+def layout(fields):
+    return '<' + ''.join(TYPES[t][1] for _, t in fields)
+
+
+def size_of(fields):
+    return sum(TYPES[t][2] for _, t in fields)
+
+
+def check_schema(schema):
+    for name, record in schema['records'].items():
+        for field, t in record['fields']:
+            if t not in TYPES:
+                sys.exit('unknown type {} of {}.{}'.format(t, name, field))
+        if size_of(record['fields']) > 255:
+            sys.exit('record {} is too large'.format(name))
+
+    types = [r['type'] for r in schema['records'].values()]
+    if len(types) != len(set(types)):
+        sys.exit('duplicated record type')
+
+
+def cpp_struct(name, fields, type_enum=None):
+    lines = ['struct {} {{'.format(name)]
+    if type_enum:
+        lines.append('  static constexpr uint8_t kType = {};'.format(type_enum))
+        lines.append('')
+    for field, t in fields:
+        lines.append('  {} {};'.format(TYPES[t][0], field))
+    lines.append('} __attribute__((packed));')
+    return lines
+
+
+def gen_cpp(schema):
+    out = [
+        '// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>',
+        '//',
+        '// ' + BANNER,
+        '',
+        '#ifndef FT_INCLUDE_CORE_WIRE_PROTOCOL_H_',
+        '#define FT_INCLUDE_CORE_WIRE_PROTOCOL_H_',
+        '',
+        '#include <cstddef>',
+        '#include <cstdint>',
+        '',
+        '#include "core/constants.h"',
+        '',
+        'namespace ft {',
+        '',
+        'inline constexpr uint16_t kWireMagic = {:#x};'.format(schema['magic']),
+        'inline constexpr uint8_t kWireVersion = {};'.format(
+            schema['version']),
+        'inline constexpr std::size_t kWireMaxMessageSize = {};'.format(
+            schema['max_message_size']),
+        '',
+        'enum WireMsgType : uint8_t {',
+    ]
+    for name, value in schema['msg_types'].items():
+        out.append('  WIRE_{} = {},'.format(name, value))
+    out += ['};', '', 'enum WireRecordType : uint8_t {']
+    for name, record in schema['records'].items():
+        out.append('  WIRE_{} = {},'.format(upper_snake(name), record['type']))
+    out += ['};', '']
+
+    out += cpp_struct('WireHeader', schema['header'])
+    out.append('')
+    out += cpp_struct('WireRecordHeader', schema['record_header'])
+    out.append('')
+    for name, record in schema['records'].items():
+        out += cpp_struct('Wire' + name, record['fields'],
+                          'WIRE_' + upper_snake(name))
+        out.append('')
+
+    out.append('static_assert(sizeof(WireHeader) == {});'.format(
+        size_of(schema['header'])))
+    out.append('static_assert(sizeof(WireRecordHeader) == {});'.format(
+        size_of(schema['record_header'])))
+    for name, record in schema['records'].items():
+        out.append('static_assert(sizeof(Wire{}) == {});'.format(
+            name, size_of(record['fields'])))
+    out.append('')
+
+    for enum, values in schema['enums'].items():
+        for name, value in values.items():
+            out.append('static_assert({}::{} == {});'.format(enum, name, value))
+    out += ['', '}  // namespace ft', '',
+            '#endif  // FT_INCLUDE_CORE_WIRE_PROTOCOL_H_', '']
+    return '\n'.join(out)
+
+
+def gen_python(schema):
+    header_fields = [f for f, _ in schema['header']]
+    out = [
+        '# ' + BANNER,
+        '',
+        'import collections',
+        'import struct',
+        '',
+        'MAGIC = {:#x}'.format(schema['magic']),
+        'VERSION = {}'.format(schema['version']),
+        'MAX_MESSAGE_SIZE = {}'.format(schema['max_message_size']),
+        '',
+    ]
+    for name, value in schema['msg_types'].items():
+        out.append('{} = {}'.format(name, value))
+
+    for enum, values in schema['enums'].items():
+        out += ['', '', 'class {}(object):'.format(enum)]
+        for name, value in values.items():
+            out.append('    {} = {}'.format(name, value))
+    out += ['', '']
+
+    out.append("Header = collections.namedtuple('Header', {})".format(
+        header_fields))
+    out.append("HEADER = struct.Struct('{}')".format(layout(schema['header'])))
+    out.append("RECORD_HEADER = struct.Struct('{}')".format(
+        layout(schema['record_header'])))
+
+    for name, record in schema['records'].items():
+        fields = [f for f, _ in record['fields']]
+        out += [
+            '',
+            '',
+            'class {0}(collections.namedtuple(\'{0}\', {1})):'.format(
+                name, fields),
+            '    __slots__ = ()',
+            '    TYPE = {}'.format(record['type']),
+            "    STRUCT = struct.Struct('{}')".format(layout(record['fields'])),
+        ]
+
+    out += ['', '', 'RECORDS = {']
+    for name, record in schema['records'].items():
+        out.append('    {}: {},'.format(record['type'], name))
+    out.append('}')
+
+    out += '''
+
+def encode(msg_type, strategy_id, seq, records):
+    body = b''.join(RECORD_HEADER.pack(r.TYPE, r.STRUCT.size) +
+                    r.STRUCT.pack(*r) for r in records)
+    length = HEADER.size + len(body)
+    if length > MAX_MESSAGE_SIZE:
+        raise ValueError('message too large: {}'.format(length))
+    return HEADER.pack(MAGIC, VERSION, msg_type, length, len(records),
+                       strategy_id, seq) + body
+
+
+def decode(data):
+    header = Header._make(HEADER.unpack_from(data))
+    if header.magic != MAGIC or header.version != VERSION:
+        raise ValueError('unknown message version: {}'.format(header.version))
+    if header.length > len(data):
+        raise ValueError('truncated message')
+
+    records = []
+    offset = HEADER.size
+    for _ in range(header.count):
+        record_type, length = RECORD_HEADER.unpack_from(data, offset)
+        offset += RECORD_HEADER.size
+        if offset + length > header.length:
+            raise ValueError('truncated record')
+        cls = RECORDS.get(record_type)
+        if cls and length >= cls.STRUCT.size:
+            records.append(cls._make(cls.STRUCT.unpack_from(data, offset)))
+        offset += length
+    return header, records
+'''.split('\n')
+    return '\n'.join(out)
+
+
+def main():
+    with open(SCHEMA) as f:
+        schema = yaml.safe_load(f)
+    check_schema(schema)
+
+    outputs = {CPP_OUT: gen_cpp(schema), PY_OUT: gen_python(schema)}
+    if '--check' in sys.argv:
+        stale = []
+        for path, content in outputs.items():
+            if not os.path.exists(path) or open(path).read() != content:
+                stale.append(os.path.relpath(path, ROOT))
+        if stale:
+            sys.exit('out of date: ' + ', '.join(stale))
+        return
+
+    for path, content in outputs.items():
+        with open(path, 'w') as f:
+            f.write(content)
+
+
+if __name__ == '__main__':
+    main()
@@ -1,21 +1,17 @@
-BUY = 1
-SELL = 2
+from ft.wire_protocol import Direction, Offset, OrderType
 
-OPEN = 1
-CLOSE = 2
-CLOSE_TODAY = 4
-CLOSE_YESTERDAY = 8
+BUY = Direction.BUY
+SELL = Direction.SELL
 
-LIMIT = 1
-MARKET = 2
-BEST = 3
-FAK = 4
-FOK = 5
+OPEN = Offset.OPEN
+CLOSE = Offset.CLOSE
+CLOSE_TODAY = Offset.CLOSE_TODAY
+CLOSE_YESTERDAY = Offset.CLOSE_YESTERDAY
 
-NEW_ORDER = 1
-CANCEL_ORDER = 2
-CANCEL_TICKER = 3
-CANCEL_ALL = 4
+MARKET = OrderType.MARKET
+LIMIT = OrderType.LIMIT
+BEST = OrderType.BEST
+FAK = OrderType.FAK
+FOK = OrderType.FOK
 
-CMD_MAGIC = 0x1709394
 CMD_TOPIC = 'trader_cmd'
@@ -1,38 +1,46 @@
 import redis
-import struct
 
 import ft.constants as constants
 import ft.contract_table as contract_table
+import ft.wire_protocol as wire
 
 
 def gen_order_req(ticker, direction, offset, volume, price,
-                  order_type=constants.FAK, user_order_id=0,
-                  strategy_id=''):
+                  order_type=constants.FAK, user_order_id=0, account_id=0):
     contract = contract_table.ct.get_by_ticker(ticker)
     if not contract:
         return None
 
-    req = struct.pack('<II16sIIIIIid', constants.CMD_MAGIC, constants.NEW_ORDER,
-                      strategy_id.encode(encoding='utf-8'), user_order_id,
-                      contract.ticker_index, direction, offset, order_type,
-                      volume, price)
-
-    return req
+    return wire.NewOrder(account_id=account_id, user_order_id=user_order_id,
+                         ticker_index=contract.ticker_index,
+                         direction=direction, offset=offset,
+                         order_type=order_type, without_check=0, flags=0,
+                         volume=volume, price=price)
 
 
 class OrderSender(object):
-    def __init__(self, strategy_id='', host='localhost', port=6379):
+    def __init__(self, strategy_id=0, host='localhost', port=6379):
         self.strategy_id = strategy_id
+        self.seq = 0
         self.redis = redis.StrictRedis(host, port)
 
+    def send(self, records):
+        self.seq += 1
+        msg = wire.encode(wire.COMMANDS, self.strategy_id, self.seq, records)
+        self.redis.publish(constants.CMD_TOPIC, msg)
+
     def send_order(self, ticker, direction, offset, order_type, volume, price,
                    user_order_id=0):
         req = gen_order_req(ticker, direction, offset, volume, price,
-                            order_type, user_order_id, self.strategy_id)
+                            order_type, user_order_id)
         if req:
-            self.redis.publish(constants.CMD_TOPIC, req)
+            self.send([req])
             return True
         return False
 
     def cancel_order(self, order_id):
-        pass
+        self.send([wire.CancelOrder(account_id=0, order_id=order_id)])
+
+    def amend_order(self, order_id, volume, price):
+        self.send([wire.AmendOrder(account_id=0, order_id=order_id,
+                                   volume=volume, price=price)])
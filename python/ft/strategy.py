@@ -1,11 +1,7 @@
 import redis
 
 import ft.order_sender as order_sender
-
-
-class OrderResponse(object):
-    def __init__(self, data):
-        pass
+import ft.wire_protocol as wire
 
 
 class Tick(object):
@@ -29,6 +25,9 @@ class Strategy(object):
     def on_order_rsp(self, order):
         pass
 
+    def on_order_amended(self, rsp):
+        pass
+
     def on_exit(self):
         pass
 
@@ -42,13 +41,20 @@ class Strategy(object):
     def run(self):
         self.on_init()
 
+        rsp_topic = 'rsp-{}'.format(self.strategy_id).encode()
         if self.strategy_id:
-            self.subscribe(Strategy)
+            self.subscribe(rsp_topic)
 
         for reply in self.tick_sub.listen():
-            if reply['channel'] == self.strategy_id:
-                rsp = OrderResponse(reply['data'])
-                self.on_order_rsp(rsp)
+            if reply['type'] != 'message':
+                continue
+            if reply['channel'] == rsp_topic:
+                _, records = wire.decode(reply['data'])
+                for rsp in records:
+                    if isinstance(rsp, wire.OrderResponse):
+                        self.on_order_rsp(rsp)
+                    elif isinstance(rsp, wire.OrderAmended):
+                        self.on_order_amended(rsp)
             else:
                 tick = Tick(reply['data'])
                 self.on_tick(tick)
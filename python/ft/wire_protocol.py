@@ -0,0 +1,136 @@
+# 由protocol/codegen.py根据protocol/wire_protocol.yml生成，不要直接修改
+
+import collections
+import struct
+
+MAGIC = 0x4654
+VERSION = 1
+MAX_MESSAGE_SIZE = 1024
+
+COMMANDS = 1
+RESPONSES = 2
+
+
+class Direction(object):
+    BUY = 1
+    SELL = 2
+    PURCHASE = 4
+    REDEEM = 5
+
+
+class Offset(object):
+    OPEN = 1
+    CLOSE = 2
+    CLOSE_TODAY = 4
+    CLOSE_YESTERDAY = 8
+
+
+class OrderType(object):
+    MARKET = 1
+    LIMIT = 2
+    BEST = 3
+    FAK = 4
+    FOK = 5
+
+
+Header = collections.namedtuple('Header', ['magic', 'version', 'msg_type', 'length', 'count', 'strategy_id', 'seq'])
+HEADER = struct.Struct('<HBBHHIQ')
+RECORD_HEADER = struct.Struct('<BB')
+
+
+class NewOrder(collections.namedtuple('NewOrder', ['account_id', 'user_order_id', 'ticker_index', 'direction', 'offset', 'order_type', 'without_check', 'flags', 'volume', 'price'])):
+    __slots__ = ()
+    TYPE = 1
+    STRUCT = struct.Struct('<QIIBBBBIid')
+
+
+class CancelOrder(collections.namedtuple('CancelOrder', ['account_id', 'order_id'])):
+    __slots__ = ()
+    TYPE = 2
+    STRUCT = struct.Struct('<QQ')
+
+
+class CancelTicker(collections.namedtuple('CancelTicker', ['account_id', 'ticker_index'])):
+    __slots__ = ()
+    TYPE = 3
+    STRUCT = struct.Struct('<QI')
+
+
+class CancelAll(collections.namedtuple('CancelAll', ['account_id'])):
+    __slots__ = ()
+    TYPE = 4
+    STRUCT = struct.Struct('<Q')
+
+
+class Subscribe(collections.namedtuple('Subscribe', ['ticker_index'])):
+    __slots__ = ()
+    TYPE = 5
+    STRUCT = struct.Struct('<I')
+
+
+class Unsubscribe(collections.namedtuple('Unsubscribe', ['ticker_index'])):
+    __slots__ = ()
+    TYPE = 6
+    STRUCT = struct.Struct('<I')
+
+
+class AmendOrder(collections.namedtuple('AmendOrder', ['account_id', 'order_id', 'volume', 'price'])):
+    __slots__ = ()
+    TYPE = 7
+    STRUCT = struct.Struct('<QQid')
+
+
+class OrderResponse(collections.namedtuple('OrderResponse', ['order_id', 'user_order_id', 'ticker_index', 'direction', 'offset', 'completed', 'reserved', 'original_volume', 'traded_volume', 'this_traded', 'error_code', 'this_traded_price'])):
+    __slots__ = ()
+    TYPE = 16
+    STRUCT = struct.Struct('<QIIBBBBiiiid')
+
+
+class OrderAmended(collections.namedtuple('OrderAmended', ['order_id', 'user_order_id', 'ticker_index', 'direction', 'offset', 'completed', 'reserved', 'volume', 'traded_volume', 'price'])):
+    __slots__ = ()
+    TYPE = 17
+    STRUCT = struct.Struct('<QIIBBBBiid')
+
+
+RECORDS = {
+    1: NewOrder,
+    2: CancelOrder,
+    3: CancelTicker,
+    4: CancelAll,
+    5: Subscribe,
+    6: Unsubscribe,
+    7: AmendOrder,
+    16: OrderResponse,
+    17: OrderAmended,
+}
+
+
+def encode(msg_type, strategy_id, seq, records):
+    body = b''.join(RECORD_HEADER.pack(r.TYPE, r.STRUCT.size) +
+                    r.STRUCT.pack(*r) for r in records)
+    length = HEADER.size + len(body)
+    if length > MAX_MESSAGE_SIZE:
+        raise ValueError('message too large: {}'.format(length))
+    return HEADER.pack(MAGIC, VERSION, msg_type, length, len(records),
+                       strategy_id, seq) + body
+
+
+def decode(data):
+    header = Header._make(HEADER.unpack_from(data))
+    if header.magic != MAGIC or header.version != VERSION:
+        raise ValueError('unknown message version: {}'.format(header.version))
+    if header.length > len(data):
+        raise ValueError('truncated message')
+
+    records = []
+    offset = HEADER.size
+    for _ in range(header.count):
+        record_type, length = RECORD_HEADER.unpack_from(data, offset)
+        offset += RECORD_HEADER.size
+        if offset + length > header.length:
+            raise ValueError('truncated record')
+        cls = RECORDS.get(record_type)
+        if cls and length >= cls.STRUCT.size:
+            records.append(cls._make(cls.STRUCT.unpack_from(data, offset)))
+        offset += length
+    return header, records
@@ -8,18 +8,20 @@
 #include <vector>
 
 #include "core/contract_table.h"
+#include "core/price.h"
 #include "core/tick_data.h"
 
 namespace ft {
 
+// 除iopv外都是以price_tick为单位的整数价格，0表示没有价格
 struct TickDataSnapshot {
-  double last_price;
-  double ask;
-  double bid;
+  TickPrice last_price;
+  TickPrice ask;
+  TickPrice bid;
   double iopv;
 
-  double upper_limit_price;
-  double lower_limit_price;
+  TickPrice upper_limit_price;
+  TickPrice lower_limit_price;
 };
 
 class MdSnapshot {
@@ -31,22 +33,23 @@ class MdSnapshot {
   }
 
   void update_snapshot(const TickData& tick) {
+    auto params = ContractTable::get_params(tick.ticker_index);
+    double price_tick = params->price_tick;
+
     auto data = snapshot_[tick.ticker_index];
-    if (data) {
-      data->last_price = tick.last_price;
-      data->bid = tick.bid[0];
-      data->ask = tick.ask[0];
-      data->iopv = tick.etf.iopv;
-    } else {
+    if (!data) {
       data = new TickDataSnapshot;
-      data->last_price = tick.last_price;
-      data->bid = tick.bid[0];
-      data->ask = tick.ask[0];
-      data->iopv = tick.etf.iopv;
-      data->upper_limit_price = tick.upper_limit_price;
-      data->lower_limit_price = tick.lower_limit_price;
+      data->upper_limit_price =
+          to_tick_price(tick.upper_limit_price, price_tick);
+      data->lower_limit_price =
+          to_tick_price(tick.lower_limit_price, price_tick);
       snapshot_[tick.ticker_index] = data;
     }
+
+    data->last_price = to_tick_price(tick.last_price, price_tick);
+    data->bid = to_tick_price(tick.bid[0], price_tick);
+    data->ask = to_tick_price(tick.ask[0], price_tick);
+    data->iopv = tick.etf.iopv;
   }
 
  private:
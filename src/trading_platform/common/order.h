@@ -37,7 +37,17 @@ struct Order {
   int canceled_volume = 0;
   OrderStatus status;
   uint64_t insert_time;
-  std::string strategy_id;
+  uint32_t strategy_id = 0;  // 0表示不需要回报
+
+  // 改单还没有结果时为true，改单后的委托总量及价格暂存在amend_volume及
+  // amend_price中，改单成功后才更新到req
+  bool amending = false;
+  int amend_volume = 0;
+  TickPrice amend_price = 0;
+
+  // 柜台不支持改单时，撤单后按改单结果重新发出的订单。改单请求已经计入
+  // 流控，重新发单时不再重复计入
+  bool is_replacement = false;
 };
 
 }  // namespace ft
@@ -4,25 +4,28 @@
 #define FT_SRC_COMMON_ORDER_SENDER_H_
 
 #include <string>
+#include <string_view>
 
 #include "core/constants.h"
 #include "core/contract_table.h"
-#include "core/protocol.h"
+#include "core/wire_codec.h"
 #include "ipc/redis_trader_cmd_helper.h"
 
 namespace ft {
 
 class OrderSender {
  public:
-  void set_id(const std::string& name) {
-    strncpy(strategy_id_, name.c_str(), sizeof(strategy_id_) - 1);
-  }
+  // strategy_id为0时TradingEngine不推送订单回报
+  void set_id(uint32_t strategy_id) { strategy_id_ = strategy_id; }
 
-  void set_account(uint64_t account_id) { cmd_pusher_.set_account(account_id); }
+  void set_account(uint64_t account_id) {
+    account_id_ = account_id;
+    cmd_pusher_.set_account(account_id);
+  }
 
   void set_order_flags(uint32_t flags) { flags_ = flags; }
 
-  void buy_open(const std::string& ticker, int volume, double price,
+  void buy_open(std::string_view ticker, int volume, double price,
                 uint64_t type = OrderType::FAK, uint32_t user_order_id = 0) {
     send_order(ticker, volume, Direction::BUY, Offset::OPEN, type, price,
                user_order_id);
@@ -34,7 +37,7 @@ class OrderSender {
                user_order_id);
   }
 
-  void buy_close(const std::string& ticker, int volume, double price,
+  void buy_close(std::string_view ticker, int volume, double price,
                  uint64_t type = OrderType::FAK, uint32_t user_order_id = 0) {
     send_order(ticker, volume, Direction::BUY, Offset::CLOSE_TODAY, type, price,
                user_order_id);
@@ -46,7 +49,7 @@ class OrderSender {
                price, user_order_id);
   }
 
-  void sell_open(const std::string& ticker, int volume, double price,
+  void sell_open(std::string_view ticker, int volume, double price,
                  uint64_t type = OrderType::FAK, uint32_t user_order_id = 0) {
     send_order(ticker, volume, Direction::SELL, Offset::OPEN, type, price,
                user_order_id);
@@ -58,7 +61,7 @@ class OrderSender {
                user_order_id);
   }
 
-  void sell_close(const std::string& ticker, int volume, double price,
+  void sell_close(std::string_view ticker, int volume, double price,
                   uint64_t type = OrderType::FAK, uint32_t user_order_id = 0) {
     send_order(ticker, volume, Direction::SELL, Offset::CLOSE_TODAY, type,
                price, user_order_id);
@@ -73,66 +76,116 @@ class OrderSender {
   void send_order(uint32_t ticker_index, int volume, uint32_t direction,
                   uint32_t offset, uint32_t type, double price,
                   uint32_t user_order_id) {
-    TraderCommand cmd{};
-    cmd.magic = TRADER_CMD_MAGIC;
-    cmd.type = CMD_NEW_ORDER;
-    strncpy(cmd.strategy_id, strategy_id_, sizeof(cmd.strategy_id));
-    cmd.order_req.user_order_id = user_order_id;
-    cmd.order_req.ticker_index = ticker_index;
-    cmd.order_req.volume = volume;
-    cmd.order_req.direction = direction;
-    cmd.order_req.offset = offset;
-    cmd.order_req.type = type;
-    cmd.order_req.price = price;
-    cmd.order_req.flags = flags_;
-    cmd.order_req.without_check = false;
-
-    cmd_pusher_.push(cmd);
-  }
-
-  void send_order(const std::string& ticker, int volume, uint32_t direction,
+    WireNewOrder req{};
+    req.account_id = account_id_;
+    req.user_order_id = user_order_id;
+    req.ticker_index = ticker_index;
+    req.direction = direction;
+    req.offset = offset;
+    req.order_type = type;
+    req.without_check = false;
+    req.flags = flags_;
+    req.volume = volume;
+    req.price = price;
+
+    push(req);
+  }
+
+  void send_order(std::string_view ticker, int volume, uint32_t direction,
                   uint32_t offset, uint32_t type, double price,
                   uint32_t user_order_id) {
     const Contract* contract;
     contract = ContractTable::get_by_ticker(ticker);
     assert(contract);
 
-    send_order(contract->index, volume, direction, offset, type, price,
+    send_order(contract->params.index, volume, direction, offset, type, price,
                user_order_id);
   }
 
   void cancel_order(uint64_t order_id) {
-    TraderCommand cmd{};
-    cmd.magic = TRADER_CMD_MAGIC;
-    cmd.type = CMD_CANCEL_ORDER;
-    cmd.cancel_req.order_id = order_id;
+    WireCancelOrder req{};
+    req.account_id = account_id_;
+    req.order_id = order_id;
+
+    push(req);
+  }
 
-    cmd_pusher_.push(cmd);
+  // volume为改单后的委托总量，包括已经成交的部分
+  void amend_order(uint64_t order_id, int volume, double price) {
+    WireAmendOrder req{};
+    req.account_id = account_id_;
+    req.order_id = order_id;
+    req.volume = volume;
+    req.price = price;
+
+    push(req);
   }
 
-  void cancel_for_ticker(const std::string& ticker) {
+  void cancel_for_ticker(std::string_view ticker) {
     auto contract = ContractTable::get_by_ticker(ticker);
     assert(contract);
-    TraderCommand cmd{};
-    cmd.magic = TRADER_CMD_MAGIC;
-    cmd.type = CMD_CANCEL_TICKER;
-    cmd.cancel_ticker_req.ticker_index = contract->index;
+    WireCancelTicker req{};
+    req.account_id = account_id_;
+    req.ticker_index = contract->params.index;
 
-    cmd_pusher_.push(cmd);
+    push(req);
   }
 
   void cancel_all() {
-    TraderCommand cmd{};
-    cmd.magic = TRADER_CMD_MAGIC;
-    cmd.type = CMD_CANCEL_ALL;
+    WireCancelAll req{};
+    req.account_id = account_id_;
+
+    push(req);
+  }
+
+  void subscribe(std::string_view ticker) {
+    auto contract = ContractTable::get_by_ticker(ticker);
+    assert(contract);
+    push(WireSubscribe{contract->params.index});
+  }
+
+  void unsubscribe(std::string_view ticker) {
+    auto contract = ContractTable::get_by_ticker(ticker);
+    assert(contract);
+    push(WireUnsubscribe{contract->params.index});
+  }
+
+  /*
+   * begin_batch与end_batch之间的指令合并到尽量少的消息中发送，消息写满时
+   * 提前发送。适用于一次性下多笔订单或撤单的场景，减少IPC的次数
+   */
+  void begin_batch() { is_batching_ = true; }
 
-    cmd_pusher_.push(cmd);
+  void end_batch() {
+    is_batching_ = false;
+    flush();
   }
 
  private:
-  StrategyIdType strategy_id_;
+  template <class Record>
+  void push(const Record& record) {
+    if (!writer_.append(record)) {
+      flush();
+      writer_.append(record);
+    }
+    if (!is_batching_) flush();
+  }
+
+  void flush() {
+    if (writer_.empty()) return;
+    cmd_pusher_.push(writer_.finish(strategy_id_, ++seq_), writer_.size());
+    writer_.reset();
+  }
+
+ private:
+  uint32_t strategy_id_{0};
   RedisTraderCmdPusher cmd_pusher_;
+  uint64_t account_id_{0};
   uint32_t flags_{0};
+
+  WireWriter writer_{WIRE_COMMANDS};
+  uint64_t seq_{0};
+  bool is_batching_{false};
 };
 
 }  // namespace ft
@@ -158,26 +158,27 @@ void Portfolio::update_buy_or_sell(uint32_t ticker_index, uint32_t direction,
     // spdlog::warn("[Portfolio::update_traded] correct close_pending");
   }
 
-  const auto* contract = ContractTable::get_by_index(ticker_index);
-  if (!contract) {
+  const auto* params = ContractTable::get_params(ticker_index);
+  if (!params) {
     spdlog::error("[Position::update_buy_or_sell] Contract not found");
     return;
   }
-  assert(contract->size > 0);
+  assert(params->size > 0);
 
   // 如果是开仓则计算当前持仓的成本价
   if (is_offset_open(offset) && pos_detail.holdings > 0) {
-    double cost = contract->size * (pos_detail.holdings - traded) *
+    double cost = params->size * (pos_detail.holdings - traded) *
                       pos_detail.cost_price +
-                  contract->size * traded * traded_price;
-    pos_detail.cost_price = cost / (pos_detail.holdings * contract->size);
+                  params->size * traded * traded_price;
+    pos_detail.cost_price = cost / (pos_detail.holdings * params->size);
   }
 
   if (pos_detail.holdings == 0) {
     pos_detail.cost_price = 0;
   }
 
-  if (redis_) redis_->set(contract->ticker, pos);
+  if (redis_)
+    redis_->set(ContractTable::get_by_index(ticker_index)->ticker, pos);
 }
 
 void Portfolio::update_purchase_or_redeem(uint32_t ticker_index,
@@ -239,23 +240,21 @@ void Portfolio::update_component_stock(uint32_t ticker_index, int traded,
 void Portfolio::update_float_pnl(uint32_t ticker_index, double last_price) {
   auto* pos = find(ticker_index);
   if (pos) {
-    const auto* contract = ContractTable::get_by_index(ticker_index);
-    if (!contract || contract->size <= 0) return;
+    const auto* params = ContractTable::get_params(ticker_index);
+    if (!params || params->size <= 0) return;
 
     auto& lp = pos->long_pos;
     auto& sp = pos->short_pos;
 
     if (lp.holdings > 0)
-      lp.float_pnl =
-          lp.holdings * contract->size * (last_price - lp.cost_price);
+      lp.float_pnl = lp.holdings * params->size * (last_price - lp.cost_price);
 
     if (sp.holdings > 0)
-      sp.float_pnl =
-          sp.holdings * contract->size * (sp.cost_price - last_price);
+      sp.float_pnl = sp.holdings * params->size * (sp.cost_price - last_price);
 
     if (redis_) {
       if (lp.holdings > 0 || sp.holdings > 0) {
-        redis_->set(contract->ticker, *pos);
+        redis_->set(ContractTable::get_by_index(ticker_index)->ticker, *pos);
       }
     }
   }
@@ -3,28 +3,41 @@
 #include <fmt/format.h>
 
 #include "common/order_sender.h"
+#include "core/wire_codec.h"
 #include "ipc/redis.h"
+#include "ipc/redis_md_helper.h"
 #include "risk_management/etf/etf_table.h"
 
 using namespace ft;
 
-const char* strategy_id = "etf_arb";
+const uint32_t strategy_id = 1001;
 
 int wait_for_receipt(RedisSession* redis, int volume) {
   for (;;) {
     auto reply = redis->get_sub_reply();
-    if (reply) {
-      if (strcmp(reply->element[1]->str, strategy_id) == 0) {
-        auto rsp =
-            reinterpret_cast<const OrderResponse*>(reply->element[2]->str);
-        auto contract = ContractTable::get_by_index(rsp->ticker_index);
-        spdlog::info(
-            "rsp: {} {} {}{} {}/{} traded:{}, price:{:.3f} completed:{}",
-            rsp->user_order_id, contract->ticker, direction_str(rsp->direction),
-            offset_str(rsp->offset), rsp->traded_volume, rsp->original_volume,
-            rsp->this_traded, rsp->this_traded_price, rsp->completed);
-        if (rsp->completed) return volume - rsp->traded_volume;
-      }
+    if (!reply) continue;
+
+    WireReader reader;
+    if (!reader.parse(reply->element[2]->str, reply->element[2]->len))
+      continue;
+
+    uint8_t type;
+    const char* body;
+    std::size_t length;
+    WireOrderResponse wire_rsp;
+    while (reader.next(&type, &body, &length)) {
+      if (type != WIRE_ORDER_RESPONSE ||
+          !WireReader::get(body, length, &wire_rsp))
+        continue;
+
+      auto rsp = to_order_response(wire_rsp);
+      auto contract = ContractTable::get_by_index(rsp.ticker_index);
+      spdlog::info(
+          "rsp: {} {} {}{} {}/{} traded:{}, price:{:.3f} completed:{}",
+          rsp.user_order_id, contract->ticker, direction_str(rsp.direction),
+          offset_str(rsp.offset), rsp.traded_volume, rsp.original_volume,
+          rsp.this_traded, rsp.this_traded_price, rsp.completed);
+      if (rsp.completed) return volume - rsp.traded_volume;
     }
   }
 }
@@ -42,7 +55,7 @@ int main() {
 
   sender.set_account(5319);
   sender.set_id(strategy_id);
-  redis.subscribe({strategy_id});
+  redis.subscribe({order_rsp_topic(strategy_id)});
 
   uint32_t user_order_id = 1;
   int left;
@@ -44,12 +44,13 @@ class EtfMonitor : public Strategy {
 
     auto& s = snapshots_[tick.ticker_index];
     s.last_price = tick.last_price;
-    if (tick.ticker_index == etf_contract_->index) s.iopv = tick.etf.iopv;
+    if (tick.ticker_index == etf_contract_->params.index)
+      s.iopv = tick.etf.iopv;
 
     if (snapshots_.size() == components_->size() + 1) {
       double value = etf_->cash_component + etf_->must_cash_substitution;
       for (const auto& [ticker_index, snapshot] : snapshots_) {
-        if (ticker_index == etf_contract_->index) continue;
+        if (ticker_index == etf_contract_->params.index) continue;
 
         auto& component = components_->find(ticker_index)->second;
         value += component.volume * snapshot.last_price;
@@ -57,7 +58,7 @@ class EtfMonitor : public Strategy {
 
       double value_L1 = value / etf_->unit;
       spdlog::info("L1:{:.4f}  L2:{:.4f}", value_L1,
-                   snapshots_[etf_contract_->index].last_price);
+                   snapshots_[etf_contract_->params.index].last_price);
     }
   }
 
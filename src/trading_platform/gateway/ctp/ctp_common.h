@@ -5,9 +5,7 @@
 
 #include <ThostFtdcUserApiDataType.h>
 
-#include <codecvt>
 #include <limits>
-#include <locale>
 #include <map>
 #include <string>
 #include <vector>
@@ -17,6 +15,7 @@
 #include "core/contract.h"
 #include "core/contract_table.h"
 #include "core/position.h"
+#include "utils/encoding.h"
 
 namespace ft {
 
@@ -35,23 +34,24 @@ inline bool is_error_rsp(CThostFtdcRspInfoField* rsp_info) {
   return false;
 }
 
-inline std::string gb2312_to_utf8(const std::string& gb2312) {
-  static const std::locale loc("zh_CN.GB2312");
+// 解析CTP定长字段中的整数（如OrderRef、OrderSysID），允许前导空格，
+// 不分配内存。字段中没有数字时返回false
+template <std::size_t N>
+inline bool parse_fixed_int(const char (&field)[N], int64_t* value) {
+  std::size_t i = 0;
+  while (i < N && field[i] == ' ') ++i;
 
-  std::vector<wchar_t> wstr(gb2312.size());
-  wchar_t* wstr_end = nullptr;
-  const char* gb_end = nullptr;
-  mbstate_t state{};
-  int res = std::use_facet<std::codecvt<wchar_t, char, mbstate_t>>(loc).in(
-      state, gb2312.data(), gb2312.data() + gb2312.size(), gb_end, wstr.data(),
-      wstr.data() + wstr.size(), wstr_end);
+  bool negative = i < N && field[i] == '-';
+  if (negative) ++i;
 
-  if (res == std::codecvt_base::ok) {
-    std::wstring_convert<std::codecvt_utf8<wchar_t>> cutf8;
-    return cutf8.to_bytes(std::wstring(wstr.data(), wstr_end));
-  }
+  std::size_t begin = i;
+  int64_t result = 0;
+  for (; i < N && field[i] >= '0' && field[i] <= '9'; ++i)
+    result = result * 10 + (field[i] - '0');
 
-  return "";
+  if (i == begin) return false;
+  *value = negative ? -result : result;
+  return true;
 }
 
 template <class PriceType>
@@ -54,8 +54,9 @@ bool CtpGateway::login(TradingEngineInterface *engine, const Config &config) {
 }
 
 void CtpGateway::logout() {
-  trade_api_->logout();
-  quote_api_->logout();
+  // 只登录了交易或者行情时另一个API为空
+  if (trade_api_) trade_api_->logout();
+  if (quote_api_) quote_api_->logout();
 }
 
 bool CtpGateway::send_order(const OrderReq& order) {
@@ -66,6 +67,14 @@ bool CtpGateway::cancel_order(uint64_t order_id) {
   return trade_api_->cancel_order(order_id);
 }
 
+bool CtpGateway::subscribe(const std::vector<std::string> &tickers) {
+  return quote_api_ && quote_api_->subscribe(tickers);
+}
+
+bool CtpGateway::unsubscribe(const std::vector<std::string> &tickers) {
+  return quote_api_ && quote_api_->unsubscribe(tickers);
+}
+
 bool CtpGateway::query_contract(const std::string &ticker,
                                 const std::string &exchange) {
   return trade_api_->query_contract(ticker, exchange);
@@ -87,4 +96,8 @@ bool CtpGateway::query_margin_rate(const std::string &ticker) {
   return trade_api_->query_margin_rate(ticker);
 }
 
+bool CtpGateway::query_batch(uint32_t types) {
+  return trade_api_->query_batch(types);
+}
+
 }  // namespace ft
@@ -8,6 +8,7 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "gateway/ctp/ctp_common.h"
 #include "gateway/ctp/ctp_quote_api.h"
@@ -30,6 +31,10 @@ class CtpGateway : public Gateway {
 
   bool cancel_order(uint64_t order_id) override;
 
+  bool subscribe(const std::vector<std::string> &tickers) override;
+
+  bool unsubscribe(const std::vector<std::string> &tickers) override;
+
   bool query_contract(const std::string &ticker,
                       const std::string &exchange) override;
 
@@ -45,6 +50,8 @@ class CtpGateway : public Gateway {
 
   bool query_margin_rate(const std::string &ticker) override;
 
+  bool query_batch(uint32_t types) override;
+
  private:
   std::unique_ptr<CtpTradeApi> trade_api_;
   std::unique_ptr<CtpQuoteApi> quote_api_;
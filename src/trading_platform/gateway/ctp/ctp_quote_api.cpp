@@ -4,6 +4,7 @@
 
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
 #include <utility>
 
 namespace ft {
@@ -11,8 +12,11 @@ namespace ft {
 CtpQuoteApi::CtpQuoteApi(TradingEngineInterface *engine) : engine_(engine) {}
 
 CtpQuoteApi::~CtpQuoteApi() {
-  is_error_ = true;
+  has_logged_in_ = false;
+  requests_.fail_all();
+  reconnector_.stop();
   logout();
+  requests_.fail_all();
 }
 
 bool CtpQuoteApi::login(const Config &config) {
@@ -31,42 +35,59 @@ bool CtpQuoteApi::login(const Config &config) {
   broker_id_ = config.broker_id;
   investor_id_ = config.investor_id;
   passwd_ = config.password;
+  timeout_ = RequestTracker::Timeout(config.request_timeout_ms);
 
+  requests_.add(kConnectReqId);
   quote_api_->RegisterSpi(this);
   quote_api_->RegisterFront(const_cast<char *>(server_addr_.c_str()));
   quote_api_->Init();
 
-  for (;;) {
-    if (is_error_) return false;
-
-    if (is_connected_) break;
+  if (!requests_.wait(kConnectReqId, timeout_)) {
+    spdlog::error("[CtpQuoteApi::login] Failed. Cannot connect to {}",
+                  server_addr_);
+    return false;
   }
 
+  sub_list_ = config.subscription_list;
+  if (!login_and_subscribe()) return false;
+
+  has_logged_in_ = true;
+  return true;
+}
+
+bool CtpQuoteApi::login_and_subscribe() {
   CThostFtdcReqUserLoginField login_req{};
   strncpy(login_req.BrokerID, broker_id_.c_str(), sizeof(login_req.BrokerID));
   strncpy(login_req.UserID, investor_id_.c_str(), sizeof(login_req.UserID));
   strncpy(login_req.Password, passwd_.c_str(), sizeof(login_req.Password));
-  if (quote_api_->ReqUserLogin(&login_req, next_req_id()) != 0) {
-    spdlog::error("[CtpQuoteApi::login] Invalid user-login field");
+  int req_id = next_req_id();
+  requests_.add(req_id);
+  if (quote_api_->ReqUserLogin(&login_req, req_id) != 0) {
+    spdlog::error("[CtpQuoteApi::login_and_subscribe] Failed to ReqUserLogin");
+    requests_.remove(req_id);
     return false;
   }
 
-  for (;;) {
-    if (is_error_) return false;
-
-    if (is_logon_) break;
+  if (!requests_.wait(req_id, timeout_)) {
+    spdlog::error("[CtpQuoteApi::login_and_subscribe] Failed to login");
+    return false;
   }
+  is_logon_ = true;
 
-  std::vector<char *> sub_list;
-  sub_list_ = config.subscription_list;
+  // 断线后柜台上的订阅全部失效，每次登录后都需要重新订阅。is_logon_先于
+  // 复制sub_list_设置，保证同时新增的订阅不会遗漏
+  std::unique_lock<std::mutex> lock(sub_mutex_);
+  auto tickers = sub_list_;
+  lock.unlock();
 
-  for (const auto &p : sub_list_)
+  std::vector<char *> sub_list;
+  for (const auto &p : tickers)
     sub_list.emplace_back(const_cast<char *>(p.c_str()));
 
   if (sub_list.size() > 0) {
     if (quote_api_->SubscribeMarketData(sub_list.data(), sub_list.size()) !=
         0) {
-      spdlog::error("[CtpQuoteApi::login] Failed to subscribe");
+      spdlog::error("[CtpQuoteApi::login_and_subscribe] Failed to subscribe");
       return false;
     }
   }
@@ -74,26 +95,73 @@ bool CtpQuoteApi::login(const Config &config) {
   return true;
 }
 
+bool CtpQuoteApi::subscribe(const std::vector<std::string> &tickers) {
+  std::vector<char *> sub_list;
+  std::unique_lock<std::mutex> lock(sub_mutex_);
+  for (const auto &ticker : tickers) {
+    if (std::find(sub_list_.begin(), sub_list_.end(), ticker) ==
+        sub_list_.end())
+      sub_list_.emplace_back(ticker);
+    sub_list.emplace_back(const_cast<char *>(ticker.c_str()));
+  }
+  lock.unlock();
+
+  if (!is_logon_ || sub_list.empty()) return true;
+  if (quote_api_->SubscribeMarketData(sub_list.data(), sub_list.size()) != 0) {
+    spdlog::error("[CtpQuoteApi::subscribe] Failed to subscribe");
+    return false;
+  }
+  return true;
+}
+
+bool CtpQuoteApi::unsubscribe(const std::vector<std::string> &tickers) {
+  std::vector<char *> unsub_list;
+  std::unique_lock<std::mutex> lock(sub_mutex_);
+  for (const auto &ticker : tickers) {
+    auto iter = std::find(sub_list_.begin(), sub_list_.end(), ticker);
+    if (iter != sub_list_.end()) sub_list_.erase(iter);
+    unsub_list.emplace_back(const_cast<char *>(ticker.c_str()));
+  }
+  lock.unlock();
+
+  if (!is_logon_ || unsub_list.empty()) return true;
+  if (quote_api_->UnSubscribeMarketData(unsub_list.data(),
+                                        unsub_list.size()) != 0) {
+    spdlog::error("[CtpQuoteApi::unsubscribe] Failed to unsubscribe");
+    return false;
+  }
+  return true;
+}
+
 void CtpQuoteApi::logout() {
   if (is_logon_) {
     CThostFtdcUserLogoutField req{};
     strncpy(req.BrokerID, broker_id_.c_str(), sizeof(req.BrokerID));
     strncpy(req.UserID, investor_id_.c_str(), sizeof(req.UserID));
-    if (quote_api_->ReqUserLogout(&req, next_req_id()) != 0) return;
-
-    while (is_logon_) continue;
+    int req_id = next_req_id();
+    requests_.add(req_id);
+    if (quote_api_->ReqUserLogout(&req, req_id) != 0 ||
+        !requests_.wait(req_id, timeout_))
+      spdlog::warn("[CtpQuoteApi::logout] No response to ReqUserLogout");
+    is_logon_ = false;
   }
 }
 
 void CtpQuoteApi::OnFrontConnected() {
-  is_connected_ = true;
+  requests_.done(kConnectReqId);
   spdlog::debug("[CtpQuoteApi::OnFrontConnectedMD] Connected");
+
+  // CTP自动重连前置后需要重新登录并订阅
+  if (has_logged_in_)
+    reconnector_.start([this] { return login_and_subscribe(); });
 }
 
 void CtpQuoteApi::OnFrontDisconnected(int reason) {
-  is_error_ = true;
-  is_connected_ = false;
-  spdlog::error("[CtpQuoteApi::OnFrontDisconnectedMD] Disconnected");
+  is_logon_ = false;
+  requests_.fail_all();
+  spdlog::error(
+      "[CtpQuoteApi::OnFrontDisconnectedMD] Disconnected. Reason: {:#x}",
+      reason);
 }
 
 void CtpQuoteApi::OnHeartBeatWarning(int time_lapse) {
@@ -110,13 +178,13 @@ void CtpQuoteApi::OnRspUserLogin(CThostFtdcRspUserLoginField *login_rsp,
   if (is_error_rsp(rsp_info)) {
     spdlog::error("[CtpQuoteApi::OnRspUserLogin] Failed. ErrorMsg: {}",
                   gb2312_to_utf8(rsp_info->ErrorMsg));
-    is_error_ = true;
+    requests_.error(req_id);
     return;
   }
 
   spdlog::debug("[CtpQuoteApi::OnRspUserLogin] Success. Login as {}",
                 investor_id_);
-  is_logon_ = true;
+  requests_.done(req_id);
 }
 
 void CtpQuoteApi::OnRspUserLogout(CThostFtdcUserLogoutField *logout_rsp,
@@ -125,14 +193,14 @@ void CtpQuoteApi::OnRspUserLogout(CThostFtdcUserLogoutField *logout_rsp,
   spdlog::debug(
       "[CtpQuoteApi::OnRspUserLogout] Success. Broker ID: {}, Investor ID: {}",
       logout_rsp->BrokerID, logout_rsp->UserID);
-  is_logon_ = false;
+  requests_.done(req_id);
 }
 
 void CtpQuoteApi::OnRspError(CThostFtdcRspInfoField *rsp_info, int req_id,
                              bool is_last) {
   spdlog::debug("[CtpQuoteApi::OnRspError] ErrorMsg: {}",
                 gb2312_to_utf8(rsp_info->ErrorMsg));
-  is_logon_ = false;
+  requests_.error(req_id);
 }
 
 void CtpQuoteApi::OnRspSubMarketData(
@@ -160,7 +228,16 @@ void CtpQuoteApi::OnRspSubMarketData(
 
 void CtpQuoteApi::OnRspUnSubMarketData(
     CThostFtdcSpecificInstrumentField *instrument,
-    CThostFtdcRspInfoField *rsp_info, int req_id, bool is_last) {}
+    CThostFtdcRspInfoField *rsp_info, int req_id, bool is_last) {
+  if (is_error_rsp(rsp_info) || !instrument) {
+    spdlog::error("[CtpQuoteApi::OnRspUnSubMarketData] Failed. Error Msg: {}",
+                  gb2312_to_utf8(rsp_info->ErrorMsg));
+    return;
+  }
+
+  spdlog::debug("[CtpQuoteApi::OnRspUnSubMarketData] Success. Ticker: {}",
+                instrument->InstrumentID);
+}
 
 void CtpQuoteApi::OnRspSubForQuoteRsp(
     CThostFtdcSpecificInstrumentField *instrument,
@@ -187,7 +264,7 @@ void CtpQuoteApi::OnRtnDepthMarketData(CThostFtdcDepthMarketDataField *md) {
   }
 
   TickData tick{};
-  tick.ticker_index = contract->index;
+  tick.ticker_index = contract->params.index;
 
   struct tm _tm;
   strptime(md->UpdateTime, "%H:%M:%S", &_tm);
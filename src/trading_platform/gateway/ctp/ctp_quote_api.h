@@ -8,6 +8,7 @@
 #include <atomic>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -15,6 +16,8 @@
 #include "core/tick_data.h"
 #include "gateway/ctp/ctp_common.h"
 #include "interface/trading_engine_interface.h"
+#include "utils/reconnector.h"
+#include "utils/request_tracker.h"
 
 namespace ft {
 
@@ -28,6 +31,11 @@ class CtpQuoteApi : public CThostFtdcMdSpi {
 
   void logout();
 
+  // 运行时增减订阅。未登录时只更新sub_list_，登录后统一订阅
+  bool subscribe(const std::vector<std::string> &tickers);
+
+  bool unsubscribe(const std::vector<std::string> &tickers);
+
   void OnFrontConnected() override;
 
   void OnFrontDisconnected(int reason) override;
@@ -68,6 +76,9 @@ class CtpQuoteApi : public CThostFtdcMdSpi {
  private:
   int next_req_id() { return next_req_id_++; }
 
+  // 登录并订阅sub_list_中的合约，断线重连后在reconnector_的线程中重新执行
+  bool login_and_subscribe();
+
  private:
   TradingEngineInterface *engine_;
   std::unique_ptr<CThostFtdcMdApi, CtpApiDeleter> quote_api_;
@@ -77,13 +88,20 @@ class CtpQuoteApi : public CThostFtdcMdSpi {
   std::string investor_id_;
   std::string passwd_;
 
-  std::atomic<int> next_req_id_ = 0;
+  // 连接前置没有对应的请求，使用保留的req_id跟踪，其他请求从1开始编号
+  static constexpr int kConnectReqId = 0;
+  std::atomic<int> next_req_id_ = 1;
 
-  std::atomic<bool> is_error_ = false;
-  std::atomic<bool> is_connected_ = false;
+  RequestTracker requests_;
+  RequestTracker::Timeout timeout_{10000};
   std::atomic<bool> is_logon_ = false;
+  std::atomic<bool> has_logged_in_ = false;  // 首次登录成功后才需要重连
 
+  std::mutex sub_mutex_;  // 保护sub_list_，重连线程会读取
   std::vector<std::string> sub_list_;
+
+  // 最后声明，析构时最先停止重连线程
+  Reconnector reconnector_;
 };
 
 }  // namespace ft
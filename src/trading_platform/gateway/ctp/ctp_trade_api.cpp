@@ -5,75 +5,145 @@
 #include <ThostFtdcTraderApi.h>
 #include <spdlog/spdlog.h>
 
+#include <thread>
+
 #include "utils/misc.h"
 
 namespace ft {
 
 CtpTradeApi::CtpTradeApi(TradingEngineInterface *engine)
-    : engine_(engine), trade_api_(CThostFtdcTraderApi::CreateFtdcTraderApi()) {
+    : engine_(engine),
+      trade_api_(CThostFtdcTraderApi::CreateFtdcTraderApi()),
+      order_slots_(kOrderSlotMask + 1) {
   if (!trade_api_) {
     spdlog::error("[CtpTradeApi::CtpTradeApi] Failed to CreateFtdcTraderApi");
     exit(-1);
   }
 }
 
+template <class ReqFunc>
+int CtpTradeApi::send_request(const char *name, ReqFunc &&req_func) {
+  int req_id = next_req_id();
+  requests_.add(req_id);
+
+  auto deadline = std::chrono::steady_clock::now() + timeout_;
+  for (;;) {
+    int ret = req_func(req_id);
+    if (ret == 0) return req_id;
+
+    if ((ret != -2 && ret != -3) ||
+        std::chrono::steady_clock::now() >= deadline) {
+      spdlog::error("[CtpTradeApi::send_request] Failed to call {}. Ret: {}",
+                    name, ret);
+      requests_.remove(req_id);
+      return -1;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  }
+}
+
 CtpTradeApi::~CtpTradeApi() {
-  error();
+  // 先唤醒并停止可能正在恢复会话的重连线程
+  has_logged_in_ = false;
+  requests_.fail_all();
+  reconnector_.stop();
   logout();
+  requests_.fail_all();
 }
 
 bool CtpTradeApi::login(const Config &config) {
+  config_ = config;
   front_addr_ = config.trade_server_address;
   broker_id_ = config.broker_id;
   investor_id_ = config.investor_id;
+  timeout_ = RequestTracker::Timeout(config.request_timeout_ms);
+  init_order_templates();
 
+  requests_.add(kConnectReqId);
   trade_api_->SubscribePrivateTopic(THOST_TERT_QUICK);
   trade_api_->RegisterSpi(this);
   trade_api_->RegisterFront(
       const_cast<char *>(config.trade_server_address.c_str()));
   trade_api_->Init();
-  while (!is_connected_) {
-    if (is_error_) {
-      spdlog::error("[CtpTradeApi::login] Failed. Cannot connect to {}",
-                    front_addr_);
+  if (!wait(kConnectReqId)) {
+    spdlog::error("[CtpTradeApi::login] Failed. Cannot connect to {}",
+                  front_addr_);
+    return false;
+  }
+
+  if (!login_session()) return false;
+
+  if (config.cancel_outstanding_orders_on_startup) {
+    spdlog::debug("[CtpTradeApi::login] Cancel outstanding orders on startup");
+
+    CThostFtdcQryOrderField req{};
+    strncpy(req.BrokerID, broker_id_.c_str(), sizeof(req.BrokerID));
+    strncpy(req.InvestorID, investor_id_.c_str(), sizeof(req.InvestorID));
+
+    startup_canceling_ = true;
+    int req_id = send_request("ReqQryOrder", [&](int req_id) {
+      return trade_api_->ReqQryOrder(&req, req_id);
+    });
+    if (!wait(req_id)) {
+      startup_canceling_ = false;
+      spdlog::error("[CtpTradeApi::login] Failed to query orders");
       return false;
     }
+
+    // 撤单请求在查询回报中发出，查询完成后所有撤单都已登记
+    std::vector<int> cancel_req_ids;
+    {
+      std::unique_lock<std::mutex> lock(startup_cancel_mutex_);
+      cancel_req_ids.swap(startup_cancel_req_ids_);
+    }
+    if (!requests_.wait_all(cancel_req_ids, timeout_))
+      spdlog::warn(
+          "[CtpTradeApi::login] Not all outstanding orders were canceled");
+
+    startup_canceling_ = false;
+    std::unique_lock<std::mutex> lock(startup_cancel_mutex_);
+    startup_cancels_.clear();
   }
 
-  if (!config.auth_code.empty()) {
+  has_logged_in_ = true;
+  is_logon_ = true;
+  return true;
+}
+
+bool CtpTradeApi::login_session() {
+  if (!config_.auth_code.empty()) {
     CThostFtdcReqAuthenticateField auth_req{};
-    strncpy(auth_req.BrokerID, config.broker_id.c_str(),
+    strncpy(auth_req.BrokerID, config_.broker_id.c_str(),
             sizeof(auth_req.BrokerID));
-    strncpy(auth_req.UserID, config.investor_id.c_str(),
+    strncpy(auth_req.UserID, config_.investor_id.c_str(),
             sizeof(auth_req.UserID));
-    strncpy(auth_req.AuthCode, config.auth_code.c_str(),
+    strncpy(auth_req.AuthCode, config_.auth_code.c_str(),
             sizeof(auth_req.AuthCode));
-    strncpy(auth_req.AppID, config.app_id.c_str(), sizeof(auth_req.AppID));
+    strncpy(auth_req.AppID, config_.app_id.c_str(), sizeof(auth_req.AppID));
 
-    if (trade_api_->ReqAuthenticate(&auth_req, next_req_id()) != 0) {
-      spdlog::error("[CtpTradeApi::login] Failed. Failed to ReqAuthenticate");
-      return false;
-    }
-    if (!wait_sync()) {
-      spdlog::error("[CtpTradeApi::login] Failed. Failed to authenticate");
+    int req_id = send_request("ReqAuthenticate", [&](int req_id) {
+      return trade_api_->ReqAuthenticate(&auth_req, req_id);
+    });
+    if (!wait(req_id)) {
+      spdlog::error(
+          "[CtpTradeApi::login_session] Failed. Failed to authenticate");
       return false;
     }
   }
 
   CThostFtdcReqUserLoginField login_req{};
-  strncpy(login_req.BrokerID, config.broker_id.c_str(),
+  strncpy(login_req.BrokerID, config_.broker_id.c_str(),
           sizeof(login_req.BrokerID));
-  strncpy(login_req.UserID, config.investor_id.c_str(),
+  strncpy(login_req.UserID, config_.investor_id.c_str(),
           sizeof(login_req.UserID));
-  strncpy(login_req.Password, config.password.c_str(),
+  strncpy(login_req.Password, config_.password.c_str(),
           sizeof(login_req.Password));
 
-  if (trade_api_->ReqUserLogin(&login_req, next_req_id()) != 0) {
-    spdlog::error("[CtpTradeApi::login] Failed. Failed to ReqUserLogin");
-    return false;
-  }
-  if (!wait_sync()) {
-    spdlog::error("[CtpTradeApi::login] Failed. Failed to login");
+  int req_id = send_request("ReqUserLogin", [&](int req_id) {
+    return trade_api_->ReqUserLogin(&login_req, req_id);
+  });
+  if (!wait(req_id)) {
+    spdlog::error("[CtpTradeApi::login_session] Failed. Failed to login");
     return false;
   }
 
@@ -83,13 +153,12 @@ bool CtpTradeApi::login(const Config &config) {
   strncpy(settlement_req.InvestorID, investor_id_.c_str(),
           sizeof(settlement_req.InvestorID));
 
-  if (trade_api_->ReqQrySettlementInfo(&settlement_req, next_req_id()) != 0) {
+  req_id = send_request("ReqQrySettlementInfo", [&](int req_id) {
+    return trade_api_->ReqQrySettlementInfo(&settlement_req, req_id);
+  });
+  if (!wait(req_id)) {
     spdlog::error(
-        "[CtpTradeApi::login] Failed. Failed to ReqQrySettlementInfo");
-    return false;
-  }
-  if (!wait_sync()) {
-    spdlog::error("[CtpTradeApi::login] Failed. Failed to query settlement");
+        "[CtpTradeApi::login_session] Failed. Failed to query settlement");
     return false;
   }
 
@@ -99,38 +168,151 @@ bool CtpTradeApi::login(const Config &config) {
   strncpy(confirm_req.InvestorID, investor_id_.c_str(),
           sizeof(confirm_req.InvestorID));
 
-  if (trade_api_->ReqSettlementInfoConfirm(&confirm_req, next_req_id()) != 0) {
+  req_id = send_request("ReqSettlementInfoConfirm", [&](int req_id) {
+    return trade_api_->ReqSettlementInfoConfirm(&confirm_req, req_id);
+  });
+  if (!wait(req_id)) {
     spdlog::error(
-        "[CtpTradeApi::login] Failed. Failed to ReqSettlementInfoConfirm");
+        "[CtpTradeApi::login_session] Failed. Failed to confirm settlement");
     return false;
   }
-  if (!wait_sync()) {
-    spdlog::error(
-        "[CtpTradeApi::login] Failed. Failed to confirm settlement info");
+
+  return true;
+}
+
+bool CtpTradeApi::resume_session() {
+  spdlog::info("[CtpTradeApi::resume_session] Reconnected to {}", front_addr_);
+  if (!login_session() || !resync_orders()) {
+    spdlog::error("[CtpTradeApi::resume_session] Failed. Retry later");
     return false;
   }
 
-  if (config.cancel_outstanding_orders_on_startup) {
-    spdlog::debug("[CtpTradeApi::login] Cancel outstanding orders on startup");
+  is_logon_ = true;
+  spdlog::info("[CtpTradeApi::resume_session] Success. Session resumed");
+  return true;
+}
 
-    CThostFtdcQryOrderField req{};
-    strncpy(req.BrokerID, broker_id_.c_str(), sizeof(req.BrokerID));
-    strncpy(req.InvestorID, investor_id_.c_str(), sizeof(req.InvestorID));
+bool CtpTradeApi::resync_orders() {
+  {
+    std::unique_lock<std::mutex> lock(resync_mutex_);
+    resync_trades_.clear();
+  }
 
-    if (trade_api_->ReqQryOrder(&req, next_req_id()) != 0) {
-      spdlog::error("[CtpTradeApi::login] Failed. Failed to ReqQryOrder");
-      return false;
-    }
-    if (!wait_sync()) {
-      spdlog::error("[CtpTradeApi::login] Failed to query orders");
-      return false;
-    }
+  // 先查成交再查订单，订单查询的回报中才能拿到该订单完整的成交记录
+  CThostFtdcQryTradeField trade_req{};
+  strncpy(trade_req.BrokerID, broker_id_.c_str(), sizeof(trade_req.BrokerID));
+  strncpy(trade_req.InvestorID, investor_id_.c_str(),
+          sizeof(trade_req.InvestorID));
+
+  int req_id = send_request("ReqQryTrade", [&](int req_id) {
+    resync_trade_req_id_ = req_id;
+    return trade_api_->ReqQryTrade(&trade_req, req_id);
+  });
+  if (!wait(req_id)) {
+    spdlog::error("[CtpTradeApi::resync_orders] Failed to query trades");
+    return false;
+  }
 
-    std::this_thread::sleep_for(std::chrono::seconds(1));
+  CThostFtdcQryOrderField order_req{};
+  strncpy(order_req.BrokerID, broker_id_.c_str(), sizeof(order_req.BrokerID));
+  strncpy(order_req.InvestorID, investor_id_.c_str(),
+          sizeof(order_req.InvestorID));
+
+  req_id = send_request("ReqQryOrder", [&](int req_id) {
+    resync_order_req_id_ = req_id;
+    return trade_api_->ReqQryOrder(&order_req, req_id);
+  });
+  bool ok = wait(req_id);
+  if (!ok) spdlog::error("[CtpTradeApi::resync_orders] Failed to query orders");
+
+  {
+    std::unique_lock<std::mutex> lock(resync_mutex_);
+    resync_trades_.clear();
   }
 
-  is_logon_ = true;
-  return true;
+  // 查询完整返回后才能确定哪些订单没有到达柜台
+  if (ok) engine_->on_order_sync_finished();
+  return ok;
+}
+
+void CtpTradeApi::on_resync_trade(const CThostFtdcTradeField &trade) {
+  if (!is_my_investor(trade.InvestorID)) return;
+
+  int64_t order_ref;
+  int64_t order_sys_id;
+  if (!parse_fixed_int(trade.OrderRef, &order_ref) ||
+      !parse_fixed_int(trade.OrderSysID, &order_sys_id))
+    return;
+
+  OrderTradedRsp rsp{};
+  rsp.engine_order_id = get_engine_order_id(order_ref);
+  uint32_t ticker_index =
+      get_ticker_index(rsp.engine_order_id, trade.InstrumentID);
+  if (ticker_index == 0) return;
+
+  rsp.order_id = get_order_id(ticker_index, order_sys_id);
+  rsp.volume = trade.Volume;
+  rsp.price = trade.Price;
+  rsp.trade_type = TradeType::SECONDARY_MARKET;
+
+  std::unique_lock<std::mutex> lock(resync_mutex_);
+  resync_trades_[rsp.order_id].emplace_back(rsp);
+}
+
+void CtpTradeApi::on_resync_order(const CThostFtdcOrderField &order) {
+  if (!is_my_investor(order.InvestorID) ||
+      !is_my_session(order.FrontID, order.SessionID))
+    return;
+
+  int64_t order_ref;
+  if (!parse_fixed_int(order.OrderRef, &order_ref)) return;
+
+  OrderSyncRsp rsp{};
+  rsp.engine_order_id = get_engine_order_id(order_ref);
+  rsp.reason = {order.StatusMsg, true};
+  if (order.OrderSubmitStatus == THOST_FTDC_OSS_InsertRejected) {
+    rsp.rejected = true;
+    engine_->on_order_synced(&rsp);
+    return;
+  }
+
+  // 还没有到达交易所的订单，之后的回报会正常推送，这里只告知引擎柜台
+  // 已经收到该订单
+  int64_t order_sys_id = 0;
+  uint32_t ticker_index =
+      get_ticker_index(rsp.engine_order_id, order.InstrumentID);
+  if (ticker_index == 0 || !parse_fixed_int(order.OrderSysID, &order_sys_id)) {
+    engine_->on_order_synced(&rsp);
+    return;
+  }
+
+  rsp.order_id = get_order_id(ticker_index, order_sys_id);
+  rsp.accepted = true;
+  if (order.OrderStatus == THOST_FTDC_OST_PartTradedNotQueueing ||
+      order.OrderStatus == THOST_FTDC_OST_Canceled)
+    rsp.canceled_volume = order.VolumeTotalOriginal - order.VolumeTraded;
+
+  std::unique_lock<std::mutex> lock(resync_mutex_);
+  auto iter = resync_trades_.find(rsp.order_id);
+  if (iter != resync_trades_.end()) {
+    rsp.trades = iter->second.data();
+    rsp.num_trades = static_cast<int>(iter->second.size());
+  }
+  engine_->on_order_synced(&rsp);
+}
+
+bool CtpTradeApi::is_my_session(int front_id, int session_id) const {
+  for (auto &[my_front_id, my_session_id] : sessions_) {
+    if (front_id == my_front_id && session_id == my_session_id) return true;
+  }
+  return false;
+}
+
+void CtpTradeApi::init_offline(const Config &config, int order_ref_base) {
+  broker_id_ = config.broker_id;
+  investor_id_ = config.investor_id;
+  order_ref_base_ = order_ref_base;
+  init_order_templates();
 }
 
 void CtpTradeApi::logout() {
@@ -138,23 +320,34 @@ void CtpTradeApi::logout() {
     CThostFtdcUserLogoutField req{};
     strncpy(req.BrokerID, broker_id_.c_str(), sizeof(req.BrokerID));
     strncpy(req.UserID, investor_id_.c_str(), sizeof(req.UserID));
-    if (trade_api_->ReqUserLogout(&req, next_req_id()) != 0) return;
-
-    while (is_logon_) continue;
+    int req_id = send_request("ReqUserLogout", [&](int req_id) {
+      return trade_api_->ReqUserLogout(&req, req_id);
+    });
+    if (!wait(req_id))
+      spdlog::warn("[CtpTradeApi::logout] No response to ReqUserLogout");
+    is_logon_ = false;
   }
 }
 
 void CtpTradeApi::OnFrontConnected() {
   spdlog::debug("[CtpTradeApi::OnFrontConnected] Success. Connected to {}",
                 front_addr_);
-  is_error_ = false;
-  is_connected_ = true;
+  requests_.done(kConnectReqId);
+
+  // 首次连接由login完成登录，之后的重连不能阻塞回调线程，在后台恢复会话
+  if (has_logged_in_)
+    reconnector_.start([this] { return resume_session(); });
 }
 
 void CtpTradeApi::OnFrontDisconnected(int reason) {
-  spdlog::error("[CtpTradeApi::OnFrontDisconnected] . Disconnected from {}",
-                front_addr_);
-  exit(-1);
+  spdlog::error(
+      "[CtpTradeApi::OnFrontDisconnected] Disconnected from {}. Reason: {:#x}",
+      front_addr_, reason);
+
+  // 等待中的请求不会再有回报，CTP会自动重连前置
+  is_logon_ = false;
+  requests_.fail_all();
+  engine_->on_disconnected();
 }
 
 void CtpTradeApi::OnHeartBeatWarning(int time_lapse) {
@@ -162,6 +355,13 @@ void CtpTradeApi::OnHeartBeatWarning(int time_lapse) {
       "[CtpTradeApi::OnHeartBeatWarning] No packet received for some time");
 }
 
+void CtpTradeApi::OnRspError(CThostFtdcRspInfoField *rsp_info, int req_id,
+                             bool is_last) {
+  spdlog::error("[CtpTradeApi::OnRspError] ReqID: {}, ErrorMsg: {}", req_id,
+                rsp_info ? gb2312_to_utf8(rsp_info->ErrorMsg) : "");
+  requests_.error(req_id);
+}
+
 void CtpTradeApi::OnRspAuthenticate(
     CThostFtdcRspAuthenticateField *rsp_authenticate_field,
     CThostFtdcRspInfoField *rsp_info, int req_id, bool is_last) {
@@ -170,13 +370,13 @@ void CtpTradeApi::OnRspAuthenticate(
   if (is_error_rsp(rsp_info)) {
     spdlog::error("[CtpTradeApi::OnRspAuthenticate] Failed. ErrorMsg: {}",
                   gb2312_to_utf8(rsp_info->ErrorMsg));
-    error();
+    requests_.error(req_id);
     return;
   }
 
   spdlog::debug("[CTP::OnRspAuthenticate] Success. Investor ID: {}",
                 investor_id_);
-  done();
+  requests_.done(req_id);
 }
 
 void CtpTradeApi::OnRspUserLogin(CThostFtdcRspUserLoginField *rsp_user_login,
@@ -187,20 +387,24 @@ void CtpTradeApi::OnRspUserLogin(CThostFtdcRspUserLoginField *rsp_user_login,
   if (is_error_rsp(rsp_info)) {
     spdlog::error("[CtpTradeApi::OnRspUserLogin] Failed. ErrorMsg: {}",
                   gb2312_to_utf8(rsp_info->ErrorMsg));
-    error();
+    requests_.error(req_id);
     return;
   }
 
   front_id_ = rsp_user_login->FrontID;
   session_id_ = rsp_user_login->SessionID;
+  sessions_.emplace_back(front_id_, session_id_);
   int max_order_ref = std::stoi(rsp_user_login->MaxOrderRef);
-  order_ref_base_ = max_order_ref + 1;
+
+  // 重连后沿用原来的OrderRef编号，保证OrderRef与engine_order_id的对应关系
+  // 不变，新会话中的OrderRef仍然是递增的
+  if (!has_logged_in_) order_ref_base_ = max_order_ref + 1;
 
   spdlog::debug(
       "[CtpTradeApi::OnRspUserLogin] Success. Login as {}. "
       "Front ID: {}, Session ID: {}, Max OrderRef: {}",
       investor_id_, front_id_, session_id_, max_order_ref);
-  done();
+  requests_.done(req_id);
 }
 
 void CtpTradeApi::OnRspQrySettlementInfo(
@@ -211,12 +415,12 @@ void CtpTradeApi::OnRspQrySettlementInfo(
   if (is_error_rsp(rsp_info)) {
     spdlog::error("[CTP::OnRspQrySettlementInfo] Failed. ErrorMsg: {}",
                   gb2312_to_utf8(rsp_info->ErrorMsg));
-    error();
+    requests_.error(req_id);
     return;
   }
 
   spdlog::debug("[CTP::OnRspQrySettlementInfo] Success");
-  done();
+  requests_.done(req_id);
 }
 
 void CtpTradeApi::OnRspSettlementInfoConfirm(
@@ -228,14 +432,14 @@ void CtpTradeApi::OnRspSettlementInfoConfirm(
     spdlog::debug(
         "[CtpTradeApi::OnRspSettlementInfoConfirm] Failed. ErrorMsg: {}",
         gb2312_to_utf8(rsp_info->ErrorMsg));
-    error();
+    requests_.error(req_id);
     return;
   }
 
   spdlog::debug(
       "[CtpTradeApi::OnRspSettlementInfoConfirm] Success. Settlement "
       "confirmed");
-  done();
+  requests_.done(req_id);
 }
 
 void CtpTradeApi::OnRspUserLogout(CThostFtdcUserLogoutField *user_logout,
@@ -244,32 +448,47 @@ void CtpTradeApi::OnRspUserLogout(CThostFtdcUserLogoutField *user_logout,
   spdlog::debug(
       "[CtpTradeApi::OnRspUserLogout] Success. Broker ID: {}, Investor ID: {}",
       user_logout->BrokerID, user_logout->UserID);
-  is_logon_ = false;
+  requests_.done(req_id);
+}
+
+void CtpTradeApi::init_order_templates() {
+  order_templates_.clear();
+  order_templates_.resize(ContractTable::size() + 1);
+  for (uint32_t i = 1; i <= ContractTable::size(); ++i) {
+    auto contract = ContractTable::get_by_index(i);
+    auto &req = order_templates_[i];
+    strncpy(req.BrokerID, broker_id_.c_str(), sizeof(req.BrokerID) - 1);
+    strncpy(req.InvestorID, investor_id_.c_str(), sizeof(req.InvestorID) - 1);
+    strncpy(req.InstrumentID, contract->ticker.data(),
+            sizeof(req.InstrumentID) - 1);
+    strncpy(req.ExchangeID, contract->exchange.data(),
+            sizeof(req.ExchangeID) - 1);
+    req.ContingentCondition = THOST_FTDC_CC_Immediately;
+    req.ForceCloseReason = THOST_FTDC_FCC_NotForceClose;
+    req.MinVolume = 1;
+    req.IsAutoSuspend = 0;
+    req.UserForceClose = 0;
+  }
 }
 
 bool CtpTradeApi::send_order(const OrderReq &order) {
-  auto contract = order.contract;
+  uint32_t ticker_index = order.params->index;
+  if (ticker_index >= order_templates_.size()) {
+    spdlog::error("[CtpTradeApi::send_order] Contract not found");
+    return false;
+  }
 
   int order_ref = static_cast<int>(order.engine_order_id) + order_ref_base_;
-  CThostFtdcInputOrderField req{};
-  strncpy(req.BrokerID, broker_id_.c_str(), sizeof(req.BrokerID));
-  strncpy(req.InvestorID, investor_id_.c_str(), sizeof(req.InvestorID));
-  strncpy(req.InstrumentID, contract->ticker.c_str(), sizeof(req.InstrumentID));
-  strncpy(req.ExchangeID, contract->exchange.c_str(), sizeof(req.ExchangeID));
+  CThostFtdcInputOrderField req = order_templates_[ticker_index];
   snprintf(req.OrderRef, sizeof(req.OrderRef), "%d", order_ref);
   req.OrderPriceType = order_type(order.type);
   req.Direction = direction(order.direction);
   req.CombOffsetFlag[0] = offset(order.offset);
-  req.LimitPrice = order.price;
+  req.LimitPrice = order.real_price();
   req.VolumeTotalOriginal = order.volume;
   req.CombHedgeFlag[0] = order.flags & OrderFlag::HEDGE
                              ? THOST_FTDC_HF_Hedge
                              : THOST_FTDC_HF_Speculation;
-  req.ContingentCondition = THOST_FTDC_CC_Immediately;
-  req.ForceCloseReason = THOST_FTDC_FCC_NotForceClose;
-  req.MinVolume = 1;
-  req.IsAutoSuspend = 0;
-  req.UserForceClose = 0;
 
   if (order.type == OrderType::FAK) {
     req.TimeCondition = THOST_FTDC_TC_IOC;
@@ -286,6 +505,12 @@ bool CtpTradeApi::send_order(const OrderReq &order) {
     req.LimitPrice = 0.0;
   }
 
+  auto &slot = order_slots_[order.engine_order_id & kOrderSlotMask];
+  slot.engine_order_id.store(0, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  slot.ticker_index.store(ticker_index, std::memory_order_relaxed);
+  slot.engine_order_id.store(order.engine_order_id, std::memory_order_release);
+
   if (trade_api_->ReqOrderInsert(&req, next_req_id()) != 0) {
     spdlog::error("[CtpTradeApi::send_order] Failed to call ReqOrderInsert");
     return false;
@@ -294,8 +519,8 @@ bool CtpTradeApi::send_order(const OrderReq &order) {
   spdlog::debug(
       "[CtpTradeApi::send_order] 订单发送成功. {}, {}, {}{}"
       "Volume:{}, Price:{:.3f}",
-      order_ref, contract->ticker, direction_str(order.direction),
-      offset_str(order.offset), order.volume, order.price);
+      order_ref, order.contract->ticker, direction_str(order.direction),
+      offset_str(order.offset), order.volume, order.real_price());
   return true;
 }
 
@@ -307,23 +532,21 @@ void CtpTradeApi::OnRspOrderInsert(CThostFtdcInputOrderField *order,
     return;
   }
 
-  if (order->InvestorID != investor_id_) {
+  if (!is_my_investor(order->InvestorID)) {
     spdlog::warn(
         "[CtpTradeApi::OnRspOrderInsert] Failed. "
         "= =#Receive RspOrderInsert of other investor");
     return;
   }
 
-  int order_ref;
-  try {
-    order_ref = std::stoi(order->OrderRef);
-  } catch (...) {
+  int64_t order_ref;
+  if (!parse_fixed_int(order->OrderRef, &order_ref)) {
     spdlog::error("[CtpTradeApi::OnRspOrderInsert] Invalid order ref");
     return;
   }
 
   OrderRejectedRsp rsp = {get_engine_order_id(order_ref),
-                          gb2312_to_utf8(rsp_info->ErrorMsg)};
+                          {rsp_info ? rsp_info->ErrorMsg : "", true}};
   engine_->on_order_rejected(&rsp);
 }
 
@@ -334,22 +557,27 @@ void CtpTradeApi::OnRtnOrder(CThostFtdcOrderField *order) {
   }
 
   // 听说CTP会收到别人的订单回报？判断一下
-  if (order->InvestorID != investor_id_) {
+  if (!is_my_investor(order->InvestorID)) {
     spdlog::warn("[CtpTradeApi::OnRtnOrder] Failed. Unknown order");
     return;
   }
 
-  // CTP返回的OrderRef不会有问题吧？
-  uint64_t engine_order_id = get_engine_order_id(std::stoi(order->OrderRef));
+  if (startup_canceling_ && on_startup_cancel(*order)) return;
+
+  int64_t order_ref;
+  if (!parse_fixed_int(order->OrderRef, &order_ref)) {
+    spdlog::error("[CtpTradeApi::OnRtnOrder] Invalid order ref");
+    return;
+  }
+  uint64_t engine_order_id = get_engine_order_id(order_ref);
 
   // 被拒单或撤销被拒，回调相应函数
   if (order->OrderSubmitStatus == THOST_FTDC_OSS_InsertRejected) {
-    OrderRejectedRsp rsp = {engine_order_id, gb2312_to_utf8(order->StatusMsg)};
+    OrderRejectedRsp rsp = {engine_order_id, {order->StatusMsg, true}};
     engine_->on_order_rejected(&rsp);
     return;
   } else if (order->OrderSubmitStatus == THOST_FTDC_OSS_CancelRejected) {
-    OrderCancelRejectedRsp rsp = {engine_order_id,
-                                  gb2312_to_utf8(order->StatusMsg)};
+    OrderCancelRejectedRsp rsp = {engine_order_id, {order->StatusMsg, true}};
     engine_->on_order_cancel_rejected(&rsp);
     return;
   } else if (order->OrderSubmitStatus == THOST_FTDC_OSS_InsertSubmitted ||
@@ -369,11 +597,18 @@ void CtpTradeApi::OnRtnOrder(CThostFtdcOrderField *order) {
                             order->VolumeTotalOriginal - order->VolumeTraded};
     engine_->on_order_canceled(&rsp);
   } else if (order->OrderStatus == THOST_FTDC_OST_NoTradeQueueing) {
-    auto contract = ContractTable::get_by_ticker(order->InstrumentID);
-    assert(contract);
-    OrderAcceptedRsp rsp = {
-        engine_order_id,
-        get_order_id(contract->index, std::stoi(order->OrderSysID))};
+    uint32_t ticker_index =
+        get_ticker_index(engine_order_id, order->InstrumentID);
+    int64_t order_sys_id = 0;
+    if (ticker_index == 0 ||
+        !parse_fixed_int(order->OrderSysID, &order_sys_id)) {
+      spdlog::error("[CtpTradeApi::OnRtnOrder] Unknown order. {}, {}",
+                    order->InstrumentID, order->OrderSysID);
+      return;
+    }
+
+    OrderAcceptedRsp rsp = {engine_order_id,
+                            get_order_id(ticker_index, order_sys_id)};
     engine_->on_order_accepted(&rsp);
   }
 }
@@ -384,17 +619,30 @@ void CtpTradeApi::OnRtnTrade(CThostFtdcTradeField *trade) {
     return;
   }
 
-  if (trade->InvestorID != investor_id_) {
+  if (!is_my_investor(trade->InvestorID)) {
     spdlog::warn("[CtpTradeApi::OnRtnTrade] Failed. Recv unknown trade");
     return;
   }
 
-  auto contract = ContractTable::get_by_ticker(trade->InstrumentID);
-  assert(contract);
+  int64_t order_ref;
+  int64_t order_sys_id;
+  if (!parse_fixed_int(trade->OrderRef, &order_ref) ||
+      !parse_fixed_int(trade->OrderSysID, &order_sys_id)) {
+    spdlog::error("[CtpTradeApi::OnRtnTrade] Invalid OrderRef or OrderSysID");
+    return;
+  }
 
   OrderTradedRsp rsp{};
-  rsp.engine_order_id = get_engine_order_id(std::stoi(trade->OrderRef));
-  rsp.order_id = get_order_id(contract->index, std::stoi(trade->OrderSysID));
+  rsp.engine_order_id = get_engine_order_id(order_ref);
+  uint32_t ticker_index =
+      get_ticker_index(rsp.engine_order_id, trade->InstrumentID);
+  if (ticker_index == 0) {
+    spdlog::error("[CtpTradeApi::OnRtnTrade] Unknown ticker {}",
+                  trade->InstrumentID);
+    return;
+  }
+
+  rsp.order_id = get_order_id(ticker_index, order_sys_id);
   rsp.volume = trade->Volume;
   rsp.price = trade->Price;
   rsp.trade_type = TradeType::SECONDARY_MARKET;
@@ -411,7 +659,7 @@ bool CtpTradeApi::cancel_order(uint64_t order_id) {
   }
 
   CThostFtdcInputOrderActionField req{};
-  strncpy(req.ExchangeID, contract->exchange.c_str(), sizeof(req.ExchangeID));
+  strncpy(req.ExchangeID, contract->exchange.data(), sizeof(req.ExchangeID));
   snprintf(req.OrderSysID, sizeof(req.OrderSysID), "%12llu",
            order_id & 0xffffffffULL);
   strncpy(req.BrokerID, broker_id_.c_str(), sizeof(req.BrokerID));
@@ -441,6 +689,26 @@ void CtpTradeApi::OnRspOrderAction(CThostFtdcInputOrderActionField *action,
 
   spdlog::error("[CtpTradeApi::OnRspOrderAction] Failed. Rejected. Reason: {}",
                 gb2312_to_utf8(rsp_info->ErrorMsg));
+  // 登录时撤销历史订单失败，其他撤单没有登记，会被忽略
+  requests_.error(req_id);
+}
+
+bool CtpTradeApi::on_startup_cancel(const CThostFtdcOrderField &order) {
+  std::unique_lock<std::mutex> lock(startup_cancel_mutex_);
+  auto iter = startup_cancels_.find(
+      fmt::format("{}.{}", order.ExchangeID, order.OrderSysID));
+  if (iter == startup_cancels_.end()) return false;
+
+  if (order.OrderStatus == THOST_FTDC_OST_Canceled ||
+      order.OrderStatus == THOST_FTDC_OST_PartTradedNotQueueing) {
+    requests_.done(iter->second);
+    startup_cancels_.erase(iter);
+  } else if (order.OrderSubmitStatus == THOST_FTDC_OSS_CancelRejected ||
+             order.OrderStatus == THOST_FTDC_OST_AllTraded) {
+    requests_.error(iter->second);
+    startup_cancels_.erase(iter);
+  }
+  return true;
 }
 
 bool CtpTradeApi::query_contract(const std::string &ticker,
@@ -449,13 +717,9 @@ bool CtpTradeApi::query_contract(const std::string &ticker,
   strncpy(req.InstrumentID, ticker.c_str(), sizeof(req.InstrumentID));
   strncpy(req.ExchangeID, exchange.c_str(), sizeof(req.ExchangeID));
 
-  if (trade_api_->ReqQryInstrument(&req, next_req_id()) != 0) {
-    spdlog::error(
-        "[CtpTradeApi::query_contract] Failed. Failed to ReqQryInstrument");
-    return false;
-  }
-
-  return wait_sync();
+  return wait(send_request("ReqQryInstrument", [&](int req_id) {
+    return trade_api_->ReqQryInstrument(&req, req_id);
+  }));
 }
 
 bool CtpTradeApi::query_contracts() { return query_contract("", ""); }
@@ -466,14 +730,14 @@ void CtpTradeApi::OnRspQryInstrument(CThostFtdcInstrumentField *instrument,
   if (is_error_rsp(rsp_info)) {
     spdlog::error("[CtpTradeApi::OnRspQryInstrument] Failed. Error Msg: {}",
                   gb2312_to_utf8(rsp_info->ErrorMsg));
-    error();
+    requests_.error(req_id);
     return;
   }
 
   if (!instrument) {
     spdlog::error(
         "[CtpTradeApi::OnRspQryInstrument] Failed. instrument is nullptr");
-    error();
+    requests_.error(req_id);
     return;
   }
 
@@ -483,50 +747,53 @@ void CtpTradeApi::OnRspQryInstrument(CThostFtdcInstrumentField *instrument,
       instrument->InstrumentID, instrument->ExchangeID,
       instrument->LongMarginRatio);
 
+  // contract中的字符串只在回调期间有效
+  auto name = gb2312_to_utf8(instrument->InstrumentName);
   Contract contract;
-  contract.product_type = product_type(instrument->ProductClass);
+  contract.params.product_type = product_type(instrument->ProductClass);
   contract.ticker = instrument->InstrumentID;
   contract.exchange = instrument->ExchangeID;
-  contract.name = gb2312_to_utf8(instrument->InstrumentName);
-  contract.product_type = product_type(instrument->ProductClass);
-  contract.size = instrument->VolumeMultiple;
-  contract.price_tick = instrument->PriceTick;
-  contract.long_margin_rate = instrument->LongMarginRatio;
-  contract.short_margin_rate = instrument->ShortMarginRatio;
-  contract.max_market_order_volume = instrument->MaxMarketOrderVolume;
-  contract.min_market_order_volume = instrument->MinMarketOrderVolume;
-  contract.max_limit_order_volume = instrument->MaxLimitOrderVolume;
-  contract.min_limit_order_volume = instrument->MinLimitOrderVolume;
+  contract.name = name;
+  contract.params.product_type = product_type(instrument->ProductClass);
+  contract.params.size = instrument->VolumeMultiple;
+  contract.params.price_tick = instrument->PriceTick;
+  contract.params.long_margin_rate = instrument->LongMarginRatio;
+  contract.params.short_margin_rate = instrument->ShortMarginRatio;
+  contract.params.max_market_order_volume = instrument->MaxMarketOrderVolume;
+  contract.params.min_market_order_volume = instrument->MinMarketOrderVolume;
+  contract.params.max_limit_order_volume = instrument->MaxLimitOrderVolume;
+  contract.params.min_limit_order_volume = instrument->MinLimitOrderVolume;
   contract.delivery_year = instrument->DeliveryYear;
   contract.delivery_month = instrument->DeliveryMonth;
 
   engine_->on_query_contract(&contract);
 
-  if (is_last) done();
+  if (is_last) requests_.done(req_id);
 }
 
 bool CtpTradeApi::query_position(const std::string &ticker) {
+  return wait(query_position_async(ticker));
+}
+
+int CtpTradeApi::query_position_async(const std::string &ticker) {
   CThostFtdcQryInvestorPositionField req{};
   if (!ticker.empty()) {
     auto contract = ContractTable::get_by_ticker(ticker);
     if (!contract) {
       spdlog::error("[CtpTradeApi::query_position] Contract not found: {}",
                     ticker);
-      return false;
+      return -1;
     }
-    strncpy(req.InstrumentID, contract->ticker.c_str(),
+    strncpy(req.InstrumentID, contract->ticker.data(),
             sizeof(req.InstrumentID));
-    strncpy(req.ExchangeID, contract->exchange.c_str(), sizeof(req.ExchangeID));
+    strncpy(req.ExchangeID, contract->exchange.data(), sizeof(req.ExchangeID));
   }
   strncpy(req.BrokerID, broker_id_.c_str(), sizeof(req.BrokerID));
   strncpy(req.InvestorID, investor_id_.c_str(), sizeof(req.InvestorID));
 
-  if (trade_api_->ReqQryInvestorPosition(&req, next_req_id()) != 0) {
-    spdlog::error("[CtpTradeApi::query_position] Failed to send query req");
-    return false;
-  }
-
-  return wait_sync();
+  return send_request("ReqQryInvestorPosition", [&](int req_id) {
+    return trade_api_->ReqQryInvestorPosition(&req, req_id);
+  });
 }
 
 bool CtpTradeApi::query_positions() { return query_position(""); }
@@ -538,8 +805,8 @@ void CtpTradeApi::OnRspQryInvestorPosition(
     spdlog::error(
         "[CtpTradeApi::OnRspQryInvestorPosition] Failed. Error Msg: {}",
         gb2312_to_utf8(rsp_info->ErrorMsg));
-    pos_cache_.clear();
-    error();
+    pos_cache_.erase(req_id);
+    requests_.error(req_id);
     return;
   }
 
@@ -552,8 +819,8 @@ void CtpTradeApi::OnRspQryInvestorPosition(
       goto check_last;
     }
 
-    auto &pos = pos_cache_[contract->index];
-    pos.ticker_index = contract->index;
+    auto &pos = pos_cache_[req_id][contract->params.index];
+    pos.ticker_index = contract->params.index;
 
     bool is_long_pos = position->PosiDirection == THOST_FTDC_PD_Long;
     auto &pos_detail = is_long_pos ? pos.long_pos : pos.short_pos;
@@ -566,9 +833,9 @@ void CtpTradeApi::OnRspQryInvestorPosition(
     else
       pos_detail.frozen = position->ShortFrozen;
 
-    if (pos_detail.holdings > 0 && contract->size > 0)
-      pos_detail.cost_price =
-          position->PositionCost / (pos_detail.holdings * contract->size);
+    if (pos_detail.holdings > 0 && contract->params.size > 0)
+      pos_detail.cost_price = position->PositionCost /
+                              (pos_detail.holdings * contract->params.size);
 
     spdlog::debug(
         "[CtpTradeApi::OnRspQryInvestorPosition] {}, long:{}, ydlong:{}, "
@@ -579,28 +846,25 @@ void CtpTradeApi::OnRspQryInvestorPosition(
 
 check_last:
   if (is_last) {
-    for (auto &[ticker_index, pos] : pos_cache_) {
+    for (auto &[ticker_index, pos] : pos_cache_[req_id]) {
       UNUSED(ticker_index);
       engine_->on_query_position(&pos);
     }
-    pos_cache_.clear();
-    done();
+    pos_cache_.erase(req_id);
+    requests_.done(req_id);
   }
 }
 
-bool CtpTradeApi::query_account() {
+bool CtpTradeApi::query_account() { return wait(query_account_async()); }
+
+int CtpTradeApi::query_account_async() {
   CThostFtdcQryTradingAccountField req{};
   strncpy(req.BrokerID, broker_id_.c_str(), sizeof(req.BrokerID));
   strncpy(req.InvestorID, investor_id_.c_str(), sizeof(req.InvestorID));
 
-  if (trade_api_->ReqQryTradingAccount(&req, next_req_id()) != 0) {
-    spdlog::error(
-        "[CtpTradeApi::query_account] Failed. Failed to "
-        "ReqQryTradingAccount");
-    return false;
-  }
-
-  return wait_sync();
+  return send_request("ReqQryTradingAccount", [&](int req_id) {
+    return trade_api_->ReqQryTradingAccount(&req, req_id);
+  });
 }
 
 void CtpTradeApi::OnRspQryTradingAccount(
@@ -611,7 +875,7 @@ void CtpTradeApi::OnRspQryTradingAccount(
   if (is_error_rsp(rsp_info)) {
     spdlog::error("[CtpTradeApi::OnRspQryTradingAccount] Failed. ErrorMsg: {}",
                   gb2312_to_utf8(rsp_info->ErrorMsg));
-    error();
+    requests_.error(req_id);
     return;
   }
 
@@ -630,7 +894,7 @@ void CtpTradeApi::OnRspQryTradingAccount(
   account.cash = account.total_asset - account.margin - account.frozen;
 
   engine_->on_query_account(&account);
-  done();
+  requests_.done(req_id);
 }
 
 void CtpTradeApi::OnRspQryOrder(CThostFtdcOrderField *order,
@@ -641,7 +905,13 @@ void CtpTradeApi::OnRspQryOrder(CThostFtdcOrderField *order,
   if (is_error_rsp(rsp_info)) {
     spdlog::error("[CtpTradeApi::OnRspQryOrder] Failed. ErrorMsg: {}",
                   gb2312_to_utf8(rsp_info->ErrorMsg));
-    error();
+    requests_.error(req_id);
+    return;
+  }
+
+  if (req_id == resync_order_req_id_) {
+    if (order) on_resync_order(*order);
+    if (is_last) requests_.done(req_id);
     return;
   }
 
@@ -662,46 +932,61 @@ void CtpTradeApi::OnRspQryOrder(CThostFtdcOrderField *order,
     strncpy(req.InvestorID, investor_id_.c_str(), sizeof(req.InvestorID));
     req.ActionFlag = THOST_FTDC_AF_Delete;
 
-    if (trade_api_->ReqOrderAction(&req, next_req_id()) != 0)
+    int action_req_id = next_req_id();
+    requests_.add(action_req_id);
+    if (trade_api_->ReqOrderAction(&req, action_req_id) != 0) {
       spdlog::error(
           "[CtpTradeApi::OnRspQryOrder] Failed to call ReqOrderAction");
+      requests_.remove(action_req_id);
+    } else {
+      std::unique_lock<std::mutex> lock(startup_cancel_mutex_);
+      startup_cancels_.emplace(
+          fmt::format("{}.{}", order->ExchangeID, order->OrderSysID),
+          action_req_id);
+      startup_cancel_req_ids_.emplace_back(action_req_id);
+    }
   }
 
-  if (is_last) done();
+  if (is_last) requests_.done(req_id);
 }
 
-bool CtpTradeApi::query_trades() {
+bool CtpTradeApi::query_trades() { return wait(query_trades_async()); }
+
+int CtpTradeApi::query_trades_async() {
   CThostFtdcQryTradeField req{};
   strncpy(req.BrokerID, broker_id_.c_str(), sizeof(req.BrokerID));
   strncpy(req.InvestorID, investor_id_.c_str(), sizeof(req.InvestorID));
 
-  if (trade_api_->ReqQryTrade(&req, next_req_id()) != 0) {
-    spdlog::error("[CtpTradeApi::query_trades] Failed. Failed to ReqQryTrade");
-    return false;
-  }
-
-  return wait_sync();
+  return send_request("ReqQryTrade", [&](int req_id) {
+    return trade_api_->ReqQryTrade(&req, req_id);
+  });
 }
 
 void CtpTradeApi::OnRspQryTrade(CThostFtdcTradeField *trade,
                                 CThostFtdcRspInfoField *rsp_info, int req_id,
                                 bool is_last) {
   // TODO(kevin)
-  if (!is_last) return;
-
   if (is_error_rsp(rsp_info)) {
     spdlog::error("[CtpTradeApi::OnRspQryTrade] Failed. ErrorMsg: {}",
                   gb2312_to_utf8(rsp_info->ErrorMsg));
-    error();
+    requests_.error(req_id);
     return;
   }
 
-  if (trade) {
-    auto contract = ContractTable::get_by_ticker(trade->InstrumentID);
-    assert(contract);
+  if (req_id == resync_trade_req_id_) {
+    if (trade) on_resync_trade(*trade);
+    if (is_last) requests_.done(req_id);
+    return;
+  }
 
+  auto contract =
+      trade ? ContractTable::get_by_ticker(trade->InstrumentID) : nullptr;
+  if (trade && !contract) {
+    spdlog::error("[CtpTradeApi::OnRspQryTrade] Contract not found: {}",
+                  trade->InstrumentID);
+  } else if (trade) {
     OrderTradedRsp td{};
-    td.ticker_index = contract->index;
+    td.ticker_index = contract->params.index;
     td.volume = trade->Volume;
     td.price = trade->Price;
     td.direction = direction(trade->Direction);
@@ -709,10 +994,14 @@ void CtpTradeApi::OnRspQryTrade(CThostFtdcTradeField *trade,
     engine_->on_query_trade(&td);
   }
 
-  if (is_last) done();
+  if (is_last) requests_.done(req_id);
 }
 
 bool CtpTradeApi::query_margin_rate(const std::string &ticker) {
+  return wait(query_margin_rate_async(ticker));
+}
+
+int CtpTradeApi::query_margin_rate_async(const std::string &ticker) {
   CThostFtdcQryInstrumentMarginRateField req{};
 
   if (!ticker.empty()) {
@@ -721,25 +1010,36 @@ bool CtpTradeApi::query_margin_rate(const std::string &ticker) {
       spdlog::error(
           "[CtpTradeApi::query_margin_rate] Contract not found. Ticker: {}",
           ticker);
-      return false;
+      return -1;
     }
-    strncpy(req.InstrumentID, contract->ticker.c_str(),
+    strncpy(req.InstrumentID, contract->ticker.data(),
             sizeof(req.InstrumentID));
-    strncpy(req.ExchangeID, contract->exchange.c_str(), sizeof(req.ExchangeID));
+    strncpy(req.ExchangeID, contract->exchange.data(), sizeof(req.ExchangeID));
   }
 
   req.HedgeFlag = THOST_FTDC_HF_Speculation;
   strncpy(req.BrokerID, broker_id_.c_str(), sizeof(req.BrokerID));
   strncpy(req.InvestorID, investor_id_.c_str(), sizeof(req.InvestorID));
 
-  if (trade_api_->ReqQryInstrumentMarginRate(&req, next_req_id()) != 0) {
-    spdlog::error(
-        "[CtpTradeApi::query_margin_rate] Failed. "
-        "Failed to call ReqQryInstrumentMarginRate");
-    return false;
-  }
+  return send_request("ReqQryInstrumentMarginRate", [&](int req_id) {
+    return trade_api_->ReqQryInstrumentMarginRate(&req, req_id);
+  });
+}
 
-  return wait_sync();
+bool CtpTradeApi::query_batch(uint32_t types) {
+  // 所有请求先发出再一起等待。柜台对查询有流控，被流控的请求会在
+  // send_request中重试
+  std::vector<int> req_ids;
+  if (types & QueryType::ACCOUNT) req_ids.emplace_back(query_account_async());
+  if (types & QueryType::POSITIONS)
+    req_ids.emplace_back(query_position_async(""));
+  if (types & QueryType::TRADES) req_ids.emplace_back(query_trades_async());
+  if (types & QueryType::MARGIN_RATES)
+    req_ids.emplace_back(query_margin_rate_async(""));
+
+  bool ok = requests_.wait_all(req_ids, timeout_);
+  if (!ok) spdlog::error("[CtpTradeApi::query_batch] Failed. Types: {}", types);
+  return ok;
 }
 
 void CtpTradeApi::OnRspQryInstrumentMarginRate(
@@ -749,29 +1049,28 @@ void CtpTradeApi::OnRspQryInstrumentMarginRate(
     spdlog::error(
         "[CtpTradeApi::OnRspQryInstrumentMarginRate] Failed. ErrorMsg: {}",
         gb2312_to_utf8(rsp_info->ErrorMsg));
-    error();
+    requests_.error(req_id);
     return;
   }
 
   if (margin_rate) {
-    // TODO(kevin)
-    auto __c = ContractTable::get_by_ticker(margin_rate->InstrumentID);
-    if (!__c) {
+    auto contract = ContractTable::get_by_ticker(margin_rate->InstrumentID);
+    if (!contract) {
       spdlog::error(
           "[CtpTradeApi::OnRspQryInstrumentMarginRate] Contract not found: {}",
           margin_rate->InstrumentID);
+    } else {
+      spdlog::info("Margin Rate. {}, {}, {}", margin_rate->InstrumentID,
+                   margin_rate->LongMarginRatioByMoney,
+                   margin_rate->ShortMarginRatioByMoney);
+
+      ContractTable::update_margin_rate(contract->params.index,
+                                        margin_rate->LongMarginRatioByMoney,
+                                        margin_rate->ShortMarginRatioByMoney);
     }
-
-    spdlog::info("Margin Rate. {}, {}, {}", margin_rate->InstrumentID,
-                 margin_rate->LongMarginRatioByMoney,
-                 margin_rate->ShortMarginRatioByMoney);
-
-    auto contract = const_cast<Contract *>(__c);
-    contract->long_margin_rate = margin_rate->LongMarginRatioByMoney;
-    contract->short_margin_rate = margin_rate->ShortMarginRatioByMoney;
   }
 
-  if (is_last) done();
+  if (is_last) requests_.done(req_id);
 }
 
 }  // namespace ft
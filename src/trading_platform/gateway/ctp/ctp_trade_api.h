@@ -6,16 +6,23 @@
 #include <ThostFtdcTraderApi.h>
 
 #include <atomic>
+#include <chrono>
+#include <cstring>
 #include <map>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "core/config.h"
 #include "core/constants.h"
 #include "gateway/ctp/ctp_common.h"
 #include "interface/gateway.h"
 #include "interface/trading_engine_interface.h"
+#include "utils/reconnector.h"
+#include "utils/request_tracker.h"
 
 namespace ft {
 
@@ -29,6 +36,9 @@ class CtpTradeApi : public CThostFtdcTraderSpi {
 
   bool login(const Config &config);
 
+  // 不连接柜台，只初始化会话相关的信息，用于离线回放回报
+  void init_offline(const Config &config, int order_ref_base);
+
   void logout();
 
   bool send_order(const OrderReq &order);
@@ -49,11 +59,26 @@ class CtpTradeApi : public CThostFtdcTraderSpi {
 
   bool query_margin_rate(const std::string &ticker);
 
+  bool query_batch(uint32_t types);
+
+  // 下面几个查询只发出请求，成功返回req_id，失败返回-1，通过wait等待结果
+  int query_position_async(const std::string &ticker);
+
+  int query_account_async();
+
+  int query_trades_async();
+
+  int query_margin_rate_async(const std::string &ticker);
+
+  // 等待请求完成，超时时间为Config::request_timeout_ms
+  bool wait(int req_id) { return requests_.wait(req_id, timeout_); }
+
   // 当客户端与交易后台建立起通信连接时（还未登录前），该方法被调用。
   void OnFrontConnected() override;
 
   // 当客户端与交易后台通信连接断开时，该方法被调用。
-  // 当发生这个情况后，API会自动重新连接，客户端可不做处理。
+  // 当发生这个情况后，API会自动重新连接，重连成功后在OnFrontConnected中
+  // 恢复会话。
   // @param reason 错误原因
   //         0x1001 网络读失败
   //         0x1002 网络写失败
@@ -66,6 +91,10 @@ class CtpTradeApi : public CThostFtdcTraderSpi {
   // @param time_lapse 距离上次接收报文的时间
   void OnHeartBeatWarning(int time_lapse) override;
 
+  // 错误应答，用于请求没有对应的响应函数或者请求格式错误等情况
+  void OnRspError(CThostFtdcRspInfoField *rsp_info, int req_id,
+                  bool is_last) override;
+
   // 客户端认证响应
   void OnRspAuthenticate(CThostFtdcRspAuthenticateField *auth,
                          CThostFtdcRspInfoField *rsp_info, int req_id,
@@ -129,47 +158,126 @@ class CtpTradeApi : public CThostFtdcTraderSpi {
  private:
   int next_req_id() { return next_req_id_++; }
 
-  uint64_t get_engine_order_id(int order_ref) const {
+  // 登记并发出请求，成功返回req_id，失败返回-1。CTP对查询有流控，
+  // req_func返回-2（未处理请求超过许可数）或-3（每秒发送请求数超过许可数）
+  // 时稍后重试，直到超时
+  template <class ReqFunc>
+  int send_request(const char *name, ReqFunc &&req_func);
+
+  // 认证、登录及确认结算单，首次登录及断线重连后都需要执行
+  bool login_session();
+
+  // 断线重连后在reconnector_的线程中恢复会话，失败时按退避时间重试
+  bool resume_session();
+
+  // 查询当日的成交及订单，补齐断线期间丢失的回报
+  bool resync_orders();
+
+  void on_resync_trade(const CThostFtdcTradeField &trade);
+
+  void on_resync_order(const CThostFtdcOrderField &order);
+
+  // 登录时撤销的历史订单的回报，返回true表示已处理
+  bool on_startup_cancel(const CThostFtdcOrderField &order);
+
+  bool is_my_session(int front_id, int session_id) const;
+
+  void init_order_templates();
+
+  uint64_t get_engine_order_id(int64_t order_ref) const {
     return order_ref - order_ref_base_;
   }
 
+  bool is_my_investor(const char *investor_id) const {
+    return strncmp(investor_id, investor_id_.c_str(),
+                   sizeof(TThostFtdcInvestorIDType)) == 0;
+  }
+
+  // 报单时按engine_order_id记录合约，回报时直接通过OrderRef取得合约，
+  // 只有找不到时（如其他会话的订单）才按InstrumentID查找合约表
+  template <std::size_t N>
+  uint32_t get_ticker_index(uint64_t engine_order_id,
+                            const char (&instrument_id)[N]) const {
+    auto &slot = order_slots_[engine_order_id & kOrderSlotMask];
+    if (slot.engine_order_id.load(std::memory_order_acquire) ==
+        engine_order_id) {
+      uint32_t ticker_index = slot.ticker_index.load(std::memory_order_relaxed);
+      // 读取期间槽位可能被回绕的新订单覆盖，需要再次确认
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (slot.engine_order_id.load(std::memory_order_relaxed) ==
+          engine_order_id)
+        return ticker_index;
+    }
+
+    auto contract = ContractTable::get_by_ticker(instrument_id);
+    return contract ? contract->params.index : 0;
+  }
+
   uint64_t get_order_id(uint32_t ticker_index, uint32_t order_sys_id) const {
     return ((static_cast<uint64_t>(ticker_index) << 32) &
             0xffffffff00000000ULL) |
            (static_cast<uint64_t>(order_sys_id) & 0xffffffffULL);
   }
 
-  void done() { is_done_ = true; }
-
-  void error() { is_error_ = true; }
-
-  bool wait_sync() {
-    while (!is_done_)
-      if (is_error_) return false;
-
-    is_done_ = false;
-    return true;
-  }
-
  private:
   TradingEngineInterface *engine_;
   std::unique_ptr<CThostFtdcTraderApi, CtpApiDeleter> trade_api_;
 
+  Config config_;
   std::string front_addr_;
   std::string broker_id_;
   std::string investor_id_;
   int front_id_;
   int session_id_;
-  int order_ref_base_;
-
-  std::atomic<int> next_req_id_ = 0;
-
-  volatile bool is_error_ = false;
-  volatile bool is_connected_ = false;
-  volatile bool is_done_ = false;
-  volatile bool is_logon_ = false;
-
-  std::map<uint32_t, Position> pos_cache_;
+  int order_ref_base_ = 0;
+
+  // 本进程登录过的所有会话(FrontID, SessionID)，重连后同步订单时用于
+  // 区分其他进程的订单，只在回调线程中访问
+  std::vector<std::pair<int, int>> sessions_;
+
+  // 连接前置没有对应的请求，使用保留的req_id跟踪，其他请求从1开始编号
+  static constexpr int kConnectReqId = 0;
+  std::atomic<int> next_req_id_ = 1;
+
+  RequestTracker requests_;
+  RequestTracker::Timeout timeout_{10000};
+  std::atomic<bool> is_logon_ = false;
+  std::atomic<bool> has_logged_in_ = false;  // 首次登录成功后才需要重连
+
+  // 同步订单时的查询请求，回报按req_id与普通查询区分
+  std::atomic<int> resync_trade_req_id_ = -1;
+  std::atomic<int> resync_order_req_id_ = -1;
+
+  // 同步期间查询到的成交，按order_id归类，供随后的订单查询使用
+  std::mutex resync_mutex_;
+  std::unordered_map<uint64_t, std::vector<OrderTradedRsp>> resync_trades_;
+
+  // 登录时撤销的历史订单，ExchangeID.OrderSysID -> 撤单的req_id，
+  // 撤单结果通过OnRtnOrder或OnRspOrderAction返回，login通过requests_等待
+  std::atomic<bool> startup_canceling_ = false;
+  std::mutex startup_cancel_mutex_;
+  std::unordered_map<std::string, int> startup_cancels_;
+  std::vector<int> startup_cancel_req_ids_;
+
+  // 持仓查询的回报按req_id分别缓存，最后一个回报到达时一起推送
+  std::map<int, std::map<uint32_t, Position>> pos_cache_;
+
+  // 按ticker_index预先填充好账户及合约相关字段的报单请求，报单时只需要补充
+  // 价格、数量、OrderRef等字段
+  std::vector<CThostFtdcInputOrderField> order_templates_;
+
+  // 槽位由报单线程写入、SPI线程读取，engine_order_id兼作seqlock的版本号：
+  // 写入前先置0，写完ticker_index后再发布新的engine_order_id
+  struct OrderSlot {
+    std::atomic<uint64_t> engine_order_id{0};
+    std::atomic<uint32_t> ticker_index{0};
+  };
+
+  static constexpr uint64_t kOrderSlotMask = (1ULL << 16) - 1;
+  std::vector<OrderSlot> order_slots_;
+
+  // 最后声明，析构时最先停止重连线程，保证线程退出前其他成员都还有效
+  Reconnector reconnector_;
 };
 
 }  // namespace ft
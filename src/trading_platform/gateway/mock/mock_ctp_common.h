@@ -0,0 +1,57 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef FT_SRC_GATEWAY_MOCK_MOCK_CTP_COMMON_H_
+#define FT_SRC_GATEWAY_MOCK_MOCK_CTP_COMMON_H_
+
+#include <ThostFtdcUserApiStruct.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <string_view>
+
+namespace ft {
+
+inline CThostFtdcRspInfoField mock_ctp_rsp_info(int error_id = 0,
+                                                const char* error_msg = "") {
+  CThostFtdcRspInfoField rsp_info{};
+  rsp_info.ErrorID = error_id;
+  strncpy(rsp_info.ErrorMsg, error_msg, sizeof(rsp_info.ErrorMsg) - 1);
+  return rsp_info;
+}
+
+// YYYYMMDD
+inline void mock_ctp_date(char (&date)[9]) {
+  time_t now = time(nullptr);
+  struct tm local_time;
+  localtime_r(&now, &local_time);
+  strftime(date, sizeof(date), "%Y%m%d", &local_time);
+}
+
+// HH:MM:SS
+inline void mock_ctp_time(char (&time_str)[9]) {
+  time_t now = time(nullptr);
+  struct tm local_time;
+  localtime_r(&now, &local_time);
+  strftime(time_str, sizeof(time_str), "%H:%M:%S", &local_time);
+}
+
+// 定长字段复制，超长时截断，保证以'\0'结尾。源为定长字段时最多读取M个字节
+template <std::size_t N, std::size_t M>
+inline void mock_ctp_copy(char (&dst)[N], const char (&src)[M]) {
+  std::size_t len = strnlen(src, std::min(N - 1, M));
+  memcpy(dst, src, len);
+  dst[len] = '\0';
+}
+
+template <std::size_t N>
+inline void mock_ctp_copy(char (&dst)[N], std::string_view src) {
+  std::size_t len = std::min(N - 1, src.size());
+  memcpy(dst, src.data(), len);
+  dst[len] = '\0';
+}
+
+}  // namespace ft
+
+#endif  // FT_SRC_GATEWAY_MOCK_MOCK_CTP_COMMON_H_
@@ -0,0 +1,168 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#include "gateway/mock/mock_ctp_md_api.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "gateway/mock/mock_ctp_common.h"
+
+CThostFtdcMdApi* CThostFtdcMdApi::CreateFtdcMdApi(const char* flow_path,
+                                                  const bool is_using_udp,
+                                                  const bool is_multicast) {
+  return new ft::MockCtpMdApi;
+}
+
+const char* CThostFtdcMdApi::GetApiVersion() { return "v6.3.15_mock"; }
+
+namespace ft {
+
+MockCtpMdApi::MockCtpMdApi() : exchange_(MockExchange::instance()) {
+  mock_ctp_date(trading_day_);
+}
+
+void MockCtpMdApi::Release() {
+  exchange_->remove_listener(this);
+  delete this;
+}
+
+void MockCtpMdApi::RegisterSpi(CThostFtdcMdSpi* spi) {
+  auto lock = exchange_->lock_dispatch();
+  spi_ = spi;
+}
+
+void MockCtpMdApi::Init() {
+  exchange_->post(this, [this] {
+    auto spi = connected_spi();
+    if (spi) spi->OnFrontConnected();
+  });
+}
+
+int MockCtpMdApi::ReqUserLogin(CThostFtdcReqUserLoginField* req, int req_id) {
+  if (!req || !exchange_->is_connected()) return -1;
+
+  exchange_->post(this, [this, login = *req, req_id] {
+    auto spi = connected_spi();
+    if (!spi) return;
+
+    CThostFtdcRspUserLoginField rsp{};
+    mock_ctp_copy(rsp.TradingDay, trading_day_);
+    mock_ctp_time(rsp.LoginTime);
+    mock_ctp_copy(rsp.BrokerID, login.BrokerID);
+    mock_ctp_copy(rsp.UserID, login.UserID);
+    auto rsp_info = mock_ctp_rsp_info();
+    spi->OnRspUserLogin(&rsp, &rsp_info, req_id, true);
+  });
+  return 0;
+}
+
+int MockCtpMdApi::ReqUserLogout(CThostFtdcUserLogoutField* req, int req_id) {
+  if (!req || !exchange_->is_connected()) return -1;
+
+  exchange_->post(this, [this, logout = *req, req_id]() mutable {
+    auto spi = connected_spi();
+    auto rsp_info = mock_ctp_rsp_info();
+    if (spi) spi->OnRspUserLogout(&logout, &rsp_info, req_id, true);
+  });
+  return 0;
+}
+
+int MockCtpMdApi::SubscribeMarketData(char* tickers[], int count) {
+  if (!tickers || count <= 0 || !exchange_->is_connected()) return -1;
+
+  std::vector<std::string> ticker_list(tickers, tickers + count);
+  exchange_->post(this, [this, ticker_list] {
+    auto spi = connected_spi();
+    for (std::size_t i = 0; i < ticker_list.size(); ++i) {
+      exchange_->subscribe(this, ticker_list[i]);
+      if (!spi) continue;
+
+      CThostFtdcSpecificInstrumentField instrument{};
+      mock_ctp_copy(instrument.InstrumentID, ticker_list[i].c_str());
+      auto rsp_info = mock_ctp_rsp_info();
+      spi->OnRspSubMarketData(&instrument, &rsp_info, 0,
+                              i + 1 == ticker_list.size());
+    }
+  });
+  return 0;
+}
+
+int MockCtpMdApi::UnSubscribeMarketData(char* tickers[], int count) {
+  if (!tickers || count <= 0 || !exchange_->is_connected()) return -1;
+
+  std::vector<std::string> ticker_list(tickers, tickers + count);
+  exchange_->post(this, [this, ticker_list] {
+    auto spi = connected_spi();
+    for (std::size_t i = 0; i < ticker_list.size(); ++i) {
+      exchange_->unsubscribe(this, ticker_list[i]);
+      if (!spi) continue;
+
+      CThostFtdcSpecificInstrumentField instrument{};
+      mock_ctp_copy(instrument.InstrumentID, ticker_list[i].c_str());
+      auto rsp_info = mock_ctp_rsp_info();
+      spi->OnRspUnSubMarketData(&instrument, &rsp_info, 0,
+                                i + 1 == ticker_list.size());
+    }
+  });
+  return 0;
+}
+
+void MockCtpMdApi::on_mock_quote(const MockQuote& quote) {
+  auto spi = connected_spi();
+  if (!spi) return;
+
+  CThostFtdcDepthMarketDataField md{};
+  mock_ctp_copy(md.TradingDay, trading_day_);
+  mock_ctp_copy(md.ActionDay, trading_day_);
+  mock_ctp_copy(md.InstrumentID, quote.ticker.c_str());
+  uint32_t sec = static_cast<uint32_t>(quote.time_ms / 1000) % 86400;
+  snprintf(md.UpdateTime, sizeof(md.UpdateTime), "%02u:%02u:%02u",
+           sec / 3600, sec / 60 % 60, sec % 60);
+  md.UpdateMillisec = quote.time_ms % 1000;
+
+  md.LastPrice = quote.last_price;
+  md.OpenPrice = quote.open_price;
+  md.HighestPrice = quote.highest_price;
+  md.LowestPrice = quote.lowest_price;
+  md.PreClosePrice = quote.pre_close_price;
+  md.UpperLimitPrice = quote.upper_limit_price;
+  md.LowerLimitPrice = quote.lower_limit_price;
+  md.Volume = quote.volume;
+  md.Turnover = quote.turnover;
+
+  md.BidPrice1 = quote.bid[0];
+  md.BidPrice2 = quote.bid[1];
+  md.BidPrice3 = quote.bid[2];
+  md.BidPrice4 = quote.bid[3];
+  md.BidPrice5 = quote.bid[4];
+  md.AskPrice1 = quote.ask[0];
+  md.AskPrice2 = quote.ask[1];
+  md.AskPrice3 = quote.ask[2];
+  md.AskPrice4 = quote.ask[3];
+  md.AskPrice5 = quote.ask[4];
+  md.BidVolume1 = quote.bid_volume[0];
+  md.BidVolume2 = quote.bid_volume[1];
+  md.BidVolume3 = quote.bid_volume[2];
+  md.BidVolume4 = quote.bid_volume[3];
+  md.BidVolume5 = quote.bid_volume[4];
+  md.AskVolume1 = quote.ask_volume[0];
+  md.AskVolume2 = quote.ask_volume[1];
+  md.AskVolume3 = quote.ask_volume[2];
+  md.AskVolume4 = quote.ask_volume[3];
+  md.AskVolume5 = quote.ask_volume[4];
+
+  spi->OnRtnDepthMarketData(&md);
+}
+
+void MockCtpMdApi::on_mock_disconnected() {
+  auto spi = spi_.load();
+  if (spi) spi->OnFrontDisconnected(0x1001);
+}
+
+void MockCtpMdApi::on_mock_reconnected() {
+  auto spi = spi_.load();
+  if (spi) spi->OnFrontConnected();
+}
+
+}  // namespace ft
@@ -0,0 +1,75 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef FT_SRC_GATEWAY_MOCK_MOCK_CTP_MD_API_H_
+#define FT_SRC_GATEWAY_MOCK_MOCK_CTP_MD_API_H_
+
+#include <ThostFtdcMdApi.h>
+
+#include <atomic>
+
+#include "gateway/mock/mock_exchange.h"
+
+namespace ft {
+
+/*
+ * CThostFtdcMdApi的模拟实现，编译为libthostmduserapi_se.so
+ *
+ * 订阅的合约由MockExchange按FT_MOCK_TICK_INTERVAL_MS推送随机游走的行情
+ */
+class MockCtpMdApi : public CThostFtdcMdApi, public MockExchangeListener {
+ public:
+  MockCtpMdApi();
+
+  void Release() override;
+
+  void Init() override;
+
+  int Join() override { return 0; }
+
+  const char* GetTradingDay() override { return trading_day_; }
+
+  void RegisterFront(char* front_address) override {}
+
+  void RegisterNameServer(char* ns_address) override {}
+
+  void RegisterFensUserInfo(CThostFtdcFensUserInfoField* info) override {}
+
+  void RegisterSpi(CThostFtdcMdSpi* spi) override;
+
+  int SubscribeMarketData(char* tickers[], int count) override;
+
+  int UnSubscribeMarketData(char* tickers[], int count) override;
+
+  int SubscribeForQuoteRsp(char* tickers[], int count) override { return 0; }
+
+  int UnSubscribeForQuoteRsp(char* tickers[], int count) override {
+    return 0;
+  }
+
+  int ReqUserLogin(CThostFtdcReqUserLoginField* req, int req_id) override;
+
+  int ReqUserLogout(CThostFtdcUserLogoutField* req, int req_id) override;
+
+  void on_mock_quote(const MockQuote& quote) override;
+
+  void on_mock_disconnected() override;
+
+  void on_mock_reconnected() override;
+
+ private:
+  // 模拟断线期间产生的回报都被丢弃
+  CThostFtdcMdSpi* connected_spi() const {
+    return exchange_->is_connected() ? spi_.load() : nullptr;
+  }
+
+  ~MockCtpMdApi() = default;
+
+ private:
+  MockExchange* exchange_;
+  std::atomic<CThostFtdcMdSpi*> spi_ = nullptr;
+  char trading_day_[9]{};
+};
+
+}  // namespace ft
+
+#endif  // FT_SRC_GATEWAY_MOCK_MOCK_CTP_MD_API_H_
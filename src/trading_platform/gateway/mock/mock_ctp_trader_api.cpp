@@ -0,0 +1,697 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#include "gateway/mock/mock_ctp_trader_api.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "gateway/mock/mock_ctp_common.h"
+
+CThostFtdcTraderApi* CThostFtdcTraderApi::CreateFtdcTraderApi(
+    const char* flow_path) {
+  return new ft::MockCtpTraderApi;
+}
+
+const char* CThostFtdcTraderApi::GetApiVersion() {
+  return "v6.3.15_mock";
+}
+
+namespace ft {
+
+namespace {
+
+std::atomic<int> next_session_id = 1;
+
+}  // namespace
+
+MockCtpTraderApi::MockCtpTraderApi() : exchange_(MockExchange::instance()) {
+  mock_ctp_date(trading_day_);
+  session_id_ = next_session_id.fetch_add(1);
+}
+
+void MockCtpTraderApi::Release() {
+  exchange_->remove_listener(this);
+  delete this;
+}
+
+void MockCtpTraderApi::RegisterSpi(CThostFtdcTraderSpi* spi) {
+  auto lock = exchange_->lock_dispatch();
+  spi_ = spi;
+}
+
+void MockCtpTraderApi::Init() {
+  exchange_->post(this, [this] {
+    auto spi = connected_spi();
+    if (spi) spi->OnFrontConnected();
+  });
+}
+
+int MockCtpTraderApi::ReqAuthenticate(CThostFtdcReqAuthenticateField* req,
+                                      int req_id) {
+  if (!req || !exchange_->is_connected()) return -1;
+
+  CThostFtdcRspAuthenticateField rsp{};
+  mock_ctp_copy(rsp.BrokerID, req->BrokerID);
+  mock_ctp_copy(rsp.UserID, req->UserID);
+  mock_ctp_copy(rsp.AppID, req->AppID);
+  exchange_->post(this, [this, rsp, req_id]() mutable {
+    auto spi = connected_spi();
+    auto rsp_info = mock_ctp_rsp_info();
+    if (spi) spi->OnRspAuthenticate(&rsp, &rsp_info, req_id, true);
+  });
+  return 0;
+}
+
+int MockCtpTraderApi::ReqUserLogin(CThostFtdcReqUserLoginField* req,
+                                   int req_id) {
+  if (!req || !exchange_->is_connected()) return -1;
+
+  exchange_->post(this, [this, login = *req, req_id] {
+    auto spi = connected_spi();
+    if (!spi) return;
+
+    CThostFtdcRspUserLoginField rsp{};
+    if (login.UserID[0] == '\0') {
+      auto rsp_info = mock_ctp_rsp_info(3, "CTP:Invalid login");
+      spi->OnRspUserLogin(&rsp, &rsp_info, req_id, true);
+      return;
+    }
+
+    broker_id_ = login.BrokerID;
+    investor_id_ = login.UserID;
+    is_logon_ = true;
+
+    mock_ctp_copy(rsp.TradingDay, trading_day_);
+    mock_ctp_time(rsp.LoginTime);
+    mock_ctp_copy(rsp.BrokerID, login.BrokerID);
+    mock_ctp_copy(rsp.UserID, login.UserID);
+    mock_ctp_copy(rsp.SystemName, "MockCTP");
+    rsp.FrontID = front_id_;
+    rsp.SessionID = session_id_;
+    snprintf(rsp.MaxOrderRef, sizeof(rsp.MaxOrderRef), "%d", max_order_ref_);
+
+    auto rsp_info = mock_ctp_rsp_info();
+    spi->OnRspUserLogin(&rsp, &rsp_info, req_id, true);
+  });
+  return 0;
+}
+
+int MockCtpTraderApi::ReqUserLogout(CThostFtdcUserLogoutField* req,
+                                    int req_id) {
+  if (!req || !exchange_->is_connected()) return -1;
+
+  exchange_->post(this, [this, logout = *req, req_id]() mutable {
+    is_logon_ = false;
+    auto spi = connected_spi();
+    auto rsp_info = mock_ctp_rsp_info();
+    if (spi) spi->OnRspUserLogout(&logout, &rsp_info, req_id, true);
+  });
+  return 0;
+}
+
+int MockCtpTraderApi::ReqOrderInsert(CThostFtdcInputOrderField* req,
+                                     int req_id) {
+  if (!req || !exchange_->is_connected()) return -1;
+
+  exchange_->post(this, [this, order = *req, req_id] {
+    insert_order(order, req_id);
+  });
+  return 0;
+}
+
+void MockCtpTraderApi::insert_order(const CThostFtdcInputOrderField& req,
+                                    int req_id) {
+  // 断线前已经到达的报单照常处理，只是回报被丢弃
+  auto spi = connected_spi();
+  if (!is_logon_) {
+    auto input = req;
+    auto rsp_info = mock_ctp_rsp_info(3, "CTP:Not logged in");
+    if (spi) spi->OnRspOrderInsert(&input, &rsp_info, req_id, true);
+    return;
+  }
+
+  uint64_t order_id = exchange_->next_order_id();
+  CThostFtdcOrderField order{};
+  mock_ctp_copy(order.BrokerID, req.BrokerID);
+  mock_ctp_copy(order.InvestorID, req.InvestorID);
+  mock_ctp_copy(order.InstrumentID, req.InstrumentID);
+  mock_ctp_copy(order.OrderRef, req.OrderRef);
+  mock_ctp_copy(order.UserID, req.UserID);
+  mock_ctp_copy(order.ExchangeID, req.ExchangeID);
+  mock_ctp_copy(order.CombOffsetFlag, req.CombOffsetFlag);
+  mock_ctp_copy(order.CombHedgeFlag, req.CombHedgeFlag);
+  order.OrderPriceType = req.OrderPriceType;
+  order.Direction = req.Direction;
+  order.LimitPrice = req.LimitPrice;
+  order.VolumeTotalOriginal = req.VolumeTotalOriginal;
+  order.VolumeTotal = req.VolumeTotalOriginal;
+  order.TimeCondition = req.TimeCondition;
+  order.VolumeCondition = req.VolumeCondition;
+  order.MinVolume = req.MinVolume;
+  order.ContingentCondition = req.ContingentCondition;
+  order.ForceCloseReason = req.ForceCloseReason;
+  order.RequestID = req_id;
+  order.FrontID = front_id_;
+  order.SessionID = session_id_;
+  mock_ctp_copy(order.TradingDay, trading_day_);
+  mock_ctp_copy(order.InsertDate, trading_day_);
+  mock_ctp_time(order.InsertTime);
+  max_order_ref_ = std::max(max_order_ref_, atoi(req.OrderRef));
+
+  // 平仓时柜台先检查并冻结可平的持仓
+  auto closing = closing_position(order);
+  if (closing &&
+      closing->holdings - closing->frozen < order.VolumeTotalOriginal) {
+    auto input = req;
+    auto rsp_info = mock_ctp_rsp_info(30, "CTP:Close volume exceeds position");
+    if (spi) spi->OnRspOrderInsert(&input, &rsp_info, req_id, true);
+    return;
+  }
+  if (closing) closing->frozen += order.VolumeTotalOriginal;
+
+  order.OrderSubmitStatus = THOST_FTDC_OSS_InsertSubmitted;
+  order.OrderStatus = THOST_FTDC_OST_Unknown;
+  orders_.emplace(order_id, order);
+  notify_order(order);
+
+  MockOrder mock_order{};
+  mock_order.order_id = order_id;
+  mock_order.ticker = req.InstrumentID;
+  mock_order.is_buy = req.Direction == THOST_FTDC_D_Buy;
+  mock_order.is_market = req.OrderPriceType == THOST_FTDC_OPT_AnyPrice;
+  mock_order.immediate = req.TimeCondition == THOST_FTDC_TC_IOC;
+  mock_order.all_or_none = req.VolumeCondition == THOST_FTDC_VC_CV;
+  mock_order.volume = req.VolumeTotalOriginal;
+  mock_order.price = req.LimitPrice;
+  exchange_->new_order(this, std::move(mock_order));
+}
+
+int MockCtpTraderApi::ReqOrderAction(CThostFtdcInputOrderActionField* req,
+                                     int req_id) {
+  if (!req || !exchange_->is_connected()) return -1;
+
+  exchange_->post(this, [this, action = *req, req_id] {
+    cancel_order(action, req_id);
+  });
+  return 0;
+}
+
+void MockCtpTraderApi::cancel_order(
+    const CThostFtdcInputOrderActionField& req, int req_id) {
+  auto spi = connected_spi();
+
+  // 优先按OrderSysID查找，其次按FrontID+SessionID+OrderRef
+  const CThostFtdcOrderField* order = nullptr;
+  uint64_t order_id = strtoull(req.OrderSysID, nullptr, 10);
+  if (order_id != 0) {
+    auto iter = orders_.find(order_id);
+    if (iter != orders_.end()) order = &iter->second;
+  } else {
+    for (auto& [id, o] : orders_) {
+      if (o.FrontID == req.FrontID && o.SessionID == req.SessionID &&
+          strcmp(o.OrderRef, req.OrderRef) == 0) {
+        order_id = id;
+        order = &o;
+        break;
+      }
+    }
+  }
+
+  if (!order || is_finished(*order)) {
+    auto action = req;
+    auto rsp_info =
+        order ? mock_ctp_rsp_info(26, "CTP:Order already finished")
+              : mock_ctp_rsp_info(25, "CTP:Order not found");
+    if (spi) spi->OnRspOrderAction(&action, &rsp_info, req_id, true);
+    return;
+  }
+
+  exchange_->cancel_order(this, order_id);
+}
+
+int MockCtpTraderApi::ReqSettlementInfoConfirm(
+    CThostFtdcSettlementInfoConfirmField* req, int req_id) {
+  if (!req || !exchange_->is_connected()) return -1;
+
+  exchange_->post(this, [this, confirm = *req, req_id]() mutable {
+    auto spi = connected_spi();
+    if (!spi) return;
+
+    mock_ctp_copy(confirm.ConfirmDate, trading_day_);
+    mock_ctp_time(confirm.ConfirmTime);
+    auto rsp_info = mock_ctp_rsp_info();
+    spi->OnRspSettlementInfoConfirm(&confirm, &rsp_info, req_id, true);
+  });
+  return 0;
+}
+
+int MockCtpTraderApi::ReqQryOrder(CThostFtdcQryOrderField* req, int req_id) {
+  if (!req || !exchange_->is_connected()) return -1;
+
+  exchange_->post(this, [this, qry = *req, req_id] {
+    auto spi = connected_spi();
+    if (!spi) return;
+
+    std::vector<CThostFtdcOrderField> orders;
+    for (auto& [order_id, order] : orders_) {
+      if (qry.InstrumentID[0] == '\0' ||
+          strcmp(qry.InstrumentID, order.InstrumentID) == 0)
+        orders.emplace_back(order);
+    }
+
+    if (orders.empty()) {
+      spi->OnRspQryOrder(nullptr, nullptr, req_id, true);
+      return;
+    }
+
+    for (std::size_t i = 0; i < orders.size(); ++i)
+      spi->OnRspQryOrder(&orders[i], nullptr, req_id, i + 1 == orders.size());
+  });
+  return 0;
+}
+
+int MockCtpTraderApi::ReqQryTrade(CThostFtdcQryTradeField* req, int req_id) {
+  if (!req || !exchange_->is_connected()) return -1;
+
+  exchange_->post(this, [this, qry = *req, req_id] {
+    auto spi = connected_spi();
+    if (!spi) return;
+
+    std::vector<CThostFtdcTradeField> trades;
+    for (auto& trade : trades_) {
+      if (qry.InstrumentID[0] == '\0' ||
+          strcmp(qry.InstrumentID, trade.InstrumentID) == 0)
+        trades.emplace_back(trade);
+    }
+
+    if (trades.empty()) {
+      spi->OnRspQryTrade(nullptr, nullptr, req_id, true);
+      return;
+    }
+
+    for (std::size_t i = 0; i < trades.size(); ++i)
+      spi->OnRspQryTrade(&trades[i], nullptr, req_id, i + 1 == trades.size());
+  });
+  return 0;
+}
+
+int MockCtpTraderApi::ReqQryInvestorPosition(
+    CThostFtdcQryInvestorPositionField* req, int req_id) {
+  if (!req || !exchange_->is_connected()) return -1;
+
+  exchange_->post(this, [this, qry = *req, req_id] {
+    auto spi = connected_spi();
+    if (!spi) return;
+
+    std::vector<CThostFtdcInvestorPositionField> positions;
+    for (auto& [ticker, pos] : positions_) {
+      if (qry.InstrumentID[0] != '\0' && ticker != qry.InstrumentID) continue;
+
+      int size = contract_size(ticker.c_str());
+      double last_price = exchange_->get_quote(ticker).last_price;
+      auto contract = exchange_->get_contract(ticker);
+      for (int i = 0; i < 2; ++i) {
+        bool is_long = i == 0;
+        auto& detail = is_long ? pos.long_pos : pos.short_pos;
+        if (detail.holdings == 0 && detail.frozen == 0) continue;
+
+        CThostFtdcInvestorPositionField position{};
+        mock_ctp_copy(position.InstrumentID, ticker.c_str());
+        mock_ctp_copy(position.ExchangeID, pos.exchange.c_str());
+        mock_ctp_copy(position.BrokerID, broker_id_.c_str());
+        mock_ctp_copy(position.InvestorID, investor_id_.c_str());
+        mock_ctp_copy(position.TradingDay, trading_day_);
+        position.PosiDirection =
+            is_long ? THOST_FTDC_PD_Long : THOST_FTDC_PD_Short;
+        position.HedgeFlag = THOST_FTDC_HF_Speculation;
+        position.PositionDate = THOST_FTDC_PSD_Today;
+        position.Position = detail.holdings;
+        position.TodayPosition = detail.holdings;
+        position.YdPosition = 0;
+        if (is_long)
+          position.LongFrozen = detail.frozen;
+        else
+          position.ShortFrozen = detail.frozen;
+        position.PositionCost = detail.cost * size;
+        position.OpenCost = detail.cost * size;
+        double market_value = last_price * detail.holdings * size;
+        position.PositionProfit = is_long ? market_value - detail.cost * size
+                                          : detail.cost * size - market_value;
+        if (contract)
+          position.UseMargin =
+              detail.cost * size *
+              (is_long ? contract->params.long_margin_rate
+                       : contract->params.short_margin_rate);
+        positions.emplace_back(position);
+      }
+    }
+
+    if (positions.empty()) {
+      spi->OnRspQryInvestorPosition(nullptr, nullptr, req_id, true);
+      return;
+    }
+
+    for (std::size_t i = 0; i < positions.size(); ++i)
+      spi->OnRspQryInvestorPosition(&positions[i], nullptr, req_id,
+                                    i + 1 == positions.size());
+  });
+  return 0;
+}
+
+int MockCtpTraderApi::ReqQryTradingAccount(
+    CThostFtdcQryTradingAccountField* req, int req_id) {
+  if (!req || !exchange_->is_connected()) return -1;
+
+  exchange_->post(this, [this, req_id] {
+    auto spi = connected_spi();
+    if (!spi) return;
+
+    double margin = 0;
+    double position_profit = 0;
+    for (auto& [ticker, pos] : positions_) {
+      int size = contract_size(ticker.c_str());
+      double last_price = exchange_->get_quote(ticker).last_price;
+      auto contract = exchange_->get_contract(ticker);
+      if (contract)
+        margin += (pos.long_pos.cost * contract->params.long_margin_rate +
+                   pos.short_pos.cost * contract->params.short_margin_rate) *
+                  size;
+      position_profit +=
+          (last_price * pos.long_pos.holdings - pos.long_pos.cost) * size;
+      position_profit +=
+          (pos.short_pos.cost - last_price * pos.short_pos.holdings) * size;
+    }
+
+    CThostFtdcTradingAccountField account{};
+    mock_ctp_copy(account.BrokerID, broker_id_.c_str());
+    mock_ctp_copy(account.AccountID, investor_id_.c_str());
+    mock_ctp_copy(account.TradingDay, trading_day_);
+    mock_ctp_copy(account.CurrencyID, "CNY");
+    account.PreBalance = exchange_->config().cash;
+    account.CloseProfit = close_profit_;
+    account.PositionProfit = position_profit;
+    account.Balance = account.PreBalance + close_profit_ + position_profit;
+    account.CurrMargin = margin;
+    account.Available = account.Balance - margin;
+    account.WithdrawQuota = account.Available;
+
+    auto rsp_info = mock_ctp_rsp_info();
+    spi->OnRspQryTradingAccount(&account, &rsp_info, req_id, true);
+  });
+  return 0;
+}
+
+int MockCtpTraderApi::ReqQryInstrumentMarginRate(
+    CThostFtdcQryInstrumentMarginRateField* req, int req_id) {
+  if (!req || !exchange_->is_connected()) return -1;
+
+  exchange_->post(this, [this, qry = *req, req_id] {
+    auto spi = connected_spi();
+    if (!spi) return;
+
+    std::vector<CThostFtdcInstrumentMarginRateField> rates;
+    for (auto& contract : exchange_->contracts()) {
+      if (qry.InstrumentID[0] != '\0' && contract.ticker != qry.InstrumentID)
+        continue;
+
+      CThostFtdcInstrumentMarginRateField rate{};
+      mock_ctp_copy(rate.InstrumentID, contract.ticker.data());
+      mock_ctp_copy(rate.ExchangeID, contract.exchange.data());
+      mock_ctp_copy(rate.BrokerID, broker_id_.c_str());
+      mock_ctp_copy(rate.InvestorID, investor_id_.c_str());
+      rate.InvestorRange = THOST_FTDC_IR_Single;
+      rate.HedgeFlag = THOST_FTDC_HF_Speculation;
+      rate.LongMarginRatioByMoney = contract.params.long_margin_rate;
+      rate.ShortMarginRatioByMoney = contract.params.short_margin_rate;
+      rates.emplace_back(rate);
+    }
+
+    if (rates.empty()) {
+      spi->OnRspQryInstrumentMarginRate(nullptr, nullptr, req_id, true);
+      return;
+    }
+
+    for (std::size_t i = 0; i < rates.size(); ++i)
+      spi->OnRspQryInstrumentMarginRate(&rates[i], nullptr, req_id,
+                                        i + 1 == rates.size());
+  });
+  return 0;
+}
+
+int MockCtpTraderApi::ReqQryInstrument(CThostFtdcQryInstrumentField* req,
+                                       int req_id) {
+  if (!req || !exchange_->is_connected()) return -1;
+
+  exchange_->post(this, [this, qry = *req, req_id] {
+    auto spi = connected_spi();
+    if (!spi) return;
+
+    if (exchange_->contracts().empty()) {
+      auto rsp_info = mock_ctp_rsp_info(16, "CTP:FT_MOCK_CONTRACTS not set");
+      spi->OnRspQryInstrument(nullptr, &rsp_info, req_id, true);
+      return;
+    }
+
+    std::vector<CThostFtdcInstrumentField> instruments;
+    for (auto& contract : exchange_->contracts()) {
+      if (qry.InstrumentID[0] != '\0' && contract.ticker != qry.InstrumentID)
+        continue;
+      if (qry.ExchangeID[0] != '\0' && contract.exchange != qry.ExchangeID)
+        continue;
+
+      CThostFtdcInstrumentField instrument{};
+      mock_ctp_copy(instrument.InstrumentID, contract.ticker.data());
+      mock_ctp_copy(instrument.ExchangeID, contract.exchange.data());
+      mock_ctp_copy(instrument.InstrumentName, contract.name.data());
+      mock_ctp_copy(instrument.ExchangeInstID, contract.ticker.data());
+      instrument.ProductClass =
+          contract.params.product_type == ProductType::OPTIONS
+              ? THOST_FTDC_PC_Options
+              : THOST_FTDC_PC_Futures;
+      instrument.DeliveryYear = contract.delivery_year;
+      instrument.DeliveryMonth = contract.delivery_month;
+      instrument.MaxMarketOrderVolume = contract.params.max_market_order_volume;
+      instrument.MinMarketOrderVolume = contract.params.min_market_order_volume;
+      instrument.MaxLimitOrderVolume = contract.params.max_limit_order_volume;
+      instrument.MinLimitOrderVolume = contract.params.min_limit_order_volume;
+      instrument.VolumeMultiple = contract.params.size;
+      instrument.PriceTick = contract.params.price_tick;
+      instrument.IsTrading = 1;
+      instrument.LongMarginRatio = contract.params.long_margin_rate;
+      instrument.ShortMarginRatio = contract.params.short_margin_rate;
+      instruments.emplace_back(instrument);
+    }
+
+    if (instruments.empty()) {
+      spi->OnRspQryInstrument(nullptr, nullptr, req_id, true);
+      return;
+    }
+
+    for (std::size_t i = 0; i < instruments.size(); ++i)
+      spi->OnRspQryInstrument(&instruments[i], nullptr, req_id,
+                              i + 1 == instruments.size());
+  });
+  return 0;
+}
+
+int MockCtpTraderApi::ReqQrySettlementInfo(
+    CThostFtdcQrySettlementInfoField* req, int req_id) {
+  if (!req || !exchange_->is_connected()) return -1;
+
+  exchange_->post(this, [this, qry = *req, req_id] {
+    auto spi = connected_spi();
+    if (!spi) return;
+
+    CThostFtdcSettlementInfoField info{};
+    mock_ctp_copy(info.TradingDay, trading_day_);
+    mock_ctp_copy(info.BrokerID, qry.BrokerID);
+    mock_ctp_copy(info.InvestorID, qry.InvestorID);
+    mock_ctp_copy(info.Content, "Mock settlement");
+    auto rsp_info = mock_ctp_rsp_info();
+    spi->OnRspQrySettlementInfo(&info, &rsp_info, req_id, true);
+  });
+  return 0;
+}
+
+int MockCtpTraderApi::ReqQrySettlementInfoConfirm(
+    CThostFtdcQrySettlementInfoConfirmField* req, int req_id) {
+  if (!req || !exchange_->is_connected()) return -1;
+
+  exchange_->post(this, [this, qry = *req, req_id] {
+    auto spi = connected_spi();
+    if (!spi) return;
+
+    CThostFtdcSettlementInfoConfirmField confirm{};
+    mock_ctp_copy(confirm.BrokerID, qry.BrokerID);
+    mock_ctp_copy(confirm.InvestorID, qry.InvestorID);
+    mock_ctp_copy(confirm.ConfirmDate, trading_day_);
+    mock_ctp_time(confirm.ConfirmTime);
+    auto rsp_info = mock_ctp_rsp_info();
+    spi->OnRspQrySettlementInfoConfirm(&confirm, &rsp_info, req_id, true);
+  });
+  return 0;
+}
+
+void MockCtpTraderApi::on_mock_order_accepted(const MockOrder& mock_order) {
+  auto iter = orders_.find(mock_order.order_id);
+  if (iter == orders_.end()) return;
+
+  auto& order = iter->second;
+  snprintf(order.OrderSysID, sizeof(order.OrderSysID), "%12llu",
+           static_cast<unsigned long long>(mock_order.order_id));
+  order.OrderSubmitStatus = THOST_FTDC_OSS_Accepted;
+  order.OrderStatus = THOST_FTDC_OST_NoTradeQueueing;
+  mock_ctp_copy(order.StatusMsg, "NoTradeQueueing");
+  notify_order(order);
+}
+
+void MockCtpTraderApi::on_mock_order_rejected(const MockOrder& mock_order,
+                                              const char* reason) {
+  auto iter = orders_.find(mock_order.order_id);
+  if (iter == orders_.end()) return;
+
+  auto& order = iter->second;
+  auto closing = closing_position(order);
+  if (closing) closing->frozen -= order.VolumeTotalOriginal;
+
+  order.OrderSubmitStatus = THOST_FTDC_OSS_InsertRejected;
+  order.OrderStatus = THOST_FTDC_OST_Canceled;
+  mock_ctp_copy(order.StatusMsg, reason);
+  notify_order(order);
+}
+
+void MockCtpTraderApi::on_mock_order_traded(const MockOrder& mock_order,
+                                            int volume, double price) {
+  auto spi = connected_spi();
+  auto iter = orders_.find(mock_order.order_id);
+  if (iter == orders_.end()) return;
+
+  auto& order = iter->second;
+  order.VolumeTraded = mock_order.traded;
+  order.VolumeTotal = order.VolumeTotalOriginal - order.VolumeTraded;
+  order.OrderStatus = order.VolumeTotal > 0 ? THOST_FTDC_OST_PartTradedQueueing
+                                            : THOST_FTDC_OST_AllTraded;
+  mock_ctp_copy(order.StatusMsg, order.VolumeTotal > 0 ? "PartTraded"
+                                                       : "AllTraded");
+
+  CThostFtdcTradeField trade{};
+  mock_ctp_copy(trade.BrokerID, order.BrokerID);
+  mock_ctp_copy(trade.InvestorID, order.InvestorID);
+  mock_ctp_copy(trade.InstrumentID, order.InstrumentID);
+  mock_ctp_copy(trade.OrderRef, order.OrderRef);
+  mock_ctp_copy(trade.UserID, order.UserID);
+  mock_ctp_copy(trade.ExchangeID, order.ExchangeID);
+  mock_ctp_copy(trade.OrderSysID, order.OrderSysID);
+  snprintf(trade.TradeID, sizeof(trade.TradeID), "%12llu",
+           static_cast<unsigned long long>(next_trade_id_++));
+  trade.Direction = order.Direction;
+  trade.OffsetFlag = order.CombOffsetFlag[0];
+  trade.HedgeFlag = order.CombHedgeFlag[0];
+  trade.Price = price;
+  trade.Volume = volume;
+  mock_ctp_copy(trade.TradeDate, trading_day_);
+  mock_ctp_copy(trade.TradingDay, trading_day_);
+  mock_ctp_time(trade.TradeTime);
+  update_position(trade);
+  trades_.emplace_back(trade);
+
+  notify_order(order);
+  if (spi) spi->OnRtnTrade(&trade);
+}
+
+void MockCtpTraderApi::on_mock_order_canceled(const MockOrder& mock_order) {
+  auto iter = orders_.find(mock_order.order_id);
+  if (iter == orders_.end()) return;
+
+  auto& order = iter->second;
+  auto closing = closing_position(order);
+  if (closing) closing->frozen -= order.VolumeTotal;
+
+  // FAK部分成交后剩余部分被撤销
+  order.OrderStatus = order.TimeCondition == THOST_FTDC_TC_IOC &&
+                              order.VolumeTraded > 0
+                          ? THOST_FTDC_OST_PartTradedNotQueueing
+                          : THOST_FTDC_OST_Canceled;
+  mock_ctp_time(order.CancelTime);
+  mock_ctp_copy(order.StatusMsg, "Canceled");
+  notify_order(order);
+}
+
+void MockCtpTraderApi::on_mock_cancel_rejected(uint64_t order_id,
+                                               const char* reason) {
+  auto iter = orders_.find(order_id);
+  if (iter == orders_.end()) return;
+
+  // 撤单被拒不改变订单本身的状态
+  auto order = iter->second;
+  order.OrderSubmitStatus = THOST_FTDC_OSS_CancelRejected;
+  mock_ctp_copy(order.StatusMsg, reason);
+  notify_order(order);
+}
+
+void MockCtpTraderApi::on_mock_disconnected() {
+  // 断线后原来的会话失效，重连后需要重新认证和登录
+  is_logon_ = false;
+  session_id_ = next_session_id.fetch_add(1);
+  auto spi = spi_.load();
+  if (spi) spi->OnFrontDisconnected(0x1001);
+}
+
+void MockCtpTraderApi::on_mock_reconnected() {
+  auto spi = spi_.load();
+  if (spi) spi->OnFrontConnected();
+}
+
+void MockCtpTraderApi::notify_order(const CThostFtdcOrderField& order) {
+  auto spi = connected_spi();
+  if (!spi) return;
+
+  auto rtn_order = order;
+  spi->OnRtnOrder(&rtn_order);
+}
+
+MockCtpTraderApi::PositionDetail* MockCtpTraderApi::closing_position(
+    const CThostFtdcOrderField& order) {
+  if (order.CombOffsetFlag[0] == THOST_FTDC_OF_Open) return nullptr;
+
+  auto& pos = positions_[order.InstrumentID];
+  return order.Direction == THOST_FTDC_D_Buy ? &pos.short_pos : &pos.long_pos;
+}
+
+void MockCtpTraderApi::update_position(const CThostFtdcTradeField& trade) {
+  auto& pos = positions_[trade.InstrumentID];
+  pos.exchange = trade.ExchangeID;
+
+  bool is_buy = trade.Direction == THOST_FTDC_D_Buy;
+  if (trade.OffsetFlag == THOST_FTDC_OF_Open) {
+    auto& detail = is_buy ? pos.long_pos : pos.short_pos;
+    detail.holdings += trade.Volume;
+    detail.cost += trade.Price * trade.Volume;
+    return;
+  }
+
+  auto& detail = is_buy ? pos.short_pos : pos.long_pos;
+  int volume = std::min(trade.Volume, detail.holdings);
+  double avg_price = detail.holdings > 0 ? detail.cost / detail.holdings : 0;
+  detail.holdings -= volume;
+  detail.frozen -= trade.Volume;
+  detail.cost -= avg_price * volume;
+  double profit = is_buy ? avg_price - trade.Price : trade.Price - avg_price;
+  close_profit_ += profit * volume * contract_size(trade.InstrumentID);
+}
+
+bool MockCtpTraderApi::is_finished(const CThostFtdcOrderField& order) const {
+  return order.OrderStatus == THOST_FTDC_OST_AllTraded ||
+         order.OrderStatus == THOST_FTDC_OST_Canceled ||
+         order.OrderStatus == THOST_FTDC_OST_PartTradedNotQueueing ||
+         order.OrderSubmitStatus == THOST_FTDC_OSS_InsertRejected;
+}
+
+int MockCtpTraderApi::contract_size(const char* ticker) const {
+  auto contract = exchange_->get_contract(ticker);
+  return contract && contract->params.size > 0 ? contract->params.size : 1;
+}
+
+}  // namespace ft
@@ -0,0 +1,275 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef FT_SRC_GATEWAY_MOCK_MOCK_CTP_TRADER_API_H_
+#define FT_SRC_GATEWAY_MOCK_MOCK_CTP_TRADER_API_H_
+
+#include <ThostFtdcTraderApi.h>
+
+#include <atomic>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "gateway/mock/mock_exchange.h"
+
+namespace ft {
+
+#define MOCK_CTP_UNSUPPORTED(method, field) \
+  int method(field*, int) override { return -1; }
+
+/*
+ * CThostFtdcTraderApi的模拟实现，编译为libthosttraderapi_se.so，
+ * 运行时通过LD_LIBRARY_PATH替换真实的CTP库
+ *
+ * 实现了登录、结算确认、报撤单及常用查询，报单由MockExchange撮合，
+ * 持仓和资金只统计本进程内的成交。未实现的请求返回-1
+ */
+class MockCtpTraderApi : public CThostFtdcTraderApi,
+                         public MockExchangeListener {
+ public:
+  MockCtpTraderApi();
+
+  void Release() override;
+
+  void Init() override;
+
+  int Join() override { return 0; }
+
+  const char* GetTradingDay() override { return trading_day_; }
+
+  void RegisterFront(char* front_address) override {}
+
+  void RegisterNameServer(char* ns_address) override {}
+
+  void RegisterFensUserInfo(CThostFtdcFensUserInfoField* info) override {}
+
+  void RegisterSpi(CThostFtdcTraderSpi* spi) override;
+
+  void SubscribePrivateTopic(THOST_TE_RESUME_TYPE resume_type) override {}
+
+  void SubscribePublicTopic(THOST_TE_RESUME_TYPE resume_type) override {}
+
+  int ReqAuthenticate(CThostFtdcReqAuthenticateField* req,
+                      int req_id) override;
+
+  int RegisterUserSystemInfo(CThostFtdcUserSystemInfoField* info) override {
+    return 0;
+  }
+
+  int SubmitUserSystemInfo(CThostFtdcUserSystemInfoField* info) override {
+    return 0;
+  }
+
+  int ReqUserLogin(CThostFtdcReqUserLoginField* req, int req_id) override;
+
+  int ReqUserLogout(CThostFtdcUserLogoutField* req, int req_id) override;
+
+  int ReqOrderInsert(CThostFtdcInputOrderField* req, int req_id) override;
+
+  int ReqOrderAction(CThostFtdcInputOrderActionField* req,
+                     int req_id) override;
+
+  int ReqSettlementInfoConfirm(CThostFtdcSettlementInfoConfirmField* req,
+                               int req_id) override;
+
+  int ReqQryOrder(CThostFtdcQryOrderField* req, int req_id) override;
+
+  int ReqQryTrade(CThostFtdcQryTradeField* req, int req_id) override;
+
+  int ReqQryInvestorPosition(CThostFtdcQryInvestorPositionField* req,
+                             int req_id) override;
+
+  int ReqQryTradingAccount(CThostFtdcQryTradingAccountField* req,
+                           int req_id) override;
+
+  int ReqQryInstrumentMarginRate(CThostFtdcQryInstrumentMarginRateField* req,
+                                 int req_id) override;
+
+  int ReqQryInstrument(CThostFtdcQryInstrumentField* req, int req_id) override;
+
+  int ReqQrySettlementInfo(CThostFtdcQrySettlementInfoField* req,
+                           int req_id) override;
+
+  int ReqQrySettlementInfoConfirm(
+      CThostFtdcQrySettlementInfoConfirmField* req, int req_id) override;
+
+  MOCK_CTP_UNSUPPORTED(ReqUserPasswordUpdate,
+                       CThostFtdcUserPasswordUpdateField);
+  MOCK_CTP_UNSUPPORTED(ReqTradingAccountPasswordUpdate,
+                       CThostFtdcTradingAccountPasswordUpdateField);
+  MOCK_CTP_UNSUPPORTED(ReqUserAuthMethod, CThostFtdcReqUserAuthMethodField);
+  MOCK_CTP_UNSUPPORTED(ReqGenUserCaptcha, CThostFtdcReqGenUserCaptchaField);
+  MOCK_CTP_UNSUPPORTED(ReqGenUserText, CThostFtdcReqGenUserTextField);
+  MOCK_CTP_UNSUPPORTED(ReqUserLoginWithCaptcha,
+                       CThostFtdcReqUserLoginWithCaptchaField);
+  MOCK_CTP_UNSUPPORTED(ReqUserLoginWithText,
+                       CThostFtdcReqUserLoginWithTextField);
+  MOCK_CTP_UNSUPPORTED(ReqUserLoginWithOTP, CThostFtdcReqUserLoginWithOTPField);
+  MOCK_CTP_UNSUPPORTED(ReqParkedOrderInsert, CThostFtdcParkedOrderField);
+  MOCK_CTP_UNSUPPORTED(ReqParkedOrderAction, CThostFtdcParkedOrderActionField);
+  MOCK_CTP_UNSUPPORTED(ReqQueryMaxOrderVolume,
+                       CThostFtdcQueryMaxOrderVolumeField);
+  MOCK_CTP_UNSUPPORTED(ReqRemoveParkedOrder, CThostFtdcRemoveParkedOrderField);
+  MOCK_CTP_UNSUPPORTED(ReqRemoveParkedOrderAction,
+                       CThostFtdcRemoveParkedOrderActionField);
+  MOCK_CTP_UNSUPPORTED(ReqExecOrderInsert, CThostFtdcInputExecOrderField);
+  MOCK_CTP_UNSUPPORTED(ReqExecOrderAction, CThostFtdcInputExecOrderActionField);
+  MOCK_CTP_UNSUPPORTED(ReqForQuoteInsert, CThostFtdcInputForQuoteField);
+  MOCK_CTP_UNSUPPORTED(ReqQuoteInsert, CThostFtdcInputQuoteField);
+  MOCK_CTP_UNSUPPORTED(ReqQuoteAction, CThostFtdcInputQuoteActionField);
+  MOCK_CTP_UNSUPPORTED(ReqBatchOrderAction,
+                       CThostFtdcInputBatchOrderActionField);
+  MOCK_CTP_UNSUPPORTED(ReqOptionSelfCloseInsert,
+                       CThostFtdcInputOptionSelfCloseField);
+  MOCK_CTP_UNSUPPORTED(ReqOptionSelfCloseAction,
+                       CThostFtdcInputOptionSelfCloseActionField);
+  MOCK_CTP_UNSUPPORTED(ReqCombActionInsert, CThostFtdcInputCombActionField);
+  MOCK_CTP_UNSUPPORTED(ReqQryInvestor, CThostFtdcQryInvestorField);
+  MOCK_CTP_UNSUPPORTED(ReqQryTradingCode, CThostFtdcQryTradingCodeField);
+  MOCK_CTP_UNSUPPORTED(ReqQryInstrumentCommissionRate,
+                       CThostFtdcQryInstrumentCommissionRateField);
+  MOCK_CTP_UNSUPPORTED(ReqQryExchange, CThostFtdcQryExchangeField);
+  MOCK_CTP_UNSUPPORTED(ReqQryProduct, CThostFtdcQryProductField);
+  MOCK_CTP_UNSUPPORTED(ReqQryDepthMarketData,
+                       CThostFtdcQryDepthMarketDataField);
+  MOCK_CTP_UNSUPPORTED(ReqQryTransferBank, CThostFtdcQryTransferBankField);
+  MOCK_CTP_UNSUPPORTED(ReqQryInvestorPositionDetail,
+                       CThostFtdcQryInvestorPositionDetailField);
+  MOCK_CTP_UNSUPPORTED(ReqQryNotice, CThostFtdcQryNoticeField);
+  MOCK_CTP_UNSUPPORTED(ReqQryInvestorPositionCombineDetail,
+                       CThostFtdcQryInvestorPositionCombineDetailField);
+  MOCK_CTP_UNSUPPORTED(ReqQryCFMMCTradingAccountKey,
+                       CThostFtdcQryCFMMCTradingAccountKeyField);
+  MOCK_CTP_UNSUPPORTED(ReqQryEWarrantOffset, CThostFtdcQryEWarrantOffsetField);
+  MOCK_CTP_UNSUPPORTED(ReqQryInvestorProductGroupMargin,
+                       CThostFtdcQryInvestorProductGroupMarginField);
+  MOCK_CTP_UNSUPPORTED(ReqQryExchangeMarginRate,
+                       CThostFtdcQryExchangeMarginRateField);
+  MOCK_CTP_UNSUPPORTED(ReqQryExchangeMarginRateAdjust,
+                       CThostFtdcQryExchangeMarginRateAdjustField);
+  MOCK_CTP_UNSUPPORTED(ReqQryExchangeRate, CThostFtdcQryExchangeRateField);
+  MOCK_CTP_UNSUPPORTED(ReqQrySecAgentACIDMap,
+                       CThostFtdcQrySecAgentACIDMapField);
+  MOCK_CTP_UNSUPPORTED(ReqQryProductExchRate,
+                       CThostFtdcQryProductExchRateField);
+  MOCK_CTP_UNSUPPORTED(ReqQryProductGroup, CThostFtdcQryProductGroupField);
+  MOCK_CTP_UNSUPPORTED(ReqQryMMInstrumentCommissionRate,
+                       CThostFtdcQryMMInstrumentCommissionRateField);
+  MOCK_CTP_UNSUPPORTED(ReqQryMMOptionInstrCommRate,
+                       CThostFtdcQryMMOptionInstrCommRateField);
+  MOCK_CTP_UNSUPPORTED(ReqQryInstrumentOrderCommRate,
+                       CThostFtdcQryInstrumentOrderCommRateField);
+  MOCK_CTP_UNSUPPORTED(ReqQrySecAgentTradingAccount,
+                       CThostFtdcQryTradingAccountField);
+  MOCK_CTP_UNSUPPORTED(ReqQrySecAgentCheckMode,
+                       CThostFtdcQrySecAgentCheckModeField);
+  MOCK_CTP_UNSUPPORTED(ReqQrySecAgentTradeInfo,
+                       CThostFtdcQrySecAgentTradeInfoField);
+  MOCK_CTP_UNSUPPORTED(ReqQryOptionInstrTradeCost,
+                       CThostFtdcQryOptionInstrTradeCostField);
+  MOCK_CTP_UNSUPPORTED(ReqQryOptionInstrCommRate,
+                       CThostFtdcQryOptionInstrCommRateField);
+  MOCK_CTP_UNSUPPORTED(ReqQryExecOrder, CThostFtdcQryExecOrderField);
+  MOCK_CTP_UNSUPPORTED(ReqQryForQuote, CThostFtdcQryForQuoteField);
+  MOCK_CTP_UNSUPPORTED(ReqQryQuote, CThostFtdcQryQuoteField);
+  MOCK_CTP_UNSUPPORTED(ReqQryOptionSelfClose,
+                       CThostFtdcQryOptionSelfCloseField);
+  MOCK_CTP_UNSUPPORTED(ReqQryInvestUnit, CThostFtdcQryInvestUnitField);
+  MOCK_CTP_UNSUPPORTED(ReqQryCombInstrumentGuard,
+                       CThostFtdcQryCombInstrumentGuardField);
+  MOCK_CTP_UNSUPPORTED(ReqQryCombAction, CThostFtdcQryCombActionField);
+  MOCK_CTP_UNSUPPORTED(ReqQryTransferSerial, CThostFtdcQryTransferSerialField);
+  MOCK_CTP_UNSUPPORTED(ReqQryAccountregister,
+                       CThostFtdcQryAccountregisterField);
+  MOCK_CTP_UNSUPPORTED(ReqQryContractBank, CThostFtdcQryContractBankField);
+  MOCK_CTP_UNSUPPORTED(ReqQryParkedOrder, CThostFtdcQryParkedOrderField);
+  MOCK_CTP_UNSUPPORTED(ReqQryParkedOrderAction,
+                       CThostFtdcQryParkedOrderActionField);
+  MOCK_CTP_UNSUPPORTED(ReqQryTradingNotice, CThostFtdcQryTradingNoticeField);
+  MOCK_CTP_UNSUPPORTED(ReqQryBrokerTradingParams,
+                       CThostFtdcQryBrokerTradingParamsField);
+  MOCK_CTP_UNSUPPORTED(ReqQryBrokerTradingAlgos,
+                       CThostFtdcQryBrokerTradingAlgosField);
+  MOCK_CTP_UNSUPPORTED(ReqQueryCFMMCTradingAccountToken,
+                       CThostFtdcQueryCFMMCTradingAccountTokenField);
+  MOCK_CTP_UNSUPPORTED(ReqFromBankToFutureByFuture, CThostFtdcReqTransferField);
+  MOCK_CTP_UNSUPPORTED(ReqFromFutureToBankByFuture, CThostFtdcReqTransferField);
+  MOCK_CTP_UNSUPPORTED(ReqQueryBankAccountMoneyByFuture,
+                       CThostFtdcReqQueryAccountField);
+
+  void on_mock_order_accepted(const MockOrder& order) override;
+
+  void on_mock_order_rejected(const MockOrder& order,
+                              const char* reason) override;
+
+  void on_mock_order_traded(const MockOrder& order, int volume,
+                            double price) override;
+
+  void on_mock_order_canceled(const MockOrder& order) override;
+
+  void on_mock_cancel_rejected(uint64_t order_id, const char* reason) override;
+
+  void on_mock_disconnected() override;
+
+  void on_mock_reconnected() override;
+
+ private:
+  // 模拟断线期间产生的回报都被丢弃
+  CThostFtdcTraderSpi* connected_spi() const {
+    return exchange_->is_connected() ? spi_.load() : nullptr;
+  }
+
+  struct PositionDetail {
+    int holdings = 0;
+    int frozen = 0;   // 未成交的平仓单冻结的持仓
+    double cost = 0;  // 开仓金额，不含合约乘数
+  };
+
+  struct MockPosition {
+    std::string exchange;
+    PositionDetail long_pos;
+    PositionDetail short_pos;
+  };
+
+  ~MockCtpTraderApi() = default;
+
+  void insert_order(const CThostFtdcInputOrderField& req, int req_id);
+
+  void cancel_order(const CThostFtdcInputOrderActionField& req, int req_id);
+
+  void notify_order(const CThostFtdcOrderField& order);
+
+  // 平仓单冻结的是反方向的持仓，开仓单返回nullptr
+  PositionDetail* closing_position(const CThostFtdcOrderField& order);
+
+  void update_position(const CThostFtdcTradeField& trade);
+
+  bool is_finished(const CThostFtdcOrderField& order) const;
+
+  int contract_size(const char* ticker) const;
+
+ private:
+  MockExchange* exchange_;
+  std::atomic<CThostFtdcTraderSpi*> spi_ = nullptr;
+  char trading_day_[9]{};
+
+  // 以下成员只在撮合线程中访问
+  bool is_logon_ = false;
+  std::string broker_id_;
+  std::string investor_id_;
+  int front_id_ = 1;
+  int session_id_ = 0;
+  int max_order_ref_ = 0;
+  uint64_t next_trade_id_ = 1;
+  double close_profit_ = 0;
+  std::unordered_map<uint64_t, CThostFtdcOrderField> orders_;
+  std::vector<CThostFtdcTradeField> trades_;
+  std::map<std::string, MockPosition> positions_;
+};
+
+#undef MOCK_CTP_UNSUPPORTED
+
+}  // namespace ft
+
+#endif  // FT_SRC_GATEWAY_MOCK_MOCK_CTP_TRADER_API_H_
@@ -0,0 +1,429 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#include "gateway/mock/mock_exchange.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <thread>
+#include <utility>
+
+#include "core/contract_table.h"
+#include "core/price.h"
+
+namespace ft {
+
+namespace {
+
+double env_double(const char* name, double default_value) {
+  const char* value = getenv(name);
+  return value ? atof(value) : default_value;
+}
+
+uint64_t env_uint(const char* name, uint64_t default_value) {
+  const char* value = getenv(name);
+  return value ? strtoull(value, nullptr, 10) : default_value;
+}
+
+double round_price(double price, double price_tick) {
+  return std::round(price / price_tick) * price_tick;
+}
+
+}  // namespace
+
+MockExchange* MockExchange::instance() {
+  // 撮合线程是detach的，不析构
+  static MockExchange* exchange = new MockExchange;
+  return exchange;
+}
+
+MockExchange::MockExchange() {
+  config_.latency_us = env_uint("FT_MOCK_LATENCY_US", config_.latency_us);
+  config_.reject_ratio = env_double("FT_MOCK_REJECT_RATIO", 0);
+  config_.partial_fill_ratio = env_double("FT_MOCK_PARTIAL_FILL_RATIO", 0);
+  config_.tick_interval_ms =
+      env_uint("FT_MOCK_TICK_INTERVAL_MS", config_.tick_interval_ms);
+  config_.initial_price =
+      env_double("FT_MOCK_INITIAL_PRICE", config_.initial_price);
+  config_.cash = env_double("FT_MOCK_CASH", config_.cash);
+  config_.seed = env_uint("FT_MOCK_SEED", 0);
+  config_.disconnect_after_ms = env_uint("FT_MOCK_DISCONNECT_AFTER_MS", 0);
+  config_.disconnect_ms =
+      env_uint("FT_MOCK_DISCONNECT_MS", config_.disconnect_ms);
+  if (getenv("FT_MOCK_CONTRACTS"))
+    config_.contracts_file = getenv("FT_MOCK_CONTRACTS");
+
+  if (!config_.contracts_file.empty()) {
+    auto& file = contract_file_;
+    bool res = file.open(config_.contracts_file);
+    if (res && file.is_binary()) {
+      res = file.validate();
+      if (res) load_contracts_binary(file, &contracts_, nullptr);
+    } else if (res) {
+      file.close();
+      res = load_contracts(config_.contracts_file, &contracts_,
+                           &contract_strings_);
+    }
+
+    if (!res) {
+      fprintf(stderr, "[MockExchange] Failed to load contracts from %s\n",
+              config_.contracts_file.c_str());
+      contracts_.clear();
+    }
+
+    for (std::size_t i = 0; i < contracts_.size(); ++i)
+      contract_map_.emplace(contracts_[i].ticker, i);
+  }
+
+  rng_.seed(config_.seed);
+  next_tick_ns_ = now_ns() + config_.tick_interval_ms * 1000000;
+  if (config_.disconnect_after_ms > 0) {
+    disconnect_ns_ = now_ns() + config_.disconnect_after_ms * 1000000;
+    reconnect_ns_ = disconnect_ns_ + config_.disconnect_ms * 1000000;
+  }
+  std::thread([this] { run(); }).detach();
+}
+
+const Contract* MockExchange::get_contract(const std::string& ticker) const {
+  auto iter = contract_map_.find(ticker);
+  if (iter == contract_map_.end()) return nullptr;
+  return &contracts_[iter->second];
+}
+
+void MockExchange::post(MockExchangeListener* listener,
+                        std::function<void()> fn) {
+  // 延迟是固定的，先投递的请求一定先到期，用队列即可
+  int64_t due_ns = now_ns() + config_.latency_us * 1000;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    events_.emplace_back(Event{due_ns, listener, std::move(fn)});
+  }
+  cv_.notify_one();
+}
+
+void MockExchange::run() {
+  std::vector<Event> ready;
+  int64_t tick_interval_ns = config_.tick_interval_ms * 1000000;
+
+  for (;;) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+      int64_t now = now_ns();
+      bool tick_due = tick_interval_ns > 0 && now >= next_tick_ns_;
+      int64_t switch_ns = disconnect_ns_ > 0 ? disconnect_ns_ : reconnect_ns_;
+      bool switch_due = switch_ns > 0 && now >= switch_ns;
+      if (tick_due || switch_due ||
+          (!events_.empty() && events_.front().due_ns <= now))
+        break;
+
+      int64_t wake_ns = tick_interval_ns > 0 ? next_tick_ns_ : INT64_MAX;
+      if (!events_.empty()) wake_ns = std::min(wake_ns, events_.front().due_ns);
+      if (switch_ns > 0) wake_ns = std::min(wake_ns, switch_ns);
+      if (wake_ns == INT64_MAX)
+        cv_.wait(lock);
+      else
+        cv_.wait_for(lock, std::chrono::nanoseconds(wake_ns - now));
+    }
+    lock.unlock();
+
+    // 先拿到dispatch锁再取出事件，保证remove_listener之后不会再回调
+    auto dispatch_lock = lock_dispatch();
+    lock.lock();
+    int64_t now = now_ns();
+    while (!events_.empty() && events_.front().due_ns <= now) {
+      ready.emplace_back(std::move(events_.front()));
+      events_.pop_front();
+    }
+    lock.unlock();
+
+    for (auto& event : ready) {
+      listeners_.insert(event.listener);
+      event.fn();
+    }
+    ready.clear();
+    update_connection(now);
+
+    if (tick_interval_ns > 0 && now >= next_tick_ns_) {
+      update_quotes();
+      next_tick_ns_ = std::max(next_tick_ns_ + tick_interval_ns, now);
+    }
+  }
+}
+
+void MockExchange::new_order(MockExchangeListener* listener, MockOrder order) {
+  order.traded = 0;
+
+  if (!contracts_.empty() && !get_contract(order.ticker)) {
+    listener->on_mock_order_rejected(order, "Instrument not found");
+    return;
+  }
+
+  if (order.volume <= 0) {
+    listener->on_mock_order_rejected(order, "Invalid volume");
+    return;
+  }
+
+  if (!order.is_market && order.price < 1e-6) {
+    listener->on_mock_order_rejected(order, "Invalid price");
+    return;
+  }
+
+  if (dist_(rng_) < config_.reject_ratio) {
+    listener->on_mock_order_rejected(order, "Rejected by mock exchange");
+    return;
+  }
+
+  auto book = get_book(order.ticker);
+  listener->on_mock_order_accepted(order);
+
+  if (is_marketable(order, *book)) {
+    int volume = fill_volume(order);
+    if (volume > 0) {
+      order.traded += volume;
+      listener->on_mock_order_traded(order, volume,
+                                     match_price(order, *book, false));
+    }
+  }
+
+  if (order.traded >= order.volume) return;
+
+  if (!rests_on_book(order.is_market, order.immediate)) {
+    listener->on_mock_order_canceled(order);
+    return;
+  }
+
+  book->orders.emplace_back(RestingOrder{order, listener});
+  resting_orders_[order.order_id] = {book, std::prev(book->orders.end())};
+}
+
+void MockExchange::cancel_order(MockExchangeListener* listener,
+                                uint64_t order_id) {
+  auto iter = resting_orders_.find(order_id);
+  if (iter == resting_orders_.end() ||
+      iter->second.second->listener != listener) {
+    listener->on_mock_cancel_rejected(order_id,
+                                      "Order not found or already finished");
+    return;
+  }
+
+  auto [book, order_iter] = iter->second;
+  MockOrder order = order_iter->order;
+  book->orders.erase(order_iter);
+  resting_orders_.erase(iter);
+  listener->on_mock_order_canceled(order);
+}
+
+void MockExchange::subscribe(MockExchangeListener* listener,
+                             const std::string& ticker) {
+  auto& subscribers = get_book(ticker)->subscribers;
+  if (std::find(subscribers.begin(), subscribers.end(), listener) ==
+      subscribers.end())
+    subscribers.emplace_back(listener);
+}
+
+void MockExchange::unsubscribe(MockExchangeListener* listener,
+                               const std::string& ticker) {
+  auto iter = books_.find(ticker);
+  if (iter == books_.end()) return;
+
+  auto& subscribers = iter->second.subscribers;
+  subscribers.erase(
+      std::remove(subscribers.begin(), subscribers.end(), listener),
+      subscribers.end());
+}
+
+const MockQuote& MockExchange::get_quote(const std::string& ticker) {
+  return get_book(ticker)->quote;
+}
+
+void MockExchange::update_connection(int64_t now) {
+  if (disconnect_ns_ > 0 && now >= disconnect_ns_) {
+    disconnect_ns_ = 0;
+    is_connected_ = false;
+    fprintf(stderr, "[MockExchange] Disconnected for %lums\n",
+            config_.disconnect_ms);
+
+    // 断线后柜台上的订阅全部失效，挂单不受影响
+    for (auto& [ticker, book] : books_) book.subscribers.clear();
+    for (auto* listener : listeners_) listener->on_mock_disconnected();
+  } else if (reconnect_ns_ > 0 && now >= reconnect_ns_) {
+    reconnect_ns_ = 0;
+    is_connected_ = true;
+    fprintf(stderr, "[MockExchange] Reconnected\n");
+    for (auto* listener : listeners_) listener->on_mock_reconnected();
+  }
+}
+
+void MockExchange::remove_listener(MockExchangeListener* listener) {
+  auto dispatch_lock = lock_dispatch();
+  listeners_.erase(listener);
+
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    events_.erase(std::remove_if(events_.begin(), events_.end(),
+                                 [=](const Event& event) {
+                                   return event.listener == listener;
+                                 }),
+                  events_.end());
+  }
+
+  for (auto& [ticker, book] : books_) {
+    auto& subscribers = book.subscribers;
+    subscribers.erase(
+        std::remove(subscribers.begin(), subscribers.end(), listener),
+        subscribers.end());
+
+    for (auto iter = book.orders.begin(); iter != book.orders.end();) {
+      if (iter->listener == listener) {
+        resting_orders_.erase(iter->order.order_id);
+        iter = book.orders.erase(iter);
+      } else {
+        ++iter;
+      }
+    }
+  }
+}
+
+MockExchange::Book* MockExchange::get_book(const std::string& ticker) {
+  auto iter = books_.find(ticker);
+  if (iter != books_.end()) return &iter->second;
+
+  auto& book = books_[ticker];
+  auto contract = get_contract(ticker);
+  auto params = contract ? &contract->params : nullptr;
+  book.price_tick =
+      params && params->price_tick > 1e-6 ? params->price_tick : 0.01;
+  book.size = params && params->size > 0 ? params->size : 1;
+
+  auto& quote = book.quote;
+  double price = std::max(round_price(config_.initial_price, book.price_tick),
+                          book.price_tick * 10);
+  quote.ticker = ticker;
+  quote.pre_close_price = price;
+  quote.open_price = price;
+  quote.highest_price = price;
+  quote.lowest_price = price;
+  quote.last_price = price;
+  quote.upper_limit_price = round_price(price * 1.1, book.price_tick);
+  quote.lower_limit_price = round_price(price * 0.9, book.price_tick);
+  set_levels(&book, price);
+  return &book;
+}
+
+void MockExchange::set_levels(Book* book, double bid) {
+  auto& quote = book->quote;
+  for (int i = 0; i < kMockQuoteLevel; ++i) {
+    quote.bid[i] = bid - i * book->price_tick;
+    quote.ask[i] = bid + (i + 1) * book->price_tick;
+    quote.bid_volume[i] = 1 + static_cast<int>(dist_(rng_) * 100);
+    quote.ask_volume[i] = 1 + static_cast<int>(dist_(rng_) * 100);
+  }
+
+  auto now = std::chrono::system_clock::now();
+  time_t seconds = std::chrono::system_clock::to_time_t(now);
+  struct tm local_time;
+  localtime_r(&seconds, &local_time);
+  quote.date = (local_time.tm_year + 1900) * 10000 +
+               (local_time.tm_mon + 1) * 100 + local_time.tm_mday;
+  quote.time_ms =
+      (local_time.tm_hour * 3600 + local_time.tm_min * 60 + local_time.tm_sec) *
+          1000LL +
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+          now.time_since_epoch())
+              .count() %
+          1000;
+}
+
+void MockExchange::update_quotes() {
+  for (auto& [ticker, book] : books_) {
+    if (book.subscribers.empty() && book.orders.empty()) continue;
+
+    // 随机游走，价格限制在涨跌停之内
+    auto& quote = book.quote;
+    double bid = quote.bid[0];
+    double direction = dist_(rng_);
+    if (direction < 0.33)
+      bid -= book.price_tick;
+    else if (direction > 0.66)
+      bid += book.price_tick;
+    bid = std::min(std::max(bid, quote.lower_limit_price),
+                   quote.upper_limit_price - book.price_tick);
+    set_levels(&book, bid);
+
+    int volume = 1 + static_cast<int>(dist_(rng_) * 10);
+    quote.last_price = dist_(rng_) < 0.5 ? quote.bid[0] : quote.ask[0];
+    quote.volume += volume;
+    quote.turnover += quote.last_price * volume * book.size;
+    quote.highest_price = std::max(quote.highest_price, quote.last_price);
+    quote.lowest_price = std::min(quote.lowest_price, quote.last_price);
+
+    match_resting_orders(&book);
+    for (auto listener : book.subscribers) listener->on_mock_quote(quote);
+  }
+}
+
+void MockExchange::match_resting_orders(Book* book) {
+  for (auto iter = book->orders.begin(); iter != book->orders.end();) {
+    auto& order = iter->order;
+    if (!is_marketable(order, *book)) {
+      ++iter;
+      continue;
+    }
+
+    int volume = fill_volume(order);
+    if (volume <= 0) {
+      ++iter;
+      continue;
+    }
+
+    order.traded += volume;
+    iter->listener->on_mock_order_traded(order, volume,
+                                         match_price(order, *book, true));
+    if (order.traded >= order.volume) {
+      resting_orders_.erase(order.order_id);
+      iter = book->orders.erase(iter);
+    } else {
+      ++iter;
+    }
+  }
+}
+
+int MockExchange::fill_volume(const MockOrder& order) {
+  int remain = order.volume - order.traded;
+  if (dist_(rng_) >= config_.partial_fill_ratio) return remain;
+
+  // FOK不能部分成交，注入部分成交时视为对手盘不足
+  if (order.all_or_none) return 0;
+  // 只剩1手时无法再拆分
+  return remain > 1 ? std::max(1, remain / 2) : remain;
+}
+
+MatchQuote MockExchange::match_quote(const Book& book) {
+  return {to_tick_price(book.quote.bid[0], book.price_tick),
+          to_tick_price(book.quote.ask[0], book.price_tick)};
+}
+
+bool MockExchange::is_marketable(const MockOrder& order, const Book& book) {
+  return ft::is_marketable(order.is_buy, order.is_market,
+                           to_tick_price(order.price, book.price_tick),
+                           match_quote(book));
+}
+
+double MockExchange::match_price(const MockOrder& order, const Book& book,
+                                 bool is_resting) {
+  auto price = ft::match_price(order.is_buy, is_resting,
+                               to_tick_price(order.price, book.price_tick),
+                               match_quote(book));
+  return to_real_price(price, book.price_tick);
+}
+
+int64_t MockExchange::now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+}  // namespace ft
@@ -0,0 +1,246 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef FT_SRC_GATEWAY_MOCK_MOCK_EXCHANGE_H_
+#define FT_SRC_GATEWAY_MOCK_MOCK_EXCHANGE_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "core/contract_table.h"
+#include "gateway/virtual/order_matching.h"
+
+namespace ft {
+
+/*
+ * 模拟交易所，为mock版本的CTP/XTP API提供撮合及行情
+ *
+ * 所有请求都被投递到同一个撮合线程中执行，模拟柜台的网络延迟，
+ * 撮合、行情生成以及对listener的回调都在该线程中完成，
+ * 因此listener内部的状态不需要加锁。
+ *
+ * 通过环境变量配置：
+ *   FT_MOCK_LATENCY_US          请求到达及回报返回的延迟，默认0
+ *   FT_MOCK_REJECT_RATIO        随机拒单的比例，默认0
+ *   FT_MOCK_PARTIAL_FILL_RATIO  每次撮合只成交一半的比例，默认0
+ *   FT_MOCK_TICK_INTERVAL_MS    行情的推送间隔，0表示不推送，默认500
+ *   FT_MOCK_INITIAL_PRICE       合约的初始价格，默认100
+ *   FT_MOCK_CASH                账户的初始资金，默认1e8
+ *   FT_MOCK_CONTRACTS           合约表(csv或二进制)，用于合约查询，可不设置
+ *   FT_MOCK_SEED                随机数种子，默认0
+ *   FT_MOCK_DISCONNECT_AFTER_MS 模拟断线的时间，从交易所创建时起算，
+ *                               0表示不断线，默认0
+ *   FT_MOCK_DISCONNECT_MS       断线持续的时间，默认1000
+ *
+ * 断线期间API的请求都返回失败，撮合线程中已经收到的请求照常处理，但是
+ * 产生的回报都被丢弃，行情订阅也全部失效，用于测试Gateway的断线重连
+ */
+struct MockExchangeConfig {
+  uint64_t latency_us = 0;
+  double reject_ratio = 0;
+  double partial_fill_ratio = 0;
+  uint64_t tick_interval_ms = 500;
+  double initial_price = 100;
+  double cash = 1e8;
+  std::string contracts_file;
+  uint32_t seed = 0;
+  uint64_t disconnect_after_ms = 0;
+  uint64_t disconnect_ms = 1000;
+};
+
+struct MockOrder {
+  uint64_t order_id;
+  std::string ticker;
+  bool is_buy;
+  bool is_market;
+  bool immediate;    // FAK/FOK，未能立即成交的部分撤销
+  bool all_or_none;  // FOK
+  int volume;
+  int traded;
+  double price;
+};
+
+// XTP推送10档行情，CTP只使用前5档
+constexpr int kMockQuoteLevel = 10;
+
+struct MockQuote {
+  std::string ticker;
+  double last_price;
+  double open_price;
+  double highest_price;
+  double lowest_price;
+  double pre_close_price;
+  double upper_limit_price;
+  double lower_limit_price;
+  double bid[kMockQuoteLevel];
+  double ask[kMockQuoteLevel];
+  int bid_volume[kMockQuoteLevel];
+  int ask_volume[kMockQuoteLevel];
+  int64_t volume;
+  double turnover;
+  int64_t date;     // YYYYMMDD
+  int64_t time_ms;  // 当天0点起的毫秒数
+};
+
+class MockExchangeListener {
+ public:
+  virtual ~MockExchangeListener() {}
+
+  virtual void on_mock_order_accepted(const MockOrder& order) {}
+
+  virtual void on_mock_order_rejected(const MockOrder& order,
+                                      const char* reason) {}
+
+  // 回调时order.traded已经包含本次成交
+  virtual void on_mock_order_traded(const MockOrder& order, int volume,
+                                    double price) {}
+
+  // 撤单数量为order.volume - order.traded
+  virtual void on_mock_order_canceled(const MockOrder& order) {}
+
+  virtual void on_mock_cancel_rejected(uint64_t order_id, const char* reason) {
+  }
+
+  virtual void on_mock_quote(const MockQuote& quote) {}
+
+  // 模拟的连接断开及恢复
+  virtual void on_mock_disconnected() {}
+
+  virtual void on_mock_reconnected() {}
+};
+
+class MockExchange {
+ public:
+  static MockExchange* instance();
+
+  const MockExchangeConfig& config() const { return config_; }
+
+  uint64_t next_order_id() { return next_order_id_.fetch_add(1); }
+
+  const std::vector<Contract>& contracts() const { return contracts_; }
+
+  // 可在任意线程调用，模拟断线期间返回false
+  bool is_connected() const { return is_connected_.load(); }
+
+  // 没有加载合约表时返回nullptr
+  const Contract* get_contract(const std::string& ticker) const;
+
+  /*
+   * 可在任意线程调用，经过FT_MOCK_LATENCY_US后在撮合线程中执行fn
+   */
+  void post(MockExchangeListener* listener, std::function<void()> fn);
+
+  /*
+   * 以下接口只能在撮合线程中（即post的回调中）调用
+   */
+  void new_order(MockExchangeListener* listener, MockOrder order);
+
+  void cancel_order(MockExchangeListener* listener, uint64_t order_id);
+
+  void subscribe(MockExchangeListener* listener, const std::string& ticker);
+
+  void unsubscribe(MockExchangeListener* listener, const std::string& ticker);
+
+  // 最新的行情，不存在时以初始价格创建
+  const MockQuote& get_quote(const std::string& ticker);
+
+  /*
+   * 持有该锁期间撮合线程不会回调任何listener，
+   * 用于API替换spi或析构前与撮合线程同步
+   */
+  std::unique_lock<std::recursive_mutex> lock_dispatch() {
+    return std::unique_lock<std::recursive_mutex>(dispatch_mutex_);
+  }
+
+  // 删除listener的挂单、订阅及尚未执行的请求，之后不会再回调该listener
+  void remove_listener(MockExchangeListener* listener);
+
+ private:
+  struct Event {
+    int64_t due_ns;
+    MockExchangeListener* listener;
+    std::function<void()> fn;
+  };
+
+  struct RestingOrder {
+    MockOrder order;
+    MockExchangeListener* listener;
+  };
+
+  using RestingOrderIter = std::list<RestingOrder>::iterator;
+
+  struct Book {
+    MockQuote quote;
+    double price_tick;
+    int size;
+    std::list<RestingOrder> orders;
+    std::vector<MockExchangeListener*> subscribers;
+  };
+
+  MockExchange();
+
+  void run();
+
+  Book* get_book(const std::string& ticker);
+
+  void update_quotes();
+
+  // 按FT_MOCK_DISCONNECT_*模拟断线及恢复
+  void update_connection(int64_t now);
+
+  void set_levels(Book* book, double bid);
+
+  void match_resting_orders(Book* book);
+
+  // 按配置的比例随机决定本次撮合的成交量
+  int fill_volume(const MockOrder& order);
+
+  // 撮合规则与VirtualApi共用，见gateway/virtual/order_matching.h
+  static MatchQuote match_quote(const Book& book);
+
+  static bool is_marketable(const MockOrder& order, const Book& book);
+
+  static double match_price(const MockOrder& order, const Book& book,
+                            bool is_resting);
+
+  static int64_t now_ns();
+
+ private:
+  MockExchangeConfig config_;
+  // contracts_中的字符串引用contract_file_的映射或contract_strings_
+  ContractFile contract_file_;
+  StringPool contract_strings_;
+  std::vector<Contract> contracts_;
+  std::unordered_map<std::string, std::size_t> contract_map_;
+  std::atomic<uint64_t> next_order_id_ = 1;
+  std::atomic<bool> is_connected_ = true;
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<Event> events_;
+
+  // 以下成员只在撮合线程中或持有dispatch_mutex_时访问
+  std::recursive_mutex dispatch_mutex_;
+  std::unordered_map<std::string, Book> books_;
+  std::unordered_map<uint64_t, std::pair<Book*, RestingOrderIter>>
+      resting_orders_;
+  std::mt19937 rng_;
+  std::uniform_real_distribution<double> dist_{0, 1};
+  int64_t next_tick_ns_ = 0;
+  std::unordered_set<MockExchangeListener*> listeners_;
+  int64_t disconnect_ns_ = 0;
+  int64_t reconnect_ns_ = 0;
+};
+
+}  // namespace ft
+
+#endif  // FT_SRC_GATEWAY_MOCK_MOCK_EXCHANGE_H_
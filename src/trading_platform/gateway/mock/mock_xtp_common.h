@@ -0,0 +1,41 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef FT_SRC_GATEWAY_MOCK_MOCK_XTP_COMMON_H_
+#define FT_SRC_GATEWAY_MOCK_MOCK_XTP_COMMON_H_
+
+#include <xtp_api_struct_common.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+
+namespace ft {
+
+inline XTPRI mock_xtp_error(int error_id = 0, const char* error_msg = "") {
+  XTPRI error_info{};
+  error_info.error_id = error_id;
+  strncpy(error_info.error_msg, error_msg, sizeof(error_info.error_msg) - 1);
+  return error_info;
+}
+
+// YYYYMMDDHHMMSSsss
+inline int64_t mock_xtp_time() {
+  auto now = std::chrono::system_clock::now();
+  time_t seconds = std::chrono::system_clock::to_time_t(now);
+  struct tm local_time;
+  localtime_r(&seconds, &local_time);
+  int64_t ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                   now.time_since_epoch())
+                   .count() %
+               1000;
+  int64_t date = (local_time.tm_year + 1900) * 10000 +
+                 (local_time.tm_mon + 1) * 100 + local_time.tm_mday;
+  int64_t time = local_time.tm_hour * 10000 + local_time.tm_min * 100 +
+                 local_time.tm_sec;
+  return (date * 1000000 + time) * 1000 + ms;
+}
+
+}  // namespace ft
+
+#endif  // FT_SRC_GATEWAY_MOCK_MOCK_XTP_COMMON_H_
@@ -0,0 +1,198 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#include "gateway/mock/mock_xtp_quote_api.h"
+
+#include <cstring>
+#include <ctime>
+#include <vector>
+
+#include "core/constants.h"
+#include "gateway/mock/mock_xtp_common.h"
+
+namespace XTP {
+namespace API {
+
+QuoteApi* QuoteApi::CreateQuoteApi(uint8_t client_id,
+                                   const char* save_file_path,
+                                   XTP_LOG_LEVEL log_level) {
+  return new ft::MockXtpQuoteApi;
+}
+
+}  // namespace API
+}  // namespace XTP
+
+namespace ft {
+
+MockXtpQuoteApi::MockXtpQuoteApi() : exchange_(MockExchange::instance()) {
+  time_t now = time(nullptr);
+  struct tm local_time;
+  localtime_r(&now, &local_time);
+  strftime(trading_day_, sizeof(trading_day_), "%Y%m%d", &local_time);
+}
+
+void MockXtpQuoteApi::Release() {
+  exchange_->remove_listener(this);
+  delete this;
+}
+
+void MockXtpQuoteApi::RegisterSpi(XTP::API::QuoteSpi* spi) {
+  auto lock = exchange_->lock_dispatch();
+  spi_ = spi;
+}
+
+int MockXtpQuoteApi::Login(const char* ip, int port, const char* user,
+                           const char* password, XTP_PROTOCOL_TYPE sock_type) {
+  if (!user || user[0] == '\0') {
+    last_error_ = mock_xtp_error(10200001, "invalid user");
+    return -1;
+  }
+
+  if (!exchange_->is_connected()) {
+    last_error_ = mock_xtp_error(10200005, "connection lost");
+    return -1;
+  }
+
+  is_logon_ = true;
+  return 0;
+}
+
+int MockXtpQuoteApi::Logout() {
+  is_logon_ = false;
+  return 0;
+}
+
+int MockXtpQuoteApi::SubscribeMarketData(char* ticker[], int count,
+                                         XTP_EXCHANGE_TYPE exchange_id) {
+  if (!is_logon_ || !ticker || count <= 0) {
+    last_error_ = mock_xtp_error(10200004, "invalid subscription");
+    return -1;
+  }
+
+  std::vector<std::string> ticker_list(ticker, ticker + count);
+  exchange_->post(this, [this, ticker_list, exchange_id] {
+    auto spi = connected_spi();
+    for (std::size_t i = 0; i < ticker_list.size(); ++i) {
+      subscribed_[ticker_list[i]] = exchange_id;
+      exchange_->subscribe(this, ticker_list[i]);
+      if (!spi) continue;
+
+      XTPST st{};
+      st.exchange_id = exchange_id;
+      strncpy(st.ticker, ticker_list[i].c_str(), sizeof(st.ticker) - 1);
+      auto error_info = mock_xtp_error();
+      spi->OnSubMarketData(&st, &error_info, i + 1 == ticker_list.size());
+    }
+  });
+  return 0;
+}
+
+int MockXtpQuoteApi::UnSubscribeMarketData(char* ticker[], int count,
+                                           XTP_EXCHANGE_TYPE exchange_id) {
+  if (!is_logon_ || !ticker || count <= 0) {
+    last_error_ = mock_xtp_error(10200004, "invalid subscription");
+    return -1;
+  }
+
+  std::vector<std::string> ticker_list(ticker, ticker + count);
+  exchange_->post(this, [this, ticker_list, exchange_id] {
+    auto spi = connected_spi();
+    for (std::size_t i = 0; i < ticker_list.size(); ++i) {
+      subscribed_.erase(ticker_list[i]);
+      exchange_->unsubscribe(this, ticker_list[i]);
+      if (!spi) continue;
+
+      XTPST st{};
+      st.exchange_id = exchange_id;
+      strncpy(st.ticker, ticker_list[i].c_str(), sizeof(st.ticker) - 1);
+      auto error_info = mock_xtp_error();
+      spi->OnUnSubMarketData(&st, &error_info, i + 1 == ticker_list.size());
+    }
+  });
+  return 0;
+}
+
+int MockXtpQuoteApi::QueryAllTickers(XTP_EXCHANGE_TYPE exchange_id) {
+  if (!is_logon_) {
+    last_error_ = mock_xtp_error(10200005, "not logged in");
+    return -1;
+  }
+
+  exchange_->post(this, [this, exchange_id] {
+    auto spi = connected_spi();
+    if (!spi) return;
+
+    const std::string& exchange = exchange_id == XTP_EXCHANGE_SH ? SSE : SZE;
+    std::vector<XTPQSI> tickers;
+    for (auto& contract : exchange_->contracts()) {
+      if (contract.exchange != exchange) continue;
+
+      XTPQSI info{};
+      info.exchange_id = exchange_id;
+      strncpy(info.ticker, contract.ticker.data(), sizeof(info.ticker) - 1);
+      strncpy(info.ticker_name, contract.name.data(),
+              sizeof(info.ticker_name) - 1);
+      info.ticker_type = contract.params.product_type == ProductType::FUND
+                             ? XTP_TICKER_TYPE_FUND
+                             : XTP_TICKER_TYPE_STOCK;
+      info.price_tick = contract.params.price_tick;
+      info.buy_qty_unit = 100;
+      info.sell_qty_unit = 1;
+      tickers.emplace_back(info);
+    }
+
+    // 与真实柜台一致，没有合约时返回错误
+    if (tickers.empty()) {
+      auto error_info = mock_xtp_error(11200000, "no ticker found");
+      spi->OnQueryAllTickers(nullptr, &error_info, true);
+      return;
+    }
+
+    auto error_info = mock_xtp_error();
+    for (std::size_t i = 0; i < tickers.size(); ++i)
+      spi->OnQueryAllTickers(&tickers[i], &error_info,
+                             i + 1 == tickers.size());
+  });
+  return 0;
+}
+
+void MockXtpQuoteApi::on_mock_quote(const MockQuote& quote) {
+  auto spi = connected_spi();
+  auto iter = subscribed_.find(quote.ticker);
+  if (!spi || iter == subscribed_.end()) return;
+
+  XTPMD md{};
+  md.exchange_id = iter->second;
+  strncpy(md.ticker, quote.ticker.c_str(), sizeof(md.ticker) - 1);
+  md.last_price = quote.last_price;
+  md.pre_close_price = quote.pre_close_price;
+  md.open_price = quote.open_price;
+  md.high_price = quote.highest_price;
+  md.low_price = quote.lowest_price;
+  md.upper_limit_price = quote.upper_limit_price;
+  md.lower_limit_price = quote.lower_limit_price;
+  int64_t sec = quote.time_ms / 1000;
+  int64_t hhmmss = sec / 3600 * 10000 + sec / 60 % 60 * 100 + sec % 60;
+  md.data_time = (quote.date * 1000000 + hhmmss) * 1000 + quote.time_ms % 1000;
+  md.qty = quote.volume;
+  md.turnover = quote.turnover;
+  md.avg_price = quote.volume > 0 ? quote.turnover / quote.volume : 0;
+  for (int i = 0; i < kMockQuoteLevel; ++i) {
+    md.bid[i] = quote.bid[i];
+    md.ask[i] = quote.ask[i];
+    md.bid_qty[i] = quote.bid_volume[i];
+    md.ask_qty[i] = quote.ask_volume[i];
+  }
+  md.data_type = XTP_MARKETDATA_ACTUAL;
+
+  spi->OnDepthMarketData(&md, nullptr, 0, 0, nullptr, 0, 0);
+}
+
+void MockXtpQuoteApi::on_mock_disconnected() {
+  // 断线后需要重新登录并订阅
+  is_logon_ = false;
+  subscribed_.clear();
+  auto spi = spi_.load();
+  if (spi) spi->OnDisconnected(10200005);
+}
+
+}  // namespace ft
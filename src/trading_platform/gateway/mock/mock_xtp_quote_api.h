@@ -0,0 +1,154 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef FT_SRC_GATEWAY_MOCK_MOCK_XTP_QUOTE_API_H_
+#define FT_SRC_GATEWAY_MOCK_MOCK_XTP_QUOTE_API_H_
+
+#include <xtp_quote_api.h>
+
+#include <atomic>
+#include <string>
+#include <unordered_map>
+
+#include "gateway/mock/mock_exchange.h"
+
+namespace ft {
+
+/*
+ * XTP::API::QuoteApi的模拟实现，编译为libxtpquoteapi.so
+ *
+ * 支持登录、普通行情的订阅以及合约查询，合约查询返回FT_MOCK_CONTRACTS中
+ * 上交所及深交所的合约。逐笔、订单簿等其他接口返回-1
+ */
+class MockXtpQuoteApi : public XTP::API::QuoteApi,
+                        public MockExchangeListener {
+ public:
+  MockXtpQuoteApi();
+
+  void Release() override;
+
+  const char* GetTradingDay() override { return trading_day_; }
+
+  const char* GetApiVersion() override { return "1.1.19.2_mock"; }
+
+  XTPRI* GetApiLastError() override { return &last_error_; }
+
+  void SetUDPBufferSize(uint32_t buff_size) override {}
+
+  void RegisterSpi(XTP::API::QuoteSpi* spi) override;
+
+  void SetHeartBeatInterval(uint32_t interval) override {}
+
+  int SubscribeMarketData(char* ticker[], int count,
+                          XTP_EXCHANGE_TYPE exchange_id) override;
+
+  int UnSubscribeMarketData(char* ticker[], int count,
+                            XTP_EXCHANGE_TYPE exchange_id) override;
+
+  int SubscribeOrderBook(char* ticker[], int count,
+                         XTP_EXCHANGE_TYPE exchange_id) override {
+    return -1;
+  }
+
+  int UnSubscribeOrderBook(char* ticker[], int count,
+                           XTP_EXCHANGE_TYPE exchange_id) override {
+    return -1;
+  }
+
+  int SubscribeTickByTick(char* ticker[], int count,
+                          XTP_EXCHANGE_TYPE exchange_id) override {
+    return -1;
+  }
+
+  int UnSubscribeTickByTick(char* ticker[], int count,
+                            XTP_EXCHANGE_TYPE exchange_id) override {
+    return -1;
+  }
+
+  int SubscribeAllMarketData(XTP_EXCHANGE_TYPE exchange_id) override {
+    return -1;
+  }
+
+  int UnSubscribeAllMarketData(XTP_EXCHANGE_TYPE exchange_id) override {
+    return -1;
+  }
+
+  int SubscribeAllOrderBook(XTP_EXCHANGE_TYPE exchange_id) override {
+    return -1;
+  }
+
+  int UnSubscribeAllOrderBook(XTP_EXCHANGE_TYPE exchange_id) override {
+    return -1;
+  }
+
+  int SubscribeAllTickByTick(XTP_EXCHANGE_TYPE exchange_id) override {
+    return -1;
+  }
+
+  int UnSubscribeAllTickByTick(XTP_EXCHANGE_TYPE exchange_id) override {
+    return -1;
+  }
+
+  int Login(const char* ip, int port, const char* user, const char* password,
+            XTP_PROTOCOL_TYPE sock_type) override;
+
+  int Logout() override;
+
+  int QueryAllTickers(XTP_EXCHANGE_TYPE exchange_id) override;
+
+  int QueryTickersPriceInfo(char* ticker[], int count,
+                            XTP_EXCHANGE_TYPE exchange_id) override {
+    return -1;
+  }
+
+  int QueryAllTickersPriceInfo() override { return -1; }
+
+  int SubscribeAllOptionMarketData(XTP_EXCHANGE_TYPE exchange_id) override {
+    return -1;
+  }
+
+  int UnSubscribeAllOptionMarketData(XTP_EXCHANGE_TYPE exchange_id) override {
+    return -1;
+  }
+
+  int SubscribeAllOptionOrderBook(XTP_EXCHANGE_TYPE exchange_id) override {
+    return -1;
+  }
+
+  int UnSubscribeAllOptionOrderBook(XTP_EXCHANGE_TYPE exchange_id) override {
+    return -1;
+  }
+
+  int SubscribeAllOptionTickByTick(XTP_EXCHANGE_TYPE exchange_id) override {
+    return -1;
+  }
+
+  int UnSubscribeAllOptionTickByTick(XTP_EXCHANGE_TYPE exchange_id) override {
+    return -1;
+  }
+
+  void on_mock_quote(const MockQuote& quote) override;
+
+  void on_mock_disconnected() override;
+
+ private:
+  // 模拟断线期间产生的回报都被丢弃
+  XTP::API::QuoteSpi* connected_spi() const {
+    return exchange_->is_connected() ? spi_.load() : nullptr;
+  }
+
+  ~MockXtpQuoteApi() = default;
+
+ private:
+  MockExchange* exchange_;
+  std::atomic<XTP::API::QuoteSpi*> spi_ = nullptr;
+  std::atomic<bool> is_logon_ = false;
+  char trading_day_[9]{};
+  XTPRI last_error_{};
+
+  // 只在撮合线程中访问
+  std::unordered_map<std::string, XTP_EXCHANGE_TYPE> subscribed_;
+};
+
+}  // namespace ft
+
+#endif  // FT_SRC_GATEWAY_MOCK_MOCK_XTP_QUOTE_API_H_
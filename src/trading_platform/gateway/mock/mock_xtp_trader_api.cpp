@@ -0,0 +1,466 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#include "gateway/mock/mock_xtp_trader_api.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+
+#include "gateway/mock/mock_xtp_common.h"
+
+namespace XTP {
+namespace API {
+
+TraderApi* TraderApi::CreateTraderApi(uint8_t client_id,
+                                      const char* save_file_path,
+                                      XTP_LOG_LEVEL log_level) {
+  return new ft::MockXtpTraderApi(client_id);
+}
+
+}  // namespace API
+}  // namespace XTP
+
+namespace ft {
+
+namespace {
+
+std::atomic<uint64_t> next_session_id = 1;
+
+}  // namespace
+
+MockXtpTraderApi::MockXtpTraderApi(uint8_t client_id)
+    : exchange_(MockExchange::instance()), client_id_(client_id) {
+  time_t now = time(nullptr);
+  struct tm local_time;
+  localtime_r(&now, &local_time);
+  strftime(trading_day_, sizeof(trading_day_), "%Y%m%d", &local_time);
+  cash_ = exchange_->config().cash;
+}
+
+void MockXtpTraderApi::Release() {
+  exchange_->remove_listener(this);
+  delete this;
+}
+
+void MockXtpTraderApi::RegisterSpi(XTP::API::TraderSpi* spi) {
+  auto lock = exchange_->lock_dispatch();
+  spi_ = spi;
+}
+
+uint64_t MockXtpTraderApi::Login(const char* ip, int port, const char* user,
+                                 const char* password,
+                                 XTP_PROTOCOL_TYPE sock_type) {
+  if (!user || user[0] == '\0') {
+    last_error_ = mock_xtp_error(10200001, "invalid user");
+    return 0;
+  }
+
+  if (!exchange_->is_connected()) {
+    last_error_ = mock_xtp_error(10200005, "connection lost");
+    return 0;
+  }
+
+  if (session_id_ != 0) {
+    last_error_ = mock_xtp_error(10200002, "already logged in");
+    return 0;
+  }
+
+  investor_id_ = user;
+  session_id_ = next_session_id.fetch_add(1);
+  return session_id_;
+}
+
+int MockXtpTraderApi::Logout(uint64_t session_id) {
+  if (!check_session(session_id)) return -1;
+
+  session_id_ = 0;
+  return 0;
+}
+
+bool MockXtpTraderApi::check_session(uint64_t session_id) {
+  if (session_id == 0 || session_id != session_id_) {
+    last_error_ = mock_xtp_error(10200003, "invalid session");
+    return false;
+  }
+  return true;
+}
+
+template <class Rsp, class Fn>
+void MockXtpTraderApi::reply_query(const std::vector<Rsp>& rsps,
+                                   int request_id, Fn&& fn) {
+  auto spi = connected_spi();
+  if (!spi) return;
+
+  if (rsps.empty()) {
+    fn(spi, static_cast<Rsp*>(nullptr), request_id, true);
+    return;
+  }
+
+  for (std::size_t i = 0; i < rsps.size(); ++i) {
+    auto rsp = rsps[i];
+    fn(spi, &rsp, request_id, i + 1 == rsps.size());
+  }
+}
+
+uint64_t MockXtpTraderApi::InsertOrder(XTPOrderInsertInfo* order,
+                                       uint64_t session_id) {
+  if (!order || !check_session(session_id)) return 0;
+
+  uint64_t order_id = exchange_->next_order_id();
+  exchange_->post(this, [this, req = *order, order_id] {
+    insert_order(req, order_id);
+  });
+  return order_id;
+}
+
+void MockXtpTraderApi::insert_order(const XTPOrderInsertInfo& req,
+                                    uint64_t order_id) {
+  XTPOrderInfo order{};
+  order.order_xtp_id = order_id;
+  order.order_client_id = req.order_client_id;
+  memcpy(order.ticker, req.ticker, sizeof(order.ticker));
+  order.market = req.market;
+  order.price = req.price;
+  order.quantity = req.quantity;
+  order.price_type = req.price_type;
+  order.side = req.side;
+  order.position_effect = req.position_effect;
+  order.business_type = req.business_type;
+  order.qty_left = req.quantity;
+  order.insert_time = mock_xtp_time();
+  order.update_time = order.insert_time;
+  snprintf(order.order_local_id, sizeof(order.order_local_id), "%llu",
+           static_cast<unsigned long long>(order_id));
+  order.order_status = XTP_ORDER_STATUS_INIT;
+  order.order_submit_status = XTP_ORDER_SUBMIT_STATUS_INSERT_SUBMITTED;
+  order.order_type = XTP_ORDT_Normal;
+  auto& stored = orders_.emplace(order_id, order).first->second;
+
+  if (req.business_type != XTP_BUSINESS_TYPE_CASH ||
+      (req.side != XTP_SIDE_BUY && req.side != XTP_SIDE_SELL)) {
+    reject_order(&stored, "business type not supported by mock");
+    return;
+  }
+
+  if (req.side == XTP_SIDE_SELL) {
+    auto& pos = positions_[req.ticker];
+    if (pos.holdings - pos.frozen < req.quantity) {
+      reject_order(&stored, "insufficient position");
+      return;
+    }
+    pos.frozen += req.quantity;
+  }
+
+  MockOrder mock_order{};
+  mock_order.order_id = order_id;
+  mock_order.ticker = req.ticker;
+  mock_order.is_buy = req.side == XTP_SIDE_BUY;
+  mock_order.is_market = req.price_type != XTP_PRICE_LIMIT;
+  mock_order.immediate = mock_order.is_market;
+  mock_order.all_or_none = req.price_type == XTP_PRICE_ALL_OR_CANCEL;
+  mock_order.volume = req.quantity;
+  mock_order.price = req.price;
+  exchange_->new_order(this, std::move(mock_order));
+}
+
+uint64_t MockXtpTraderApi::CancelOrder(const uint64_t order_xtp_id,
+                                       uint64_t session_id) {
+  if (!check_session(session_id)) return 0;
+
+  uint64_t cancel_id = exchange_->next_order_id();
+  exchange_->post(this, [this, order_xtp_id, cancel_id] {
+    cancel_order(order_xtp_id, cancel_id);
+  });
+  return cancel_id;
+}
+
+void MockXtpTraderApi::cancel_order(uint64_t order_xtp_id,
+                                    uint64_t cancel_id) {
+  auto iter = orders_.find(order_xtp_id);
+  if (iter == orders_.end()) {
+    auto spi = connected_spi();
+    if (!spi) return;
+
+    XTPOrderCancelInfo cancel_info{cancel_id, order_xtp_id};
+    auto error_info = mock_xtp_error(11000005, "order not found");
+    spi->OnCancelOrderError(&cancel_info, &error_info, session_id_);
+    return;
+  }
+
+  iter->second.order_cancel_xtp_id = cancel_id;
+  exchange_->cancel_order(this, order_xtp_id);
+}
+
+int MockXtpTraderApi::QueryOrderByXTPID(const uint64_t order_xtp_id,
+                                        uint64_t session_id, int request_id) {
+  if (!check_session(session_id)) return -1;
+
+  exchange_->post(this, [this, order_xtp_id, request_id] {
+    std::vector<XTPQueryOrderRsp> rsps;
+    auto iter = orders_.find(order_xtp_id);
+    if (iter != orders_.end()) rsps.emplace_back(iter->second);
+
+    reply_query(rsps, request_id, [this](auto spi, auto rsp, auto request_id,
+                                         bool is_last) {
+      spi->OnQueryOrder(rsp, nullptr, request_id, is_last, session_id_);
+    });
+  });
+  return 0;
+}
+
+int MockXtpTraderApi::QueryOrders(const XTPQueryOrderReq* query_param,
+                                  uint64_t session_id, int request_id) {
+  if (!query_param || !check_session(session_id)) return -1;
+
+  exchange_->post(this, [this, qry = *query_param, request_id] {
+    std::vector<XTPQueryOrderRsp> rsps;
+    for (auto& [order_id, order] : orders_) {
+      if (qry.ticker[0] == '\0' || strcmp(qry.ticker, order.ticker) == 0)
+        rsps.emplace_back(order);
+    }
+
+    reply_query(rsps, request_id, [this](auto spi, auto rsp, auto request_id,
+                                         bool is_last) {
+      spi->OnQueryOrder(rsp, nullptr, request_id, is_last, session_id_);
+    });
+  });
+  return 0;
+}
+
+int MockXtpTraderApi::QueryTradesByXTPID(const uint64_t order_xtp_id,
+                                         uint64_t session_id, int request_id) {
+  if (!check_session(session_id)) return -1;
+
+  exchange_->post(this, [this, order_xtp_id, request_id] {
+    std::vector<XTPQueryTradeRsp> rsps;
+    for (auto& trade : trades_) {
+      if (trade.order_xtp_id == order_xtp_id) rsps.emplace_back(trade);
+    }
+
+    reply_query(rsps, request_id, [this](auto spi, auto rsp, auto request_id,
+                                         bool is_last) {
+      spi->OnQueryTrade(rsp, nullptr, request_id, is_last, session_id_);
+    });
+  });
+  return 0;
+}
+
+int MockXtpTraderApi::QueryTrades(XTPQueryTraderReq* query_param,
+                                  uint64_t session_id, int request_id) {
+  if (!query_param || !check_session(session_id)) return -1;
+
+  exchange_->post(this, [this, qry = *query_param, request_id] {
+    std::vector<XTPQueryTradeRsp> rsps;
+    for (auto& trade : trades_) {
+      if (qry.ticker[0] == '\0' || strcmp(qry.ticker, trade.ticker) == 0)
+        rsps.emplace_back(trade);
+    }
+
+    reply_query(rsps, request_id, [this](auto spi, auto rsp, auto request_id,
+                                         bool is_last) {
+      spi->OnQueryTrade(rsp, nullptr, request_id, is_last, session_id_);
+    });
+  });
+  return 0;
+}
+
+int MockXtpTraderApi::QueryPosition(const char* ticker, uint64_t session_id,
+                                    int request_id) {
+  if (!check_session(session_id)) return -1;
+
+  std::string qry_ticker = ticker ? ticker : "";
+  exchange_->post(this, [this, qry_ticker, request_id] {
+    std::vector<XTPQueryStkPositionRsp> rsps;
+    for (auto& [ticker, pos] : positions_) {
+      if (!qry_ticker.empty() && ticker != qry_ticker) continue;
+      if (pos.holdings == 0) continue;
+
+      double last_price = exchange_->get_quote(ticker).last_price;
+      XTPQueryStkPositionRsp position{};
+      strncpy(position.ticker, ticker.c_str(), sizeof(position.ticker) - 1);
+      strncpy(position.ticker_name, ticker.c_str(),
+              sizeof(position.ticker_name) - 1);
+      position.market = pos.market;
+      position.total_qty = pos.holdings;
+      position.sellable_qty = pos.holdings - pos.frozen;
+      position.avg_price = pos.cost / pos.holdings;
+      position.unrealized_pnl = last_price * pos.holdings - pos.cost;
+      position.position_direction = XTP_POSITION_DIRECTION_NET;
+      rsps.emplace_back(position);
+    }
+
+    reply_query(rsps, request_id, [this](auto spi, auto rsp, auto request_id,
+                                         bool is_last) {
+      spi->OnQueryPosition(rsp, nullptr, request_id, is_last, session_id_);
+    });
+  });
+  return 0;
+}
+
+int MockXtpTraderApi::QueryAsset(uint64_t session_id, int request_id) {
+  if (!check_session(session_id)) return -1;
+
+  exchange_->post(this, [this, request_id] {
+    auto spi = connected_spi();
+    if (!spi) return;
+
+    double security_asset = 0;
+    for (auto& [ticker, pos] : positions_) {
+      if (pos.holdings == 0) continue;
+      double last_price = exchange_->get_quote(ticker).last_price;
+      security_asset += last_price * pos.holdings;
+    }
+
+    XTPQueryAssetRsp asset{};
+    asset.total_asset = cash_ + security_asset;
+    asset.buying_power = cash_;
+    asset.security_asset = security_asset;
+    asset.account_type = XTP_ACCOUNT_NORMAL;
+    asset.orig_banlance = exchange_->config().cash;
+    asset.banlance = cash_;
+    auto error_info = mock_xtp_error();
+    spi->OnQueryAsset(&asset, &error_info, request_id, true, session_id_);
+  });
+  return 0;
+}
+
+void MockXtpTraderApi::on_mock_order_accepted(const MockOrder& mock_order) {
+  auto iter = orders_.find(mock_order.order_id);
+  if (iter == orders_.end()) return;
+
+  auto& order = iter->second;
+  order.order_status = XTP_ORDER_STATUS_NOTRADEQUEUEING;
+  order.order_submit_status = XTP_ORDER_SUBMIT_STATUS_INSERT_ACCEPTED;
+  order.update_time = mock_xtp_time();
+  notify_order(order, nullptr);
+}
+
+void MockXtpTraderApi::on_mock_order_rejected(const MockOrder& mock_order,
+                                              const char* reason) {
+  auto iter = orders_.find(mock_order.order_id);
+  if (iter == orders_.end()) return;
+
+  release_frozen(iter->second);
+  reject_order(&iter->second, reason);
+}
+
+void MockXtpTraderApi::on_mock_order_traded(const MockOrder& mock_order,
+                                            int volume, double price) {
+  auto spi = connected_spi();
+  auto iter = orders_.find(mock_order.order_id);
+  if (iter == orders_.end()) return;
+
+  auto& order = iter->second;
+  order.qty_traded = mock_order.traded;
+  order.qty_left = order.quantity - order.qty_traded;
+  order.trade_amount += price * volume;
+  order.update_time = mock_xtp_time();
+  order.order_status = order.qty_left > 0
+                           ? XTP_ORDER_STATUS_PARTTRADEDQUEUEING
+                           : XTP_ORDER_STATUS_ALLTRADED;
+
+  XTPTradeReport trade{};
+  trade.order_xtp_id = order.order_xtp_id;
+  trade.order_client_id = order.order_client_id;
+  memcpy(trade.ticker, order.ticker, sizeof(trade.ticker));
+  trade.market = order.market;
+  trade.local_order_id = order.order_xtp_id;
+  snprintf(trade.exec_id, sizeof(trade.exec_id), "%llu",
+           static_cast<unsigned long long>(next_exec_id_++));
+  trade.price = price;
+  trade.quantity = volume;
+  trade.trade_time = order.update_time;
+  trade.trade_amount = price * volume;
+  trade.report_index = trades_.size() + 1;
+  memcpy(trade.order_exch_id, order.order_local_id,
+         std::min(sizeof(trade.order_exch_id), sizeof(order.order_local_id)));
+  trade.trade_type = XTP_TRDT_COMMON;
+  trade.side = order.side;
+  trade.position_effect = order.position_effect;
+  trade.business_type = XTP_BUSINESS_TYPE_CASH;
+  trades_.emplace_back(trade);
+
+  auto& pos = positions_[order.ticker];
+  pos.market = order.market;
+  if (order.side == XTP_SIDE_BUY) {
+    pos.holdings += volume;
+    pos.cost += price * volume;
+    cash_ -= price * volume;
+  } else {
+    double avg_price = pos.holdings > 0 ? pos.cost / pos.holdings : 0;
+    pos.holdings -= volume;
+    pos.frozen -= volume;
+    pos.cost -= avg_price * volume;
+    cash_ += price * volume;
+  }
+
+  if (spi) spi->OnTradeEvent(&trade, session_id_);
+
+  // XTP的订单回报中没有部分成交的推送
+  if (order.order_status == XTP_ORDER_STATUS_ALLTRADED)
+    notify_order(order, nullptr);
+}
+
+void MockXtpTraderApi::on_mock_order_canceled(const MockOrder& mock_order) {
+  auto iter = orders_.find(mock_order.order_id);
+  if (iter == orders_.end()) return;
+
+  auto& order = iter->second;
+  release_frozen(order);
+  order.qty_left = order.quantity - order.qty_traded;
+  order.cancel_time = mock_xtp_time();
+  order.update_time = order.cancel_time;
+  order.order_status = order.qty_traded > 0
+                           ? XTP_ORDER_STATUS_PARTTRADEDNOTQUEUEING
+                           : XTP_ORDER_STATUS_CANCELED;
+  order.order_submit_status = XTP_ORDER_SUBMIT_STATUS_CANCEL_ACCEPTED;
+  notify_order(order, nullptr);
+}
+
+void MockXtpTraderApi::on_mock_cancel_rejected(uint64_t order_id,
+                                               const char* reason) {
+  auto spi = connected_spi();
+  auto iter = orders_.find(order_id);
+  if (!spi || iter == orders_.end()) return;
+
+  XTPOrderCancelInfo cancel_info{iter->second.order_cancel_xtp_id, order_id};
+  auto error_info = mock_xtp_error(11000343, reason);
+  spi->OnCancelOrderError(&cancel_info, &error_info, session_id_);
+}
+
+void MockXtpTraderApi::on_mock_disconnected() {
+  // XTP不会自动重连，需要重新调用Login
+  uint64_t session_id = session_id_.exchange(0);
+  auto spi = spi_.load();
+  if (spi && session_id != 0) {
+    auto error_info = mock_xtp_error(10200005, "connection lost");
+    spi->OnDisconnected(session_id, error_info.error_id);
+  }
+}
+
+void MockXtpTraderApi::reject_order(XTPOrderInfo* order, const char* reason) {
+  order->order_status = XTP_ORDER_STATUS_REJECTED;
+  order->order_submit_status = XTP_ORDER_SUBMIT_STATUS_INSERT_REJECTED;
+  order->update_time = mock_xtp_time();
+  auto error_info = mock_xtp_error(11000010, reason);
+  notify_order(*order, &error_info);
+}
+
+void MockXtpTraderApi::notify_order(const XTPOrderInfo& order,
+                                    const XTPRI* error_info) {
+  auto spi = connected_spi();
+  if (!spi) return;
+
+  auto rtn_order = order;
+  auto rtn_error = error_info ? *error_info : mock_xtp_error();
+  spi->OnOrderEvent(&rtn_order, &rtn_error, session_id_);
+}
+
+void MockXtpTraderApi::release_frozen(const XTPOrderInfo& order) {
+  if (order.side != XTP_SIDE_SELL) return;
+
+  positions_[order.ticker].frozen -= order.quantity - order.qty_traded;
+}
+
+}  // namespace ft
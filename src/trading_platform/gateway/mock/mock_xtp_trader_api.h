@@ -0,0 +1,196 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef FT_SRC_GATEWAY_MOCK_MOCK_XTP_TRADER_API_H_
+#define FT_SRC_GATEWAY_MOCK_MOCK_XTP_TRADER_API_H_
+
+#include <xtp_trader_api.h>
+
+#include <atomic>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "gateway/mock/mock_exchange.h"
+
+namespace ft {
+
+/*
+ * XTP::API::TraderApi的模拟实现，编译为libxtptraderapi.so
+ *
+ * 只支持普通股票买卖(XTP_BUSINESS_TYPE_CASH)，卖出时检查可卖持仓，
+ * 不校验资金，也没有T+1的限制。每个实例只维护一个session
+ */
+class MockXtpTraderApi : public XTP::API::TraderApi,
+                         public MockExchangeListener {
+ public:
+  explicit MockXtpTraderApi(uint8_t client_id);
+
+  void Release() override;
+
+  const char* GetTradingDay() override { return trading_day_; }
+
+  void RegisterSpi(XTP::API::TraderSpi* spi) override;
+
+  XTPRI* GetApiLastError() override { return &last_error_; }
+
+  const char* GetApiVersion() override { return "1.1.19.2_mock"; }
+
+  uint8_t GetClientIDByXTPID(uint64_t order_xtp_id) override {
+    return client_id_;
+  }
+
+  const char* GetAccountByXTPID(uint64_t order_xtp_id) override {
+    return investor_id_.c_str();
+  }
+
+  void SubscribePublicTopic(XTP_TE_RESUME_TYPE resume_type) override {}
+
+  void SetSoftwareVersion(const char* version) override {}
+
+  void SetSoftwareKey(const char* key) override {}
+
+  void SetHeartBeatInterval(uint32_t interval) override {}
+
+  uint64_t Login(const char* ip, int port, const char* user,
+                 const char* password, XTP_PROTOCOL_TYPE sock_type) override;
+
+  int Logout(uint64_t session_id) override;
+
+  bool IsServerRestart(uint64_t session_id) override { return false; }
+
+  uint64_t InsertOrder(XTPOrderInsertInfo* order,
+                       uint64_t session_id) override;
+
+  uint64_t CancelOrder(const uint64_t order_xtp_id,
+                       uint64_t session_id) override;
+
+  int QueryOrderByXTPID(const uint64_t order_xtp_id, uint64_t session_id,
+                        int request_id) override;
+
+  int QueryOrders(const XTPQueryOrderReq* query_param, uint64_t session_id,
+                  int request_id) override;
+
+  int QueryOrdersByPage(const XTPQueryOrderByPageReq* query_param,
+                        uint64_t session_id, int request_id) override {
+    return -1;
+  }
+
+  int QueryTradesByXTPID(const uint64_t order_xtp_id, uint64_t session_id,
+                         int request_id) override;
+
+  int QueryTrades(XTPQueryTraderReq* query_param, uint64_t session_id,
+                  int request_id) override;
+
+  int QueryTradesByPage(const XTPQueryTraderByPageReq* query_param,
+                        uint64_t session_id, int request_id) override {
+    return -1;
+  }
+
+  int QueryPosition(const char* ticker, uint64_t session_id,
+                    int request_id) override;
+
+  int QueryAsset(uint64_t session_id, int request_id) override;
+
+  int QueryStructuredFund(XTPQueryStructuredFundInfoReq* query_param,
+                          uint64_t session_id, int request_id) override {
+    return -1;
+  }
+
+  uint64_t FundTransfer(XTPFundTransferReq* fund_transfer,
+                        uint64_t session_id) override {
+    return 0;
+  }
+
+  int QueryFundTransfer(XTPQueryFundTransferLogReq* query_param,
+                        uint64_t session_id, int request_id) override {
+    return -1;
+  }
+
+  int QueryETF(XTPQueryETFBaseReq* query_param, uint64_t session_id,
+               int request_id) override {
+    return -1;
+  }
+
+  int QueryETFTickerBasket(XTPQueryETFComponentReq* query_param,
+                           uint64_t session_id, int request_id) override {
+    return -1;
+  }
+
+  int QueryIPOInfoList(uint64_t session_id, int request_id) override {
+    return -1;
+  }
+
+  int QueryIPOQuotaInfo(uint64_t session_id, int request_id) override {
+    return -1;
+  }
+
+  int QueryOptionAuctionInfo(XTPQueryOptionAuctionInfoReq* query_param,
+                             uint64_t session_id, int request_id) override {
+    return -1;
+  }
+
+  void on_mock_order_accepted(const MockOrder& order) override;
+
+  void on_mock_order_rejected(const MockOrder& order,
+                              const char* reason) override;
+
+  void on_mock_order_traded(const MockOrder& order, int volume,
+                            double price) override;
+
+  void on_mock_order_canceled(const MockOrder& order) override;
+
+  void on_mock_cancel_rejected(uint64_t order_id, const char* reason) override;
+
+  void on_mock_disconnected() override;
+
+ private:
+  // 模拟断线期间产生的回报都被丢弃
+  XTP::API::TraderSpi* connected_spi() const {
+    return exchange_->is_connected() ? spi_.load() : nullptr;
+  }
+
+  struct MockPosition {
+    XTP_MARKET_TYPE market = XTP_MKT_INIT;
+    int64_t holdings = 0;
+    int64_t frozen = 0;  // 未成交的卖单冻结的持仓
+    double cost = 0;
+  };
+
+  ~MockXtpTraderApi() = default;
+
+  bool check_session(uint64_t session_id);
+
+  void insert_order(const XTPOrderInsertInfo& req, uint64_t order_id);
+
+  void cancel_order(uint64_t order_xtp_id, uint64_t cancel_id);
+
+  void reject_order(XTPOrderInfo* order, const char* reason);
+
+  void notify_order(const XTPOrderInfo& order, const XTPRI* error_info);
+
+  void release_frozen(const XTPOrderInfo& order);
+
+  template <class Rsp, class Fn>
+  void reply_query(const std::vector<Rsp>& rsps, int request_id, Fn&& fn);
+
+ private:
+  MockExchange* exchange_;
+  uint8_t client_id_;
+  std::atomic<XTP::API::TraderSpi*> spi_ = nullptr;
+  std::atomic<uint64_t> session_id_ = 0;
+  char trading_day_[9]{};
+  std::string investor_id_;
+  XTPRI last_error_{};
+
+  // 以下成员只在撮合线程中访问
+  uint64_t next_exec_id_ = 1;
+  double cash_ = 0;
+  std::unordered_map<uint64_t, XTPOrderInfo> orders_;
+  std::vector<XTPTradeReport> trades_;
+  std::map<std::string, MockPosition> positions_;
+};
+
+}  // namespace ft
+
+#endif  // FT_SRC_GATEWAY_MOCK_MOCK_XTP_TRADER_API_H_
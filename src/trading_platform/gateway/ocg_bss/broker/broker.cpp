@@ -4,7 +4,10 @@
 
 #include <spdlog/spdlog.h>
 
+#include <charconv>
+#include <cmath>
 #include <cstdio>
+#include <cstring>
 #include <thread>
 
 #include "broker/cmd_processor.h"
@@ -37,6 +40,13 @@ static time_t convert_str_to_tm(const char *str_time) {
   return mktime(&tt) * 1000 + atoi(str_time + 18);
 }
 
+// 回报中的ID从接收缓冲区中原地读取，不以'\0'结尾
+static uint64_t to_uint(std::string_view str) {
+  uint64_t value = 0;
+  std::from_chars(str.data(), str.data() + str.size(), value);
+  return value;
+}
+
 static bool contain_between(const std::string &str, char begin, char end) {
   for (auto ch : str) {
     if (begin <= ch && ch <= end) return true;
@@ -64,62 +74,186 @@ static bool verify_passwd(const std::string &passwd) {
   return true;
 }
 
+static bool to_bss_order_type(uint32_t type, bss::OrderType *order_type,
+                              bss::Tif *tif,
+                              bss::MaxPriceLevels *max_price_levels) {
+  switch (type) {
+    case ::ft::OrderType::hkex::MO_AT_CROSSING: {
+      *tif = bss::TIF_AT_CROSSING;
+      *order_type = bss::ORDER_TYPE_MARKET;
+      break;
+    }
+    case ::ft::OrderType::hkex::LO_AT_CROSSING: {
+      *tif = bss::TIF_AT_CROSSING;
+      *order_type = bss::ORDER_TYPE_LIMIT;
+      break;
+    }
+    case ::ft::OrderType::hkex::LO: {
+      *tif = bss::TIF_DAY;
+      *order_type = bss::ORDER_TYPE_LIMIT;
+      *max_price_levels = 1;
+      break;
+    }
+    case ::ft::OrderType::hkex::ELO: {
+      *tif = bss::TIF_DAY;
+      *order_type = bss::ORDER_TYPE_LIMIT;
+      break;
+    }
+    case ::ft::OrderType::hkex::SLO: {
+      *tif = bss::TIF_IOC;
+      *order_type = bss::ORDER_TYPE_LIMIT;
+      break;
+    }
+    default: {
+      return false;
+    }
+  }
+  return true;
+}
+
 BssBroker::BssBroker() {
   //   time_t t = wqutil::getWallTime();
   time_t t = time(nullptr);
   struct tm _tm;
   localtime_r(&t, &_tm);
-  snprintf(date_, sizeof(date_), "%04d%02d%02d", _tm.tm_mday + 1900,
+  snprintf(date_, sizeof(date_), "%04d%02d%02d", _tm.tm_year + 1900,
            _tm.tm_mon + 1, _tm.tm_mday);
 }
 
-/* TODO: read config from a config file */
+// 先停止事件循环，之后各组件在当前线程中释放
+BssBroker::~BssBroker() {
+  if (loop_) loop_->stop();
+  if (loop_thread_.joinable()) loop_thread_.join();
+}
+
+// 每个Comp ID一个session，需要更高的流速时在配置的sessions中增加
 bool BssBroker::login(TradingEngineInterface *engine, const Config &config) {
   engine_ = engine;
-  /* for test */
-  {
-    sess_conf_.comp_id = "CO99999902";
-    sess_conf_.password = "123aA678";
-    sess_conf_.new_password = "2bB56789";
-    sess_conf_.rsa_pubkey_file = "./5-RSA_public_key.pem";
-    sess_conf_.msg_limit_per_sec = 8;
+  if (config.sessions.empty()) {
+    spdlog::error("[BssBroker::login] no session configured");
+    return false;
+  }
+
+  std::vector<bss::SessionConfig> confs(config.sessions.size());
+  for (std::size_t i = 0; i < confs.size(); ++i) {
+    const auto &session = config.sessions[i];
+    confs[i].comp_id = session.comp_id;
+    confs[i].password = session.password;
+    confs[i].new_password = session.new_password;
+    confs[i].rsa_pubkey_file = session.rsa_pubkey_file;
+    confs[i].msg_limit_per_sec = session.msg_limit_per_sec;
+    confs[i].msg_burst = session.msg_burst;
   }
 
-  if (!check_config()) return false;
+  // 连接管理、OCG连接的收发及命令端口都在同一个事件循环中
+  loop_ = std::make_unique<bss::EventLoop>();
+  if (!loop_->init()) {
+    spdlog::error("[BssBroker::login] failed to init event loop");
+    return false;
+  }
 
-  session_ = std::make_unique<bss::Session>(this);
-  session_->init(sess_conf_);
-  session_->enable();
+  for (auto &conf : confs) {
+    // 每个交易日一个文件，BSS当日重启后仍能响应OCG的重传请求
+    conf.sent_msg_store = fmt::format("./{}-{}", conf.comp_id, date_);
+    conf.state_file = fmt::format("./{}.state", conf.comp_id);
+    conf.trading_date = date_;
+
+    if (!check_config(conf)) return false;
+
+    auto ctx = std::make_unique<SessionContext>();
+    ctx->conf = conf;
+    ctx->session = std::make_unique<bss::Session>(this);
+    if (!ctx->session->init(conf)) {
+      spdlog::error("[BssBroker::login] failed to init session {}",
+                    conf.comp_id);
+      return false;
+    }
+    ctx->session->enable();
+    ctx->conn_mgr = std::make_unique<bss::ConnectionManager>(
+        loop_.get(), ctx->session.get());
+    sessions_.emplace_back(std::move(ctx));
+  }
 
-  std::thread([this] {
-    bss::ConnectionManager conn_mgr(session_.get());
-    conn_mgr.run();
-  }).detach();
+  cmd_processor_ = std::make_unique<bss::CmdProcessor>(loop_.get(), this);
+  loop_->post([this] {
+    for (auto &ctx : sessions_) {
+      if (!ctx->conn_mgr->start())
+        spdlog::error("[BssBroker::login] failed to start connection manager");
+    }
+    if (!cmd_processor_->start(18889))
+      spdlog::error("[BssBroker::login] failed to start cmd processor");
+  });
 
-  std::thread([this] {
-    bss::CmdProcessor cmd_processor(this);
-    cmd_processor.start(18889);
-  }).detach();
+  loop_thread_ = std::thread([this] { loop_->run(); });
 
   return true;
 }
 
-bool BssBroker::check_config() const {
-  if (!verify_passwd(sess_conf_.password)) {
-    spdlog::error("[BssBroker::check_config] invalid password");
+bool BssBroker::check_config(const bss::SessionConfig &conf) {
+  if (conf.comp_id.empty() || conf.rsa_pubkey_file.empty()) {
+    spdlog::error(
+        "[BssBroker::check_config] comp_id and rsa_pubkey_file are required");
     return false;
   }
-  if (!sess_conf_.new_password.empty() &&
-      (!verify_passwd(sess_conf_.new_password) ||
-       sess_conf_.password == sess_conf_.new_password)) {
-    spdlog::error("[BssBroker::check_config] invalid new password");
+  if (conf.msg_limit_per_sec == 0 || conf.msg_burst == 0) {
+    spdlog::error(
+        "[BssBroker::check_config] invalid msg_limit_per_sec or msg_burst. "
+        "CompID:{}",
+        conf.comp_id);
+    return false;
+  }
+  if (!verify_passwd(conf.password)) {
+    spdlog::error("[BssBroker::check_config] invalid password. CompID:{}",
+                  conf.comp_id);
+    return false;
+  }
+  if (!conf.new_password.empty() &&
+      (!verify_passwd(conf.new_password) ||
+       conf.password == conf.new_password)) {
+    spdlog::error("[BssBroker::check_config] invalid new password. CompID:{}",
+                  conf.comp_id);
     return false;
   }
 
   return true;
 }
 
-void BssBroker::logon(const std::string &passwd,
+BssBroker::SessionContext *BssBroker::find_session(bss::Session *session) {
+  for (auto &ctx : sessions_) {
+    if (ctx->session.get() == session) return ctx.get();
+  }
+  return nullptr;
+}
+
+BssBroker::SessionContext *BssBroker::select_session() {
+  SessionContext *selected = nullptr;
+  double min_load = 0.0;
+  for (auto &ctx : sessions_) {
+    if (!ctx->is_logon) continue;
+    double load = ctx->session->send_load();
+    if (!selected || load < min_load) {
+      selected = ctx.get();
+      min_load = load;
+    }
+  }
+  return selected;
+}
+
+bool BssBroker::find_order(uint64_t engine_order_id, OrderInfo *info) {
+  {
+    std::unique_lock<std::mutex> lock(id_mutex_);
+    auto iter = orders_.find(engine_order_id);
+    if (iter == orders_.end()) return false;
+    // 只取发单需要的字段，不复制amend_ids
+    info->ctx = iter->second.ctx;
+    memcpy(info->security_id, iter->second.security_id,
+           sizeof(info->security_id));
+    info->side = iter->second.side;
+  }
+  return info->ctx->is_logon;
+}
+
+void BssBroker::logon(const std::string &comp_id, const std::string &passwd,
                       const std::string &new_passwd) {
   if (!verify_passwd(passwd)) {
     spdlog::error("[BssBroker::logon] invalid password");
@@ -131,11 +265,19 @@ void BssBroker::logon(const std::string &passwd,
     return;
   }
 
-  session_->set_password(passwd, new_passwd);
-  session_->enable();
+  bool found = false;
+  for (auto &ctx : sessions_) {
+    if (!comp_id.empty() && ctx->conf.comp_id != comp_id) continue;
+    ctx->session->set_password(passwd, new_passwd);
+    ctx->session->enable();
+    found = true;
+  }
+  if (!found) spdlog::error("[BssBroker::logon] unknown CompID:{}", comp_id);
 }
 
-void BssBroker::logout() { session_->disable(); }
+void BssBroker::logout() {
+  for (auto &ctx : sessions_) ctx->session->disable();
+}
 
 bool BssBroker::query_account() {
   // test
@@ -150,7 +292,8 @@ bool BssBroker::query_account() {
 }
 
 bool BssBroker::send_order(const OrderReq &order) {
-  if (!is_logon_) {
+  auto ctx = select_session();
+  if (!ctx) {
     spdlog::error("[BssBroker::send_order]: not logon");
     return false;
   }
@@ -162,41 +305,13 @@ bool BssBroker::send_order(const OrderReq &order) {
            static_cast<uint32_t>(order.engine_order_id));
   strncpy(req.submitting_broker_id, broker_id_,
           sizeof(req.submitting_broker_id));
-  strncpy(req.security_id, contract->ticker.c_str(), sizeof(req.security_id));
+  strncpy(req.security_id, contract->ticker.data(), sizeof(req.security_id));
   req.side = bss_detail::diroff2side(order.direction, order.offset);
-  switch (order.type) {
-    case ::ft::OrderType::hkex::MO_AT_CROSSING: {
-      req.tif = bss::TIF_AT_CROSSING;
-      req.order_type = bss::ORDER_TYPE_MARKET;
-      break;
-    }
-    case ::ft::OrderType::hkex::LO_AT_CROSSING: {
-      req.tif = bss::TIF_AT_CROSSING;
-      req.order_type = bss::ORDER_TYPE_LIMIT;
-      break;
-    }
-    case ::ft::OrderType::hkex::LO: {
-      req.tif = bss::TIF_DAY;
-      req.order_type = bss::ORDER_TYPE_LIMIT;
-      req.max_price_levels = 1;
-      break;
-    }
-    case ::ft::OrderType::hkex::ELO: {
-      req.tif = bss::TIF_DAY;
-      req.order_type = bss::ORDER_TYPE_LIMIT;
-      break;
-    }
-    case ::ft::OrderType::hkex::SLO: {
-      req.tif = bss::TIF_IOC;
-      req.order_type = bss::ORDER_TYPE_LIMIT;
-      break;
-    }
-    default: {
-      return false;
-    }
-  }
+  if (!to_bss_order_type(order.type, &req.order_type, &req.tif,
+                         &req.max_price_levels))
+    return false;
   if (req.order_type == bss::ORDER_TYPE_LIMIT)
-    req.price = (order.price + 0.0005) * 1e3 * 1e5;
+    req.price = std::llround(order.real_price() * 1e8);
 
   req.order_quantity = order.volume * 1e8;
   req.security_id_source = 8;
@@ -206,36 +321,192 @@ bool BssBroker::send_order(const OrderReq &order) {
   req.position_effect = 0;
   req.disclosure_instructions = 0;
 
-  if (!session_->send_business_msg(req)) {
+  // 回报可能在send_business_msg返回前就到了，先记录下来
+  {
+    std::unique_lock<std::mutex> lock(id_mutex_);
+    auto &info = orders_[order.engine_order_id];
+    info.ctx = ctx;
+    memcpy(info.security_id, req.security_id, sizeof(info.security_id));
+    info.side = req.side;
+  }
+
+  // 限价单的格式是固定的，presence bitmap在编译期就已确定
+  bool sent;
+  if (req.order_type != bss::ORDER_TYPE_LIMIT)
+    sent = ctx->session->send_business_msg(req);
+  else if (req.max_price_levels != 0)
+    sent = ctx->session->send_business_msg(bss::LevelLimitOrder{req});
+  else
+    sent = ctx->session->send_business_msg(bss::LimitOrder{req});
+
+  if (!sent) {
     spdlog::error("[BssBroker::send_order] failed to send order");
+    std::unique_lock<std::mutex> lock(id_mutex_);
+    orders_.erase(order.engine_order_id);
+    return false;
+  }
+  return true;
+}
+
+/*
+ * order_id为on_order_accepted中回报给engine的OCG订单号，撤单请求发往
+ * 原订单所在的session
+ */
+bool BssBroker::cancel_order(uint64_t order_id) {
+  uint64_t engine_order_id;
+  uint32_t cancel_id;
+  uint32_t original_id;
+  OrderInfo info;
+  {
+    std::unique_lock<std::mutex> lock(id_mutex_);
+    auto iter = exchange_order_ids_.find(order_id);
+    if (iter == exchange_order_ids_.end()) {
+      spdlog::error("[BssBroker::cancel_order] order not found. OrderID:{}",
+                    order_id);
+      return false;
+    }
+    engine_order_id = iter->second;
+    auto id_iter = current_client_ids_.find(engine_order_id);
+    original_id = id_iter == current_client_ids_.end()
+                      ? static_cast<uint32_t>(engine_order_id)
+                      : id_iter->second;
+    cancel_id = next_amend_id_++;
+  }
+  if (!find_order(engine_order_id, &info)) {
+    spdlog::error("[BssBroker::cancel_order]: not logon");
+    return false;
+  }
+
+  bss::CancelRequest req{};
+  snprintf(req.client_order_id, sizeof(req.client_order_id), "%u", cancel_id);
+  snprintf(req.original_client_order_id, sizeof(req.original_client_order_id),
+           "%u", original_id);
+  snprintf(req.order_id, sizeof(req.order_id), "%lu", order_id);
+  strncpy(req.submitting_broker_id, broker_id_,
+          sizeof(req.submitting_broker_id));
+  memcpy(req.security_id, info.security_id, sizeof(req.security_id));
+  req.security_id_source = 8;
+  snprintf(req.security_exchange, sizeof(req.security_exchange), "%s", "XHKG");
+  get_transaction_time(req.transaction_time);
+  req.side = info.side;
+
+  {
+    std::unique_lock<std::mutex> lock(id_mutex_);
+    amend_ids_.emplace(cancel_id, engine_order_id);
+    orders_[engine_order_id].amend_ids.emplace_back(cancel_id);
+  }
+  if (!info.ctx->session->send_business_msg(req)) {
+    spdlog::error("[BssBroker::cancel_order] failed to send cancel request");
+    std::unique_lock<std::mutex> lock(id_mutex_);
+    amend_ids_.erase(cancel_id);
     return false;
   }
   return true;
 }
 
-bool BssBroker::cancel_order(uint64_t order_id) { return true; }
+void BssBroker::begin_batch() {
+  for (auto &ctx : sessions_) ctx->session->begin_batch();
+}
+
+void BssBroker::end_batch() {
+  for (auto &ctx : sessions_) ctx->session->end_batch();
+}
 
+// 按各个session的流速限制加权，表示整体的发送能力用掉了多少
+double BssBroker::send_utilization() {
+  double sent = 0.0;
+  double limit = 0.0;
+  for (auto &ctx : sessions_) {
+    if (!ctx->is_logon) continue;
+    sent += ctx->session->send_utilization() * ctx->conf.msg_limit_per_sec;
+    limit += ctx->conf.msg_limit_per_sec;
+  }
+  return limit > 0.0 ? sent / limit : 0.0;
+}
+
+/*
+ * OCG的改单请求需要携带原订单最近一次的ClientOrderID及完整的订单信息，
+ * order_quantity为改单后的委托总量。只减少数量时保留队列优先级
+ */
 bool BssBroker::amend_order(uint64_t order_id, const OrderReq &order) {
+  OrderInfo info;
+  if (!find_order(order.engine_order_id, &info)) {
+    spdlog::error("[BssBroker::amend_order]: not logon");
+    return false;
+  }
+
+  auto contract = order.contract;
+
+  bss::AmendRequest req{};
+  if (!to_bss_order_type(order.type, &req.order_type, &req.tif,
+                         &req.max_price_levels))
+    return false;
+
+  uint32_t amend_id;
+  uint32_t original_id;
+  {
+    std::unique_lock<std::mutex> lock(id_mutex_);
+    amend_id = next_amend_id_++;
+    auto iter = current_client_ids_.find(order.engine_order_id);
+    original_id = iter == current_client_ids_.end()
+                      ? static_cast<uint32_t>(order.engine_order_id)
+                      : iter->second;
+    amend_ids_.emplace(amend_id, order.engine_order_id);
+    orders_[order.engine_order_id].amend_ids.emplace_back(amend_id);
+  }
+
+  snprintf(req.client_order_id, sizeof(req.client_order_id), "%u", amend_id);
+  snprintf(req.original_client_order_id, sizeof(req.original_client_order_id),
+           "%u", original_id);
+  snprintf(req.order_id, sizeof(req.order_id), "%lu", order_id);
+  strncpy(req.submitting_broker_id, broker_id_,
+          sizeof(req.submitting_broker_id));
+  strncpy(req.security_id, contract->ticker.data(), sizeof(req.security_id));
+  req.security_id_source = 8;
+  snprintf(req.security_exchange, sizeof(req.security_exchange), "%s", "XHKG");
+  get_transaction_time(req.transaction_time);
+  req.side = bss_detail::diroff2side(order.direction, order.offset);
+  if (req.order_type == bss::ORDER_TYPE_LIMIT)
+    req.price = std::llround(order.real_price() * 1e8);
+  req.order_quantity = order.volume * 1e8;
+  req.disclosure_instructions = 0;
+
+  if (!info.ctx->session->send_business_msg(req)) {
+    spdlog::error("[BssBroker::amend_order] failed to send amend request");
+    std::unique_lock<std::mutex> lock(id_mutex_);
+    amend_ids_.erase(amend_id);
+    return false;
+  }
   return true;
 }
 
+uint64_t BssBroker::to_engine_order_id(std::string_view client_order_id) {
+  uint64_t id = to_uint(client_order_id);
+  std::unique_lock<std::mutex> lock(id_mutex_);
+  auto iter = amend_ids_.find(id);
+  return iter == amend_ids_.end() ? id : iter->second;
+}
+
 bool mass_cancel() { return true; }
 
 // TODO(kevin):
 // 如果在登录成功后网络断线，密码更改成功通知没有收到，
 // 会导致本地登录密码没有被更新，使得下次登录因密码错误而失败
-void BssBroker::on_msg(const bss::LogonMessage &msg) {
-  is_logon_ = true;
+void BssBroker::on_msg(bss::Session *session, const bss::LogonMessage &msg) {
+  auto ctx = find_session(session);
+  ctx->is_logon = true;
   if (msg.session_status == bss::BssSessionStatus::SESSION_PASSWORD_CHANGE) {
-    sess_conf_.password = sess_conf_.new_password;
-    sess_conf_.new_password = "";
-    session_->set_password(sess_conf_.password, sess_conf_.new_password);
+    ctx->conf.password = ctx->conf.new_password;
+    ctx->conf.new_password = "";
+    session->set_password(ctx->conf.password, ctx->conf.new_password);
   }
-  if (msg.text.len > 0) spdlog::info("logon text: {}", msg.text.data);
+  if (msg.text.len > 0)
+    spdlog::info("{} logon text: {}", ctx->conf.comp_id, msg.text.data);
 }
 
-void BssBroker::on_msg(const bss::LogoutMessage &msg) {
-  is_logon_ = false;
+void BssBroker::on_msg(bss::Session *session, const bss::LogoutMessage &msg) {
+  auto ctx = find_session(session);
+  ctx->is_logon = false;
   if (msg.session_status ==
           bss::BssSessionStatus::INVAILD_USERNAME_OR_PASSWORD ||
       msg.session_status == bss::BssSessionStatus::ACCOUNT_LOCKED ||
@@ -243,10 +514,11 @@ void BssBroker::on_msg(const bss::LogoutMessage &msg) {
           bss::BssSessionStatus::LOGONS_NOT_ALLOWED_AT_THIS_TIME ||
       msg.session_status == bss::BssSessionStatus::PASSWORD_EXPIRED ||
       msg.session_status == bss::BssSessionStatus::PASSWORD_CHANGE_REQUIRED) {
-    session_->disable();
+    session->disable();
   }
   if (msg.logout_text.len > 0)
-    spdlog::info("logout text: {}", msg.logout_text.data);
+    spdlog::info("{} logout text: {}", ctx->conf.comp_id,
+                 msg.logout_text.data);
 }
 
 void BssBroker::on_msg(const bss::RejectMessage &msg) {
@@ -261,8 +533,8 @@ void BssBroker::on_msg(const bss::BusinessRejectMessage &msg) {
   uint32_t client_order_id = atoi(msg.business_reject_reference_id);
 }
 
-void BssBroker::on_msg(const bss::ExecutionReport &report) {
-  switch (report.exec_type) {
+void BssBroker::on_msg(const bss::ExecutionReportView &report) {
+  switch (report.exec_type()) {
     case bss::OcgExecType::EXEC_TYPE_NEW: {
       on_order_accepted(report);
       break;
@@ -299,7 +571,7 @@ void BssBroker::on_msg(const bss::ExecutionReport &report) {
     }
     default: {
       spdlog::error("[BssBroker::on_ep]: exec type not supported. type:{}",
-                    report.exec_type);
+                    report.exec_type());
       break;
     }
   }
@@ -313,90 +585,134 @@ void BssBroker::on_msg(const bss::TradeCaptureReport &report) {}
 
 void BssBroker::on_msg(const bss::TradeCaptureReportAck &ack) {}
 
-void BssBroker::on_order_accepted(const bss::ExecutionReport &msg) {
+void BssBroker::on_order_accepted(const bss::ExecutionReportView &msg) {
   spdlog::debug(
       "[BssBroker::on_order_accepted] ClientOrderID:{} Security:{} "
       "OrderQty:{} Price:{}",
-      msg.client_order_id, msg.security_id, msg.order_quantity / 100000000,
-      static_cast<double>(msg.price) / 1e8);
+      msg.client_order_id(), msg.security_id(),
+      msg.order_quantity() / 100000000, static_cast<double>(msg.price()) / 1e8);
 
   OrderAcceptedRsp rsp{};
-  rsp.engine_order_id = std::stoul(msg.client_order_id);
-  rsp.order_id = std::stoul(msg.order_id);
+  rsp.engine_order_id = to_engine_order_id(msg.client_order_id());
+  rsp.order_id = to_uint(msg.order_id());
+  {
+    std::unique_lock<std::mutex> lock(id_mutex_);
+    exchange_order_ids_[rsp.order_id] = rsp.engine_order_id;
+    auto iter = orders_.find(rsp.engine_order_id);
+    if (iter != orders_.end()) iter->second.order_id = rsp.order_id;
+  }
   engine_->on_order_accepted(&rsp);
 }
 
-void BssBroker::on_order_rejected(const bss::ExecutionReport &msg) {
+void BssBroker::on_order_rejected(const bss::ExecutionReportView &msg) {
   spdlog::error("[BssBroker::on_order_rejected] RejectCode:{} Reason:{}",
-                msg.order_reject_code, msg.reason.data);
+                msg.order_reject_code(), msg.reason());
 
   OrderRejectedRsp rsp{};
-  rsp.engine_order_id = std::stoul(msg.client_order_id);
+  rsp.engine_order_id = to_engine_order_id(msg.client_order_id());
+  std::string reason(msg.reason());
+  rsp.reason.text = reason.c_str();
   engine_->on_order_rejected(&rsp);
+  erase_order(rsp.engine_order_id);
 }
 
-void BssBroker::on_order_executed(const bss::ExecutionReport &msg) {
-  int qty = msg.execution_quantity / 100000000;
-  double price = static_cast<double>(msg.execution_price) / 1e8;
+void BssBroker::on_order_executed(const bss::ExecutionReportView &msg) {
+  int qty = msg.execution_quantity() / 100000000;
+  double price = static_cast<double>(msg.execution_price()) / 1e8;
   spdlog::debug(
       "[BssBroker::on_order_executed] OrderID:{} ClOrdToken:{} LastQty:{} "
       "LastPrice:{}",
-      msg.order_id, msg.client_order_id, qty, price);
+      msg.order_id(), msg.client_order_id(), qty, price);
 
   OrderTradedRsp rsp{};
-  rsp.engine_order_id = std::stoul(msg.client_order_id);
-  rsp.order_id = std::stoul(msg.order_id);
+  rsp.engine_order_id = to_engine_order_id(msg.client_order_id());
+  rsp.order_id = to_uint(msg.order_id());
   rsp.volume = qty;
   rsp.price = price;
   rsp.trade_type = TradeType::SECONDARY_MARKET;
   engine_->on_order_traded(&rsp);
+  // 没有LeavesQty时不能判断是否全部成交，留到撤单或过期时再清理
+  if (msg.has(25) && msg.leaves_quantity() == 0)
+    erase_order(rsp.engine_order_id);
 }
 
-void BssBroker::on_order_cancelled(const bss::ExecutionReport &msg) {
+void BssBroker::on_order_cancelled(const bss::ExecutionReportView &msg) {
   // TODO(kevin): 可能没有order_quantity这个字段
-  int total = msg.order_quantity / 100000000;
-  int traded = msg.cumulative_quantity / 100000000;
+  int total = msg.order_quantity() / 100000000;
+  int traded = msg.cumulative_quantity() / 100000000;
 
   OrderCanceledRsp rsp{};
-  rsp.engine_order_id = std::stoul(msg.client_order_id);
+  rsp.engine_order_id = to_engine_order_id(msg.client_order_id());
   rsp.canceled_volume = total - traded;
   engine_->on_order_canceled(&rsp);
+  erase_order(rsp.engine_order_id);
 }
 
-void BssBroker::on_order_cancel_rejected(const bss::ExecutionReport &msg) {
+void BssBroker::on_order_cancel_rejected(const bss::ExecutionReportView &msg) {
   spdlog::error("[BssBroker::on_order_cancel_rejected] RejectCode:{} Reason:{}",
-                msg.cancel_reject_code, msg.reason.data);
+                msg.cancel_reject_code(), msg.reason());
   OrderCancelRejectedRsp rsp{};
-  rsp.engine_order_id = std::stoul(msg.original_client_order_id);
+  rsp.engine_order_id = to_engine_order_id(msg.original_client_order_id());
+  std::string reason(msg.reason());
+  rsp.reason.text = reason.c_str();
   engine_->on_order_cancel_rejected(&rsp);
 }
 
-// 暂未支持
-void BssBroker::on_order_amended(const bss::ExecutionReport &msg) {
-  int qty = msg.execution_quantity / 100000000;
-  double price = static_cast<double>(msg.execution_price) / 1e8;
+void BssBroker::on_order_amended(const bss::ExecutionReportView &msg) {
+  int qty = msg.order_quantity() / 100000000;
+  double price = static_cast<double>(msg.price()) / 1e8;
   spdlog::debug(
       "[BssBroker::on_order_amended] ClientOrderID:{} OriginalOrderID:{} "
       "Qty:{} Price:{}",
-      msg.client_order_id, msg.original_client_order_id, qty, price);
+      msg.client_order_id(), msg.original_client_order_id(), qty, price);
 
-  uint32_t client_order_id = atoi(msg.original_client_order_id);
+  OrderAmendedRsp rsp{};
+  rsp.engine_order_id = to_engine_order_id(msg.client_order_id());
+  if (!msg.order_id().empty()) rsp.order_id = to_uint(msg.order_id());
+  {
+    std::unique_lock<std::mutex> lock(id_mutex_);
+    current_client_ids_[rsp.engine_order_id] = to_uint(msg.client_order_id());
+  }
+  engine_->on_order_amended(&rsp);
 }
 
-// 暂未支持
-void BssBroker::on_order_amend_rejected(const bss::ExecutionReport &msg) {
+void BssBroker::on_order_amend_rejected(const bss::ExecutionReportView &msg) {
   spdlog::error("[BssBroker::on_order_amend_rejected] RejectCode:{} Reason:{}",
-                msg.amend_reject_code, msg.reason.data);
-  uint32_t client_order_id = atoi(msg.original_client_order_id);
+                msg.amend_reject_code(), msg.reason());
+
+  OrderAmendRejectedRsp rsp{};
+  rsp.engine_order_id = to_engine_order_id(msg.client_order_id());
+  std::string reason(msg.reason());
+  rsp.reason.text = reason.c_str();
+  {
+    std::unique_lock<std::mutex> lock(id_mutex_);
+    amend_ids_.erase(to_uint(msg.client_order_id()));
+  }
+  engine_->on_order_amend_rejected(&rsp);
 }
 
-void BssBroker::on_order_expired(const bss::ExecutionReport &msg) {
+void BssBroker::on_order_expired(const bss::ExecutionReportView &msg) {
   spdlog::error("[BssBroker::on_order_expired] RejectReason:{} Reason:{}",
-                msg.order_reject_code, msg.reason.data);
+                msg.order_reject_code(), msg.reason());
 
   OrderRejectedRsp rsp{};
-  rsp.engine_order_id = std::stoul(msg.client_order_id);
+  rsp.engine_order_id = to_engine_order_id(msg.client_order_id());
+  std::string reason(msg.reason());
+  rsp.reason.text = reason.c_str();
   engine_->on_order_rejected(&rsp);
+  erase_order(rsp.engine_order_id);
+}
+
+void BssBroker::erase_order(uint64_t engine_order_id) {
+  std::unique_lock<std::mutex> lock(id_mutex_);
+  auto iter = orders_.find(engine_order_id);
+  if (iter == orders_.end()) return;
+
+  const auto &info = iter->second;
+  if (info.order_id != 0) exchange_order_ids_.erase(info.order_id);
+  for (auto id : info.amend_ids) amend_ids_.erase(id);
+  current_client_ids_.erase(engine_order_id);
+  orders_.erase(iter);
 }
 
 }  // namespace ft
@@ -1,10 +1,17 @@
 // Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
 
+#include <atomic>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
 
 #include "broker/session_config.h"
 #include "interface/gateway.h"
+#include "protocol/message_view.h"
 #include "protocol/protocol.h"
 
 #ifndef BSS_BROKER_BROKER_H_
@@ -14,20 +21,31 @@ namespace ft {
 
 namespace bss {
 class Session;
-}
+class EventLoop;
+class ConnectionManager;
+class CmdProcessor;
+}  // namespace bss
 
 /*
  * Broker类用于处理业务逻辑
  *
  * Broker所收到的消息都是连续且正确的，Broker内部只需要专注于处理业务逻辑
+ *
+ * 每个OCG session都有自己的流速限制，一个Broker可以同时登录多个Comp ID，
+ * 新订单发往当前负载最低的session，改单及撤单发往原订单所在的session。
+ * 所有session都在同一个事件循环中收消息，回报按到达顺序回调给engine
  */
 class BssBroker : public Gateway {
  public:
   BssBroker();
 
+  ~BssBroker();
+
   bool login(TradingEngineInterface* engine, const Config& config);
 
-  void logon(const std::string& passwd, const std::string& new_passwd = "");
+  // comp_id为空时对所有session生效
+  void logon(const std::string& comp_id, const std::string& passwd,
+             const std::string& new_passwd = "");
 
   void logout();
 
@@ -37,19 +55,27 @@ class BssBroker : public Gateway {
 
   bool cancel_order(uint64_t order_id) override;
 
-  bool amend_order(uint64_t order_id, const OrderReq& order);
+  void begin_batch() override;
+
+  void end_batch() override;
+
+  double send_utilization() override;
+
+  bool supports_amend() const override { return true; }
+
+  bool amend_order(uint64_t order_id, const OrderReq& order) override;
 
   bool mass_cancel();
 
-  void on_msg(const bss::LogonMessage& msg);
+  void on_msg(bss::Session* session, const bss::LogonMessage& msg);
 
-  void on_msg(const bss::LogoutMessage& msg);
+  void on_msg(bss::Session* session, const bss::LogoutMessage& msg);
 
   void on_msg(const bss::RejectMessage& msg);
 
   void on_msg(const bss::BusinessRejectMessage& msg);
 
-  void on_msg(const bss::ExecutionReport& report);
+  void on_msg(const bss::ExecutionReportView& report);
 
   void on_msg(const bss::OrderMassCancelReport& report);
 
@@ -70,31 +96,77 @@ class BssBroker : public Gateway {
              date_, hour, min, sec, static_cast<int>(ts.tv_nsec / 1000000));
   }
 
-  bool check_config() const;
+  // 一个Comp ID对应一个session，有各自的连接、序列号及流速限制
+  struct SessionContext {
+    bss::SessionConfig conf;
+    std::unique_ptr<bss::Session> session;
+    std::unique_ptr<bss::ConnectionManager> conn_mgr;
+    std::atomic<bool> is_logon{false};
+  };
+
+  // 订单所在的session及撤单时需要带上的原订单信息，以及订单结束时需要
+  // 一并清理的各个ID
+  struct OrderInfo {
+    SessionContext* ctx;
+    bss::SecurityId security_id;
+    bss::Side side;
+    uint64_t order_id{0};            // OCG的OrderID，被接受后才有
+    std::vector<uint32_t> amend_ids;  // 改单及撤单使用过的ClientOrderID
+  };
 
-  void on_order_accepted(const bss::ExecutionReport& msg);
+  static bool check_config(const bss::SessionConfig& conf);
 
-  void on_order_rejected(const bss::ExecutionReport& msg);
+  SessionContext* find_session(bss::Session* session);
 
-  void on_order_executed(const bss::ExecutionReport& msg);
+  // 已登录的session中负载最低的一个，都没有登录时返回nullptr
+  SessionContext* select_session();
 
-  void on_order_cancelled(const bss::ExecutionReport& msg);
+  // 找不到或者所在的session没有登录时返回false
+  bool find_order(uint64_t engine_order_id, OrderInfo* info);
 
-  void on_order_cancel_rejected(const bss::ExecutionReport& msg);
+  // 改单使用新的ClientOrderID，之后的回报都以新的ID为准，需要映射回订单号
+  uint64_t to_engine_order_id(std::string_view client_order_id);
 
-  void on_order_amended(const bss::ExecutionReport& msg);
+  void on_order_accepted(const bss::ExecutionReportView& msg);
 
-  void on_order_amend_rejected(const bss::ExecutionReport& msg);
+  void on_order_rejected(const bss::ExecutionReportView& msg);
 
-  void on_order_expired(const bss::ExecutionReport& msg);
+  void on_order_executed(const bss::ExecutionReportView& msg);
+
+  void on_order_cancelled(const bss::ExecutionReportView& msg);
+
+  void on_order_cancel_rejected(const bss::ExecutionReportView& msg);
+
+  void on_order_amended(const bss::ExecutionReportView& msg);
+
+  void on_order_amend_rejected(const bss::ExecutionReportView& msg);
+
+  void on_order_expired(const bss::ExecutionReportView& msg);
+
+  // 订单全部成交、撤销、被拒或过期后清理它在各个映射表中的记录
+  void erase_order(uint64_t engine_order_id);
 
  private:
   TradingEngineInterface* engine_;
-  bss::SessionConfig sess_conf_;
-  bool is_logon_{false};
-  std::unique_ptr<bss::Session> session_;
+  // 析构时session要先于事件循环释放
+  std::unique_ptr<bss::EventLoop> loop_;
+  std::vector<std::unique_ptr<SessionContext>> sessions_;
+  std::unique_ptr<bss::CmdProcessor> cmd_processor_;
+  std::thread loop_thread_;
   bss::BrokerId broker_id_;
   char date_[9]{};
+
+  // 引擎的订单号不会达到这个范围，改单及撤单的ClientOrderID从这里开始分配
+  uint32_t next_amend_id_{0x80000000};
+  // 改单及撤单的ClientOrderID -> engine_order_id
+  std::map<uint32_t, uint64_t> amend_ids_;
+  // engine_order_id -> 订单所在的session等信息
+  std::map<uint64_t, OrderInfo> orders_;
+  // OCG的OrderID -> engine_order_id，撤单时gateway只拿到OCG的OrderID
+  std::map<uint64_t, uint64_t> exchange_order_ids_;
+  // engine_order_id -> 最近一次被接受的ClientOrderID，改单时作为原订单ID
+  std::map<uint64_t, uint32_t> current_client_ids_;
+  std::mutex id_mutex_;
 };
 
 namespace bss_detail {
@@ -4,6 +4,7 @@
 
 #include <arpa/inet.h>
 #include <netinet/in.h>
+#include <sys/epoll.h>
 #include <sys/socket.h>
 #include <unistd.h>
 
@@ -18,8 +19,8 @@
 namespace ft::bss {
 
 static int create_servfd(int port) {
-  int servfd = socket(AF_INET, SOCK_STREAM, 0);
-  assert(servfd > 0);
+  int servfd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (servfd < 0) return -1;
 
   int opt = 1;
   setsockopt(servfd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(int));
@@ -29,67 +30,93 @@ static int create_servfd(int port) {
   addrin.sin_addr.s_addr = INADDR_ANY;
   addrin.sin_port = htons(port);
 
-  int res = bind(servfd, reinterpret_cast<sockaddr*>(&addrin), sizeof(addrin));
-  assert(res == 0);
-
-  res = ::listen(servfd, 5);
-  assert(res == 0);
+  if (bind(servfd, reinterpret_cast<sockaddr*>(&addrin), sizeof(addrin)) != 0 ||
+      ::listen(servfd, 5) != 0) {
+    close(servfd);
+    return -1;
+  }
 
   return servfd;
 }
 
-static int accept(int servfd) {
-  sockaddr cliaddr{};
-  socklen_t socklen = sizeof(cliaddr);
-  int sockfd;
+CmdProcessor::CmdProcessor(EventLoop* loop, ::ft::BssBroker* broker)
+    : loop_(loop), broker_(broker) {
+  assert(broker);
+}
 
-restart:
-  sockfd = ::accept(servfd, &cliaddr, &socklen);
-  if (sockfd < 0) {
-    if (errno == EINTR) goto restart;
-    abort();
+CmdProcessor::~CmdProcessor() {
+  while (!clients_.empty()) close_client(clients_.begin()->first);
+  if (servfd_ >= 0) {
+    loop_->remove_fd(servfd_);
+    close(servfd_);
   }
-  sockfd = sockfd;
-  return sockfd;
 }
 
-CmdProcessor::CmdProcessor(::ft::BssBroker* broker) : broker_(broker) {
-  assert(broker);
-}
+bool CmdProcessor::start(int port) {
+  servfd_ = create_servfd(port);
+  if (servfd_ < 0) {
+    printf("[CmdProcessor::start] failed to listen on %d\n", port);
+    return false;
+  }
 
-void CmdProcessor::start(int port) {
-  const int bufsz = 4096 * 8;
-  char buf[bufsz];
-  size_t sz;
-  int servfd = create_servfd(port);
+  return loop_->add_fd(servfd_, EPOLLIN,
+                       [this](uint32_t) { on_accept(); }) != 0;
+}
 
+void CmdProcessor::on_accept() {
   for (;;) {
-    sz = 0;
-    int sockfd = accept(servfd);
-
-    for (;;) {
-      auto n = recv(sockfd, buf + sz, bufsz - sz, 0);
-      if (n == 0) break;
-      if (n < 0) {
-        if (errno == EINTR) break;
-        continue;
-      }
-      sz += n;
-      if (sz < sizeof(CmdHeader) ||
-          sz < reinterpret_cast<CmdHeader*>(buf)->length)
-        continue;
-
-      auto hdr = reinterpret_cast<CmdHeader*>(buf);
-      if (!process_cmd(*hdr, reinterpret_cast<const char*>(hdr + 1))) break;
-
-      sz -= hdr->length;
-      memmove(buf, buf + hdr->length, sz);
+    int sockfd =
+        accept4(servfd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (sockfd < 0) {
+      if (errno == EINTR) continue;
+      return;
+    }
+
+    auto on_event = [this, sockfd](uint32_t) { on_client_event(sockfd); };
+    if (loop_->add_fd(sockfd, EPOLLIN, on_event) == 0) {
+      close(sockfd);
+      continue;
+    }
+    clients_[sockfd] = std::make_unique<Client>();
+  }
+}
+
+void CmdProcessor::on_client_event(int sockfd) {
+  auto& client = *clients_[sockfd];
+  auto n = recv(sockfd, client.buf + client.size,
+                Client::kBufSize - client.size, 0);
+  if (n < 0 && (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK))
+    return;
+  if (n <= 0) {
+    close_client(sockfd);
+    return;
+  }
+
+  client.size += n;
+  while (client.size >= sizeof(CmdHeader)) {
+    auto hdr = reinterpret_cast<CmdHeader*>(client.buf);
+    if (hdr->length < sizeof(CmdHeader) || hdr->length > Client::kBufSize) {
+      close_client(sockfd);
+      return;
+    }
+    if (client.size < hdr->length) break;
+
+    if (!process_cmd(*hdr, reinterpret_cast<const char*>(hdr + 1))) {
+      close_client(sockfd);
+      return;
     }
 
-    close(sockfd);
+    client.size -= hdr->length;
+    memmove(client.buf, client.buf + hdr->length, client.size);
   }
 }
 
+void CmdProcessor::close_client(int sockfd) {
+  loop_->remove_fd(sockfd);
+  close(sockfd);
+  clients_.erase(sockfd);
+}
+
 bool CmdProcessor::process_cmd(const CmdHeader& hdr, const char* body) {
   printf("cmd: <magic:0x%x, type:%u, length:%u>\n", hdr.magic, hdr.type,
          hdr.length);
@@ -129,7 +156,8 @@ bool CmdProcessor::process_cmd(const CmdHeader& hdr, const char* body) {
 }
 
 void CmdProcessor::process_logon(const LogonCmd& cmd) {
-  broker_->logon(cmd.password, cmd.new_password);
+  std::string comp_id(cmd.comp_id, strnlen(cmd.comp_id, sizeof(cmd.comp_id)));
+  broker_->logon(comp_id, cmd.password, cmd.new_password);
 }
 
 void CmdProcessor::process_logout() { broker_->logout(); }
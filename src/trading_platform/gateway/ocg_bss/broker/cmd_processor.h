@@ -3,7 +3,11 @@
 #ifndef BSS_BROKER_CMD_PROCESSOR_H_
 #define BSS_BROKER_CMD_PROCESSOR_H_
 
+#include <map>
+#include <memory>
+
 #include "broker/command.h"
+#include "broker/event_loop.h"
 
 namespace ft {
 class BssBroker;
@@ -11,13 +15,32 @@ class BssBroker;
 
 namespace ft::bss {
 
+/*
+ * 命令端口，监听及各个客户端的连接都注册在EventLoop中
+ */
 class CmdProcessor {
  public:
-  CmdProcessor(::ft::BssBroker* broker);
+  CmdProcessor(EventLoop* loop, ::ft::BssBroker* broker);
+
+  ~CmdProcessor();
 
-  void start(int port);
+  // 在事件循环的线程中调用
+  bool start(int port);
 
  private:
+  struct Client {
+    static constexpr std::size_t kBufSize = 4096 * 8;
+
+    std::size_t size = 0;
+    char buf[kBufSize];
+  };
+
+  void on_accept();
+
+  void on_client_event(int sockfd);
+
+  void close_client(int sockfd);
+
   bool process_cmd(const CmdHeader& hdr, const char* body);
   void process_logon(const LogonCmd& cmd);
   void process_logout();
@@ -27,7 +50,10 @@ class CmdProcessor {
   void process_mass_cancel(const MassCancelCmd& cmd);
 
  private:
+  EventLoop* loop_;
   ::ft::BssBroker* broker_;
+  int servfd_ = -1;
+  std::map<int, std::unique_ptr<Client>> clients_;
 };
 
 }  // namespace ft::bss
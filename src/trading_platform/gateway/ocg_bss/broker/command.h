@@ -21,6 +21,7 @@ enum CmdType {
 struct LogonCmd {
   char password[9];
   char new_password[9];
+  CompId comp_id;  // 为空时对所有session生效
 } __attribute__((__packed__));
 
 struct NewOrderCmd {
@@ -4,57 +4,94 @@
 
 #include <arpa/inet.h>
 #include <netinet/in.h>
+#include <sys/epoll.h>
 #include <sys/socket.h>
 #include <unistd.h>
 
+#include <cerrno>
+
 #include "broker/constants.h"
 
 namespace ft::bss {
 
-ConnectionManager::ConnectionManager(Session* session) : session_(session) {
+ConnectionManager::ConnectionManager(EventLoop* loop, Session* session)
+    : loop_(loop), session_(session) {
   for (auto& address : lookup_servers_) {
     address.first = "0.0.0.0";
     address.second = 18888;
   }
 }
 
-void ConnectionManager::on_disconnect(DisconnectReason reason) {
-  should_disconnect_ = true;
-  disconnect_reason_ = reason;
+ConnectionManager::~ConnectionManager() {
+  ocg_conn_.reset();
+  if (lookup_fd_ >= 0) {
+    loop_->remove_fd(lookup_fd_);
+    close(lookup_fd_);
+  }
+  loop_->destroy_timer(timerfd_);
 }
 
-void ConnectionManager::run() {
-  // 因session主动close，或是OCG主动close，都应该间隔一定时间才进行重连
-  // 重连原则：
-  // * 如果连接突然断开(主动断或是被动断)或是收到OCG发来的Logout，间隔10秒再重试
-  // * 如果发出Logon后没有60秒内没收到任何回应，间隔60秒再重试
-  // * 多次connect失败应该重新查找lookup service获取新的ocg地址
-  request_ocg_address();
-
-  for (;;) {
-    // 如果连接不上需要等待10秒再重试
-    if (!do_connect_to_ocg(true)) {
-      sleep(RECONNECT_INTERVAL_SEC);
-
-      // 尝试连接备用服务器
-      if (!do_connect_to_ocg(false)) {
-        sleep(RECONNECT_INTERVAL_SEC);
-
-        // 仍然连接不上，请求lookup services
-        request_ocg_address();
-        continue;
-      }
-    }
+bool ConnectionManager::start() {
+  timerfd_ = loop_->create_timer([this] { on_timer(); });
+  if (timerfd_ < 0) return false;
 
-    while (!should_disconnect_) sleep(1);
-    ocg_conn_.reset();
+  run_step(Step::LOOKUP);
+  return true;
+}
 
-    // 如果是对方没有给予登录回应，应该60秒后再尝试重连
-    if (disconnect_reason_ == DisconnectReason::LOGON_TIMEOUT) {
-      sleep(RECONNECT_INTERVAL_SEC_IF_NOT_RSP);
-    } else {
-      sleep(RECONNECT_INTERVAL_SEC);
-    }
+void ConnectionManager::schedule(Step step, uint64_t delay_sec) {
+  next_step_ = step;
+  loop_->arm_timer(timerfd_, delay_sec * 1000000);
+}
+
+void ConnectionManager::on_timer() {
+  // lookup请求进行中时定时器用于超时
+  if (lookup_fd_ >= 0) {
+    printf("request_ocg_address. timeout\n");
+    finish_lookup(false);
+    return;
+  }
+
+  run_step(next_step_);
+}
+
+void ConnectionManager::run_step(Step step) {
+  switch (step) {
+    case Step::LOOKUP:
+      request_ocg_address();
+      break;
+    case Step::CONNECT_PRIMARY:
+      do_connect_to_ocg(true);
+      break;
+    case Step::CONNECT_SECONDARY:
+      do_connect_to_ocg(false);
+      break;
+  }
+}
+
+/*
+ * 因session主动close，或是OCG主动close，都应该间隔一定时间才进行重连
+ * 重连原则：
+ * * 如果连接突然断开(主动断或是被动断)或是收到OCG发来的Logout，间隔10秒再重试
+ * * 如果发出Logon后没有60秒内没收到任何回应，间隔60秒再重试
+ * * 多次connect失败应该重新查找lookup service获取新的ocg地址
+ */
+void ConnectionManager::on_disconnect(DisconnectReason reason) {
+  // 连接对象在下一次连接时才释放，这里可能还在它的回调中
+  if (reason == DisconnectReason::LOGON_TIMEOUT)
+    schedule(Step::CONNECT_PRIMARY, RECONNECT_INTERVAL_SEC_IF_NOT_RSP);
+  else
+    schedule(Step::CONNECT_PRIMARY, RECONNECT_INTERVAL_SEC);
+}
+
+void ConnectionManager::on_connect_failed() {
+  // 如果连接不上需要等待10秒再尝试连接备用服务器，仍然连接不上，
+  // 则重新请求lookup services
+  if (using_primary_) {
+    schedule(Step::CONNECT_SECONDARY, RECONNECT_INTERVAL_SEC);
+  } else {
+    lookup_index_ = 0;
+    schedule(Step::LOOKUP, RECONNECT_INTERVAL_SEC);
   }
 }
 
@@ -66,47 +103,93 @@ void ConnectionManager::run() {
  *   2. Primary site mirror Lookup Service
  *   3. Backup site primary Lookup Service
  *   4. Backup site mirror Lookup Service
- * 如果查询失败（连接中断或查询被拒），则下一次查询要间隔5秒
+ * 如果查询失败（连接中断或查询被拒），则下一次查询要间隔5秒。4个地址都
+ * 失败时使用之前的OCG地址去连接
  */
 void ConnectionManager::request_ocg_address() {
-  for (const auto& [ip, port] : lookup_servers_) {
-    int sockfd = connect_to_lookup_server(ip, port);
-    if (sockfd < 0) {
-      sleep(LOOKUP_SERVICE_RETRY_INTERVAL_SEC);
-      continue;
+  const auto& [ip, port] = lookup_servers_[lookup_index_];
+  lookup_fd_ = connect_to_lookup_server(ip, port);
+  if (lookup_fd_ < 0) {
+    finish_lookup(false);
+    return;
+  }
+
+  lookup_sent_ = false;
+  lookup_recv_size_ = 0;
+  auto on_event = [this](uint32_t events) { on_lookup_event(events); };
+  lookup_fd_id_ = loop_->add_fd(lookup_fd_, EPOLLOUT, on_event);
+  if (lookup_fd_id_ == 0) {
+    finish_lookup(false);
+    return;
+  }
+  loop_->arm_timer(timerfd_, LOOKUP_SERVICE_TIMEOUT_SEC * 1000000UL);
+}
+
+void ConnectionManager::on_lookup_event(uint32_t events) {
+  if (!lookup_sent_) {
+    // 可写表示连接有了结果
+    int err = 0;
+    socklen_t len = sizeof(err);
+    getsockopt(lookup_fd_, SOL_SOCKET, SO_ERROR, &err, &len);
+    if (err != 0) {
+      printf("request_ocg_address. failed to connect\n");
+      finish_lookup(false);
+      return;
     }
 
     // 生成查询请求
-    if (!send_lookup_request(sockfd)) {
-      close(sockfd);
-      sleep(LOOKUP_SERVICE_RETRY_INTERVAL_SEC);
-      continue;
+    if (!send_lookup_request(lookup_fd_)) {
+      finish_lookup(false);
+      return;
     }
+    lookup_sent_ = true;
+    loop_->modify_fd(lookup_fd_, lookup_fd_id_, EPOLLIN);
+    return;
+  }
 
-    // 接收并解析查询请求
-    LookupResponse rsp{};
-    if (!recv_lookup_response(sockfd, &rsp)) {
-      close(sockfd);
-      sleep(LOOKUP_SERVICE_RETRY_INTERVAL_SEC);
-      continue;
-    }
-    close(sockfd);
+  // 接收并解析查询请求
+  auto res = recv(lookup_fd_, lookup_buf_ + lookup_recv_size_,
+                  sizeof(lookup_buf_) - lookup_recv_size_, 0);
+  if (res < 0 && (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK))
+    return;
+  if (res <= 0) {
+    finish_lookup(false);
+    return;
+  }
 
-    // 收到正确的请求
-    primary_ocg_address_.first = rsp.primary_ip;
-    primary_ocg_address_.second = rsp.primary_port;
-    secondary_ocg_address_.first = rsp.secondary_ip;
-    secondary_ocg_address_.second = rsp.secondary_port;
-    printf("lookup response. primary: %s:%u  secondary: %s:%u\n",
-           primary_ocg_address_.first.c_str(), primary_ocg_address_.second,
-           secondary_ocg_address_.first.c_str(), secondary_ocg_address_.second);
+  lookup_recv_size_ += res;
+  auto header = reinterpret_cast<MessageHeader*>(lookup_buf_);
+  if (lookup_recv_size_ < sizeof(MessageHeader) ||
+      lookup_recv_size_ < header->length) {
+    if (lookup_recv_size_ == sizeof(lookup_buf_)) finish_lookup(false);
     return;
   }
+
+  finish_lookup(process_lookup_response(*header));
+}
+
+void ConnectionManager::finish_lookup(bool success) {
+  if (lookup_fd_ >= 0) {
+    loop_->remove_fd(lookup_fd_);
+    close(lookup_fd_);
+    lookup_fd_ = -1;
+  }
+  loop_->cancel_timer(timerfd_);
+
+  if (success) {
+    lookup_index_ = 0;
+    do_connect_to_ocg(true);
+  } else if (++lookup_index_ < lookup_servers_.size()) {
+    schedule(Step::LOOKUP, LOOKUP_SERVICE_RETRY_INTERVAL_SEC);
+  } else {
+    lookup_index_ = 0;
+    schedule(Step::CONNECT_PRIMARY, LOOKUP_SERVICE_RETRY_INTERVAL_SEC);
+  }
 }
 
 int ConnectionManager::connect_to_lookup_server(const std::string& ip,
                                                 uint16_t port) {
-  int sockfd = socket(AF_INET, SOCK_STREAM, 0);
+  int sockfd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
   if (sockfd < 0) {
     printf("request_ocg_address. failed to creat socket\n");
     abort();
@@ -120,7 +203,8 @@ int ConnectionManager::connect_to_lookup_server(const std::string& ip,
   addrin.sin_family = AF_INET;
   addrin.sin_port = htons(static_cast<int16_t>(port));
 
-  if (::connect(sockfd, (sockaddr*)(&addrin), sizeof(addrin)) != 0) {
+  if (::connect(sockfd, (sockaddr*)(&addrin), sizeof(addrin)) != 0 &&
+      errno != EINPROGRESS) {
     printf("request_ocg_address. failed to connect\n");
     close(sockfd);
     return -1;
@@ -136,10 +220,11 @@ bool ConnectionManager::send_lookup_request(int sockfd) {
 
   encoder.set_comp_id(session_->comp_id());
   encoder.encode_msg(lookup_req, &msg_buf);
-  // 发送查询请求
+  // 发送查询请求，刚建立的连接一定能一次写入，写不进去时视为失败
   uint32_t total_send = 0;
   do {
-    auto res = send(sockfd, msg_buf.data, msg_buf.size, 0);
+    auto res = send(sockfd, msg_buf.data + total_send,
+                    msg_buf.size - total_send, MSG_NOSIGNAL);
     if (res == 0 || (res < 0 && errno != EINTR)) {
       printf("failed to send lookup request\n");
       return false;
@@ -151,60 +236,47 @@ bool ConnectionManager::send_lookup_request(int sockfd) {
   return true;
 }
 
-bool ConnectionManager::recv_lookup_response(int sockfd, LookupResponse* rsp) {
-  char buf[4096];
-  uint32_t total_recv = 0;
-
-  do {
-    auto res = recv(sockfd, buf, 4096 - total_recv, 0);
-    if (res == 0 || (res < 0 && errno != EINTR)) {
-      return false;
-    } else if (res > 0) {
-      total_recv += res;
-    }
-  } while (total_recv < sizeof(MessageHeader) ||
-           total_recv < reinterpret_cast<MessageHeader*>(buf)->length);
-
-  auto header = reinterpret_cast<MessageHeader*>(buf);
-  if (header->comp_id != session_->comp_id() ||
-      header->message_type != LOOKUP_RESPONSE) {
+bool ConnectionManager::process_lookup_response(const MessageHeader& header) {
+  if (header.comp_id != session_->comp_id() ||
+      header.message_type != LOOKUP_RESPONSE) {
     printf("invalid lookup response\n");
     return false;
   }
 
-  parse_lookup_response(*header, reinterpret_cast<char*>(header + 1), rsp);
-  if (rsp->status != LOOKUP_SERVICE_ACCEPTED) {
+  LookupResponse rsp{};
+  parse_msg(header, reinterpret_cast<const char*>(&header + 1), &rsp);
+  if (rsp.status != LOOKUP_SERVICE_ACCEPTED) {
     printf("request_ocg_address. rejected: reason:%u\n",
-           rsp->lookup_reject_code);
-    close(sockfd);
-    sleep(LOOKUP_SERVICE_RETRY_INTERVAL_SEC);
+           rsp.lookup_reject_code);
     return false;
   }
 
+  // 收到正确的请求
+  primary_ocg_address_.first = rsp.primary_ip;
+  primary_ocg_address_.second = rsp.primary_port;
+  secondary_ocg_address_.first = rsp.secondary_ip;
+  secondary_ocg_address_.second = rsp.secondary_port;
+  printf("lookup response. primary: %s:%u  secondary: %s:%u\n",
+         primary_ocg_address_.first.c_str(), primary_ocg_address_.second,
+         secondary_ocg_address_.first.c_str(), secondary_ocg_address_.second);
   return true;
 }
 
-bool ConnectionManager::do_connect_to_ocg(bool use_primary) {
+void ConnectionManager::do_connect_to_ocg(bool use_primary) {
   // 如果检测到当前状态不允许登录，则每隔一秒重新检测一次
-  while (!session_->is_enabled()) sleep(1);
-
-  should_disconnect_ = false;
-  if (use_primary) {
-    ocg_conn_ = std::make_unique<OcgConnection>(this, session_,
-                                                primary_ocg_address_.first,
-                                                primary_ocg_address_.second);
-  } else {
-    ocg_conn_ = std::make_unique<OcgConnection>(this, session_,
-                                                secondary_ocg_address_.first,
-                                                secondary_ocg_address_.second);
+  if (!session_->is_enabled()) {
+    schedule(use_primary ? Step::CONNECT_PRIMARY : Step::CONNECT_SECONDARY, 1);
+    return;
   }
 
+  using_primary_ = use_primary;
+  const auto& [ip, port] =
+      use_primary ? primary_ocg_address_ : secondary_ocg_address_;
+  ocg_conn_ = std::make_unique<OcgConnection>(loop_, this, session_, ip, port);
   if (!ocg_conn_->connect()) {
     ocg_conn_.reset();
-    return false;
+    on_connect_failed();
   }
-
-  return true;
 }
 
 }  // namespace ft::bss
@@ -3,43 +3,88 @@
 #ifndef BSS_BROKER_CONNECTION_MANAGER_H_
 #define BSS_BROKER_CONNECTION_MANAGER_H_
 
+#include <array>
 #include <memory>
+#include <string>
+#include <utility>
 
+#include "broker/event_loop.h"
 #include "broker/ocg_connection.h"
 #include "broker/session.h"
 
 namespace ft::bss {
 
+/*
+ * 负责查询OCG地址、连接及断线重连，所有操作都在EventLoop的线程中进行
+ *
+ * 原来的阻塞式流程拆成下面几步，每一步失败后由定时器在相应的间隔后
+ * 执行下一步，不会阻塞事件循环：
+ *   LOOKUP -> CONNECT_PRIMARY -> CONNECT_SECONDARY -> LOOKUP -> ...
+ */
 class ConnectionManager {
  public:
-  explicit ConnectionManager(Session* session);
+  ConnectionManager(EventLoop* loop, Session* session);
 
-  void on_disconnect(DisconnectReason reason);
+  ~ConnectionManager();
+
+  // 在事件循环的线程中调用
+  bool start();
 
-  void run();
+  // 以下由OcgConnection在事件循环的线程中回调
+  void on_connect_failed();
+
+  void on_disconnect(DisconnectReason reason);
 
  private:
+  enum class Step {
+    LOOKUP,
+    CONNECT_PRIMARY,
+    CONNECT_SECONDARY,
+  };
+
+  void schedule(Step step, uint64_t delay_sec);
+
+  void on_timer();
+
+  void run_step(Step step);
+
   void request_ocg_address();
 
+  void on_lookup_event(uint32_t events);
+
+  void finish_lookup(bool success);
+
   int connect_to_lookup_server(const std::string& ip, uint16_t port);
 
   bool send_lookup_request(int sockfd);
 
-  bool recv_lookup_response(int sockfd, LookupResponse* rsp);
+  // 收到完整的回应后调用，返回是否查询成功
+  bool process_lookup_response(const MessageHeader& header);
 
-  bool do_connect_to_ocg(bool use_primary = true);
+  void do_connect_to_ocg(bool use_primary = true);
 
  private:
   using Address = std::pair<std::string, uint16_t>;
 
+  EventLoop* loop_;
   std::array<Address, 4> lookup_servers_;
   Address primary_ocg_address_;
   Address secondary_ocg_address_;
 
   Session* session_;
   std::unique_ptr<OcgConnection> ocg_conn_;
-  volatile bool should_disconnect_ = false;
-  DisconnectReason disconnect_reason_;
+  bool using_primary_ = true;
+
+  int timerfd_ = -1;
+  Step next_step_ = Step::LOOKUP;
+
+  // 正在进行的lookup请求
+  int lookup_fd_ = -1;
+  uint64_t lookup_fd_id_ = 0;
+  bool lookup_sent_ = false;
+  std::size_t lookup_index_ = 0;
+  std::size_t lookup_recv_size_ = 0;
+  char lookup_buf_[4096];
 };
 
 }  // namespace ft::bss
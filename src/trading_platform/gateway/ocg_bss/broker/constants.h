@@ -8,6 +8,9 @@ namespace ft::bss {
 // Lookup service请求失败之后的重试间隔
 #define LOOKUP_SERVICE_RETRY_INTERVAL_SEC 5
 
+// Lookup service请求的超时时间，超时后视为请求失败
+#define LOOKUP_SERVICE_TIMEOUT_SEC 10
+
 // 超时没有收到登录回应导致断线，应该导致60秒后再尝试重连
 #define RECONNECT_INTERVAL_SEC_IF_NOT_RSP 60
 
@@ -29,6 +32,21 @@ namespace ft::bss {
 // 登出超时时间，若主动发出登出请求后，在超时时间内未收到登出回应则超时
 #define LOGOUT_TIMEOUT_MS (60 * 1000)
 
+// 批量发送时发送缓冲区的大小，攒满后立即发出
+#define SEND_BATCH_MAX_BYTES (64 * 1024)
+
+// 批量发送时缓冲区中第一条消息最多等待的时间
+#define SEND_BATCH_MAX_DELAY_US 200
+
+// 流控排队时每个优先级最多缓存的业务消息条数，超过后拒绝发送
+#define SEND_PENDING_MAX_MSGS 1024
+
+// 对方不收数据时socket发送缓冲区之外最多缓存的字节数，超过后断开连接
+#define SEND_OUTPUT_MAX_BYTES (4 * 1024 * 1024)
+
+// 提前到达的消息在接收缓冲区中最多保留的字节数，超过后丢弃，由重传补上
+#define RECV_CACHE_MAX_BYTES (4 * 1024 * 1024)
+
 // 每个交易日的初始发送端序列号
 #define DAILY_INITIAL_SND_MSG_SEQ 1
 
@@ -0,0 +1,172 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#include "broker/event_loop.h"
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <utility>
+
+namespace ft::bss {
+
+namespace {
+
+inline constexpr int kMaxEvents = 64;
+
+timespec to_timespec(uint64_t us) {
+  timespec ts{};
+  ts.tv_sec = static_cast<time_t>(us / 1000000);
+  ts.tv_nsec = static_cast<long>(us % 1000000 * 1000);
+  return ts;
+}
+
+}  // namespace
+
+// 注册的fd由注册者负责移除及关闭
+EventLoop::~EventLoop() {
+  if (wakeup_fd_ >= 0) close(wakeup_fd_);
+  if (epfd_ >= 0) close(epfd_);
+}
+
+bool EventLoop::init() {
+  epfd_ = epoll_create1(EPOLL_CLOEXEC);
+  wakeup_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (epfd_ < 0 || wakeup_fd_ < 0) {
+    printf("[EventLoop::init] failed to create epoll or eventfd\n");
+    return false;
+  }
+
+  auto drain = [this](uint32_t) {
+    uint64_t tmp;
+    read(wakeup_fd_, &tmp, sizeof(tmp));
+  };
+  return add_fd(wakeup_fd_, EPOLLIN, drain) != 0;
+}
+
+void EventLoop::run() {
+  loop_thread_id_ = std::this_thread::get_id();
+  running_ = true;
+
+  epoll_event events[kMaxEvents];
+  while (running_) {
+    int nfds = epoll_wait(epfd_, events, kMaxEvents, -1);
+    if (nfds < 0) {
+      if (errno == EINTR) continue;
+      printf("[EventLoop::run] epoll_wait failed: %d\n", errno);
+      break;
+    }
+
+    for (int i = 0; i < nfds; ++i) {
+      uint64_t id = events[i].data.u64;
+      auto iter = entries_.find(static_cast<int>(id & 0xffffffff));
+      // 处理前面的事件时这个fd可能已经被移除或者复用了
+      if (iter == entries_.end() || iter->second.id != id) continue;
+
+      // 回调中可能移除自己，先持有一份
+      auto handler = iter->second.handler;
+      (*handler)(events[i].events);
+    }
+
+    run_posted_tasks();
+  }
+}
+
+void EventLoop::stop() {
+  running_ = false;
+  post([] {});
+}
+
+void EventLoop::post(Task task) {
+  {
+    std::unique_lock<std::mutex> lock(task_mutex_);
+    tasks_.emplace_back(std::move(task));
+  }
+
+  uint64_t one = 1;
+  write(wakeup_fd_, &one, sizeof(one));
+}
+
+void EventLoop::run_posted_tasks() {
+  std::vector<Task> tasks;
+  {
+    std::unique_lock<std::mutex> lock(task_mutex_);
+    tasks.swap(tasks_);
+  }
+
+  for (auto& task : tasks) task();
+}
+
+uint64_t EventLoop::add_fd(int fd, uint32_t events, Handler handler) {
+  // 序号从1开始，id不会为0
+  uint64_t id = (static_cast<uint64_t>(++next_seq_) << 32) |
+                static_cast<uint32_t>(fd);
+
+  epoll_event ev{};
+  ev.events = events;
+  ev.data.u64 = id;
+  if (epoll_ctl(epfd_, EPOLL_CTL_ADD, fd, &ev) != 0) {
+    printf("[EventLoop::add_fd] epoll_ctl failed. fd:%d errno:%d\n", fd,
+           errno);
+    return 0;
+  }
+
+  entries_[fd] = {id, std::make_shared<Handler>(std::move(handler))};
+  return id;
+}
+
+bool EventLoop::modify_fd(int fd, uint64_t id, uint32_t events) {
+  epoll_event ev{};
+  ev.events = events;
+  ev.data.u64 = id;
+  return epoll_ctl(epfd_, EPOLL_CTL_MOD, fd, &ev) == 0;
+}
+
+void EventLoop::remove_fd(int fd) {
+  if (entries_.erase(fd) > 0) epoll_ctl(epfd_, EPOLL_CTL_DEL, fd, nullptr);
+}
+
+int EventLoop::create_timer(Task task) {
+  int timerfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  if (timerfd < 0) return -1;
+
+  auto handler = [timerfd, task = std::move(task)](uint32_t) {
+    uint64_t expirations;
+    // 触发后又被重新设置时可能读不到，这种情况不回调
+    if (read(timerfd, &expirations, sizeof(expirations)) > 0) task();
+  };
+  if (add_fd(timerfd, EPOLLIN, std::move(handler)) == 0) {
+    close(timerfd);
+    return -1;
+  }
+
+  return timerfd;
+}
+
+bool EventLoop::arm_timer(int timerfd, uint64_t delay_us,
+                          uint64_t interval_us) {
+  itimerspec ts{};
+  ts.it_value = to_timespec(delay_us);
+  ts.it_interval = to_timespec(interval_us);
+  // it_value为0会取消定时器，delay_us为0的周期定时器改为立即开始
+  if (delay_us == 0 && interval_us != 0) ts.it_value.tv_nsec = 1;
+  return timerfd_settime(timerfd, 0, &ts, nullptr) == 0;
+}
+
+bool EventLoop::arm_timer_at(int timerfd, uint64_t deadline_us) {
+  itimerspec ts{};
+  // 已经过去的时间会立即触发，但不能为0
+  ts.it_value = to_timespec(deadline_us > 0 ? deadline_us : 1);
+  return timerfd_settime(timerfd, TFD_TIMER_ABSTIME, &ts, nullptr) == 0;
+}
+
+void EventLoop::destroy_timer(int timerfd) {
+  if (timerfd < 0) return;
+  remove_fd(timerfd);
+  close(timerfd);
+}
+
+}  // namespace ft::bss
@@ -0,0 +1,96 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef OCG_BSS_BROKER_EVENT_LOOP_H_
+#define OCG_BSS_BROKER_EVENT_LOOP_H_
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace ft::bss {
+
+/*
+ * 基于epoll的事件循环，BSS的所有连接(OCG、lookup service、命令端口)及
+ * 定时器都注册在同一个循环中，由一个线程驱动
+ *
+ * fd注册后得到一个由fd及序号组成的id，放在epoll_event.data中。fd关闭后
+ * 编号可能被新的fd复用，同一批事件中属于旧fd的事件因为id对不上而被丢弃
+ *
+ * 除了post、modify_fd及arm_timer_at之外，其他函数都只能在循环的线程中
+ * 调用
+ */
+class EventLoop {
+ public:
+  using Handler = std::function<void(uint32_t events)>;
+  using Task = std::function<void()>;
+
+  EventLoop() = default;
+
+  ~EventLoop();
+
+  EventLoop(const EventLoop&) = delete;
+  EventLoop& operator=(const EventLoop&) = delete;
+
+  bool init();
+
+  void run();
+
+  void stop();
+
+  bool in_loop_thread() const {
+    return loop_thread_id_ == std::this_thread::get_id();
+  }
+
+  // 把任务放到循环的线程中执行，在当前这一批事件处理完之后执行
+  void post(Task task);
+
+  // events为EPOLLIN、EPOLLOUT等的组合，返回注册的id，失败时返回0
+  uint64_t add_fd(int fd, uint32_t events, Handler handler);
+
+  // 只修改关注的事件，id为add_fd的返回值，可以在其他线程中调用
+  bool modify_fd(int fd, uint64_t id, uint32_t events);
+
+  void remove_fd(int fd);
+
+  // 创建一个注册好的timerfd，返回-1表示失败
+  int create_timer(Task task);
+
+  // 相对当前时间delay_us后触发，interval_us不为0时之后周期触发
+  bool arm_timer(int timerfd, uint64_t delay_us, uint64_t interval_us = 0);
+
+  // 在CLOCK_MONOTONIC的deadline_us时刻触发一次，可以在其他线程中调用
+  bool arm_timer_at(int timerfd, uint64_t deadline_us);
+
+  void cancel_timer(int timerfd) { arm_timer(timerfd, 0); }
+
+  void destroy_timer(int timerfd);
+
+ private:
+  struct Entry {
+    uint64_t id;
+    std::shared_ptr<Handler> handler;
+  };
+
+  void run_posted_tasks();
+
+ private:
+  int epfd_ = -1;
+  int wakeup_fd_ = -1;
+  std::atomic<bool> running_{false};
+  std::thread::id loop_thread_id_;
+
+  uint32_t next_seq_ = 0;
+  std::unordered_map<int, Entry> entries_;
+
+  std::mutex task_mutex_;
+  std::vector<Task> tasks_;
+};
+
+}  // namespace ft::bss
+
+#endif  // OCG_BSS_BROKER_EVENT_LOOP_H_
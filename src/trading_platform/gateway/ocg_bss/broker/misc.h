@@ -29,6 +29,13 @@ inline uint64_t now_ms() {
       .count();
 }
 
+inline uint64_t now_us() {
+  return std::chrono::time_point_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now())
+      .time_since_epoch()
+      .count();
+}
+
 }  // namespace ft::bss
 
 #endif  // OCG_BSS_BROKER_MISC_H_
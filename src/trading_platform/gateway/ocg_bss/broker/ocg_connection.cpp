@@ -3,52 +3,42 @@
 #include "broker/ocg_connection.h"
 
 #include <arpa/inet.h>
-#include <fcntl.h>
 #include <netinet/in.h>
-#include <sys/poll.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
 #include <sys/socket.h>
-#include <sys/timerfd.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
-#include <functional>
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <ctime>
 
 #include "broker/connection_manager.h"
 
 namespace ft::bss {
 
-static void set_nonblock(int fd) {
-  int flags = 0;
-  flags = fcntl(fd, F_GETFL);
-  flags |= O_NONBLOCK;
-  fcntl(fd, F_SETFL, flags);
-}
-
-static void set_block(int fd) {
-  int flags = 0;
-  flags = fcntl(fd, F_GETFL);
-  flags &= ~O_NONBLOCK;
-  fcntl(fd, F_SETFL, flags);
-}
-
-OcgConnection::OcgConnection(ConnectionManager* conn_mgr, Session* session,
-                             const std::string& ip, uint16_t port)
-    : conn_mgr_(conn_mgr), session_(session), ip_(ip), port_(port) {
+OcgConnection::OcgConnection(EventLoop* loop, ConnectionManager* conn_mgr,
+                             Session* session, const std::string& ip,
+                             uint16_t port)
+    : loop_(loop),
+      conn_mgr_(conn_mgr),
+      session_(session),
+      ip_(ip),
+      port_(port) {
   decoder_.set_handler(session_);
+  session_->set_recv_buffer(decoder_.buffer());
 }
 
 OcgConnection::~OcgConnection() {
-  if (recv_thread_ && recv_thread_->joinable()) {
-    recv_thread_->join();
-  }
-
-  if (sockfd_ >= 0) close(sockfd_);
-  if (timerfd_ >= 0) close(timerfd_);
-
+  session_->set_recv_buffer(nullptr);
+  close_fds();
   printf("disconnect\n");
 }
 
 bool OcgConnection::connect() {
-  sockfd_ = socket(AF_INET, SOCK_STREAM, 0);
+  sockfd_ = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
   if (sockfd_ < 0) {
     printf("[OcgConnection::connect] failed to creat socket\n");
     return false;
@@ -62,140 +52,214 @@ bool OcgConnection::connect() {
   addrin.sin_family = AF_INET;
   addrin.sin_port = htons(static_cast<int16_t>(port_));
 
-  // 下面是进行了一次异步的连接，如果60秒未连接成功，则主动断开连接
-  set_nonblock(sockfd_);
-  if (::connect(sockfd_, (sockaddr*)(&addrin), sizeof(addrin)) != 0) {
-    if (errno == EINPROGRESS || errno == EAGAIN) {
-      pollfd pfd{};
-      pfd.fd = sockfd_;
-      pfd.events = POLLOUT;
-      int timeout = 60 * 1000;
-      uint64_t start_ms = now_ms();
-    restart:
-      int res = poll(&pfd, 1, 60 * 1000);
-      if (res == 0) {
-        printf("[OcgConnection::connect] timeout\n");
-        return false;
-      } else if (res < 0) {
-        if (res == EINTR) {
-          uint64_t now = now_ms();
-          timeout = 60 * 1000 - static_cast<int>(now - start_ms);
-          if (timeout > 0) goto restart;
-          printf("[OcgConnection::connect] timeout\n");
-          return false;
-        }
-        printf("[OcgConnection::connect] unknown error\n");
-        return false;
-      } else {
-        if (pfd.revents & (POLLERR | POLLHUP)) {
-          printf("[OcgConnection::connect] failed to connect\n");
-          return false;
-        }
-      }
-    } else {  // 连接直接失败了
-      printf("[OcgConnection::connect] failed to connect\n");
-      return false;
-    }
+  if (::connect(sockfd_, (sockaddr*)(&addrin), sizeof(addrin)) != 0 &&
+      errno != EINPROGRESS) {
+    printf("[OcgConnection::connect] failed to connect\n");
+    return false;
   }
 
-  set_block(sockfd_);
-  recv_thread_ = std::make_unique<std::thread>(
-      std::mem_fn(&OcgConnection::recv_and_parse_data), this);
+  // 可写时表示连接有了结果，如果60秒未连接成功，则主动断开连接
+  auto on_event = [this](uint32_t events) { on_socket_event(events); };
+  sock_id_ = loop_->add_fd(sockfd_, EPOLLOUT, on_event);
+  timerfd_ = loop_->create_timer([this] { on_timer(); });
+  if (sock_id_ == 0 || timerfd_ < 0) return false;
+  loop_->arm_timer(timerfd_, 60 * 1000000UL);
   return true;
 }
 
-bool OcgConnection::send(const void* buf, std::size_t size) {
-  // just for test
-  std::size_t total_send = 0;
-  auto p = reinterpret_cast<const char*>(buf);
-
-restart:
-  while (total_send < size) {
-    auto res = ::send(sockfd_, p + total_send, size - total_send, 0);
-    if (res == 0) {
-      session_->disconnect(DisconnectReason::SOCKET_ERROR, true);
-      return false;
-    } else if (res < 0) {
-      if (errno == EINTR) goto restart;
-      session_->disconnect(DisconnectReason::SOCKET_ERROR, true);
-      return false;
-    } else {
-      total_send += res;
-    }
+void OcgConnection::on_socket_event(uint32_t events) {
+  if (closed_) return;
+
+  if (!connected_) {
+    on_connect_result();
+    return;
   }
 
-  return true;
+  if ((events & (EPOLLIN | EPOLLERR | EPOLLHUP)) && !on_readable()) return;
+  if (events & EPOLLOUT) on_writable();
 }
 
-void OcgConnection::disconnect(DisconnectReason reason) {
-  if (timerfd_ >= 0) {
-    close(timerfd_);
-    timerfd_ = -1;
+void OcgConnection::on_connect_result() {
+  int err = 0;
+  socklen_t len = sizeof(err);
+  if (getsockopt(sockfd_, SOL_SOCKET, SO_ERROR, &err, &len) != 0 || err != 0) {
+    fail_connect("failed to connect");
+    return;
   }
 
-  if (sockfd_ >= 0) {
-    close(sockfd_);
-    sockfd_ = -1;
-    conn_mgr_->on_disconnect(reason);
-  }
+  on_connected();
 }
 
-void OcgConnection::recv_and_parse_data() {
-  session_->set_socket_sender(this);
+void OcgConnection::on_connected() {
+  connected_ = true;
+
+  // 单条消息不等待合并，批量发送由Session在用户态合并或者用cork合并
+  int nodelay = 1;
+  setsockopt(sockfd_, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+  loop_->modify_fd(sockfd_, sock_id_, EPOLLIN);
 
-  timerfd_ = timerfd_create(CLOCK_MONOTONIC, 0);
-  if (timerfd_ < 0) {
-    session_->disconnect(DisconnectReason::SOCKET_ERROR, false);
+  send_timerfd_ = loop_->create_timer([this] { session_->on_send_timer(); });
+  if (send_timerfd_ < 0) {
+    fail_connect("failed to create timer");
     return;
   }
-  itimerspec ts{};
-  ts.it_interval.tv_sec = 1;  // 一秒的定时器
 
+  // 一秒的定时器，第一次触发的时间设置成下一个一秒的开始
   timespec tv;
   clock_gettime(CLOCK_REALTIME, &tv);
-  // 第一次触发的时间设置成下一个一秒的开始
-  ts.it_value.tv_nsec = 1000000000 - tv.tv_nsec;
-  timerfd_settime(timerfd_, 0, &ts, nullptr);
-
-  pollfd pfd[2]{};
-  pfd[0].fd = sockfd_;
-  pfd[0].events = POLLIN;
-  pfd[1].fd = timerfd_;
-  pfd[1].events = POLLIN;
-
-  for (;;) {
-    int nfds = poll(pfd, 2, -1);
-    if (nfds == 0) {
-      continue;
-    } else if (nfds < 0) {
+  loop_->arm_timer(timerfd_, (1000000000 - tv.tv_nsec) / 1000 + 1, 1000000);
+
+  session_->set_socket_sender(this);
+}
+
+void OcgConnection::fail_connect(const char* reason) {
+  printf("[OcgConnection::connect] %s\n", reason);
+  closed_ = true;
+  close_fds();
+  conn_mgr_->on_connect_failed();
+}
+
+void OcgConnection::on_timer() {
+  if (!connected_) {
+    fail_connect("timeout");
+    return;
+  }
+
+  // periodically_check返回false时已经断开了连接
+  if (!closed_) session_->periodically_check();
+}
+
+bool OcgConnection::on_readable() {
+  // 缓存的消息一直等不到缺失的消息时，保留的区间会逐渐占满接收缓冲区
+  if (decoder_.writable_size() == 0) session_->drop_cached_msgs();
+
+  auto res =
+      recv(sockfd_, decoder_.writable_start(), decoder_.writable_size(), 0);
+  if (res > 0) {
+    decoder_.parse_raw_data(res);
+    return true;
+  }
+
+  if (res < 0 && (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK))
+    return true;
+
+  session_->disconnect(DisconnectReason::SOCKET_ERROR, false);
+  return false;
+}
+
+void OcgConnection::on_writable() {
+  std::unique_lock<std::mutex> lock(out_mutex_);
+  while (!closed_ && out_offset_ < out_buf_.size()) {
+    auto res = ::send(sockfd_, out_buf_.data() + out_offset_,
+                      out_buf_.size() - out_offset_, MSG_NOSIGNAL);
+    if (res < 0) {
       if (errno == EINTR) continue;
+      if (errno == EAGAIN || errno == EWOULDBLOCK) return;
+      // 不能在持有out_mutex_时去拿Session的锁
+      lock.unlock();
       session_->disconnect(DisconnectReason::SOCKET_ERROR, false);
       return;
     }
+    out_offset_ += res;
+  }
+
+  out_buf_.clear();
+  out_offset_ = 0;
+  if (!closed_) loop_->modify_fd(sockfd_, sock_id_, EPOLLIN);
+}
+
+bool OcgConnection::send(const void* buf, std::size_t size) {
+  iovec iov{const_cast<void*>(buf), size};
+  return sendv(&iov, 1);
+}
 
-    if (pfd[0].revents != 0) {
-      auto res =
-          recv(sockfd_, decoder_.writable_start(), decoder_.writable_size(), 0);
-      if (res == 0) {
-        session_->disconnect(DisconnectReason::SOCKET_ERROR, false);
-        return;
-      } else if (res < 0) {
-        if (errno == EINTR) continue;
-        session_->disconnect(DisconnectReason::SOCKET_ERROR, false);
-        return;
-      } else {
-        decoder_.parse_raw_data(res);
-      }
+bool OcgConnection::sendv(struct iovec* iov, int iovcnt) {
+  std::unique_lock<std::mutex> lock(out_mutex_);
+  if (closed_) return false;
+
+  // 发送缓冲区中还有数据时直接追加，保证顺序
+  while (out_buf_.empty() && iovcnt > 0) {
+    msghdr msg{};
+    msg.msg_iov = iov;
+    msg.msg_iovlen = std::min(iovcnt, IOV_MAX);
+    auto res = ::sendmsg(sockfd_, &msg, MSG_NOSIGNAL);
+    if (res < 0) {
+      if (errno == EINTR) continue;
+      if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+      lock.unlock();
+      session_->disconnect(DisconnectReason::SOCKET_ERROR, true);
+      return false;
     }
 
-    if (pfd[1].revents != 0) {
-      uint64_t tmp;
-      read(pfd[1].fd, &tmp, 8);
-      if (!session_->periodically_check()) {
-        return;
-      }
+    // 跳过已经完整发出的部分，剩下的从断开的位置继续发
+    auto sent = static_cast<std::size_t>(res);
+    while (iovcnt > 0 && sent >= iov->iov_len) {
+      sent -= iov->iov_len;
+      ++iov;
+      --iovcnt;
+    }
+    if (iovcnt > 0) {
+      iov->iov_base = static_cast<char*>(iov->iov_base) + sent;
+      iov->iov_len -= sent;
     }
   }
+
+  if (iovcnt == 0) return true;
+
+  bool was_empty = out_buf_.empty();
+  for (int i = 0; i < iovcnt; ++i) {
+    auto p = static_cast<const char*>(iov[i].iov_base);
+    out_buf_.insert(out_buf_.end(), p, p + iov[i].iov_len);
+  }
+
+  // 对方长时间不收数据，视为连接出了问题
+  if (out_buf_.size() - out_offset_ > SEND_OUTPUT_MAX_BYTES) {
+    printf("[OcgConnection::sendv] output buffer overflow\n");
+    lock.unlock();
+    session_->disconnect(DisconnectReason::SOCKET_ERROR, true);
+    return false;
+  }
+
+  if (was_empty) loop_->modify_fd(sockfd_, sock_id_, EPOLLIN | EPOLLOUT);
+  return true;
+}
+
+void OcgConnection::set_cork(bool cork) {
+  int value = cork ? 1 : 0;
+  setsockopt(sockfd_, IPPROTO_TCP, TCP_CORK, &value, sizeof(value));
+}
+
+void OcgConnection::arm_send_timer(uint64_t deadline_us) {
+  loop_->arm_timer_at(send_timerfd_, deadline_us);
+}
+
+/*
+ * 由Session在持有锁时调用，可能在任意线程中，fd的移除及关闭放到事件循环
+ * 中进行。之后的发送直接返回失败
+ */
+void OcgConnection::disconnect(DisconnectReason reason) {
+  {
+    std::unique_lock<std::mutex> lock(out_mutex_);
+    if (closed_) return;
+    closed_ = true;
+  }
+
+  loop_->post([this, reason] {
+    close_fds();
+    conn_mgr_->on_disconnect(reason);
+  });
+}
+
+void OcgConnection::close_fds() {
+  loop_->destroy_timer(timerfd_);
+  loop_->destroy_timer(send_timerfd_);
+  timerfd_ = send_timerfd_ = -1;
+
+  if (sockfd_ >= 0) {
+    loop_->remove_fd(sockfd_);
+    close(sockfd_);
+    sockfd_ = -1;
+  }
 }
 
 }  // namespace ft::bss
@@ -3,11 +3,12 @@
 #ifndef BSS_BROKER_OCG_CONNECTION_H_
 #define BSS_BROKER_OCG_CONNECTION_H_
 
-#include <memory>
+#include <atomic>
 #include <mutex>
 #include <string>
-#include <thread>
+#include <vector>
 
+#include "broker/event_loop.h"
 #include "broker/session.h"
 #include "broker/socket_sender.h"
 #include "protocol/protocol_parser.h"
@@ -16,30 +17,73 @@ namespace ft::bss {
 
 class ConnectionManager;
 
+/*
+ * 与OCG的一条TCP连接，socket为非阻塞的，收数据及定时器都由EventLoop驱动
+ *
+ * 发送可以在任意线程中进行(由Session加锁保证顺序)，写不完的部分放到发送
+ * 缓冲区中，等socket可写时由事件循环发出，发送缓冲区不为空时新的数据都
+ * 追加到缓冲区后面
+ */
 class OcgConnection : public SocketSender {
  public:
-  OcgConnection(ConnectionManager* conn_mgr, Session* session,
+  OcgConnection(EventLoop* loop, ConnectionManager* conn_mgr, Session* session,
                 const std::string& ip, uint16_t port);
 
   ~OcgConnection();
 
+  /*
+   * 发起非阻塞的连接，返回false表示连接直接失败了
+   *
+   * 之后连接失败或者超时通过ConnectionManager::on_connect_failed通知，
+   * 连接成功后注册到Session中，由Session在定时器中发起登录
+   */
   bool connect();
 
   bool send(const void* buf, std::size_t size) override;
 
+  bool sendv(struct iovec* iov, int iovcnt) override;
+
+  void set_cork(bool cork) override;
+
+  void arm_send_timer(uint64_t deadline_us) override;
+
   void disconnect(DisconnectReason reason) override;
 
  private:
-  void recv_and_parse_data();
+  void on_socket_event(uint32_t events);
+
+  void on_connect_result();
+
+  void on_connected();
+
+  void on_timer();
+
+  bool on_readable();
+
+  void on_writable();
+
+  void fail_connect(const char* reason);
+
+  // 只能在事件循环的线程中调用
+  void close_fds();
 
  private:
+  EventLoop* loop_;
   ConnectionManager* conn_mgr_;
   Session* session_;
   BinaryMessageDecoder decoder_;
-  std::unique_ptr<std::thread> recv_thread_;
 
   int sockfd_ = -1;
-  int timerfd_ = -1;
+  uint64_t sock_id_ = 0;
+  int timerfd_ = -1;       // 连接超时，连接后改为1秒的周期检查
+  int send_timerfd_ = -1;  // 流控排队的消息在下一个令牌可用时发出
+  bool connected_ = false;
+  std::atomic<bool> closed_{false};
+
+  std::mutex out_mutex_;
+  std::vector<char> out_buf_;
+  std::size_t out_offset_ = 0;
+
   std::string ip_;
   uint16_t port_;
 };
@@ -0,0 +1,61 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#include "broker/recv_msg_cache.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace ft::bss {
+
+RecvMsgCache::RecvMsgCache(std::size_t max_bytes) : max_bytes_(max_bytes) {}
+
+void RecvMsgCache::attach(MirroredBuffer* buffer) {
+  clear();
+  buffer_ = buffer;
+}
+
+bool RecvMsgCache::put(const MessageHeader& header) {
+  if (!buffer_ || index_.count(header.sequence_number) > 0) return false;
+  assert(reinterpret_cast<const char*>(&header) == buffer_->readable_start());
+
+  uint64_t pos = buffer_->read_pos();
+  uint64_t head = frames_.empty() ? pos : frames_.front().pos;
+  if (pos + header.length - head > max_bytes_) return false;
+
+  if (frames_.empty()) buffer_->retain(pos);
+  frames_.push_back({pos, false});
+  index_.emplace(header.sequence_number, pos);
+  return true;
+}
+
+MessageHeader* RecvMsgCache::get(uint32_t seq) {
+  auto iter = index_.find(seq);
+  if (iter == index_.end()) return nullptr;
+  return reinterpret_cast<MessageHeader*>(buffer_->at(iter->second));
+}
+
+void RecvMsgCache::erase(uint32_t seq) {
+  auto iter = index_.find(seq);
+  if (iter == index_.end()) return;
+
+  auto frame = std::lower_bound(
+      frames_.begin(), frames_.end(), iter->second,
+      [](const Frame& frame, uint64_t pos) { return frame.pos < pos; });
+  frame->erased = true;
+  index_.erase(iter);
+
+  // 最前面的消息都取走后，接收缓冲区才能回收它们占用的空间
+  while (!frames_.empty() && frames_.front().erased) frames_.pop_front();
+  if (frames_.empty())
+    buffer_->release();
+  else
+    buffer_->retain(frames_.front().pos);
+}
+
+void RecvMsgCache::clear() {
+  frames_.clear();
+  index_.clear();
+  if (buffer_) buffer_->release();
+}
+
+}  // namespace ft::bss
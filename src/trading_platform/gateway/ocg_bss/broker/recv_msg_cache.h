@@ -0,0 +1,59 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef OCG_BSS_BROKER_RECV_MSG_CACHE_H_
+#define OCG_BSS_BROKER_RECV_MSG_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+
+#include "protocol/mirrored_buffer.h"
+#include "protocol/protocol.h"
+
+namespace ft::bss {
+
+/*
+ * 提前到达的消息的缓存，不复制也不解码，消息原地留在接收缓冲区中
+ *
+ * 缓存了消息之后，接收缓冲区从最早一条缓存的消息开始保留(retain)，之后的
+ * 数据在该消息被取走前不会被覆盖，消息被取走后再逐步释放。保留的区间
+ * 超过max_bytes时不再缓存新的消息，缺失的消息由OCG重传
+ *
+ * 接收缓冲区属于当前的连接，连接建立时attach，断开前clear
+ */
+class RecvMsgCache {
+ public:
+  explicit RecvMsgCache(std::size_t max_bytes);
+
+  // buffer为nullptr表示连接已经释放，之后put都返回false
+  void attach(MirroredBuffer* buffer);
+
+  // header必须是接收缓冲区中正在处理的消息，即位于readable_start()处。
+  // 序列号已存在、没有接收缓冲区或保留的区间超过上限时返回false
+  bool put(const MessageHeader& header);
+
+  // 返回的消息在erase或clear之前有效，没有时返回nullptr
+  MessageHeader* get(uint32_t seq);
+
+  void erase(uint32_t seq);
+
+  void clear();
+
+  bool empty() const { return index_.empty(); }
+
+ private:
+  struct Frame {
+    uint64_t pos;
+    bool erased;
+  };
+
+  MirroredBuffer* buffer_ = nullptr;
+  std::size_t max_bytes_;
+  std::deque<Frame> frames_;  // 按位置排列
+  std::unordered_map<uint32_t, uint64_t> index_;  // seq -> pos
+};
+
+}  // namespace ft::bss
+
+#endif  // OCG_BSS_BROKER_RECV_MSG_CACHE_H_
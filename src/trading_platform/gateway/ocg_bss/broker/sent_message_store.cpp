@@ -0,0 +1,192 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#include "broker/sent_message_store.h"
+
+#include <fcntl.h>
+#include <spdlog/spdlog.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+namespace ft::bss {
+
+namespace {
+
+inline constexpr char kStoreMagic[8] = {'O', 'C', 'G', 'S',
+                                        'E', 'N', 'T', '\0'};
+inline constexpr uint32_t kStoreVersion = 1;
+inline constexpr std::size_t kLogAlignment = 8;
+inline constexpr std::size_t kInitialLogSize = 4UL << 20;
+inline constexpr std::size_t kInitialIndexSize =
+    sizeof(SentMessageStoreHeader) + (64UL << 10) * sizeof(uint64_t);
+
+std::size_t align_up(std::size_t size) {
+  return (size + kLogAlignment - 1) & ~(kLogAlignment - 1);
+}
+
+// 文件比size小时扩大到size，否则size更新为文件的大小
+char* map_file(int fd, std::size_t* size) {
+  struct stat st;
+  if (fstat(fd, &st) != 0) return nullptr;
+  if (static_cast<std::size_t>(st.st_size) < *size) {
+    if (ftruncate(fd, *size) != 0) return nullptr;
+  } else {
+    *size = st.st_size;
+  }
+
+  void* addr = mmap(nullptr, *size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  return addr == MAP_FAILED ? nullptr : static_cast<char*>(addr);
+}
+
+char* grow_file(int fd, char* addr, std::size_t old_size,
+                std::size_t new_size) {
+  if (ftruncate(fd, new_size) != 0) return nullptr;
+  void* new_addr = mremap(addr, old_size, new_size, MREMAP_MAYMOVE);
+  return new_addr == MAP_FAILED ? nullptr : static_cast<char*>(new_addr);
+}
+
+}  // namespace
+
+bool SentMessageStore::open(const std::string& path) {
+  close();
+
+  log_fd_ = ::open((path + ".log").c_str(), O_RDWR | O_CREAT, 0644);
+  index_fd_ = ::open((path + ".idx").c_str(), O_RDWR | O_CREAT, 0644);
+  if (log_fd_ < 0 || index_fd_ < 0) {
+    spdlog::error("[SentMessageStore::open] failed to open {}: {}", path,
+                  strerror(errno));
+    close();
+    return false;
+  }
+
+  log_capacity_ = kInitialLogSize;
+  index_capacity_ = kInitialIndexSize;
+  log_ = map_file(log_fd_, &log_capacity_);
+  index_ = map_file(index_fd_, &index_capacity_);
+  if (!log_ || !index_) {
+    spdlog::error("[SentMessageStore::open] failed to map {}: {}", path,
+                  strerror(errno));
+    close();
+    return false;
+  }
+
+  header_ = reinterpret_cast<SentMessageStoreHeader*>(index_);
+  if (header_->version == 0) {
+    memcpy(header_->magic, kStoreMagic, sizeof(kStoreMagic));
+    header_->version = kStoreVersion;
+    header_->max_seq = 0;
+    header_->log_size = kLogAlignment;
+  } else if (memcmp(header_->magic, kStoreMagic, sizeof(kStoreMagic)) != 0 ||
+             header_->version != kStoreVersion ||
+             header_->log_size > log_capacity_ ||
+             sizeof(SentMessageStoreHeader) +
+                     (header_->max_seq + 1UL) * sizeof(uint64_t) >
+                 index_capacity_) {
+    spdlog::error("[SentMessageStore::open] {} is corrupted", path);
+    close();
+    return false;
+  }
+
+  // 上次退出时写了索引但没来得及更新log_size的消息视为没有写入，这些
+  // 索引指向的位置之后会被新消息覆盖，必须清掉
+  uint32_t max_seq = 0;
+  for (uint32_t seq = 1; seq <= header_->max_seq; ++seq) {
+    if (offsets()[seq] >= header_->log_size) {
+      offsets()[seq] = 0;
+    } else if (offsets()[seq] != 0) {
+      max_seq = seq;
+    }
+  }
+  header_->max_seq = max_seq;
+
+  spdlog::info("[SentMessageStore::open] {}: max_seq:{} log_size:{}", path,
+               header_->max_seq, header_->log_size);
+  return true;
+}
+
+void SentMessageStore::close() {
+  if (log_) munmap(log_, log_capacity_);
+  if (index_) munmap(index_, index_capacity_);
+  if (log_fd_ >= 0) ::close(log_fd_);
+  if (index_fd_ >= 0) ::close(index_fd_);
+
+  log_ = index_ = nullptr;
+  log_fd_ = index_fd_ = -1;
+  log_capacity_ = index_capacity_ = 0;
+  header_ = nullptr;
+}
+
+bool SentMessageStore::append(uint32_t seq, const char* data, uint32_t size) {
+  if (!header_ || seq == 0) return false;
+  if (get(seq)) return true;
+
+  uint64_t offset = header_->log_size;
+  std::size_t end = offset + align_up(size);
+  if (!reserve_index(seq) || !reserve_log(end)) return false;
+
+  memcpy(log_ + offset, data, size);
+  offsets()[seq] = offset;
+  header_->max_seq = std::max(header_->max_seq, seq);
+
+  // 消息及索引都写完后才更新log_size，之前退出的话这条消息视为没有写入
+  std::atomic_thread_fence(std::memory_order_release);
+  header_->log_size = end;
+  return true;
+}
+
+MessageHeader* SentMessageStore::get(uint32_t seq) {
+  if (!header_ || seq == 0 || seq > header_->max_seq) return nullptr;
+
+  uint64_t offset = offsets()[seq];
+  if (offset == 0 || offset >= header_->log_size) return nullptr;
+  return reinterpret_cast<MessageHeader*>(log_ + offset);
+}
+
+void SentMessageStore::clear() {
+  if (!header_) return;
+
+  // 先缩小log_size使所有的索引失效
+  header_->log_size = kLogAlignment;
+  std::atomic_thread_fence(std::memory_order_release);
+  memset(offsets(), 0, (header_->max_seq + 1UL) * sizeof(uint64_t));
+  header_->max_seq = 0;
+}
+
+bool SentMessageStore::reserve_log(std::size_t size) {
+  if (size <= log_capacity_) return true;
+
+  std::size_t new_capacity = std::max(log_capacity_ * 2, size);
+  auto addr = grow_file(log_fd_, log_, log_capacity_, new_capacity);
+  if (!addr) {
+    spdlog::error("[SentMessageStore::reserve_log] {}", strerror(errno));
+    return false;
+  }
+
+  log_ = addr;
+  log_capacity_ = new_capacity;
+  return true;
+}
+
+bool SentMessageStore::reserve_index(uint32_t seq) {
+  std::size_t size =
+      sizeof(SentMessageStoreHeader) + (seq + 1UL) * sizeof(uint64_t);
+  if (size <= index_capacity_) return true;
+
+  std::size_t new_capacity = std::max(index_capacity_ * 2, size);
+  auto addr = grow_file(index_fd_, index_, index_capacity_, new_capacity);
+  if (!addr) {
+    spdlog::error("[SentMessageStore::reserve_index] {}", strerror(errno));
+    return false;
+  }
+
+  index_ = addr;
+  index_capacity_ = new_capacity;
+  header_ = reinterpret_cast<SentMessageStoreHeader*>(index_);
+  return true;
+}
+
+}  // namespace ft::bss
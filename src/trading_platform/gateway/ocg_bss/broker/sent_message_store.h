@@ -0,0 +1,89 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef OCG_BSS_BROKER_SENT_MESSAGE_STORE_H_
+#define OCG_BSS_BROKER_SENT_MESSAGE_STORE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "protocol/protocol.h"
+
+namespace ft::bss {
+
+/*
+ * 已发送消息的持久化存储，用于响应OCG的重传请求
+ *
+ * 由两个mmap的文件组成：
+ *   <path>.log: 按发送顺序追加的消息，保存编码后的原始字节(含校验和)，
+ *               每条消息按8字节对齐，偏移0不使用
+ *   <path>.idx: SentMessageStoreHeader | uint64_t offsets[]，offsets[seq]为
+ *               序列号为seq的消息在.log中的偏移，0表示没有记录
+ * 文件不够用时按倍数扩大。先写消息再写索引，最后更新log_size，进程在任意
+ * 位置退出后重新打开都能得到一致的内容，偏移不小于log_size的索引在打开时清除。
+ * 没有msync，只保证进程退出后数据完整，不考虑机器掉电
+ *
+ * 重传时直接发送保存的字节，只需修改PossDupFlag并更新校验和
+ */
+struct SentMessageStoreHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t max_seq;   // 已保存的最大序列号
+  uint64_t log_size;  // .log中已使用的字节数
+};
+
+class SentMessageStore {
+ public:
+  SentMessageStore() = default;
+
+  ~SentMessageStore() { close(); }
+
+  SentMessageStore(const SentMessageStore&) = delete;
+  SentMessageStore& operator=(const SentMessageStore&) = delete;
+
+  // 文件已存在时加载其中的消息
+  bool open(const std::string& path);
+
+  void close();
+
+  /*
+   * 同一个序列号只保存第一次发送的消息，重传时再次发出的消息不会覆盖
+   *
+   * size应与消息头中的length一致
+   */
+  bool append(uint32_t seq, const char* data, uint32_t size);
+
+  /*
+   * 没有记录时返回nullptr，消息长度为header->length
+   *
+   * 返回的指针在下一次append或clear之前有效
+   */
+  MessageHeader* get(uint32_t seq);
+
+  // 重置会话时清空所有消息
+  void clear();
+
+  uint32_t max_seq() const { return header_ ? header_->max_seq : 0; }
+
+ private:
+  bool reserve_log(std::size_t size);
+
+  bool reserve_index(uint32_t seq);
+
+  uint64_t* offsets() {
+    return reinterpret_cast<uint64_t*>(index_ + sizeof(SentMessageStoreHeader));
+  }
+
+ private:
+  int log_fd_ = -1;
+  int index_fd_ = -1;
+  char* log_ = nullptr;
+  char* index_ = nullptr;
+  std::size_t log_capacity_ = 0;
+  std::size_t index_capacity_ = 0;
+  SentMessageStoreHeader* header_ = nullptr;
+};
+
+}  // namespace ft::bss
+
+#endif  // OCG_BSS_BROKER_SENT_MESSAGE_STORE_H_
@@ -7,10 +7,11 @@
 #include <cstdio>
 #include <cstring>
 
+#include "protocol/protocol_parser.h"
+
 namespace ft::bss {
 
 Session::Session(BssBroker* broker) : broker_(broker) {
-  resend_visitor_.init(this);
   consumer_visitor_.init(this);
 }
 
@@ -20,8 +21,15 @@ bool Session::init(const SessionConfig& conf) {
   comp_id_ = conf.comp_id;
   encoder_.set_comp_id(comp_id_);
   set_password(conf.password, conf.new_password);
-  msg_limit_per_sec_ = conf.msg_limit_per_sec;
+  throttle_.init(conf.msg_limit_per_sec, conf.msg_burst, now_us());
+
+  if (!sent_msgs_.open(conf.sent_msg_store) ||
+      !state_.load(conf.state_file, conf.trading_date))
+    return false;
 
+  // 重传过程中退出时文件中的待发序列号可能还没恢复，以已发送的消息为准
+  if (sent_msgs_.max_seq() >= state_.next_send_msg_seq)
+    state_.next_send_msg_seq = sent_msgs_.max_seq() + 1;
   return true;
 }
 
@@ -63,8 +71,12 @@ void Session::encrypt_password() {
  */
 void Session::reset() {
   state_.reset();
-  current_sec_send_ = 0;
-  while (!cached_snd_queue_.empty()) cached_snd_queue_.pop();
+  sent_msgs_.clear();
+  throttle_.reset(now_us());
+  pending_frames_.clear();
+  urgent_msgs_.clear();
+  normal_msgs_.clear();
+  batch_size_ = 0;
 }
 
 /*
@@ -111,7 +123,8 @@ void Session::on_logon_msg(MessageHeader* header, LogonMessage* msg) {
          header->sequence_number, state_.resend_range.first,
          state_.resend_range.second);
 
-  broker_->on_msg(*msg);
+  send_pending_msgs();
+  broker_->on_msg(this, *msg);
 }
 
 void Session::on_logout_msg(MessageHeader* header, LogoutMessage* msg) {
@@ -123,7 +136,7 @@ void Session::on_logout_msg(MessageHeader* header, LogoutMessage* msg) {
   if (header->sequence_number == state_.next_recv_msg_seq)
     ++state_.next_recv_msg_seq;
 
-  broker_->on_msg(*msg);
+  broker_->on_msg(this, *msg);
 
   if (msg->session_status == SESSION_STATUS_OTHER && msg->logout_text.len > 0) {
     if (header->sequence_number < state_.next_recv_msg_seq) {
@@ -135,7 +148,7 @@ void Session::on_logout_msg(MessageHeader* header, LogoutMessage* msg) {
         state_.next_recv_msg_seq =
             std::stoul(msg->logout_text.data + reason.length());
         printf("NextExpectedSeqNum fixed. Now is %u\n",
-               state_.next_recv_msg_seq);
+               state_.next_recv_msg_seq.get());
         internal_disconnect(DisconnectReason::LOGOUT);
         return;
       }
@@ -148,7 +161,8 @@ void Session::on_logout_msg(MessageHeader* header, LogoutMessage* msg) {
       if (pos != std::string_view::npos) {
         state_.next_send_msg_seq =
             std::stoul(msg->logout_text.data + reason.length());
-        printf("NextSndSeqNum fixed. Now is %u\n", state_.next_send_msg_seq);
+        printf("NextSndSeqNum fixed. Now is %u\n",
+               state_.next_send_msg_seq.get());
         internal_disconnect(DisconnectReason::LOGOUT);
         return;
       }
@@ -199,7 +213,8 @@ void Session::on_business_reject_msg(MessageHeader* header,
   if (!is_msg_queue_empty()) consume_cached_msgs();
 }
 
-void Session::on_execution_report(MessageHeader* header, ExecutionReport* msg) {
+void Session::on_execution_report(MessageHeader* header,
+                                  ExecutionReportView* msg) {
   process_msg(header, msg);
   if (!is_msg_queue_empty()) consume_cached_msgs();
 }
@@ -272,6 +287,35 @@ void Session::process_msg(MessageHeader* header, SequenceResetMessage* msg) {
   }
 }
 
+/*
+ * 非预期序列号处理函数
+ *
+ * 收到从OCG发来的序列号大于预期的消息
+ */
+bool Session::handle_msg_seq_too_high(const MessageHeader& header) {
+  // todo: To be or not to be, that is the question
+  printf("handle_msg_seq_too_high: seq:%u type:%u expected:%u\n",
+         header.sequence_number, header.message_type,
+         state_.next_recv_msg_seq.get());
+
+  // 提前到的消息原地留在接收缓冲区中，消费时再解码
+  state_.cache_early_arriving_msg(header);
+
+  // 如果正在重传状态
+  if (state_.is_recovering()) {
+    // 如果消息在重传范围外，打印警告信息，因为不允许在重传状态下再次发起重传
+    if (header.sequence_number < state_.resend_range.first &&
+        header.sequence_number > state_.resend_range.second)
+      printf("warn. handle_msg_seq_too_high. msg outside the resend range\n");
+
+    return true;
+  }
+
+  // 发起重传请求
+  send_resend_request(state_.next_recv_msg_seq, header.sequence_number - 1);
+  return true;
+}
+
 // "return false" means a fatal error, and outer function should call
 // disconnect
 bool Session::handle_msg_seq_too_low(const MessageHeader& header) {
@@ -279,9 +323,9 @@ bool Session::handle_msg_seq_too_low(const MessageHeader& header) {
   // 如果是登录消息或是其他类型的未设置pos_dup_flag的消息，应该给予对方提示
   if (header.message_type == LOGON || header.poss_dup_flag == 0) {
     printf("failed. msg seq num is too low, received:%u expected:%u\n",
-           header.sequence_number, state_.next_recv_msg_seq);
+           header.sequence_number, state_.next_recv_msg_seq.get());
     std::string logout_reason = kReasonLocalSndSeqLessThanOcgExpected;
-    logout_reason += std::to_string(state_.next_recv_msg_seq);
+    logout_reason += std::to_string(state_.next_recv_msg_seq.get());
     send_logout_msg(SESSION_STATUS_OTHER, logout_reason);
     return false;
   }
@@ -308,24 +352,28 @@ bool Session::handle_msg_seq_too_low(const MessageHeader& header) {
 void Session::resend(uint32_t start_seq_num, uint32_t end_seq_num) {
   std::unique_lock<std::mutex> lock(mutex_);
 
-  // NextSendSeqNum重置为OCG的NextExpectedSeqNum，并设置PossDupFlag
+  // 重传的消息与gap fill分多次发出，cork期间由内核合并成尽量满的报文
+  flush_batch();
+  if (socket_sender_) socket_sender_->set_cork(true);
+
+  // NextSendSeqNum重置为OCG的NextExpectedSeqNum，PossDupFlag由
+  // resend_stored_msg及send_gap_fill_frame设置
   uint32_t cur_next_send_seq = state_.next_send_msg_seq;
   state_.next_send_msg_seq = start_seq_num;
-  encoder_.set_poss_dup_flag(1);
 
   if (end_seq_num == 0) end_seq_num = cur_next_send_seq - 1;
 
+  IovecBatch batch;
   uint32_t seq_reset_target = 0;
   for (uint32_t num = start_seq_num; num <= end_seq_num; ++num) {
-    auto iter = state_.sent_messages.find(num);
-    if (iter == state_.sent_messages.end()) {
+    auto header = sent_msgs_.get(num);
+    if (!header) {
       // 如果没有找到历史记录，应该是个BUG
       // 因为每次都会先把发送的数据记录下来然后才增加本地SeqNum
       BUG_ON();
     }
 
-    const auto& msg = iter->second;
-    auto type = msg.type;
+    auto type = header->message_type;
     // 如果是下列类型的消息则使用Sequence Reset Message跳过，因为重传这些会话
     // 控制类型的消息并没有意义
     if (type == LOGON || type == LOGOUT || type == HEARTBEAT ||
@@ -340,6 +388,7 @@ void Session::resend(uint32_t start_seq_num, uint32_t end_seq_num) {
     } else {
       // 如果需要seq reset，这里先把seq reset发出去
       if (seq_reset_target != 0) {
+        flush_iovec_batch(&batch);
         send_gap_fill(seq_reset_target);
         seq_reset_target = 0;
       }
@@ -348,30 +397,138 @@ void Session::resend(uint32_t start_seq_num, uint32_t end_seq_num) {
       // todo: 如果断线时间太长，是否应该使用SequenceResetMessage来跳过某些
       //       请求类型消息，比如订单请求，因为这中间市场很大可能发生了很大波
       //       动使得盈利机会消失
-      std::visit(resend_visitor_, msg.body);
+      resend_stored_msg(header, &batch);
     }
   }
 
+  flush_iovec_batch(&batch);
   if (seq_reset_target != 0) send_gap_fill(seq_reset_target);
 
-  // 至此消息全部重传完毕，NextSendSeqNum已经恢复到该函数调用前的状态
-  // 需要重置PossDupFlag
-  encoder_.set_poss_dup_flag(0);
+  // 至此消息全部重传完毕或者已进入待发队列，NextSendSeqNum恢复到该函数
+  // 调用前的状态
   state_.next_send_msg_seq = cur_next_send_seq;
+
+  if (socket_sender_) socket_sender_->set_cork(false);
+}
+
+/*
+ * 重传一条保存下来的消息，序列号及消息体与第一次发送时相同
+ *
+ * 流量限制与send_raw_msg_without_lock一致，没有令牌时只把序列号放入待发
+ * 队列，由发送定时器从保存的消息中发出
+ */
+void Session::resend_stored_msg(MessageHeader* header, IovecBatch* batch) {
+  patch_poss_dup_flag(header, 1);
+
+  if (acquire_send_token()) {
+    add_to_iovec_batch(header, batch);
+  } else {
+    // 先把前面合并好的发出去，保证顺序
+    flush_iovec_batch(batch);
+    queue_pending_frame(state_.next_send_msg_seq, 0);
+  }
+
+  state_.last_send_time_ms = now_ms();
+  ++state_.next_send_msg_seq;
+}
+
+void Session::add_to_iovec_batch(MessageHeader* header, IovecBatch* batch) {
+  batch->iov[batch->count].iov_base = header;
+  batch->iov[batch->count].iov_len = header->length;
+  if (++batch->count == IovecBatch::kMaxMsgs) flush_iovec_batch(batch);
+}
+
+void Session::flush_iovec_batch(IovecBatch* batch) {
+  // 发送过程中可能已经断线
+  if (batch->count > 0 && socket_sender_)
+    socket_sender_->sendv(batch->iov, batch->count);
+  batch->count = 0;
+}
+
+bool Session::send_gap_fill_frame(uint32_t seq, uint32_t new_seq_num) {
+  // gap_fill设置为Y表示让OCG跳过该消息，N有别的用途，BSS方只可使用Y功能
+  SequenceResetMessage seq_reset_msg{'Y', new_seq_num};
+  MsgBuffer msg_buffer;
+
+  // gap fill只在重传时发出，PossDupFlag总是Y
+  encoder_.set_next_seq_number(seq);
+  encoder_.set_poss_dup_flag(1);
+  encoder_.encode_msg(seq_reset_msg, &msg_buffer);
+  encoder_.set_poss_dup_flag(0);
+
+  state_.last_send_time_ms = now_ms();
+  if (!socket_sender_) return true;
+  return socket_sender_->send(msg_buffer.data, msg_buffer.size);
+}
+
+/*
+ * 按令牌发出待发队列中的消息
+ *
+ * 已分配序列号的消息必须先按序发完，之后才轮到业务消息，撤单类的消息
+ * 排在其他业务消息之前。业务消息到这里才分配序列号并保存下来，直接从
+ * 队列的槽中发出。令牌不够时按下一个令牌可用的时间重新设置发送定时器
+ */
+void Session::send_pending_msgs_without_lock() {
+  if (!socket_sender_) return;
+
+  // 批量发送缓冲区中消息的序列号更小，先发出去
+  flush_batch();
+
+  uint64_t now = now_us();
+  IovecBatch batch;
+  while (socket_sender_ && !pending_frames_.empty() &&
+         throttle_.try_acquire(now)) {
+    auto frame = pending_frames_.front();
+    pending_frames_.pop_front();
+    if (frame.gap_fill_target != 0) {
+      flush_iovec_batch(&batch);
+      send_gap_fill_frame(frame.seq, frame.gap_fill_target);
+    } else if (auto header = sent_msgs_.get(frame.seq)) {
+      add_to_iovec_batch(header, &batch);
+    } else {
+      printf("[Session::send_pending_msgs] msg %u not found\n", frame.seq);
+    }
+  }
+  // 保存业务消息时文件可能被重新映射，引用了已保存消息的部分要先发出去
+  flush_iovec_batch(&batch);
+
+  while (socket_sender_ && pending_frames_.empty() &&
+         state_.received_logon &&
+         (!urgent_msgs_.empty() || !normal_msgs_.empty()) &&
+         throttle_.try_acquire(now)) {
+    auto queue = urgent_msgs_.empty() ? &normal_msgs_ : &urgent_msgs_;
+    auto buffer = queue->front();
+    queue->pop();
+
+    // 出队的槽在下一次入队前都有效，入队需要持有同一把锁
+    uint32_t seq = state_.next_send_msg_seq;
+    auto header = reinterpret_cast<MessageHeader*>(buffer->data);
+    patch_sequence_number(header, seq);
+    sent_msgs_.append(seq, buffer->data, buffer->size);
+    add_to_iovec_batch(header, &batch);
+
+    state_.last_send_time_ms = now_ms();
+    ++state_.next_send_msg_seq;
+  }
+  flush_iovec_batch(&batch);
+
+  arm_send_timer();
 }
 
 /*
  * 尝试消费消息缓存里的数据
  */
 void Session::consume_cached_msgs() {
-  CachedRecvMessage msg{};
   for (;;) {
     // 从消息缓存中获取下一条待消费的消息，如果下一条消息还未达则直接返回
-    if (!state_.retrieve_msg_cache(state_.next_recv_msg_seq, &msg)) break;
-
-    // 根据不同消息类型调用不同的处理函数，std::visit中会回调相应的process_msg
-    consumer_visitor_.set_header(&msg.header);
-    std::visit(consumer_visitor_, msg.body);
+    uint32_t seq = state_.next_recv_msg_seq;
+    auto header = state_.find_cached_msg(seq);
+    if (!header) break;
+
+    // 在缓存中原地解码，visit_msg中会回调相应的process_msg。处理完之前
+    // 消息一直留在缓存中，处理时即使断线清空了缓存，erase也没有影响
+    visit_msg(header, consumer_visitor_);
+    state_.erase_cached_msg(seq);
   }
 }
 
@@ -424,11 +581,13 @@ void Session::disconnect(DisconnectReason reason, bool called_by_sender) {
 
       LogoutMessage logout_msg{};
       logout_msg.session_status = 101;
-      broker_->on_msg(logout_msg);
+      broker_->on_msg(this, logout_msg);
     }
 
-    while (!cached_snd_queue_.empty())
-      cached_snd_queue_.pop();  // 清空流速缓存队列
+    // 已分配序列号的消息在重新登录后由OCG请求重传，没有序列号的业务
+    // 消息保留下来，登录成功后继续发送
+    pending_frames_.clear();
+    send_timer_armed_ = false;
     state_.reset_on_logout();
   } else {
     std::unique_lock<std::mutex> lock(mutex_);
@@ -436,28 +595,42 @@ void Session::disconnect(DisconnectReason reason, bool called_by_sender) {
   }
 }
 
-/*
- * 更新当前秒钟的订单流量，并尝试把上一秒缓存待发的数据发送出去
- *
- * 该函数会在每个秒钟的开始时被定时器调用，然后执行以下操作：
- * 1. 把current_sec_send(当前秒钟内发出的消息条数)置0
- * 2. 如果缓存队列中有消息，如果把current_sec_send在流速限制范围内，
- *    则把缓存队列中的消息发送出去，否则需要等待下一秒钟才发
- */
-bool Session::update_throttle() {
-  std::unique_lock<std::mutex> lock(mutex_);
-  if (!socket_sender_) return false;
+bool Session::send_frame(const char* data, std::size_t size) {
+  if (batch_depth_ > 0) return append_to_batch(data, size);
+  // 这里需要判断指针是否为空，因为在进入send_raw_msg之前可能已经触发了断线
+  if (!socket_sender_) return true;
+  return socket_sender_->send(data, size);
+}
 
-  // current_sec_send_置0后再尝试发送缓存中的消息
-  for (current_sec_send_ = 0; current_sec_send_ < msg_limit_per_sec_;
-       ++current_sec_send_) {
-    if (cached_snd_queue_.empty()) return true;
+bool Session::append_to_batch(const char* data, std::size_t size) {
+  bool res = true;
+  if (batch_size_ + size > SEND_BATCH_MAX_BYTES ||
+      (batch_size_ > 0 &&
+       now_us() >= batch_start_us_ + SEND_BATCH_MAX_DELAY_US))
+    res = flush_batch();
+
+  if (batch_size_ == 0) batch_start_us_ = now_us();
+  memcpy(batch_buf_.get() + batch_size_, data, size);
+  batch_size_ += size;
+  return res;
+}
 
-    auto msgbuf = cached_snd_queue_.front();
-    if (!socket_sender_->send(msgbuf.data, msgbuf.size)) return false;
-    cached_snd_queue_.pop();
-  }
+bool Session::flush_batch() {
+  bool res = true;
+  // 发送过程中可能已经断线
+  if (batch_size_ > 0 && socket_sender_)
+    res = socket_sender_->send(batch_buf_.get(), batch_size_);
+  batch_size_ = 0;
+  return res;
+}
+
+bool Session::flush_stale_batch() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (!socket_sender_) return false;
 
+  if (batch_size_ > 0 &&
+      now_us() >= batch_start_us_ + SEND_BATCH_MAX_DELAY_US)
+    return flush_batch();
   return true;
 }
 
@@ -505,7 +678,7 @@ bool Session::periodically_check() {
     return true;
   }
 
-  if (!update_throttle()) return false;
+  if (!flush_stale_batch()) return false;
 
   if (state_.need_heartbeat(now)) send_heartbeat();
 
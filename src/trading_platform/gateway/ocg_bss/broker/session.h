@@ -3,22 +3,36 @@
 #ifndef OCG_BSS_BROKER_SESSION_H_
 #define OCG_BSS_BROKER_SESSION_H_
 
+#include <sys/uio.h>
+
+#include <deque>
 #include <memory>
 #include <mutex>
-#include <queue>
 #include <string>
+#include <type_traits>
 
 #include "broker/broker.h"
 #include "broker/encrypto.h"
 #include "broker/misc.h"
+#include "broker/sent_message_store.h"
 #include "broker/session_config.h"
 #include "broker/session_state.h"
 #include "broker/socket_sender.h"
+#include "broker/throttle.h"
 #include "protocol/message_handler.h"
 #include "protocol/protocol_encoder.h"
 
 namespace ft::bss {
 
+// 流控排队时撤单类的消息排在其他业务消息之前
+template <class Message>
+inline constexpr bool is_cancel_msg_v =
+    std::is_same_v<Message, CancelRequest> ||
+    std::is_same_v<Message, MassCancelRequest> ||
+    std::is_same_v<Message, OboCancelRequest> ||
+    std::is_same_v<Message, OboMassCancelRequest> ||
+    std::is_same_v<Message, QuoteCancelRequest>;
+
 /*
  * Session用于保证数据的完整性及正确性，不处理业务逻辑
  *
@@ -45,6 +59,18 @@ class Session : public MessageHandler {
 
   void set_socket_sender(SocketSender* sender) { socket_sender_ = sender; }
 
+  /*
+   * 提前到达的消息原地保留在连接的接收缓冲区中，连接创建及释放时设置
+   */
+  void set_recv_buffer(MirroredBuffer* buffer) {
+    state_.received_messages.attach(buffer);
+  }
+
+  /*
+   * 接收缓冲区被缓存的消息占满时丢弃这些消息，之后由OCG重传
+   */
+  void drop_cached_msgs() { state_.received_messages.clear(); }
+
   void reset();
 
   /*
@@ -55,18 +81,76 @@ class Session : public MessageHandler {
   /*
    * 供业务层调用，用于发送订单相关的请求
    *
-   * 如果超过了订单流速限制直接返回错误
+   * 超过流速限制时消息先编码到待发队列中，由发送定时器在有令牌时发出，
+   * 撤单类的消息排在其他业务消息之前，序列号在真正发出时才分配。
+   * 待发队列满时返回错误
    */
   template <class Message>
-  bool send_business_msg(const Message& order_req) {
+  bool send_business_msg(const Message& msg) {
     std::unique_lock<std::mutex> lock(mutex_);
-    if (is_send_vol_exceed_threshold()) {
-      return false;
+    if (!has_pending_msgs() && throttle_.try_acquire(now_us())) {
+      send_raw_msg_without_lock(msg, true);
+      return true;
     }
-    send_raw_msg_without_lock(order_req);
+
+    auto queue = is_cancel_msg_v<Message> ? &urgent_msgs_ : &normal_msgs_;
+    auto buffer = queue->back();
+    if (!buffer) return false;
+
+    encoder_.set_next_seq_number(0);
+    encoder_.encode_msg(msg, buffer);
+    queue->push();
+    arm_send_timer();
     return true;
   }
 
+  // 登录成功后把断线前没来得及发出的业务消息发出去
+  void send_pending_msgs() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    send_pending_msgs_without_lock();
+  }
+
+  // 发送定时器到期，由Connection调用
+  void on_send_timer() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    send_timer_armed_ = false;
+    send_pending_msgs_without_lock();
+  }
+
+  // 最近一秒发出的消息数与每秒流速限制之比，供策略控制下单节奏
+  double send_utilization() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return throttle_.utilization(now_us());
+  }
+
+  /*
+   * 最近一秒发出的加上还在排队的消息数与每秒流速限制之比，多个session
+   * 之间按这个值分配订单。大于1表示新的消息需要排队等待发出
+   */
+  double send_load() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (throttle_.rate() == 0) return 0.0;
+    auto queued =
+        pending_frames_.size() + urgent_msgs_.size() + normal_msgs_.size();
+    return static_cast<double>(throttle_.sent_last_second(now_us()) + queued) /
+           throttle_.rate();
+  }
+
+  /*
+   * 批量发送，begin_batch与end_batch之间发出的消息先放在发送缓冲区中，
+   * end_batch时一次发出。缓冲区满或者第一条消息等待超过
+   * SEND_BATCH_MAX_DELAY_US时提前发出。不在批量发送中时每条消息直接发送
+   */
+  void begin_batch() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    ++batch_depth_;
+  }
+
+  void end_batch() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (batch_depth_ > 0 && --batch_depth_ == 0) flush_batch();
+  }
+
   void on_logon_msg(MessageHeader* header, LogonMessage* msg) override;
 
   void on_logout_msg(MessageHeader* header, LogoutMessage* msg) override;
@@ -89,7 +173,7 @@ class Session : public MessageHandler {
                               BusinessRejectMessage* msg) override;
 
   void on_execution_report(MessageHeader* header,
-                           ExecutionReport* msg) override;
+                           ExecutionReportView* msg) override;
 
   void on_mass_cancel_report(MessageHeader* header,
                              OrderMassCancelReport* msg) override;
@@ -202,8 +286,7 @@ class Session : public MessageHandler {
            header.message_type == LOGOUT;
   }
 
-  template <class Message>
-  bool handle_msg_seq_too_high(const MessageHeader& header, const Message& msg);
+  bool handle_msg_seq_too_high(const MessageHeader& header);
 
   bool handle_msg_seq_too_low(const MessageHeader& header);
 
@@ -222,18 +305,76 @@ class Session : public MessageHandler {
 
   void resend(uint32_t start_seq_num, uint32_t end_seq_num);
 
+  // 重传或者发送待发队列时多条消息合并为一次writev
+  struct IovecBatch {
+    static constexpr int kMaxMsgs = 64;
+
+    iovec iov[kMaxMsgs];
+    int count = 0;
+  };
+
+  void add_to_iovec_batch(MessageHeader* header, IovecBatch* batch);
+
+  void flush_iovec_batch(IovecBatch* batch);
+
+  void resend_stored_msg(MessageHeader* header, IovecBatch* batch);
+
   void consume_cached_msgs();
 
   // 判断消息缓存（用于存放提前到达的消息）里是否有数据
   bool is_msg_queue_empty() const { return state_.is_msg_queue_empty(); }
 
-  bool is_send_vol_exceed_threshold() const {
-    return current_sec_send_ >= msg_limit_per_sec_;
+  /*
+   * 已分配序列号但因为流控还没发出的消息
+   *
+   * 消息本身已经保存在sent_msgs_中，这里只记录序列号。重传时的gap fill
+   * 不会保存，gap_fill_target不为0时表示发送时按序列号重新编码gap fill
+   */
+  struct PendingFrame {
+    uint32_t seq;
+    uint32_t gap_fill_target;
+  };
+
+  bool has_pending_msgs() const {
+    return !pending_frames_.empty() || !urgent_msgs_.empty() ||
+           !normal_msgs_.empty();
+  }
+
+  // 业务消息要等登录成功后才能发出
+  bool has_sendable_msgs() const {
+    return !pending_frames_.empty() ||
+           (state_.received_logon &&
+            (!urgent_msgs_.empty() || !normal_msgs_.empty()));
+  }
+
+  // 已分配序列号的消息必须按序发出，前面有消息在排队时不能直接发送
+  bool acquire_send_token() {
+    return pending_frames_.empty() && throttle_.try_acquire(now_us());
+  }
+
+  void queue_pending_frame(uint32_t seq, uint32_t gap_fill_target) {
+    pending_frames_.push_back({seq, gap_fill_target});
+    arm_send_timer();
+  }
+
+  void arm_send_timer() {
+    if (send_timer_armed_ || !socket_sender_ || !has_sendable_msgs()) return;
+    socket_sender_->arm_send_timer(throttle_.next_available_us(now_us()));
+    send_timer_armed_ = true;
   }
 
-  // 不加锁的发送，resend场景下需要在外部加一个大锁，发送函数内部不能有锁
+  void send_pending_msgs_without_lock();
+
+  /*
+   * 不加锁的发送，resend场景下需要在外部加一个大锁，发送函数内部不能有锁
+   *
+   * has_token为true表示调用者已经取得了令牌
+   */
   template <class Message>
-  bool send_raw_msg_without_lock(const Message& msg);
+  bool send_raw_msg_without_lock(const Message& msg, bool has_token = false);
+
+  // 根据是否在批量发送中选择放入发送缓冲区或者直接发送
+  bool send_frame(const char* data, std::size_t size);
 
   // 除了resend，其余场景发送时均需要加锁
   template <class Message>
@@ -279,44 +420,40 @@ class Session : public MessageHandler {
   }
 
   void send_gap_fill(uint32_t new_seq_num) {
-    // gap_fill设置为Y表示让OCG跳过该消息，N有别的用途，BSS方只可使用Y功能
-    SequenceResetMessage seq_reset_msg{'Y', new_seq_num};
-    send_raw_msg_without_lock(seq_reset_msg);
+    if (acquire_send_token())
+      send_gap_fill_frame(state_.next_send_msg_seq, new_seq_num);
+    else
+      queue_pending_frame(state_.next_send_msg_seq, new_seq_num);
     state_.next_send_msg_seq = new_seq_num;
   }
 
-  bool update_throttle();
+  // 编码并立即发出序列号为seq的gap fill，不经过批量发送缓冲区
+  bool send_gap_fill_frame(uint32_t seq, uint32_t new_seq_num);
 
-  void encrypt_password();
+  // 批量发送没有正常结束时由定时器发出，连接已断开时返回false
+  bool flush_stale_batch();
 
- private:
-  struct ResendVisitor {
-    void init(Session* self) { self_ = self; }
+  // 把消息追加到发送缓冲区，缓冲区满或者超时时先把已有的发出去
+  bool append_to_batch(const char* data, std::size_t size);
 
-    template <class Message>
-    void operator()(const Message& msg) {
-      self_->send_raw_msg_without_lock(msg);
-    }
+  bool flush_batch();
 
-   private:
-    Session* self_;
-  };
+  void encrypt_password();
 
+ private:
   struct ConsumerVisitor {
     void init(Session* self) { self_ = self; }
-    void set_header(MessageHeader* header) { header_ = header; }
 
-    void operator()(LogonMessage& msg) { BUG_ON(); }
-    void operator()(LogoutMessage& msg) { BUG_ON(); }
+    void operator()(MessageHeader* header, LogonMessage* msg) { BUG_ON(); }
+    void operator()(MessageHeader* header, LogoutMessage* msg) { BUG_ON(); }
 
     template <class Message>
-    void operator()(Message& msg) {
-      self_->process_msg(header_, &msg);
+    void operator()(MessageHeader* header, Message* msg) {
+      self_->process_msg(header, msg);
     }
 
    private:
     Session* self_;
-    MessageHeader* header_;
   };
 
  private:
@@ -325,50 +462,27 @@ class Session : public MessageHandler {
   std::string password_;
   std::string new_password_;
   SessionState state_;
+  SentMessageStore sent_msgs_;
   BinaryMessageEncoder encoder_;
   BssBroker* broker_{nullptr};
   SocketSender* socket_sender_{nullptr};
   std::unique_ptr<PasswordEncrptor> passwd_encrypto_;
   std::mutex mutex_;
 
-  std::queue<MsgBuffer> cached_snd_queue_;
-  uint32_t current_sec_send_{0};
-  uint32_t msg_limit_per_sec_{0};
+  Throttle throttle_;
+  std::deque<PendingFrame> pending_frames_;
+  PendingMsgQueue urgent_msgs_{SEND_PENDING_MAX_MSGS};
+  PendingMsgQueue normal_msgs_{SEND_PENDING_MAX_MSGS};
+  bool send_timer_armed_{false};
+
+  std::unique_ptr<char[]> batch_buf_{new char[SEND_BATCH_MAX_BYTES]};
+  std::size_t batch_size_{0};
+  uint64_t batch_start_us_{0};
+  int batch_depth_{0};
 
-  ResendVisitor resend_visitor_;
   ConsumerVisitor consumer_visitor_;
 };
 
-/*
- * 非预期序列号处理函数
- *
- * 收到从OCG发来的序列号大于预期的消息
- */
-template <class Message>
-bool Session::handle_msg_seq_too_high(const MessageHeader& header,
-                                      const Message& msg) {
-  // todo: To be or not to be, that is the question
-  printf("handle_msg_seq_too_high: seq:%u type:%u expected:%u\n",
-         header.sequence_number, header.message_type, state_.next_recv_msg_seq);
-
-  // 提前到的消息先缓存下来
-  state_.cache_early_arriving_msg(header.sequence_number, header, msg);
-
-  // 如果正在重传状态
-  if (state_.is_recovering()) {
-    // 如果消息在重传范围外，打印警告信息，因为不允许在重传状态下再次发起重传
-    if (header.sequence_number < state_.resend_range.first &&
-        header.sequence_number > state_.resend_range.second)
-      printf("warn. handle_msg_seq_too_high. msg outside the resend range\n");
-
-    return true;
-  }
-
-  // 发起重传请求
-  send_resend_request(state_.next_recv_msg_seq, header.sequence_number - 1);
-  return true;
-}
-
 /*
  * 验证消息是否正确
  *
@@ -397,7 +511,7 @@ bool Session::verify_msg(const MessageHeader& header, const Message& msg,
   }
 
   if (check_too_high && header.sequence_number > state_.next_recv_msg_seq) {
-    if (!handle_msg_seq_too_high(header, msg)) {
+    if (!handle_msg_seq_too_high(header)) {
       printf("failed. !handle_msg_seq_too_high\n");
       goto error;
     }
@@ -438,28 +552,27 @@ error:
  * 但无论消息是否发送到Connection层，都会被记录在历史消息中
  */
 template <class Message>
-bool Session::send_raw_msg_without_lock(const Message& msg) {
+bool Session::send_raw_msg_without_lock(const Message& msg, bool has_token) {
   bool res = true;
   MsgBuffer msg_buffer;
+  uint32_t seq = state_.next_send_msg_seq;
 
-  encoder_.set_next_seq_number(state_.next_send_msg_seq);
+  encoder_.set_next_seq_number(seq);
   encoder_.encode_msg(msg, &msg_buffer);
 
-  if (current_sec_send_ >= msg_limit_per_sec_) {
-    // 当前秒钟内可流量已达上限，把消息缓存到队列中，由定时器去发出
-    cached_snd_queue_.emplace(msg_buffer);
+  // 每条发出去的消息都保存下来，以处理在登录时OCG请求重传的情况
+  // 即便socket_sender_为空使得发送不成功，也应该保存该消息
+  sent_msgs_.append(seq, msg_buffer.data, msg_buffer.size);
+
+  if (has_token || acquire_send_token()) {
+    res = send_frame(msg_buffer.data, msg_buffer.size);
   } else {
-    // 这里需要判断指针是否为空，因为在进入send_raw_msg之前可能已经触发了断线
-    if (socket_sender_)
-      res = socket_sender_->send(msg_buffer.data, msg_buffer.size);
+    // 没有令牌时只记录序列号，由发送定时器从保存的消息中发出
+    queue_pending_frame(seq, 0);
   }
 
-  // 每条发出去的消息都保存下来，以处理在登录时OCG请求重传的情况
-  // 即便socket_sender_为空使得发送不成功，也应该保存该消息
-  state_.record_sent_msg(msg);
   state_.last_send_time_ms = now_ms();
   ++state_.next_send_msg_seq;
-  ++current_sec_send_;
   return res;
 }
 
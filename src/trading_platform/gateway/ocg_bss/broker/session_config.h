@@ -12,8 +12,12 @@ struct SessionConfig {
   std::string password;
   std::string new_password;
   std::string rsa_pubkey_file;
+  std::string sent_msg_store;  // 已发送消息的保存路径，不含扩展名
+  std::string state_file;      // 序列号等需要跨进程重启保存的状态
+  std::string trading_date;    // YYYYMMDD
 
   uint32_t msg_limit_per_sec;
+  uint32_t msg_burst = 1;  // 最多允许连续发出的消息数，见Throttle
 };
 
 }  // namespace ft::bss
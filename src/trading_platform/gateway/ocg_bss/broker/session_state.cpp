@@ -0,0 +1,77 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#include "broker/session_state.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+
+namespace ft::bss {
+
+namespace {
+
+inline constexpr char kStateMagic[8] = {'O', 'C', 'G', 'S',
+                                        'T', 'A', 'T', '\0'};
+inline constexpr uint32_t kStateVersion = 1;
+
+}  // namespace
+
+SessionState::~SessionState() {
+  if (persisted_) munmap(persisted_, sizeof(PersistedSessionState));
+}
+
+bool SessionState::load(const std::string& file,
+                        const std::string& trading_date) {
+  if (persisted_ || trading_date.size() >= sizeof(persisted_->trading_date))
+    return false;
+
+  int fd = open(file.c_str(), O_RDWR | O_CREAT, 0644);
+  if (fd < 0) {
+    printf("failed to open session state file %s: %s\n", file.c_str(),
+           strerror(errno));
+    return false;
+  }
+
+  void* addr = MAP_FAILED;
+  if (ftruncate(fd, sizeof(PersistedSessionState)) == 0) {
+    addr = mmap(nullptr, sizeof(PersistedSessionState),
+                PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  }
+  close(fd);
+  if (addr == MAP_FAILED) {
+    printf("failed to map session state file %s: %s\n", file.c_str(),
+           strerror(errno));
+    return false;
+  }
+
+  auto persisted = static_cast<PersistedSessionState*>(addr);
+  if (memcmp(persisted->magic, kStateMagic, sizeof(kStateMagic)) == 0 &&
+      persisted->version == kStateVersion &&
+      trading_date == persisted->trading_date) {
+    next_send_msg_seq =
+        persisted->next_send_msg_seq.load(std::memory_order_acquire);
+    next_recv_msg_seq =
+        persisted->next_recv_msg_seq.load(std::memory_order_acquire);
+    next_test_request_id =
+        persisted->next_test_request_id.load(std::memory_order_acquire);
+    printf("session state restored. NextSndSeqNum:%u NextRecvSeqNum:%u\n",
+           next_send_msg_seq.get(), next_recv_msg_seq.get());
+  } else {
+    // 新文件或者新的交易日，使用当前(即每日初始)的值
+    memcpy(persisted->magic, kStateMagic, sizeof(kStateMagic));
+    persisted->version = kStateVersion;
+    memset(persisted->trading_date, 0, sizeof(persisted->trading_date));
+    memcpy(persisted->trading_date, trading_date.data(), trading_date.size());
+  }
+
+  persisted_ = persisted;
+  next_send_msg_seq.bind(&persisted->next_send_msg_seq);
+  next_recv_msg_seq.bind(&persisted->next_recv_msg_seq);
+  next_test_request_id.bind(&persisted->next_test_request_id);
+  return true;
+}
+
+}  // namespace ft::bss
@@ -3,37 +3,94 @@
 #ifndef OCG_BSS_BROKER_SESSION_STATE_H_
 #define OCG_BSS_BROKER_SESSION_STATE_H_
 
+#include <atomic>
 #include <chrono>
 #include <cstdint>
-#include <unordered_map>
-#include <variant>
+#include <string>
 
 #include "broker/constants.h"
+#include "broker/recv_msg_cache.h"
 #include "protocol/protocol_encoder.h"
 
 namespace ft::bss {
 
-struct HistoricalSentMessage {
-  MessageType type;
-  std::variant<LogonMessage, LogoutMessage, HeartbeatMessage, TestRequest,
-               ResendRequest, RejectMessage, SequenceResetMessage,
-               NewOrderRequest, AmendRequest, CancelRequest, MassCancelRequest,
-               OboCancelRequest, OboMassCancelRequest, QuoteRequest,
-               QuoteCancelRequest, TradeCaptureReport, PartyEntitlementRequest>
-      body;
+/*
+ * 每次修改时同时写入(release)mmap文件中对应的位置，读取只访问本地的值
+ *
+ * 未绑定文件时与普通变量相同
+ */
+template <class T>
+class PersistentValue {
+ public:
+  explicit PersistentValue(T value) : value_(value) {}
+
+  PersistentValue(const PersistentValue&) = delete;
+  PersistentValue& operator=(const PersistentValue&) = delete;
+
+  operator T() const { return value_; }
+
+  T get() const { return value_; }
+
+  PersistentValue& operator=(T value) {
+    value_ = value;
+    store();
+    return *this;
+  }
+
+  PersistentValue& operator++() {
+    ++value_;
+    store();
+    return *this;
+  }
+
+  void bind(std::atomic<T>* slot) {
+    slot_ = slot;
+    store();
+  }
+
+ private:
+  void store() {
+    if (slot_) slot_->store(value_, std::memory_order_release);
+  }
+
+ private:
+  T value_;
+  std::atomic<T>* slot_ = nullptr;
 };
 
-struct CachedRecvMessage {
-  MessageHeader header;
-  std::variant<LogonMessage, LogoutMessage, HeartbeatMessage, TestRequest,
-               ResendRequest, RejectMessage, SequenceResetMessage,
-               TradeCaptureReport, ExecutionReport, TradeCaptureReportAck,
-               QuoteStatusReport, OrderMassCancelReport, BusinessRejectMessage>
-      body;
+/*
+ * 跨进程重启保存的会话状态，位于mmap的文件中
+ *
+ * BSS在盘中重启后直接使用保存的序列号登录，不需要先被OCG登出再从登出原因中
+ * 解析序列号。文件中的交易日与当天不同时从每日的初始值开始
+ */
+struct PersistedSessionState {
+  char magic[8];
+  uint32_t version;
+  char trading_date[12];
+  std::atomic<uint32_t> next_send_msg_seq;
+  std::atomic<uint32_t> next_recv_msg_seq;
+  std::atomic<TestRequestId> next_test_request_id;
 };
 
+static_assert(std::atomic<uint32_t>::is_always_lock_free);
+static_assert(std::atomic<TestRequestId>::is_always_lock_free);
+
 class SessionState {
  public:
+  SessionState() = default;
+
+  ~SessionState();
+
+  SessionState(const SessionState&) = delete;
+  SessionState& operator=(const SessionState&) = delete;
+
+  /*
+   * 打开状态文件，当天的状态已存在时从中恢复序列号，之后序列号的每次修改
+   * 都会写入文件
+   */
+  bool load(const std::string& file, const std::string& trading_date);
+
   /*
    * 恢复到未登录的状态，而非恢复至初始状态
    */
@@ -59,7 +116,6 @@ class SessionState {
     next_send_msg_seq = DAILY_INITIAL_SND_MSG_SEQ;
     next_recv_msg_seq = DAILY_INITIAL_RCV_MSG_SEQ;
     next_test_request_id = DAILY_INITIAL_TEST_REQUEST_ID;
-    sent_messages.clear();
   }
 
   void set_resend_range(uint32_t start, uint32_t end) {
@@ -98,36 +154,17 @@ class SessionState {
                         test_request_timeout_ms;
   }
 
-  template <class Message>
-  void record_sent_msg(const Message& msg) {
-    auto iter = sent_messages.find(next_send_msg_seq);
-    if (iter == sent_messages.end()) {
-      HistoricalSentMessage sent_msg;
-      sent_msg.type = get_msg_type<Message>();
-      sent_msg.body = msg;
-      sent_messages.emplace(next_send_msg_seq, sent_msg);
-    }
+  // 同一个序列号只缓存第一次收到的消息，缓存满时丢弃
+  void cache_early_arriving_msg(const MessageHeader& header) {
+    received_messages.put(header);
   }
 
-  template <class Message>
-  void cache_early_arriving_msg(uint32_t seq, const MessageHeader& header,
-                                const Message& msg) {
-    auto iter = received_messages.find(seq);
-    if (iter == received_messages.end()) {
-      CachedRecvMessage cached_msg;
-      cached_msg.header = header;
-      cached_msg.body = msg;
-      received_messages.emplace(seq, cached_msg);
-    }
+  // 取出的消息处理完之后再调用erase_cached_msg
+  MessageHeader* find_cached_msg(uint32_t seq) {
+    return received_messages.get(seq);
   }
 
-  bool retrieve_msg_cache(uint32_t seq, CachedRecvMessage* msg) {
-    auto iter = received_messages.find(seq);
-    if (iter == received_messages.end()) return false;
-    *msg = iter->second;
-    received_messages.erase(iter);
-    return true;
-  }
+  void erase_cached_msg(uint32_t seq) { received_messages.erase(seq); }
 
   bool is_msg_queue_empty() const { return received_messages.empty(); }
 
@@ -152,13 +189,16 @@ class SessionState {
   uint64_t logon_timeout_ms = LOGON_TIMEOUT_MS;
   uint64_t logout_timeout_ms = LOGOUT_TIMEOUT_MS;
 
-  uint32_t next_send_msg_seq = DAILY_INITIAL_SND_MSG_SEQ;
-  uint32_t next_recv_msg_seq = DAILY_INITIAL_RCV_MSG_SEQ;
+  PersistentValue<uint32_t> next_send_msg_seq{DAILY_INITIAL_SND_MSG_SEQ};
+  PersistentValue<uint32_t> next_recv_msg_seq{DAILY_INITIAL_RCV_MSG_SEQ};
+
+  PersistentValue<TestRequestId> next_test_request_id{
+      DAILY_INITIAL_TEST_REQUEST_ID};
 
-  TestRequestId next_test_request_id = DAILY_INITIAL_TEST_REQUEST_ID;
+  RecvMsgCache received_messages{RECV_CACHE_MAX_BYTES};
 
-  std::unordered_map<uint32_t, HistoricalSentMessage> sent_messages;
-  std::unordered_map<uint32_t, CachedRecvMessage> received_messages;
+ private:
+  PersistedSessionState* persisted_ = nullptr;
 };
 
 }  // namespace ft::bss
@@ -3,6 +3,8 @@
 #ifndef OCG_BSS_BROKER_SOCKET_SENDER_H_
 #define OCG_BSS_BROKER_SOCKET_SENDER_H_
 
+#include <sys/uio.h>
+
 #include "protocol/protocol_encoder.h"
 
 namespace ft::bss {
@@ -22,6 +24,15 @@ class SocketSender {
 
   virtual bool send(const void* buf, std::size_t size) = 0;
 
+  // 一次发送多段数据，iov的内容可能被修改
+  virtual bool sendv(struct iovec* iov, int iovcnt) = 0;
+
+  // cork期间发出的数据由内核合并成尽量满的报文，取消cork时立即发出
+  virtual void set_cork(bool cork) = 0;
+
+  // 在CLOCK_MONOTONIC的deadline_us时刻回调一次Session::on_send_timer
+  virtual void arm_send_timer(uint64_t deadline_us) = 0;
+
   virtual void disconnect(DisconnectReason reason) = 0;
 };
 
@@ -0,0 +1,68 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#include "broker/throttle.h"
+
+#include <algorithm>
+
+namespace ft::bss {
+
+void Throttle::init(uint32_t rate, uint32_t burst, uint64_t now_us) {
+  rate_ = rate;
+  capacity_ = std::max(burst, 1U) * kTokenUnit;
+  reset(now_us);
+}
+
+void Throttle::reset(uint64_t now_us) {
+  tokens_ = capacity_;
+  last_refill_us_ = now_us;
+  std::fill(slot_index_, slot_index_ + kSlots, 0);
+  std::fill(slot_count_, slot_count_ + kSlots, 0);
+}
+
+void Throttle::refill(uint64_t now_us) {
+  if (now_us <= last_refill_us_) return;
+
+  // 微秒数乘以每秒的令牌数正好是以kTokenUnit为单位的令牌数
+  tokens_ = std::min(capacity_, tokens_ + (now_us - last_refill_us_) * rate_);
+  last_refill_us_ = now_us;
+}
+
+bool Throttle::try_acquire(uint64_t now_us) {
+  refill(now_us);
+  if (tokens_ < kTokenUnit) return false;
+  tokens_ -= kTokenUnit;
+
+  uint64_t index = now_us / kSlotUs;
+  int slot = static_cast<int>(index % kSlots);
+  if (slot_index_[slot] != index) {
+    slot_index_[slot] = index;
+    slot_count_[slot] = 0;
+  }
+  ++slot_count_[slot];
+  return true;
+}
+
+uint64_t Throttle::next_available_us(uint64_t now_us) {
+  refill(now_us);
+  if (tokens_ >= kTokenUnit) return now_us;
+  if (rate_ == 0) return UINT64_MAX;
+  return now_us + (kTokenUnit - tokens_ + rate_ - 1) / rate_;
+}
+
+uint32_t Throttle::sent_last_second(uint64_t now_us) const {
+  uint64_t index = now_us / kSlotUs;
+  uint32_t sent = 0;
+  for (int i = 0; i < kSlots; ++i) {
+    if (slot_index_[i] + kSlots > index) sent += slot_count_[i];
+  }
+  return sent;
+}
+
+PendingMsgQueue::PendingMsgQueue(std::size_t capacity) {
+  capacity_ = 1;
+  while (capacity_ < capacity) capacity_ <<= 1;
+  mask_ = capacity_ - 1;
+  slots_.reset(new MsgBuffer[capacity_]);
+}
+
+}  // namespace ft::bss
@@ -0,0 +1,107 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef OCG_BSS_BROKER_THROTTLE_H_
+#define OCG_BSS_BROKER_THROTTLE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "protocol/protocol_encoder.h"
+
+namespace ft::bss {
+
+/*
+ * 令牌桶流控
+ *
+ * 令牌按每秒rate个的速度连续补充，最多积累burst个，每发一条消息消耗一个。
+ * 令牌以百万分之一个为单位计数，取令牌时按距上次补充经过的微秒数补足，
+ * 补充的精度与时钟一致，不依赖定时器的触发时间
+ *
+ * 任意半开区间[t, t+1秒)内最多发出burst+rate-1条消息，闭区间[t, t+1秒]
+ * 两端都可能有消息，最多burst+rate条。burst为1时相邻两条消息至少间隔
+ * 1/rate秒，半开的一秒内不超过rate条，闭区间内可能有rate+1条，交易所按
+ * 闭区间统计时rate应比限制小1。不会像按整秒计数那样在秒的开始时集中发出
+ *
+ * 另外按100毫秒一格统计最近一秒实际发出的消息数，供上层控制下单节奏
+ */
+class Throttle {
+ public:
+  void init(uint32_t rate, uint32_t burst, uint64_t now_us);
+
+  // 桶恢复为满的，统计清零
+  void reset(uint64_t now_us);
+
+  bool try_acquire(uint64_t now_us);
+
+  // 下一个令牌可用的时间，当前有令牌时返回now_us
+  uint64_t next_available_us(uint64_t now_us);
+
+  // 最近一秒发出的消息数
+  uint32_t sent_last_second(uint64_t now_us) const;
+
+  // 最近一秒发出的消息数与每秒限制之比
+  double utilization(uint64_t now_us) const {
+    return rate_ == 0 ? 0.0
+                      : static_cast<double>(sent_last_second(now_us)) / rate_;
+  }
+
+  uint32_t rate() const { return rate_; }
+
+ private:
+  void refill(uint64_t now_us);
+
+ private:
+  static constexpr uint64_t kTokenUnit = 1000000;
+  static constexpr int kSlots = 10;
+  static constexpr uint64_t kSlotUs = 100000;
+
+  uint32_t rate_ = 0;
+  uint64_t capacity_ = 0;
+  uint64_t tokens_ = 0;
+  uint64_t last_refill_us_ = 0;
+
+  uint64_t slot_index_[kSlots]{};
+  uint32_t slot_count_[kSlots]{};
+};
+
+/*
+ * 流控排队的消息，定长的环形队列
+ *
+ * 消息直接编码到队尾的槽中，发出时直接从槽中发送，排队期间不再拷贝。
+ * 序列号在真正发出时才分配，见patch_sequence_number
+ */
+class PendingMsgQueue {
+ public:
+  // capacity向上取整为2的幂
+  explicit PendingMsgQueue(std::size_t capacity);
+
+  bool empty() const { return head_ == tail_; }
+
+  bool full() const { return tail_ - head_ == capacity_; }
+
+  std::size_t size() const { return tail_ - head_; }
+
+  // 队列满时返回nullptr，写好后调用push
+  MsgBuffer* back() { return full() ? nullptr : &slots_[tail_ & mask_]; }
+
+  void push() { ++tail_; }
+
+  MsgBuffer* front() { return &slots_[head_ & mask_]; }
+
+  // 出队后的槽在下一次push之前仍然有效
+  void pop() { ++head_; }
+
+  void clear() { head_ = tail_ = 0; }
+
+ private:
+  std::unique_ptr<MsgBuffer[]> slots_;
+  std::size_t capacity_;
+  std::size_t mask_;
+  std::size_t head_ = 0;
+  std::size_t tail_ = 0;
+};
+
+}  // namespace ft::bss
+
+#endif  // OCG_BSS_BROKER_THROTTLE_H_
@@ -8,6 +8,7 @@
 #include <cstdint>
 #include <thread>
 
+#include "protocol/mirrored_buffer.h"
 #include "protocol/protocol.h"
 #include "protocol/protocol_encoder.h"
 #include "protocol/protocol_parser.h"
@@ -17,48 +18,43 @@ using namespace ft::bss;
 
 // CompID: CO99999902
 
+// 消息总是从front()开始，pop()只移动读位置，不搬动数据
 class OcgBinaryDecoder {
  public:
-  OcgBinaryDecoder() {}
+  OcgBinaryDecoder() : buffer_(4096 * 32) {}
 
-  char* front() { return buffer_; }
+  char* front() { return buffer_.readable_start(); }
 
-  char* back() { return buffer_ + pos_; }
+  char* back() { return buffer_.writable_start(); }
 
-  std::size_t size() const { return pos_; }
+  std::size_t size() const { return buffer_.readable_size(); }
 
   bool pop() {
-    if (pos_ < sizeof(MessageHeader) ||
-        pos_ < reinterpret_cast<MessageHeader*>(buffer_)->length)
-      return false;
-
-    std::size_t len = reinterpret_cast<MessageHeader*>(buffer_)->length;
-    std::size_t rest = pos_ - len;
-    memmove(buffer_, buffer_ + len, rest);
-    pos_ = rest;
+    if (!has_msg()) return false;
+
+    buffer_.consume(reinterpret_cast<MessageHeader*>(front())->length);
     return true;
   }
 
   std::size_t recv_from(int sock) {
-    if (pos_ >= sizeof(MessageHeader) &&
-        pos_ >= reinterpret_cast<MessageHeader*>(buffer_)->length)
-      return pos_;
-
-    for (;;) {
-      auto each = recv(sock, buffer_ + pos_, sizeof(buffer_) - pos_, 0);
+    while (!has_msg()) {
+      auto each =
+          recv(sock, buffer_.writable_start(), buffer_.writable_size(), 0);
       if (each <= 0) exit(-1);
-      pos_ += each;
-      if (pos_ < sizeof(MessageHeader)) continue;
-      if (pos_ < reinterpret_cast<MessageHeader*>(buffer_)->length) continue;
-      break;
+      buffer_.commit(each);
     }
 
-    return pos_;
+    return size();
+  }
+
+ private:
+  bool has_msg() {
+    return size() >= sizeof(MessageHeader) &&
+           size() >= reinterpret_cast<MessageHeader*>(front())->length;
   }
 
  private:
-  char buffer_[4096 * 20]{};
-  std::size_t pos_{0};
+  MirroredBuffer buffer_;
 };
 
 OcgBinaryDecoder decoder;
@@ -105,12 +101,12 @@ bool logon() {
   if (reinterpret_cast<MessageHeader*>(decoder.front())->message_type ==
       LOGOUT) {
     LogoutMessage msg{};
-    parse_logout_message(*reinterpret_cast<MessageHeader*>(decoder.front()),
-                         decoder.front() + sizeof(MessageHeader), &msg);
+    parse_msg(*reinterpret_cast<MessageHeader*>(decoder.front()),
+              decoder.front() + sizeof(MessageHeader), &msg);
   } else {
     LogonMessage msg{};
-    parse_logon_message(*reinterpret_cast<MessageHeader*>(decoder.front()),
-                        decoder.front() + sizeof(MessageHeader), &msg);
+    parse_msg(*reinterpret_cast<MessageHeader*>(decoder.front()),
+              decoder.front() + sizeof(MessageHeader), &msg);
   }
 
   decoder.pop();
@@ -256,8 +252,8 @@ void run_testcase_30() {
   send_msg(tc_om_30_s1);
   decoder.recv_from(sock);
   ExecutionReport report{};
-  parse_execution_report(*reinterpret_cast<MessageHeader*>(decoder.front()),
-                         decoder.front() + sizeof(MessageHeader), &report);
+  parse_msg(*reinterpret_cast<MessageHeader*>(decoder.front()),
+            decoder.front() + sizeof(MessageHeader), &report);
   decoder.pop();
 
   strncpy(tc_om_30_s2.order_id, report.order_id, sizeof(OrderId));
@@ -288,8 +284,8 @@ void run_testcase_32() {
   send_msg(tc_om_32_s1);
   decoder.recv_from(sock);
   ExecutionReport report{};
-  parse_execution_report(*reinterpret_cast<MessageHeader*>(decoder.front()),
-                         decoder.front() + sizeof(MessageHeader), &report);
+  parse_msg(*reinterpret_cast<MessageHeader*>(decoder.front()),
+            decoder.front() + sizeof(MessageHeader), &report);
   decoder.pop();
 
   strncpy(tc_om_32_s2.order_id, report.order_id, sizeof(OrderId));
@@ -383,8 +379,8 @@ void run_tc_tm_02() {
 void run_tc_tm_03() {
   decoder.recv_from(sock);
   TradeCaptureReport report{};
-  parse_trade_capture_report(*reinterpret_cast<MessageHeader*>(decoder.front()),
-                             decoder.front() + sizeof(MessageHeader), &report);
+  parse_msg(*reinterpret_cast<MessageHeader*>(decoder.front()),
+            decoder.front() + sizeof(MessageHeader), &report);
   decoder.pop();
 
   strncpy(report.trade_report_id, "202", sizeof(TradeReportId));
@@ -479,8 +475,8 @@ void run_testcase_tc_ol_03() {
   send_msg(tc_ol_03_s1);
   decoder.recv_from(sock);
   ExecutionReport report{};
-  parse_execution_report(*reinterpret_cast<MessageHeader*>(decoder.front()),
-                         decoder.front() + sizeof(MessageHeader), &report);
+  parse_msg(*reinterpret_cast<MessageHeader*>(decoder.front()),
+            decoder.front() + sizeof(MessageHeader), &report);
   decoder.pop();
 
   strncpy(tc_ol_03_s2.order_id, report.order_id, sizeof(OrderId));
@@ -501,8 +497,8 @@ void run_testcase_tc_ol_04() {
   send_msg(tc_ol_04_s1);
   decoder.recv_from(sock);
   ExecutionReport report{};
-  parse_execution_report(*reinterpret_cast<MessageHeader*>(decoder.front()),
-                         decoder.front() + sizeof(MessageHeader), &report);
+  parse_msg(*reinterpret_cast<MessageHeader*>(decoder.front()),
+            decoder.front() + sizeof(MessageHeader), &report);
   decoder.pop();
 
   strncpy(tc_ol_04_s2.order_id, report.order_id, sizeof(OrderId));
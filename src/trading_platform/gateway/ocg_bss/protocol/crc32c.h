@@ -3,8 +3,95 @@
 #ifndef OCG_BSS_PROTOCOL_CRC32C_H_
 #define OCG_BSS_PROTOCOL_CRC32C_H_
 
+#include <cstddef>
 #include <cstdint>
 
-uint32_t crc32c(uint32_t crc, const uint8_t* data, unsigned int length);
+/*
+ * CRC32C(Castagnoli)校验和
+ *
+ * 第一次调用时根据CPU选择实现：
+ *   1. sse4.2-pclmul: crc32指令三路交错，各段的结果用无进位乘法合并
+ *   2. sse4.2: 同上，各段的结果用查表合并
+ *   3. slicing-by-8: 每次查8张表处理8字节
+ * 各实现的结果完全一致，由test/crc32c_bench.cpp与逐字节查表的实现交叉验证
+ *
+ * 可以分段计算，例如消息头和消息体分开计算：
+ *   uint32_t state = kCrc32cInit;
+ *   state = crc32c_update(state, header, header_len);
+ *   state = crc32c_update(state, body, body_len);
+ *   Checksum checksum = crc32c_finish(state);
+ */
+inline constexpr uint32_t kCrc32cInit = 0xffffffff;
+
+uint32_t crc32c_update(uint32_t state, const void* data, std::size_t length);
+
+inline uint32_t crc32c_finish(uint32_t state) { return state ^ 0xffffffff; }
+
+// 一次算完，crc为初始状态(通常为kCrc32cInit)，返回最终的校验和
+inline uint32_t crc32c(uint32_t crc, const uint8_t* data, unsigned int length) {
+  return crc32c_finish(crc32c_update(crc, data, length));
+}
+
+/*
+ * 已知A的状态state_a，以及B以0为初始状态算出的state_b，求A后接B的状态
+ *
+ * 只依赖B的长度，不需要再遍历A或B的数据
+ */
+uint32_t crc32c_combine(uint32_t state_a, uint32_t state_b,
+                        std::size_t length_b);
+
+// 当前使用的实现，见上面的列表
+const char* crc32c_impl_name();
+
+namespace crc32c_detail {
+
+// 0x1EDC6F41按位反转，bit31为x^0的系数
+inline constexpr uint32_t kPoly = 0x82f63b78;
+
+// a * b mod P，a不能为0
+constexpr uint32_t multmodp(uint32_t a, uint32_t b) {
+  uint32_t m = 1U << 31;
+  uint32_t p = 0;
+  for (;;) {
+    if (a & m) {
+      p ^= b;
+      if ((a & (m - 1)) == 0) break;
+    }
+    m >>= 1;
+    b = b & 1 ? (b >> 1) ^ kPoly : b >> 1;
+  }
+  return p;
+}
+
+// x^n mod P
+constexpr uint32_t xnmodp(uint64_t n) {
+  uint32_t p = 1U << 31;    // x^0
+  uint32_t x2k = 1U << 30;  // x^(2^k)
+  while (n) {
+    if (n & 1) p = multmodp(x2k, p);
+    x2k = multmodp(x2k, x2k);
+    n >>= 1;
+  }
+  return p;
+}
+
+// 以下函数都不做最后的取反，供基准测试及交叉验证直接调用
+uint32_t update_bytewise(uint32_t state, const uint8_t* data,
+                         std::size_t length);
+
+uint32_t update_slicing8(uint32_t state, const uint8_t* data,
+                         std::size_t length);
+
+// 调用前需确认CPU支持，不支持时结果未定义
+uint32_t update_sse42(uint32_t state, const uint8_t* data, std::size_t length);
+
+uint32_t update_sse42_pclmul(uint32_t state, const uint8_t* data,
+                             std::size_t length);
+
+bool cpu_has_sse42();
+
+bool cpu_has_pclmul();
+
+}  // namespace crc32c_detail
 
 #endif  // OCG_BSS_PROTOCOL_CRC32C_H_
@@ -0,0 +1,92 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#include <cstring>
+
+#include "protocol/crc32c.h"
+
+namespace crc32c_detail {
+
+namespace {
+
+struct SlicingTables {
+  uint32_t t[8][256];
+};
+
+// t[0]为逐字节查表用的表，t[k][i]为字节i后面再跟k个0字节的结果
+constexpr SlicingTables make_slicing_tables() {
+  SlicingTables tables{};
+  for (uint32_t i = 0; i < 256; ++i) {
+    uint32_t crc = i;
+    for (int j = 0; j < 8; ++j) crc = crc & 1 ? (crc >> 1) ^ kPoly : crc >> 1;
+    tables.t[0][i] = crc;
+  }
+  for (int k = 1; k < 8; ++k) {
+    for (uint32_t i = 0; i < 256; ++i) {
+      uint32_t prev = tables.t[k - 1][i];
+      tables.t[k][i] = (prev >> 8) ^ tables.t[0][prev & 0xff];
+    }
+  }
+  return tables;
+}
+
+constexpr SlicingTables kTables = make_slicing_tables();
+
+}  // namespace
+
+// 按小端读取8字节，与OCG协议本身的字节序假设一致
+uint32_t update_slicing8(uint32_t state, const uint8_t* data,
+                         std::size_t length) {
+  const auto& t = kTables.t;
+  uint32_t crc = state;
+  while (length >= 8) {
+    uint64_t v;
+    memcpy(&v, data, sizeof(v));
+    v ^= crc;
+    crc = t[7][v & 0xff] ^ t[6][(v >> 8) & 0xff] ^ t[5][(v >> 16) & 0xff] ^
+          t[4][(v >> 24) & 0xff] ^ t[3][(v >> 32) & 0xff] ^
+          t[2][(v >> 40) & 0xff] ^ t[1][(v >> 48) & 0xff] ^ t[0][v >> 56];
+    data += 8;
+    length -= 8;
+  }
+  while (length--) crc = t[0][(crc ^ *data++) & 0xff] ^ (crc >> 8);
+  return crc;
+}
+
+}  // namespace crc32c_detail
+
+namespace {
+
+using UpdateFunc = uint32_t (*)(uint32_t, const uint8_t*, std::size_t);
+
+struct Crc32cImpl {
+  UpdateFunc update;
+  const char* name;
+};
+
+Crc32cImpl select_impl() {
+  using namespace crc32c_detail;
+  if (cpu_has_sse42() && cpu_has_pclmul())
+    return {update_sse42_pclmul, "sse4.2-pclmul"};
+  if (cpu_has_sse42()) return {update_sse42, "sse4.2"};
+  return {update_slicing8, "slicing-by-8"};
+}
+
+const Crc32cImpl& impl() {
+  static const Crc32cImpl impl = select_impl();
+  return impl;
+}
+
+}  // namespace
+
+uint32_t crc32c_update(uint32_t state, const void* data, std::size_t length) {
+  return impl().update(state, static_cast<const uint8_t*>(data), length);
+}
+
+uint32_t crc32c_combine(uint32_t state_a, uint32_t state_b,
+                        std::size_t length_b) {
+  using namespace crc32c_detail;
+  return multmodp(xnmodp(8 * static_cast<uint64_t>(length_b)), state_a) ^
+         state_b;
+}
+
+const char* crc32c_impl_name() { return impl().name; }
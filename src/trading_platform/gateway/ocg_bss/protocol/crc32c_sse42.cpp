@@ -0,0 +1,185 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#include "protocol/crc32c.h"
+
+#if defined(__x86_64__)
+
+#include <nmmintrin.h>
+#include <wmmintrin.h>
+
+#include <cstring>
+
+/*
+ * crc32指令的延迟为3个周期、吞吐为每周期1条，单路计算时每3个周期才能处理
+ * 8字节。这里把数据切成相邻的三段同时计算，再把三段的结果合并：
+ *   crc(A|B|C) = shift(shift(crc(A), |B|) ^ crc0(B), |C|) ^ crc0(C)
+ * 其中shift(c, n) = c * x^(8n) mod P，crc0表示以0为初始状态
+ *
+ * 段长固定，合并用的常数在编译期算好。较长的数据用kLongBlock，剩下的部分
+ * 足够长时再用kShortBlock，OCG的订单消息一般只有100~300字节
+ *
+ * 整个文件以target属性编译，不要求编译时打开-msse4.2，调用前由
+ * crc32c_engine.cpp在运行时检查CPU
+ */
+#define CRC32C_TARGET_SSE42 __attribute__((target("sse4.2")))
+#define CRC32C_TARGET_PCLMUL __attribute__((target("sse4.2,pclmul")))
+
+namespace crc32c_detail {
+
+namespace {
+
+inline constexpr std::size_t kLongBlock = 256;
+inline constexpr std::size_t kShortBlock = 32;
+
+// 无进位乘法得到的是a*b*x，crc32指令再乘上x^32，所以常数取x^(8n-33)
+inline constexpr uint32_t kLongClmulK = xnmodp(8 * kLongBlock - 33);
+inline constexpr uint32_t kShortClmulK = xnmodp(8 * kShortBlock - 33);
+
+// 没有PCLMUL时shift按字节拆开查表，shift是线性的
+struct ShiftTable {
+  uint32_t t[4][256];
+};
+
+constexpr ShiftTable make_shift_table(std::size_t length) {
+  ShiftTable table{};
+  uint32_t k = xnmodp(8 * length);
+  for (int j = 0; j < 4; ++j) {
+    for (uint32_t i = 0; i < 256; ++i)
+      table.t[j][i] = multmodp(k, i << (8 * j));
+  }
+  return table;
+}
+
+constexpr ShiftTable kLongShift = make_shift_table(kLongBlock);
+constexpr ShiftTable kShortShift = make_shift_table(kShortBlock);
+
+inline uint32_t table_shift(const ShiftTable& table, uint32_t crc) {
+  return table.t[0][crc & 0xff] ^ table.t[1][(crc >> 8) & 0xff] ^
+         table.t[2][(crc >> 16) & 0xff] ^ table.t[3][crc >> 24];
+}
+
+CRC32C_TARGET_PCLMUL inline uint32_t clmul_shift(uint32_t k, uint32_t crc) {
+  __m128i product = _mm_clmulepi64_si128(_mm_cvtsi32_si128(crc),
+                                         _mm_cvtsi32_si128(k), 0x00);
+  return _mm_crc32_u64(0, _mm_cvtsi128_si64(product));
+}
+
+inline uint64_t load64(const uint8_t* p) {
+  uint64_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+struct Partial {
+  uint32_t crc0;
+  uint32_t crc1;
+  uint32_t crc2;
+};
+
+CRC32C_TARGET_SSE42 inline Partial crc_3way(uint32_t crc, const uint8_t* p,
+                                            std::size_t block) {
+  uint64_t crc0 = crc;
+  uint64_t crc1 = 0;
+  uint64_t crc2 = 0;
+  for (std::size_t i = 0; i < block; i += 8) {
+    crc0 = _mm_crc32_u64(crc0, load64(p + i));
+    crc1 = _mm_crc32_u64(crc1, load64(p + block + i));
+    crc2 = _mm_crc32_u64(crc2, load64(p + 2 * block + i));
+  }
+  return {static_cast<uint32_t>(crc0), static_cast<uint32_t>(crc1),
+          static_cast<uint32_t>(crc2)};
+}
+
+// 先逐字节处理到8字节对齐，避免之后的读取跨越cache line
+CRC32C_TARGET_SSE42 inline uint32_t crc_head(uint32_t crc, const uint8_t** p,
+                                             std::size_t* length) {
+  while (*length > 0 && (reinterpret_cast<uintptr_t>(*p) & 7)) {
+    crc = _mm_crc32_u8(crc, *(*p)++);
+    --*length;
+  }
+  return crc;
+}
+
+CRC32C_TARGET_SSE42 inline uint32_t crc_tail(uint32_t crc, const uint8_t* p,
+                                             std::size_t length) {
+  uint64_t crc64 = crc;
+  for (; length >= 8; p += 8, length -= 8)
+    crc64 = _mm_crc32_u64(crc64, load64(p));
+  crc = static_cast<uint32_t>(crc64);
+  while (length--) crc = _mm_crc32_u8(crc, *p++);
+  return crc;
+}
+
+}  // namespace
+
+CRC32C_TARGET_SSE42 uint32_t update_sse42(uint32_t state, const uint8_t* data,
+                                          std::size_t length) {
+  uint32_t crc = crc_head(state, &data, &length);
+  for (; length >= 3 * kLongBlock;
+       data += 3 * kLongBlock, length -= 3 * kLongBlock) {
+    auto r = crc_3way(crc, data, kLongBlock);
+    crc = table_shift(kLongShift, table_shift(kLongShift, r.crc0) ^ r.crc1) ^
+          r.crc2;
+  }
+  for (; length >= 3 * kShortBlock;
+       data += 3 * kShortBlock, length -= 3 * kShortBlock) {
+    auto r = crc_3way(crc, data, kShortBlock);
+    crc = table_shift(kShortShift, table_shift(kShortShift, r.crc0) ^ r.crc1) ^
+          r.crc2;
+  }
+  return crc_tail(crc, data, length);
+}
+
+CRC32C_TARGET_PCLMUL uint32_t update_sse42_pclmul(uint32_t state,
+                                                  const uint8_t* data,
+                                                  std::size_t length) {
+  uint32_t crc = crc_head(state, &data, &length);
+  for (; length >= 3 * kLongBlock;
+       data += 3 * kLongBlock, length -= 3 * kLongBlock) {
+    auto r = crc_3way(crc, data, kLongBlock);
+    crc = clmul_shift(kLongClmulK, clmul_shift(kLongClmulK, r.crc0) ^ r.crc1) ^
+          r.crc2;
+  }
+  for (; length >= 3 * kShortBlock;
+       data += 3 * kShortBlock, length -= 3 * kShortBlock) {
+    auto r = crc_3way(crc, data, kShortBlock);
+    crc = clmul_shift(kShortClmulK,
+                      clmul_shift(kShortClmulK, r.crc0) ^ r.crc1) ^
+          r.crc2;
+  }
+  return crc_tail(crc, data, length);
+}
+
+bool cpu_has_sse42() {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("sse4.2");
+}
+
+bool cpu_has_pclmul() {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("pclmul");
+}
+
+}  // namespace crc32c_detail
+
+#else  // !defined(__x86_64__)
+
+// 其他平台上只有slicing-by-8，这两个函数不会被选中
+namespace crc32c_detail {
+
+uint32_t update_sse42(uint32_t state, const uint8_t* data, std::size_t length) {
+  return update_slicing8(state, data, length);
+}
+
+uint32_t update_sse42_pclmul(uint32_t state, const uint8_t* data,
+                             std::size_t length) {
+  return update_slicing8(state, data, length);
+}
+
+bool cpu_has_sse42() { return false; }
+
+bool cpu_has_pclmul() { return false; }
+
+}  // namespace crc32c_detail
+
+#endif  // defined(__x86_64__)
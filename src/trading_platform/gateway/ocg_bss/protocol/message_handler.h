@@ -3,6 +3,7 @@
 #ifndef OCG_BSS_MESSAGE_HANDLER_H_
 #define OCG_BSS_MESSAGE_HANDLER_H_
 
+#include "protocol/message_view.h"
 #include "protocol/protocol.h"
 
 namespace ft::bss {
@@ -29,8 +30,9 @@ class MessageHandler {
   virtual void on_business_reject_msg(MessageHeader* header,
                                       BusinessRejectMessage* msg) {}
 
+  // 字段从接收缓冲区中原地读取，只在回调期间有效
   virtual void on_execution_report(MessageHeader* header,
-                                   ExecutionReport* msg) {}
+                                   ExecutionReportView* msg) {}
 
   virtual void on_mass_cancel_report(MessageHeader* header,
                                      OrderMassCancelReport* msg) {}
@@ -0,0 +1,545 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef OCG_BSS_PROTOCOL_MESSAGE_SCHEMA_H_
+#define OCG_BSS_PROTOCOL_MESSAGE_SCHEMA_H_
+
+#include <array>
+#include <cstdint>
+#include <type_traits>
+
+#include "protocol/protocol.h"
+
+namespace ft::bss {
+
+/*
+ * OCG消息的字段表
+ *
+ * 每种消息按序号列出消息体中的字段及其出现规则，BSS及虚拟OCG的编码器
+ * (protocol_encoder.h)和解析器(protocol_parser.h)都由字段表在编译期展开，
+ * 不再为每种消息手写presence bitmap的处理，两端的格式也就不会不一致。
+ * BSS发送的消息的编码结果与原先手写的编码器逐字节相同，由
+ * test/encoder_check.cpp交叉验证
+ *
+ * 出现规则：
+ *   Required        编码时总是写入，解析时不检查bitmap
+ *   Optional<Pred>  Pred为真时才写入，解析时按bitmap判断。Optional<Always>
+ *                   表示本端总是发送，但对端可能不带
+ * 总是写入的字段的bit在编译期合并成kPresenceBitmap，编码时只需要逐个
+ * 判断真正可选的字段
+ *
+ * ExecutionReport的格式由ExecType决定，不在这里描述，见ExecutionReportView
+ */
+
+// 数值为0或字符串为空都视为字段不存在
+template <class T>
+constexpr bool is_empty_field(const T& value) {
+  if constexpr (std::is_arithmetic_v<T>) {
+    return value == 0;
+  } else if constexpr (std::is_array_v<T>) {
+    return value[0] == 0;
+  } else {
+    return value.len == 0;
+  }
+}
+
+struct NonEmpty {
+  template <class Message, class T>
+  static bool test(const Message&, const T& value) {
+    return !is_empty_field(value);
+  }
+};
+
+struct Always {
+  template <class Message, class T>
+  static constexpr bool test(const Message&, const T&) {
+    return true;
+  }
+};
+
+struct Required {
+  template <class Message, class T>
+  static constexpr bool test(const Message&, const T&) {
+    return true;
+  }
+};
+
+template <class Pred = NonEmpty>
+struct Optional {
+  template <class Message, class T>
+  static bool test(const Message& msg, const T& value) {
+    return Pred::test(msg, value);
+  }
+};
+
+template <uint32_t Index, auto Member, class Rule = Required>
+struct Field {
+  static constexpr uint32_t kIndex = Index;
+  static constexpr auto kMember = Member;
+  // 解析时不检查bitmap
+  static constexpr bool kRequired = std::is_same_v<Rule, Required>;
+  // 编码时总是写入
+  static constexpr bool kFixed =
+      kRequired || std::is_same_v<Rule, Optional<Always>>;
+
+  template <class Message, class T>
+  static bool test(const Message& msg, const T& value) {
+    return Rule::test(msg, value);
+  }
+};
+
+template <OcgMessageType Type, class... Fields>
+struct Schema {
+  static constexpr OcgMessageType kType = Type;
+
+  // 按序号从小到大回调func(Field{})，编译期完全展开
+  template <class Func>
+  static void for_each_field(Func&& func) {
+    (func(Fields{}), ...);
+  }
+
+  // 总是写入的字段再加上Extra中的字段
+  template <uint32_t... Extra>
+  static constexpr auto make_bitmap() {
+    std::array<uint8_t, sizeof(PresenceBitmap)> bitmap{};
+    auto set = [&bitmap](uint32_t i) {
+      bitmap[i >> 3] |= static_cast<uint8_t>(0b10000000U >> (i & 0x7U));
+    };
+    ((Fields::kFixed ? set(Fields::kIndex) : void()), ...);
+    (set(Extra), ...);
+    return bitmap;
+  }
+
+  template <uint32_t I>
+  static constexpr bool is_optional() {
+    return ((Fields::kIndex == I && !Fields::kFixed) || ...);
+  }
+
+  static constexpr bool is_ordered() {
+    uint32_t indices[] = {Fields::kIndex...};
+    for (std::size_t i = 1; i < sizeof...(Fields); ++i) {
+      if (indices[i - 1] >= indices[i]) return false;
+    }
+    return indices[sizeof...(Fields) - 1] < sizeof(PresenceBitmap) * 8;
+  }
+};
+
+// 编译期算好的presence bitmap，Extra为额外出现的可选字段
+template <class MsgSchema, uint32_t... Extra>
+inline constexpr auto kPresenceBitmap =
+    MsgSchema::template make_bitmap<Extra...>();
+
+/*
+ * 可选字段在编译期就确定的消息，Present为会出现的可选字段的序号
+ *
+ * 编码时presence bitmap整个是常量，不再逐个判断可选字段，用于发送量最大的
+ * 几种固定格式的消息。字段的值与Present不符时assert失败
+ */
+template <class Message, uint32_t... Present>
+struct FixedShape {
+  const Message& msg;
+};
+
+template <class Message>
+struct MessageSchema;
+
+// 以下为各消息的出现条件
+
+struct IsLimitOrder {
+  template <class Message, class T>
+  static bool test(const Message& msg, const T&) {
+    return msg.order_type == ORDER_TYPE_LIMIT;
+  }
+};
+
+struct IsBoardLot {
+  template <class Message, class T>
+  static bool test(const Message& msg, const T& value) {
+    return msg.lot_type == LOT_TYPE_BOARD && !is_empty_field(value);
+  }
+};
+
+struct IsOddLot {
+  template <class Message, class T>
+  static bool test(const Message& msg, const T&) {
+    return msg.lot_type == LOT_TYPE_ODD_SPEC;
+  }
+};
+
+struct IsLookupAccepted {
+  template <class Message, class T>
+  static bool test(const Message& msg, const T&) {
+    return msg.status == LOOKUP_SERVICE_ACCEPTED;
+  }
+};
+
+struct IsLookupRejected {
+  template <class Message, class T>
+  static bool test(const Message& msg, const T&) {
+    return msg.status != LOOKUP_SERVICE_ACCEPTED;
+  }
+};
+
+// TradeReportTransType: 0 = new, 5 = cancel
+struct IsNewTrade {
+  template <class Message, class T>
+  static bool test(const Message& msg, const T&) {
+    return msg.trade_report_trans_type == 0;
+  }
+};
+
+struct IsNewTradeNonEmpty {
+  template <class Message, class T>
+  static bool test(const Message& msg, const T& value) {
+    return msg.trade_report_trans_type == 0 && !is_empty_field(value);
+  }
+};
+
+struct IsTradeCancel {
+  template <class Message, class T>
+  static bool test(const Message& msg, const T&) {
+    return msg.trade_report_trans_type == 5;
+  }
+};
+
+template <>
+struct MessageSchema<LookupRequest>
+    : Schema<LOOKUP_REQUEST,
+             Field<0, &LookupRequest::type_of_service>,
+             Field<1, &LookupRequest::protocol_type>> {};
+
+template <>
+struct MessageSchema<LookupResponse>
+    : Schema<LOOKUP_RESPONSE,
+             Field<0, &LookupResponse::status>,
+             Field<1, &LookupResponse::lookup_reject_code,
+                   Optional<IsLookupRejected>>,
+             Field<2, &LookupResponse::reason, Optional<>>,
+             Field<3, &LookupResponse::primary_ip, Optional<IsLookupAccepted>>,
+             Field<4, &LookupResponse::primary_port,
+                   Optional<IsLookupAccepted>>,
+             Field<5, &LookupResponse::secondary_ip,
+                   Optional<IsLookupAccepted>>,
+             Field<6, &LookupResponse::secondary_port,
+                   Optional<IsLookupAccepted>>> {};
+
+template <>
+struct MessageSchema<LogonMessage>
+    : Schema<LOGON,
+             Field<0, &LogonMessage::password, Optional<Always>>,
+             Field<1, &LogonMessage::new_password, Optional<>>,
+             Field<2, &LogonMessage::next_expected_message_sequence>,
+             Field<3, &LogonMessage::session_status, Optional<>>,
+             Field<4, &LogonMessage::text, Optional<>>,
+             Field<5, &LogonMessage::test_message_indicator, Optional<>>> {};
+
+template <>
+struct MessageSchema<LogoutMessage>
+    : Schema<LOGOUT,
+             Field<0, &LogoutMessage::logout_text, Optional<>>,
+             Field<1, &LogoutMessage::session_status, Optional<Always>>> {};
+
+template <>
+struct MessageSchema<HeartbeatMessage>
+    : Schema<HEARTBEAT,
+             Field<0, &HeartbeatMessage::reference_test_request_id,
+                   Optional<>>> {};
+
+template <>
+struct MessageSchema<TestRequest>
+    : Schema<TEST_REQUEST, Field<0, &TestRequest::test_request_id>> {};
+
+template <>
+struct MessageSchema<ResendRequest>
+    : Schema<RESEND_REQUEST,
+             Field<0, &ResendRequest::start_sequence>,
+             Field<1, &ResendRequest::end_sequence>> {};
+
+template <>
+struct MessageSchema<RejectMessage>
+    : Schema<REJECT,
+             Field<0, &RejectMessage::message_reject_code>,
+             Field<1, &RejectMessage::reason, Optional<>>,
+             Field<2, &RejectMessage::reference_message_type,
+                   Optional<Always>>,
+             Field<3, &RejectMessage::reference_field_name, Optional<>>,
+             Field<4, &RejectMessage::reference_sequence_number>,
+             Field<5, &RejectMessage::client_order_id, Optional<>>> {};
+
+template <>
+struct MessageSchema<SequenceResetMessage>
+    : Schema<SEQUENCE_RESET,
+             Field<0, &SequenceResetMessage::gap_fill, Optional<Always>>,
+             Field<1, &SequenceResetMessage::new_sequence_number>> {};
+
+template <>
+struct MessageSchema<BusinessRejectMessage>
+    : Schema<BUSINESS_MESSAGE_REJECT,
+             Field<0, &BusinessRejectMessage::business_reject_code>,
+             Field<1, &BusinessRejectMessage::reason, Optional<>>,
+             Field<2, &BusinessRejectMessage::reference_message_type>,
+             Field<3, &BusinessRejectMessage::reference_field_name,
+                   Optional<>>,
+             Field<4, &BusinessRejectMessage::reference_sequence_number,
+                   Optional<>>,
+             Field<5, &BusinessRejectMessage::business_reject_reference_id,
+                   Optional<>>> {};
+
+template <>
+struct MessageSchema<PartyEntitlementRequest>
+    : Schema<PARTY_ENTITLEMENTS_REQUEST,
+             Field<0, &PartyEntitlementRequest::entitlement_request_id>> {};
+
+template <>
+struct MessageSchema<NewOrderRequest>
+    : Schema<NEW_ORDER,
+             Field<0, &NewOrderRequest::client_order_id>,
+             Field<1, &NewOrderRequest::submitting_broker_id>,
+             Field<2, &NewOrderRequest::security_id>,
+             Field<3, &NewOrderRequest::security_id_source>,
+             Field<4, &NewOrderRequest::security_exchange, Optional<>>,
+             Field<5, &NewOrderRequest::broker_location_id, Optional<>>,
+             Field<6, &NewOrderRequest::transaction_time>,
+             Field<7, &NewOrderRequest::side>,
+             Field<8, &NewOrderRequest::order_type>,
+             Field<9, &NewOrderRequest::price, Optional<IsLimitOrder>>,
+             Field<10, &NewOrderRequest::order_quantity>,
+             Field<11, &NewOrderRequest::tif>,
+             Field<12, &NewOrderRequest::position_effect, Optional<>>,
+             Field<13, &NewOrderRequest::order_restrictions,
+                   Optional<IsBoardLot>>,
+             Field<14, &NewOrderRequest::max_price_levels,
+                   Optional<IsBoardLot>>,
+             Field<15, &NewOrderRequest::order_capacity, Optional<>>,
+             Field<16, &NewOrderRequest::text, Optional<>>,
+             Field<17, &NewOrderRequest::execution_instructions, Optional<>>,
+             Field<18, &NewOrderRequest::disclosure_instructions>,
+             Field<19, &NewOrderRequest::lot_type, Optional<IsOddLot>>> {};
+
+// 报单量最大的两种限价单，除SecurityExchange及Price外只可能带MaxPriceLevels
+using LimitOrder = FixedShape<NewOrderRequest, 4, 9>;
+using LevelLimitOrder = FixedShape<NewOrderRequest, 4, 9, 14>;
+
+template <>
+struct MessageSchema<AmendRequest>
+    : Schema<AMEND_REQUEST,
+             Field<0, &AmendRequest::client_order_id>,
+             Field<1, &AmendRequest::submitting_broker_id>,
+             Field<2, &AmendRequest::security_id>,
+             Field<3, &AmendRequest::security_id_source>,
+             Field<4, &AmendRequest::security_exchange, Optional<>>,
+             Field<5, &AmendRequest::broker_location_id, Optional<>>,
+             Field<6, &AmendRequest::transaction_time>,
+             Field<7, &AmendRequest::side>,
+             Field<8, &AmendRequest::original_client_order_id>,
+             Field<9, &AmendRequest::order_id, Optional<>>,
+             Field<10, &AmendRequest::order_type>,
+             Field<11, &AmendRequest::price, Optional<IsLimitOrder>>,
+             Field<12, &AmendRequest::order_quantity>,
+             Field<13, &AmendRequest::tif>,
+             Field<14, &AmendRequest::position_effect, Optional<>>,
+             Field<15, &AmendRequest::order_restrictions, Optional<>>,
+             Field<16, &AmendRequest::max_price_levels, Optional<>>,
+             Field<17, &AmendRequest::order_capacity, Optional<>>,
+             Field<18, &AmendRequest::text, Optional<>>,
+             Field<19, &AmendRequest::execution_instructions, Optional<>>,
+             Field<20, &AmendRequest::disclosure_instructions>> {};
+
+template <>
+struct MessageSchema<CancelRequest>
+    : Schema<CANCEL_REQUEST,
+             Field<0, &CancelRequest::client_order_id>,
+             Field<1, &CancelRequest::submitting_broker_id>,
+             Field<2, &CancelRequest::security_id>,
+             Field<3, &CancelRequest::security_id_source>,
+             Field<4, &CancelRequest::security_exchange, Optional<>>,
+             Field<5, &CancelRequest::broker_location_id, Optional<>>,
+             Field<6, &CancelRequest::transaction_time>,
+             Field<7, &CancelRequest::side>,
+             Field<8, &CancelRequest::original_client_order_id>,
+             Field<9, &CancelRequest::order_id, Optional<>>,
+             Field<10, &CancelRequest::text, Optional<>>> {};
+
+template <>
+struct MessageSchema<MassCancelRequest>
+    : Schema<MASS_CANCEL_REQUEST,
+             Field<0, &MassCancelRequest::client_order_id>,
+             Field<1, &MassCancelRequest::submitting_broker_id>,
+             Field<2, &MassCancelRequest::security_id, Optional<>>,
+             Field<3, &MassCancelRequest::security_id_source, Optional<>>,
+             Field<4, &MassCancelRequest::security_exchange, Optional<>>,
+             Field<5, &MassCancelRequest::broker_location_id, Optional<>>,
+             Field<6, &MassCancelRequest::transaction_time>,
+             Field<7, &MassCancelRequest::side, Optional<>>,
+             Field<8, &MassCancelRequest::mass_cancel_request_type>,
+             Field<9, &MassCancelRequest::market_segment_id, Optional<>>> {};
+
+template <>
+struct MessageSchema<OboCancelRequest>
+    : Schema<OBO_CANCEL_REQUEST,
+             Field<0, &OboCancelRequest::client_order_id>,
+             Field<1, &OboCancelRequest::submitting_broker_id>,
+             Field<2, &OboCancelRequest::security_id>,
+             Field<3, &OboCancelRequest::security_id_source>,
+             Field<4, &OboCancelRequest::security_exchange, Optional<>>,
+             Field<5, &OboCancelRequest::broker_location_id, Optional<>>,
+             Field<6, &OboCancelRequest::transaction_time>,
+             Field<7, &OboCancelRequest::side>,
+             Field<8, &OboCancelRequest::original_client_order_id,
+                   Optional<>>,
+             Field<9, &OboCancelRequest::order_id>,
+             Field<10, &OboCancelRequest::owning_broker_id>,
+             Field<11, &OboCancelRequest::text, Optional<>>> {};
+
+template <>
+struct MessageSchema<OboMassCancelRequest>
+    : Schema<OBO_MASS_CANCEL_REQUEST,
+             Field<0, &OboMassCancelRequest::client_order_id>,
+             Field<1, &OboMassCancelRequest::submitting_broker_id>,
+             Field<2, &OboMassCancelRequest::security_id, Optional<>>,
+             Field<3, &OboMassCancelRequest::security_id_source, Optional<>>,
+             Field<4, &OboMassCancelRequest::security_exchange, Optional<>>,
+             Field<5, &OboMassCancelRequest::broker_location_id, Optional<>>,
+             Field<6, &OboMassCancelRequest::transaction_time>,
+             Field<7, &OboMassCancelRequest::side, Optional<>>,
+             Field<8, &OboMassCancelRequest::mass_cancel_request_type>,
+             Field<9, &OboMassCancelRequest::market_segment_id, Optional<>>,
+             Field<10, &OboMassCancelRequest::owning_broker_id>> {};
+
+template <>
+struct MessageSchema<OrderMassCancelReport>
+    : Schema<ORDER_MASS_CANCEL_REPORT,
+             Field<0, &OrderMassCancelReport::client_order_id, Optional<>>,
+             Field<1, &OrderMassCancelReport::submitting_broker_id,
+                   Optional<>>,
+             Field<2, &OrderMassCancelReport::security_id, Optional<>>,
+             Field<3, &OrderMassCancelReport::security_id_source, Optional<>>,
+             Field<4, &OrderMassCancelReport::security_exchange, Optional<>>,
+             Field<5, &OrderMassCancelReport::broker_location_id, Optional<>>,
+             Field<6, &OrderMassCancelReport::transaction_time>,
+             Field<7, &OrderMassCancelReport::mass_cancel_request_type>,
+             Field<8, &OrderMassCancelReport::owning_broker_id, Optional<>>,
+             Field<9, &OrderMassCancelReport::mass_action_report_id>,
+             Field<10, &OrderMassCancelReport::mass_cancel_response>,
+             Field<11, &OrderMassCancelReport::mass_cancel_reject_code,
+                   Optional<>>,
+             Field<12, &OrderMassCancelReport::reason, Optional<>>> {};
+
+template <>
+struct MessageSchema<TradeCaptureReport>
+    : Schema<TRADE_CAPTURE_REPORT,
+             Field<0, &TradeCaptureReport::trade_report_id, Optional<Always>>,
+             Field<1, &TradeCaptureReport::trade_report_trans_type,
+                   Optional<Always>>,
+             Field<2, &TradeCaptureReport::trade_report_type>,
+             Field<3, &TradeCaptureReport::trade_handling_instructions,
+                   Optional<>>,
+             Field<4, &TradeCaptureReport::submitting_broker_id>,
+             Field<5, &TradeCaptureReport::counterparty_broker_id,
+                   Optional<IsNewTradeNonEmpty>>,
+             Field<6, &TradeCaptureReport::broker_location_id, Optional<>>,
+             Field<7, &TradeCaptureReport::security_id>,
+             Field<8, &TradeCaptureReport::security_id_source>,
+             Field<9, &TradeCaptureReport::security_exchange, Optional<>>,
+             Field<10, &TradeCaptureReport::side>,
+             Field<11, &TradeCaptureReport::transaction_time>,
+             Field<12, &TradeCaptureReport::trade_id, Optional<IsTradeCancel>>,
+             Field<13, &TradeCaptureReport::trade_type, Optional<IsNewTrade>>,
+             Field<14, &TradeCaptureReport::execution_quantity>,
+             Field<15, &TradeCaptureReport::execution_price>,
+             Field<16, &TradeCaptureReport::clearing_instruction,
+                   Optional<IsNewTrade>>,
+             Field<17, &TradeCaptureReport::position_effect,
+                   Optional<IsNewTradeNonEmpty>>,
+             Field<19, &TradeCaptureReport::order_capacity,
+                   Optional<IsNewTradeNonEmpty>>,
+             Field<20, &TradeCaptureReport::order_category,
+                   Optional<IsNewTradeNonEmpty>>,
+             Field<21, &TradeCaptureReport::text,
+                   Optional<IsNewTradeNonEmpty>>,
+             Field<22, &TradeCaptureReport::execution_instructions,
+                   Optional<IsNewTradeNonEmpty>>,
+             Field<23, &TradeCaptureReport::exec_type, Optional<>>,
+             Field<24, &TradeCaptureReport::trade_report_status, Optional<>>,
+             Field<25, &TradeCaptureReport::exchange_trade_type, Optional<>>,
+             Field<27, &TradeCaptureReport::order_id,
+                   Optional<IsNewTradeNonEmpty>>> {};
+
+template <>
+struct MessageSchema<TradeCaptureReportAck>
+    : Schema<TRADE_CAPTURE_REPORT_ACK,
+             Field<0, &TradeCaptureReportAck::trade_report_id>,
+             Field<1, &TradeCaptureReportAck::trade_report_trans_type,
+                   Optional<Always>>,
+             Field<2, &TradeCaptureReportAck::trade_report_type>,
+             Field<3, &TradeCaptureReportAck::trade_handling_instructions,
+                   Optional<>>,
+             Field<4, &TradeCaptureReportAck::submitting_broker_id>,
+             Field<5, &TradeCaptureReportAck::counterparty_broker_id,
+                   Optional<>>,
+             Field<6, &TradeCaptureReportAck::broker_location_id, Optional<>>,
+             Field<7, &TradeCaptureReportAck::security_id>,
+             Field<8, &TradeCaptureReportAck::security_id_source>,
+             Field<9, &TradeCaptureReportAck::security_exchange, Optional<>>,
+             Field<10, &TradeCaptureReportAck::side>,
+             Field<11, &TradeCaptureReportAck::transaction_time>,
+             Field<12, &TradeCaptureReportAck::trade_id, Optional<>>,
+             Field<13, &TradeCaptureReportAck::trade_report_status,
+                   Optional<>>,
+             Field<14, &TradeCaptureReportAck::trade_report_reject_code,
+                   Optional<>>,
+             Field<15, &TradeCaptureReportAck::reason, Optional<>>> {};
+
+template <>
+struct MessageSchema<QuoteRequest>
+    : Schema<QUOTE,
+             Field<0, &QuoteRequest::submitting_broker_id>,
+             Field<1, &QuoteRequest::broker_location_id, Optional<>>,
+             Field<2, &QuoteRequest::security_id>,
+             Field<3, &QuoteRequest::security_id_source>,
+             Field<4, &QuoteRequest::security_exchange, Optional<>>,
+             Field<5, &QuoteRequest::quote_bid_id>,
+             Field<6, &QuoteRequest::quote_offer_id>,
+             Field<7, &QuoteRequest::quote_type, Optional<>>,
+             Field<8, &QuoteRequest::side, Optional<>>,
+             Field<9, &QuoteRequest::bid_size>,
+             Field<10, &QuoteRequest::offer_size>,
+             Field<11, &QuoteRequest::bid_price>,
+             Field<12, &QuoteRequest::offer_price>,
+             Field<13, &QuoteRequest::transaction_time>,
+             Field<14, &QuoteRequest::position_effect, Optional<>>,
+             Field<15, &QuoteRequest::order_restrictions, Optional<>>,
+             Field<16, &QuoteRequest::text, Optional<>>,
+             Field<17, &QuoteRequest::execution_instructions, Optional<>>> {};
+
+template <>
+struct MessageSchema<QuoteCancelRequest>
+    : Schema<QUOTE_CANCEL,
+             Field<0, &QuoteCancelRequest::submitting_broker_id>,
+             Field<1, &QuoteCancelRequest::broker_location_id, Optional<>>,
+             Field<2, &QuoteCancelRequest::security_id, Optional<>>,
+             Field<3, &QuoteCancelRequest::security_id_source, Optional<>>,
+             Field<4, &QuoteCancelRequest::security_exchange, Optional<>>,
+             Field<5, &QuoteCancelRequest::quote_message_id>,
+             Field<6, &QuoteCancelRequest::quote_cancel_type>> {};
+
+template <>
+struct MessageSchema<QuoteStatusReport>
+    : Schema<QUOTE_STATUS_REPORT,
+             Field<0, &QuoteStatusReport::submitting_broker_id>,
+             Field<1, &QuoteStatusReport::broker_location_id, Optional<>>,
+             Field<2, &QuoteStatusReport::security_id, Optional<>>,
+             Field<3, &QuoteStatusReport::security_id_source, Optional<>>,
+             Field<4, &QuoteStatusReport::security_exchange, Optional<>>,
+             Field<5, &QuoteStatusReport::quote_bid_id, Optional<>>,
+             Field<6, &QuoteStatusReport::quote_offer_id, Optional<>>,
+             Field<7, &QuoteStatusReport::quote_type, Optional<>>,
+             Field<8, &QuoteStatusReport::transaction_time>,
+             Field<9, &QuoteStatusReport::quote_message_id, Optional<>>,
+             Field<10, &QuoteStatusReport::quote_cancel_type, Optional<>>,
+             Field<11, &QuoteStatusReport::quote_status, Optional<>>,
+             Field<12, &QuoteStatusReport::quote_reject_code, Optional<>>,
+             Field<13, &QuoteStatusReport::reason, Optional<>>> {};
+
+}  // namespace ft::bss
+
+#endif  // OCG_BSS_PROTOCOL_MESSAGE_SCHEMA_H_
@@ -0,0 +1,133 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#include "protocol/message_view.h"
+
+#include "protocol/protocol_parser.h"
+
+namespace ft::bss {
+
+const char* ExecutionReportView::init(const MessageHeader* header) {
+  reset(header);
+  const auto& bitmap = header->body_fields_presence_map;
+  auto p = body();
+
+  p = mark<OrderId>(0, p);
+  p = mark<BrokerId>(1, p);
+  p = mark<SecurityId>(2, p);
+  p = mark<SecurityIdSource>(3, p);
+  if (is_present(bitmap, 4)) p = mark<SecurityExchange>(4, p);
+  if (is_present(bitmap, 5)) p = mark<BrokerLocationId>(5, p);
+  p = mark<TransactionTime>(6, p);
+  p = mark<Side>(7, p);
+  if (is_present(bitmap, 8)) p = mark<OrderId>(8, p);
+  p = mark<OrderId>(9, p);
+  if (is_present(bitmap, 10)) p = mark<BrokerId>(10, p);
+  if (is_present(bitmap, 11)) p = mark<OrderType>(11, p);
+  if (is_present(bitmap, 12)) p = mark<Price>(12, p);
+  if (is_present(bitmap, 13)) p = mark<Quantity>(13, p);
+  if (is_present(bitmap, 14)) p = mark<Tif>(14, p);
+  if (is_present(bitmap, 15)) p = mark<PositionEffect>(15, p);
+  if (is_present(bitmap, 16)) p = mark<OrderRestrictions>(16, p);
+  if (is_present(bitmap, 17)) p = mark<MaxPriceLevels>(17, p);
+  if (is_present(bitmap, 18)) p = mark<OrderCapacity>(18, p);
+  if (is_present(bitmap, 19)) p = mark<Text>(19, p);
+  if (is_present(bitmap, 20)) p = mark<Reason>(20, p);
+  p = mark<ExecutionId>(21, p);
+  p = mark<OrderStatus>(22, p);
+  p = mark<ExecType>(23, p);
+  p = mark<Quantity>(24, p);
+  p = mark<Quantity>(25, p);
+
+  // 后面的字段由ExecType决定
+  switch (exec_type()) {
+    case EXEC_TYPE_NEW:
+      if (is_present(bitmap, 27)) p = mark<LotType>(27, p);
+      break;
+    case EXEC_TYPE_CANCEL:
+      if (is_present(bitmap, 28)) p = mark<ExecRestatementReason>(28, p);
+      break;
+    case EXEC_TYPE_AMEND:
+      break;
+    case EXEC_TYPE_REJECT:
+      if (is_present(bitmap, 26)) p = mark<RejectCode>(26, p);
+      break;
+    case EXEC_TYPE_EXPIRE:
+      break;
+    case EXEC_TYPE_TRADE:
+      if (is_present(bitmap, 27)) p = mark<LotType>(27, p);
+      if (is_present(bitmap, 30)) p = mark<MatchType>(30, p);
+      if (is_present(bitmap, 31)) p = mark<BrokerId>(31, p);
+      p = mark<Quantity>(32, p);
+      p = mark<Price>(33, p);
+      if (is_present(bitmap, 34)) p = mark<ExecutionId>(34, p);
+      if (is_present(bitmap, 35)) p = mark<OrderCategory>(35, p);
+      if (is_present(bitmap, 38)) p = mark<TradeMatchId>(38, p);
+      if (is_present(bitmap, 39)) p = mark<ExchangeTradeType>(39, p);
+      break;
+    case EXEC_TYPE_TRADE_CANCEL:
+      if (is_present(bitmap, 28)) p = mark<ExecRestatementReason>(28, p);
+      if (is_present(bitmap, 30)) p = mark<Quantity>(32, p);
+      if (is_present(bitmap, 31)) p = mark<Price>(33, p);
+      p = mark<ExecutionId>(34, p);
+      if (is_present(bitmap, 35)) p = mark<OrderCategory>(35, p);
+      break;
+    case EXEC_TYPE_CANCEL_REJECT:
+      if (is_present(bitmap, 29)) p = mark<RejectCode>(29, p);
+      break;
+    case EXEC_TYPE_AMEND_REJECT:
+      if (is_present(bitmap, 36)) p = mark<RejectCode>(36, p);
+      break;
+    default:
+      assert(false);
+  }
+
+  return p;
+}
+
+void ExecutionReportView::decode(ExecutionReport* report) const {
+  auto copy = [this](uint32_t i, auto& field) {
+    if (has(i)) ::ft::bss::decode(field_ptr(i), field);
+  };
+
+  copy(0, report->client_order_id);
+  copy(1, report->submitting_broker_id);
+  copy(2, report->security_id);
+  copy(3, report->security_id_source);
+  copy(4, report->security_exchange);
+  copy(5, report->broker_location_id);
+  copy(6, report->transaction_time);
+  copy(7, report->side);
+  copy(8, report->original_client_order_id);
+  copy(9, report->order_id);
+  copy(10, report->owning_broker_id);
+  copy(11, report->order_type);
+  copy(12, report->price);
+  copy(13, report->order_quantity);
+  copy(14, report->tif);
+  copy(15, report->position_effect);
+  copy(16, report->order_restrictions);
+  copy(17, report->max_price_levels);
+  copy(18, report->order_capacity);
+  copy(19, report->text);
+  copy(20, report->reason);
+  copy(21, report->execution_id);
+  copy(22, report->order_status);
+  copy(23, report->exec_type);
+  copy(24, report->cumulative_quantity);
+  copy(25, report->leaves_quantity);
+  copy(26, report->order_reject_code);
+  copy(27, report->lot_type);
+  copy(28, report->exec_restatement_reason);
+  copy(29, report->cancel_reject_code);
+  copy(30, report->match_type);
+  copy(31, report->counterparty_broker_id);
+  copy(32, report->execution_quantity);
+  copy(33, report->execution_price);
+  copy(34, report->reference_execution_id);
+  copy(35, report->order_category);
+  copy(36, report->amend_reject_code);
+  copy(38, report->trade_match_id);
+  copy(39, report->exchange_trade_type);
+}
+
+}  // namespace ft::bss
@@ -0,0 +1,163 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef OCG_BSS_PROTOCOL_MESSAGE_VIEW_H_
+#define OCG_BSS_PROTOCOL_MESSAGE_VIEW_H_
+
+#include <cstring>
+#include <string_view>
+#include <type_traits>
+
+#include "protocol/protocol.h"
+
+namespace ft::bss {
+
+template <class T>
+struct is_variable_length : std::false_type {};
+
+template <std::size_t N>
+struct is_variable_length<AlphanumericVariableLength<N>> : std::true_type {};
+
+template <class T>
+inline constexpr bool is_variable_length_v = is_variable_length<T>::value;
+
+/*
+ * 跳过一个字段，返回下一个字段的位置，格式与decode相同
+ */
+template <class Field>
+const char* skip_field(const char* p) {
+  if constexpr (is_variable_length_v<Field>) {
+    uint16_t len;
+    memcpy(&len, p, sizeof(len));
+    return p + sizeof(len) + len;
+  } else {
+    return p + sizeof(Field);
+  }
+}
+
+/*
+ * 从接收缓冲区中原地读取字段，定长字符串及变长字符串都返回string_view，
+ * 不要求以'\0'结尾
+ */
+template <class Field>
+auto read_field(const char* p) {
+  if constexpr (std::is_arithmetic_v<Field>) {
+    Field value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+  } else if constexpr (is_variable_length_v<Field>) {
+    uint16_t len;
+    memcpy(&len, p, sizeof(len));
+    p += sizeof(len);
+    return std::string_view(p, strnlen(p, len));
+  } else {
+    static_assert(std::is_array_v<Field>);
+    return std::string_view(p, strnlen(p, sizeof(Field)));
+  }
+}
+
+/*
+ * 消息的字段位置表，按presence bitmap扫描一次消息体后建立
+ *
+ * 位置是相对于MessageHeader起始处的偏移，消息体在消息头之后，所以偏移为0
+ * 表示这个字段不存在。字段序号与protocol.h中结构体注释的序号一致
+ */
+template <std::size_t MaxFields>
+class MessageView {
+ public:
+  const MessageHeader* header() const { return header_; }
+
+  bool has(uint32_t i) const { return offsets_[i] != 0; }
+
+ protected:
+  void reset(const MessageHeader* header) { header_ = header; }
+
+  const char* body() const {
+    return reinterpret_cast<const char*>(header_ + 1);
+  }
+
+  template <class Field>
+  const char* mark(uint32_t i, const char* p) {
+    offsets_[i] =
+        static_cast<uint16_t>(p - reinterpret_cast<const char*>(header_));
+    return skip_field<Field>(p);
+  }
+
+  // 不存在的字段返回0或空串，与完整解码时值初始化的结果相同
+  template <class Field>
+  auto field(uint32_t i) const {
+    using Value = decltype(read_field<Field>(nullptr));
+    if (offsets_[i] == 0) return Value{};
+    return read_field<Field>(reinterpret_cast<const char*>(header_) +
+                             offsets_[i]);
+  }
+
+  const char* field_ptr(uint32_t i) const {
+    return offsets_[i] == 0
+               ? nullptr
+               : reinterpret_cast<const char*>(header_) + offsets_[i];
+  }
+
+ private:
+  const MessageHeader* header_ = nullptr;
+  uint16_t offsets_[MaxFields]{};
+};
+
+/*
+ * ExecutionReport的视图，是OCG发来的消息中数量最多的一种
+ *
+ * 不复制任何字段，访问时从接收缓冲区中原地读取。只在回调期间有效，需要
+ * 保留完整内容时用decode解码到ExecutionReport中
+ */
+class ExecutionReportView : public MessageView<40> {
+ public:
+  // 扫描消息体建立位置表，返回消息体结束的位置
+  const char* init(const MessageHeader* header);
+
+  void decode(ExecutionReport* report) const;
+
+  auto client_order_id() const { return field<OrderId>(0); }
+  auto submitting_broker_id() const { return field<BrokerId>(1); }
+  auto security_id() const { return field<SecurityId>(2); }
+  auto security_id_source() const { return field<SecurityIdSource>(3); }
+  auto security_exchange() const { return field<SecurityExchange>(4); }
+  auto broker_location_id() const { return field<BrokerLocationId>(5); }
+  auto transaction_time() const { return field<TransactionTime>(6); }
+  auto side() const { return field<Side>(7); }
+  auto original_client_order_id() const { return field<OrderId>(8); }
+  auto order_id() const { return field<OrderId>(9); }
+  auto owning_broker_id() const { return field<BrokerId>(10); }
+  auto order_type() const { return field<OrderType>(11); }
+  auto price() const { return field<Price>(12); }
+  auto order_quantity() const { return field<Quantity>(13); }
+  auto tif() const { return field<Tif>(14); }
+  auto position_effect() const { return field<PositionEffect>(15); }
+  auto order_restrictions() const { return field<OrderRestrictions>(16); }
+  auto max_price_levels() const { return field<MaxPriceLevels>(17); }
+  auto order_capacity() const { return field<OrderCapacity>(18); }
+  auto text() const { return field<Text>(19); }
+  auto reason() const { return field<Reason>(20); }
+  auto execution_id() const { return field<ExecutionId>(21); }
+  auto order_status() const { return field<OrderStatus>(22); }
+  auto exec_type() const { return field<ExecType>(23); }
+  auto cumulative_quantity() const { return field<Quantity>(24); }
+  auto leaves_quantity() const { return field<Quantity>(25); }
+  auto order_reject_code() const { return field<RejectCode>(26); }
+  auto lot_type() const { return field<LotType>(27); }
+  auto exec_restatement_reason() const {
+    return field<ExecRestatementReason>(28);
+  }
+  auto cancel_reject_code() const { return field<RejectCode>(29); }
+  auto match_type() const { return field<MatchType>(30); }
+  auto counterparty_broker_id() const { return field<BrokerId>(31); }
+  auto execution_quantity() const { return field<Quantity>(32); }
+  auto execution_price() const { return field<Price>(33); }
+  auto reference_execution_id() const { return field<ExecutionId>(34); }
+  auto order_category() const { return field<OrderCategory>(35); }
+  auto amend_reject_code() const { return field<RejectCode>(36); }
+  auto trade_match_id() const { return field<TradeMatchId>(38); }
+  auto exchange_trade_type() const { return field<ExchangeTradeType>(39); }
+};
+
+}  // namespace ft::bss
+
+#endif  // OCG_BSS_PROTOCOL_MESSAGE_VIEW_H_
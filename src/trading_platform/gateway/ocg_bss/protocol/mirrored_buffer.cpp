@@ -0,0 +1,47 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#include "protocol/mirrored_buffer.h"
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace ft::bss {
+
+MirroredBuffer::MirroredBuffer(std::size_t size) {
+  capacity_ = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+  while (capacity_ < size) capacity_ <<= 1;
+  mask_ = capacity_ - 1;
+
+  int fd = memfd_create("ocg_bss_recv", MFD_CLOEXEC);
+  if (fd < 0 || ftruncate(fd, capacity_) != 0) {
+    printf("[MirroredBuffer] failed to create memfd: %s\n", strerror(errno));
+    abort();
+  }
+
+  // 先保留两倍的地址空间，再把同一个文件映射到前后两半
+  auto addr = mmap(nullptr, capacity_ * 2, PROT_NONE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (addr == MAP_FAILED) {
+    printf("[MirroredBuffer] failed to reserve: %s\n", strerror(errno));
+    abort();
+  }
+  base_ = static_cast<char*>(addr);
+
+  for (int i = 0; i < 2; ++i) {
+    if (mmap(base_ + i * capacity_, capacity_, PROT_READ | PROT_WRITE,
+             MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED) {
+      printf("[MirroredBuffer] failed to map: %s\n", strerror(errno));
+      abort();
+    }
+  }
+  close(fd);
+}
+
+MirroredBuffer::~MirroredBuffer() { munmap(base_, capacity_ * 2); }
+
+}  // namespace ft::bss
@@ -0,0 +1,93 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef OCG_BSS_PROTOCOL_MIRRORED_BUFFER_H_
+#define OCG_BSS_PROTOCOL_MIRRORED_BUFFER_H_
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+namespace ft::bss {
+
+/*
+ * 接收用的环形缓冲区，同一块物理内存在虚拟地址上连续映射两次
+ *
+ *   | pages[0, capacity) | 同样的pages[0, capacity) |
+ *
+ * 从任意位置开始长度不超过capacity的区间在地址上都是连续的，所以跨过
+ * 缓冲区末尾的消息也能直接按结构体访问，recv也总能写满整个空闲区间，
+ * 不再需要把未读的数据搬回缓冲区开头
+ *
+ * 读写位置只增不减，取模后得到在缓冲区中的偏移。非线程安全
+ *
+ * 需要原地保留已读过的数据时调用retain，此后consume只移动读位置，从
+ * 保留位置开始的数据在release之前不会被新数据覆盖
+ */
+class MirroredBuffer {
+ public:
+  // 容量向上取整为页大小的2的幂，映射失败时abort
+  explicit MirroredBuffer(std::size_t size);
+
+  ~MirroredBuffer();
+
+  MirroredBuffer(const MirroredBuffer&) = delete;
+  MirroredBuffer& operator=(const MirroredBuffer&) = delete;
+
+  std::size_t capacity() const { return capacity_; }
+
+  std::size_t readable_size() const { return write_pos_ - read_pos_; }
+
+  std::size_t writable_size() const {
+    return capacity_ - (write_pos_ - free_pos());
+  }
+
+  uint64_t read_pos() const { return read_pos_; }
+
+  // pos为保留区间内的位置，即不早于保留位置且不晚于写位置
+  char* at(uint64_t pos) { return base_ + (pos & mask_); }
+
+  char* readable_start() { return base_ + (read_pos_ & mask_); }
+
+  char* writable_start() { return base_ + (write_pos_ & mask_); }
+
+  // 写入writable_start()后调用
+  void commit(std::size_t size) {
+    assert(size <= writable_size());
+    write_pos_ += size;
+  }
+
+  void consume(std::size_t size) {
+    assert(size <= readable_size());
+    read_pos_ += size;
+  }
+
+  // pos不能晚于当前的读位置，可以重复调用以推进保留位置
+  void retain(uint64_t pos) {
+    assert(pos <= read_pos_ && (!retained_ || pos >= retain_pos_));
+    retained_ = true;
+    retain_pos_ = pos;
+  }
+
+  void release() { retained_ = false; }
+
+  void clear() {
+    read_pos_ = 0;
+    write_pos_ = 0;
+    retained_ = false;
+  }
+
+ private:
+  uint64_t free_pos() const { return retained_ ? retain_pos_ : read_pos_; }
+
+  char* base_ = nullptr;
+  std::size_t capacity_ = 0;
+  std::size_t mask_ = 0;
+  uint64_t read_pos_ = 0;
+  uint64_t write_pos_ = 0;
+  uint64_t retain_pos_ = 0;
+  bool retained_ = false;
+};
+
+}  // namespace ft::bss
+
+#endif  // OCG_BSS_PROTOCOL_MIRRORED_BUFFER_H_
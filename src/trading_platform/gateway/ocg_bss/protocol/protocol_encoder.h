@@ -4,12 +4,14 @@
 #define OCG_BSS_PROTOCOL_ENCODER_H_
 
 #include <cassert>
+#include <cstddef>
 #include <cstring>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include "protocol/crc32c.h"
+#include "protocol/message_schema.h"
 #include "protocol/protocol.h"
 
 namespace ft::bss {
@@ -44,44 +46,54 @@ static_assert(kMsgBufSize >= kHeaderTrailerSize + sizeof(QuoteRequest));
 static_assert(kMsgBufSize >= kHeaderTrailerSize + sizeof(QuoteCancelRequest));
 static_assert(kMsgBufSize >= kHeaderTrailerSize + sizeof(QuoteRequest));
 
+inline void set_presence(PresenceBitmap bitmap, uint32_t i) {
+  assert(i < sizeof(PresenceBitmap) * 8);
+  bitmap[i >> 3] |= (0b10000000U >> (i & 0x7U));
+}
+
 class BinaryMessageEncoder {
  public:
   BinaryMessageEncoder();
 
-  void encode_msg(const LogonMessage& msg, MsgBuffer* buffer);
+  // 按MessageSchema中的字段表编码
+  template <class Message>
+  void encode_msg(const Message& msg, MsgBuffer* buffer) {
+    buffer->size = 0;
+    cur_msg_buf_ = buffer;
+    auto header = encode_header(MessageSchema<Message>::kType);
+    encode_body(msg, header);
+    fill_header_and_trailer();
+  }
 
-  void encode_msg(const LogoutMessage& msg, MsgBuffer* buffer);
+  // 可选字段在编译期确定，整个presence bitmap都是常量
+  template <class Message, uint32_t... Present>
+  void encode_msg(const FixedShape<Message, Present...>& shape,
+                  MsgBuffer* buffer) {
+    using Schema = MessageSchema<Message>;
+    static_assert((Schema::template is_optional<Present>() && ...),
+                  "Present must be optional fields of the message");
+    constexpr auto& kBitmap = kPresenceBitmap<Schema, Present...>;
+
+    buffer->size = 0;
+    cur_msg_buf_ = buffer;
+    auto header = encode_header(Schema::kType);
+    memcpy(header->body_fields_presence_map, kBitmap.data(),
+           sizeof(PresenceBitmap));
+    Schema::for_each_field([this, &shape](auto field) {
+      using F = decltype(field);
+      constexpr bool kPresent = F::kFixed || ((F::kIndex == Present) || ...);
+      const auto& value = shape.msg.*F::kMember;
+      assert(F::kFixed || F::test(shape.msg, value) == kPresent);
+      if constexpr (kPresent) encode(value);
+    });
+    fill_header_and_trailer();
+  }
 
+  // 以下几种消息编码前有额外的处理
   void encode_msg(const SequenceResetMessage& msg, MsgBuffer* buffer);
 
-  void encode_msg(const HeartbeatMessage& msg, MsgBuffer* buffer);
-
-  void encode_msg(const TestRequest& msg, MsgBuffer* buffer);
-
-  void encode_msg(const RejectMessage& msg, MsgBuffer* buffer);
-
-  void encode_msg(const ResendRequest& msg, MsgBuffer* buffer);
-
-  void encode_msg(const NewOrderRequest& req, MsgBuffer* buffer);
-
-  void encode_msg(const AmendRequest& req, MsgBuffer* buffer);
-
-  void encode_msg(const CancelRequest& req, MsgBuffer* buffer);
-
-  void encode_msg(const MassCancelRequest& req, MsgBuffer* buffer);
-
-  void encode_msg(const OboCancelRequest& req, MsgBuffer* buffer);
-
-  void encode_msg(const OboMassCancelRequest& req, MsgBuffer* buffer);
-
-  void encode_msg(const QuoteRequest& req, MsgBuffer* buffer);
-
-  void encode_msg(const QuoteCancelRequest& req, MsgBuffer* buffer);
-
   void encode_msg(const TradeCaptureReport& report, MsgBuffer* buffer);
 
-  void encode_msg(const PartyEntitlementRequest& req, MsgBuffer* buffer);
-
   void encode_msg(const LookupRequest& req, MsgBuffer* buffer);
 
   void set_comp_id(const std::string& comp_id) { comp_id_ = comp_id; }
@@ -95,11 +107,26 @@ class BinaryMessageEncoder {
   void set_poss_resend_flag(PossResendFlag flag) { poss_resend_flag_ = flag; }
 
  protected:
-  void encode_new_trade_capture_report(const TradeCaptureReport& report,
-                                       MsgBuffer* buffer);
-
-  void encode_cancel_trade_capture_report(const TradeCaptureReport& report,
-                                          MsgBuffer* buffer);
+  // 总是出现的字段的bit编译期就已确定，运行时只判断可选字段
+  template <class Message>
+  void encode_body(const Message& msg, MessageHeader* header) {
+    using Schema = MessageSchema<Message>;
+    static_assert(Schema::is_ordered(), "fields must be in ascending order");
+    constexpr auto& kBitmap = kPresenceBitmap<Schema>;
+
+    auto bitmap = header->body_fields_presence_map;
+    memcpy(bitmap, kBitmap.data(), sizeof(PresenceBitmap));
+    Schema::for_each_field([this, &msg, bitmap](auto field) {
+      using F = decltype(field);
+      const auto& value = msg.*F::kMember;
+      if constexpr (F::kFixed) {
+        encode(value);
+      } else if (F::test(msg, value)) {
+        set_presence(bitmap, F::kIndex);
+        encode(value);
+      }
+    });
+  }
 
   template <class CharArray,
             std::enable_if_t<std::is_array_v<CharArray>, int> = 0>
@@ -141,7 +168,7 @@ class BinaryMessageEncoder {
     auto header = reinterpret_cast<MessageHeader*>(cur_msg_buf_->data);
     uint32_t head_body_len = cur_msg_buf_->size;
     header->length = head_body_len + sizeof(Checksum);
-    encode(crc32c(0xffffffffUL, reinterpret_cast<uint8_t*>(header),
+    encode(crc32c(kCrc32cInit, reinterpret_cast<uint8_t*>(header),
                   head_body_len));
     cur_msg_buf_ = nullptr;
   }
@@ -155,97 +182,47 @@ class BinaryMessageEncoder {
   MsgBuffer* cur_msg_buf_ = nullptr;
 };
 
-inline void set_presence(PresenceBitmap bitmap, uint32_t i) {
-  assert(i < sizeof(PresenceBitmap) * 8);
-  bitmap[i >> 3] |= (0b10000000U >> (i & 0x7U));
+/*
+ * 修改已编码消息的PossDupFlag，用于直接重传保存下来的消息
+ *
+ * 校验和按改动的字节增量更新：改动前后的CRC之差只取决于改动的字节及其后面
+ * 的长度，不需要再遍历整个消息
+ */
+inline void patch_poss_dup_flag(MessageHeader* header, PossDupFlag flag) {
+  uint8_t delta = header->poss_dup_flag ^ flag;
+  if (delta == 0) return;
+
+  header->poss_dup_flag = flag;
+  auto p = reinterpret_cast<char*>(header);
+  std::size_t tail_len = header->length - sizeof(Checksum) -
+                         offsetof(MessageHeader, poss_dup_flag) - 1;
+  auto checksum =
+      reinterpret_cast<Checksum*>(p + header->length - sizeof(Checksum));
+  *checksum ^= crc32c_combine(crc32c_update(0, &delta, 1), 0, tail_len);
+}
+
+/*
+ * 修改已编码消息的序列号，用于流控排队的消息在真正发出时才分配序列号，
+ * 校验和的更新方式与patch_poss_dup_flag相同
+ */
+inline void patch_sequence_number(MessageHeader* header, MessageSequence seq) {
+  MessageSequence delta = header->sequence_number ^ seq;
+  if (delta == 0) return;
+
+  header->sequence_number = seq;
+  auto p = reinterpret_cast<char*>(header);
+  std::size_t tail_len = header->length - sizeof(Checksum) -
+                         offsetof(MessageHeader, sequence_number) -
+                         sizeof(MessageSequence);
+  auto checksum =
+      reinterpret_cast<Checksum*>(p + header->length - sizeof(Checksum));
+  *checksum ^= crc32c_combine(crc32c_update(0, &delta, sizeof(delta)), 0,
+                              tail_len);
 }
 
 template <class Message>
-inline OcgMessageType get_msg_type();
-
-template <>
-inline OcgMessageType get_msg_type<LogonMessage>() {
-  return LOGON;
-}
-
-template <>
-inline OcgMessageType get_msg_type<LogoutMessage>() {
-  return LOGOUT;
-}
-
-template <>
-inline OcgMessageType get_msg_type<HeartbeatMessage>() {
-  return HEARTBEAT;
-}
-
-template <>
-inline OcgMessageType get_msg_type<TestRequest>() {
-  return TEST_REQUEST;
-}
-
-template <>
-inline OcgMessageType get_msg_type<ResendRequest>() {
-  return RESEND_REQUEST;
-}
-
-template <>
-inline OcgMessageType get_msg_type<SequenceResetMessage>() {
-  return SEQUENCE_RESET;
-}
-
-template <>
-inline OcgMessageType get_msg_type<RejectMessage>() {
-  return REJECT;
-}
-
-template <>
-inline OcgMessageType get_msg_type<NewOrderRequest>() {
-  return NEW_ORDER;
-}
-
-template <>
-inline OcgMessageType get_msg_type<AmendRequest>() {
-  return AMEND_REQUEST;
-}
-
-template <>
-inline OcgMessageType get_msg_type<CancelRequest>() {
-  return CANCEL_REQUEST;
-}
-
-template <>
-inline OcgMessageType get_msg_type<MassCancelRequest>() {
-  return MASS_CANCEL_REQUEST;
-}
-
-template <>
-inline OcgMessageType get_msg_type<OboCancelRequest>() {
-  return OBO_CANCEL_REQUEST;
-}
-
-template <>
-inline OcgMessageType get_msg_type<OboMassCancelRequest>() {
-  return OBO_MASS_CANCEL_REQUEST;
-}
-
-template <>
-inline OcgMessageType get_msg_type<QuoteRequest>() {
-  return QUOTE;
-}
-
-template <>
-inline OcgMessageType get_msg_type<QuoteCancelRequest>() {
-  return QUOTE_CANCEL;
-}
-
-template <>
-inline OcgMessageType get_msg_type<TradeCaptureReport>() {
-  return TRADE_CAPTURE_REPORT;
-}
-
-template <>
-inline OcgMessageType get_msg_type<PartyEntitlementRequest>() {
-  return PARTY_ENTITLEMENTS_REQUEST;
+inline OcgMessageType get_msg_type() {
+  return MessageSchema<Message>::kType;
 }
 
 template <>
@@ -253,26 +230,6 @@ inline OcgMessageType get_msg_type<ExecutionReport>() {
   return EXECUTION_REPORT;
 }
 
-template <>
-inline OcgMessageType get_msg_type<OrderMassCancelReport>() {
-  return ORDER_MASS_CANCEL_REPORT;
-}
-
-template <>
-inline OcgMessageType get_msg_type<QuoteStatusReport>() {
-  return QUOTE_STATUS_REPORT;
-}
-
-template <>
-inline OcgMessageType get_msg_type<TradeCaptureReportAck>() {
-  return TRADE_CAPTURE_REPORT_ACK;
-}
-
-template <>
-inline OcgMessageType get_msg_type<BusinessRejectMessage>() {
-  return BUSINESS_MESSAGE_REJECT;
-}
-
 }  // namespace ft::bss
 
 #endif  // OCG_BSS_PROTOCOL_ENCODER_H_
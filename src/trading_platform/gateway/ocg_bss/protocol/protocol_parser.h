@@ -6,14 +6,20 @@
 #include <cassert>
 #include <cstring>
 #include <utility>
-#include <vector>
 
 #include "protocol/crc32c.h"
 #include "protocol/message_handler.h"
+#include "protocol/message_schema.h"
+#include "protocol/message_view.h"
+#include "protocol/mirrored_buffer.h"
 #include "protocol/protocol.h"
 
 namespace ft::bss {
 
+/*
+ * 接收缓冲区是MirroredBuffer，跨过缓冲区末尾的消息在地址上也是连续的，
+ * 解析时直接在缓冲区中访问，不需要搬动数据
+ */
 class BinaryMessageDecoder {
  public:
   BinaryMessageDecoder();
@@ -22,18 +28,19 @@ class BinaryMessageDecoder {
 
   int parse_raw_data(std::size_t new_data_size);
 
-  std::size_t readable_size() const { return write_head_ - read_head_; }
+  std::size_t readable_size() const { return buffer_.readable_size(); }
 
-  std::size_t writable_size() const { return buffer_.size() - write_head_; }
+  std::size_t writable_size() const { return buffer_.writable_size(); }
 
-  char* writable_start() { return buffer_.data() + write_head_; }
+  char* writable_start() { return buffer_.writable_start(); }
 
-  char* readable_start() { return buffer_.data() + read_head_; }
+  char* readable_start() { return buffer_.readable_start(); }
+
+  // 提前到达的消息通过RecvMsgCache原地保留在接收缓冲区中
+  MirroredBuffer* buffer() { return &buffer_; }
 
  private:
-  std::vector<char> buffer_;
-  std::size_t read_head_ = 0;
-  std::size_t write_head_ = 0;
+  MirroredBuffer buffer_;
 
   MessageHandler* handler_ = nullptr;
 };
@@ -62,7 +69,7 @@ const char* decode(const char* p, AlphanumericVariableLength<N>& field) {
 inline bool crc32c_check(const MessageHeader* header) {
   auto p = reinterpret_cast<const uint8_t*>(header);
   Checksum checksum =
-      crc32c(0xffffffffUL, p, header->length - sizeof(Checksum));
+      crc32c(kCrc32cInit, p, header->length - sizeof(Checksum));
   Checksum trailer =
       *reinterpret_cast<const Checksum*>(p + header->length - sizeof(Checksum));
 
@@ -74,51 +81,119 @@ inline bool is_present(const PresenceBitmap bitmap, uint32_t i) {
   return bitmap[i >> 3] & (0b10000000U >> (i & 0x7U));
 }
 
-const char* parse_lookup_response(const MessageHeader& header, const char* p,
-                                  LookupResponse* rsp);
-
-const char* parse_logon_message(const MessageHeader& header, const char* p,
-                                LogonMessage* msg);
-
-const char* parse_logout_message(const MessageHeader& header, const char* p,
-                                 LogoutMessage* msg);
-
-const char* parse_heartbeat_message(const MessageHeader& header, const char* p,
-                                    HeartbeatMessage* msg);
-
-const char* parse_test_request(const MessageHeader& header, const char* p,
-                               TestRequest* msg);
-
-const char* parse_resend_request(const MessageHeader& header, const char* p,
-                                 ResendRequest* msg);
-
-const char* parse_reject_message(const MessageHeader& header, const char* p,
-                                 RejectMessage* msg);
-
-const char* parse_sequence_reset_message(const MessageHeader& header,
-                                         const char* p,
-                                         SequenceResetMessage* msg);
-
-const char* parse_execution_report(const MessageHeader& header, const char* p,
-                                   ExecutionReport* report);
-
-const char* parse_mass_cancel_report(const MessageHeader& header, const char* p,
-                                     OrderMassCancelReport* report);
-
-const char* parse_trade_capture_report(const MessageHeader& header,
-                                       const char* p,
-                                       TradeCaptureReport* report);
-
-const char* parse_trade_capture_report_ack(const MessageHeader& header,
-                                           const char* p,
-                                           TradeCaptureReportAck* ack);
-
-const char* parse_business_reject_message(const MessageHeader& header,
-                                          const char* p,
-                                          BusinessRejectMessage* msg);
+/*
+ * 按MessageSchema中的字段表解析消息体，返回消息体结束的位置
+ */
+template <class Message>
+const char* parse_msg(const MessageHeader& header, const char* p,
+                      Message* msg) {
+  MessageSchema<Message>::for_each_field([&header, &p, msg](auto field) {
+    using F = decltype(field);
+    if (F::kRequired || is_present(header.body_fields_presence_map, F::kIndex))
+      p = decode(p, msg->*F::kMember);
+  });
+  return p;
+}
 
-const char* parse_quote_status_report(const MessageHeader& header,
-                                      const char* p, QuoteStatusReport* report);
+// ExecutionReport的格式由ExecType决定，见ExecutionReportView
+const char* parse_msg(const MessageHeader& header, const char* p,
+                      ExecutionReport* report);
+
+/*
+ * 解码一条完整的消息并回调visitor(header, &msg)。ExecutionReport以
+ * ExecutionReportView的形式回调，不复制字段。不支持的消息类型返回false
+ */
+template <class Visitor>
+bool visit_msg(MessageHeader* header, Visitor&& visitor) {
+  auto body = reinterpret_cast<const char*>(header + 1);
+  switch (header->message_type) {
+    case HEARTBEAT: {
+      HeartbeatMessage msg{};
+      parse_msg(*header, body, &msg);
+      visitor(header, &msg);
+      return true;
+    }
+    case TEST_REQUEST: {
+      TestRequest msg{};
+      parse_msg(*header, body, &msg);
+      visitor(header, &msg);
+      return true;
+    }
+    case RESEND_REQUEST: {
+      ResendRequest msg{};
+      parse_msg(*header, body, &msg);
+      visitor(header, &msg);
+      return true;
+    }
+    case REJECT: {
+      RejectMessage msg{};
+      parse_msg(*header, body, &msg);
+      visitor(header, &msg);
+      return true;
+    }
+    case SEQUENCE_RESET: {
+      SequenceResetMessage msg{};
+      parse_msg(*header, body, &msg);
+      visitor(header, &msg);
+      return true;
+    }
+    case LOGON: {
+      LogonMessage msg{};
+      parse_msg(*header, body, &msg);
+      visitor(header, &msg);
+      return true;
+    }
+    case LOGOUT: {
+      LogoutMessage msg{};
+      parse_msg(*header, body, &msg);
+      visitor(header, &msg);
+      return true;
+    }
+    case BUSINESS_MESSAGE_REJECT: {
+      BusinessRejectMessage msg{};
+      parse_msg(*header, body, &msg);
+      visitor(header, &msg);
+      return true;
+    }
+    case EXECUTION_REPORT: {
+      ExecutionReportView view;
+      view.init(header);
+      visitor(header, &view);
+      return true;
+    }
+    case ORDER_MASS_CANCEL_REPORT: {
+      OrderMassCancelReport msg{};
+      parse_msg(*header, body, &msg);
+      visitor(header, &msg);
+      return true;
+    }
+    case QUOTE_STATUS_REPORT: {
+      QuoteStatusReport msg{};
+      parse_msg(*header, body, &msg);
+      visitor(header, &msg);
+      return true;
+    }
+    case TRADE_CAPTURE_REPORT: {
+      TradeCaptureReport msg{};
+      parse_msg(*header, body, &msg);
+      visitor(header, &msg);
+      return true;
+    }
+    case TRADE_CAPTURE_REPORT_ACK: {
+      TradeCaptureReportAck msg{};
+      parse_msg(*header, body, &msg);
+      visitor(header, &msg);
+      return true;
+    }
+    case THROTTLE_ENTITLEMENT_RESPONSE:
+    case PARTY_ENTITLEMENTS_REPORT: {
+      return true;
+    }
+    default: {
+      return false;
+    }
+  }
+}
 
 }  // namespace ft::bss
 
@@ -18,6 +18,7 @@ char kIp[32];
 int kPort;
 char kPasswd[9];
 char kNewPasswd[9];
+char kCompId[13];
 
 void parse_cmd(int argc, char** argv);
 void usage();
@@ -49,6 +50,7 @@ void parse_cmd(int argc, char** argv) {
       {"addr", required_argument, 0, 0},
       {"passwd", optional_argument, 0, 0},
       {"new-passwd", optional_argument, 0, 0},
+      {"comp-id", optional_argument, 0, 0},
       {"help", optional_argument, 0, 0},
       {0, 0, 0, 0},
   };
@@ -80,6 +82,8 @@ void parse_cmd(int argc, char** argv) {
         usage();
       }
       strncpy(kNewPasswd, optarg, sizeof(kNewPasswd));
+    } else if (strcmp(options[i].name, "comp-id") == 0) {
+      strncpy(kCompId, optarg, sizeof(kCompId) - 1);
     } else if (strcmp(options[i].name, "help") == 0) {
       usage();
     }
@@ -140,6 +144,7 @@ void logon(int argc, char** argv) {
 
   strncpy(body.password, kPasswd, sizeof(body.password));
   strncpy(body.new_password, kNewPasswd, sizeof(body.new_password));
+  strncpy(body.comp_id, kCompId, sizeof(body.comp_id));
 
   int sockfd = connect(kIp, kPort);
   send_cmd(sockfd, &hdr, reinterpret_cast<const char*>(&body));
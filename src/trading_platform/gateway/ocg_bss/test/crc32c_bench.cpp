@@ -0,0 +1,121 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+/*
+ * CRC32C各实现的交叉验证及基准测试
+ *
+ *   ./crc32c-bench [iterations]
+ *
+ * 先用随机数据在不同长度及对齐下把每个实现与逐字节查表的实现比对，
+ * 并验证分段计算及combine，有任何不一致时返回1。然后测试各实现在
+ * 不同消息长度下的耗时
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "protocol/crc32c.h"
+
+using namespace crc32c_detail;
+
+using UpdateFunc = uint32_t (*)(uint32_t, const uint8_t*, std::size_t);
+
+struct Impl {
+  const char* name;
+  UpdateFunc update;
+};
+
+std::vector<Impl> available_impls() {
+  std::vector<Impl> impls{{"bytewise", update_bytewise},
+                          {"slicing-by-8", update_slicing8}};
+  if (cpu_has_sse42()) impls.push_back({"sse4.2", update_sse42});
+  if (cpu_has_sse42() && cpu_has_pclmul())
+    impls.push_back({"sse4.2-pclmul", update_sse42_pclmul});
+  return impls;
+}
+
+bool cross_check(const std::vector<Impl>& impls) {
+  constexpr std::size_t kMaxLength = 4096;
+  std::mt19937_64 rng(20200101);
+  std::vector<uint8_t> buf(kMaxLength + 8);
+  for (auto& b : buf) b = static_cast<uint8_t>(rng());
+
+  const char* check = "123456789";
+  if (crc32c(kCrc32cInit, reinterpret_cast<const uint8_t*>(check), 9) !=
+      0xe3069283) {
+    printf("check value mismatch\n");
+    return false;
+  }
+
+  int errors = 0;
+  for (std::size_t len = 0; len <= kMaxLength; ++len) {
+    for (std::size_t offset = 0; offset < 8; ++offset) {
+      const uint8_t* p = buf.data() + offset;
+      uint32_t expected = update_bytewise(kCrc32cInit, p, len);
+      for (auto& impl : impls) {
+        uint32_t actual = impl.update(kCrc32cInit, p, len);
+        if (actual != expected && errors++ < 10) {
+          printf("%s mismatch: len=%zu offset=%zu %08x != %08x\n", impl.name,
+                 len, offset, actual, expected);
+        }
+      }
+
+      if (crc32c_update(kCrc32cInit, p, len) != expected && errors++ < 10)
+        printf("dispatch mismatch: len=%zu offset=%zu\n", len, offset);
+
+      std::size_t split = len == 0 ? 0 : rng() % (len + 1);
+      uint32_t head = crc32c_update(kCrc32cInit, p, split);
+      if (crc32c_update(head, p + split, len - split) != expected &&
+          errors++ < 10)
+        printf("incremental mismatch: len=%zu split=%zu\n", len, split);
+
+      uint32_t tail = crc32c_update(0, p + split, len - split);
+      if (crc32c_combine(head, tail, len - split) != expected &&
+          errors++ < 10)
+        printf("combine mismatch: len=%zu split=%zu\n", len, split);
+    }
+  }
+
+  printf("cross check: %s\n", errors == 0 ? "ok" : "FAILED");
+  return errors == 0;
+}
+
+void bench(const std::vector<Impl>& impls, int iterations) {
+  const std::size_t kLengths[] = {32, 64, 128, 256, 512, 1024, 4096};
+  std::vector<uint8_t> buf(4096);
+  std::mt19937_64 rng(1);
+  for (auto& b : buf) b = static_cast<uint8_t>(rng());
+
+  printf("%-16s", "length");
+  for (auto len : kLengths) printf("%10zu", len);
+  printf("   (ns per call)\n");
+
+  volatile uint32_t sink = 0;
+  for (auto& impl : impls) {
+    printf("%-16s", impl.name);
+    for (auto len : kLengths) {
+      int n = static_cast<int>(iterations * 256 / len) + 1;
+      uint32_t crc = kCrc32cInit;
+      auto start = std::chrono::steady_clock::now();
+      for (int i = 0; i < n; ++i) crc = impl.update(crc, buf.data(), len);
+      auto end = std::chrono::steady_clock::now();
+      sink = sink + crc;
+      double ns = std::chrono::duration<double, std::nano>(end - start).count();
+      printf("%10.1f", ns / n);
+    }
+    printf("\n");
+  }
+}
+
+int main(int argc, char** argv) {
+  int iterations = argc > 1 ? atoi(argv[1]) : 200000;
+  auto impls = available_impls();
+
+  printf("dispatch: %s\n", crc32c_impl_name());
+  if (!cross_check(impls)) return 1;
+  bench(impls, iterations);
+  return 0;
+}
@@ -0,0 +1,179 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+/*
+ * 字段表展开的编码器与原先手写的编码器的交叉验证
+ *
+ *   ./encoder-check [rounds]
+ *
+ * 每种BSS发送的消息随机填充若干轮，可选字段随机出现或为空，分别用
+ * BinaryMessageEncoder和LegacyMessageEncoder在相同的CompId、SeqNum及
+ * flag下编码后逐字节比对，固定格式的限价单(LimitOrder/LevelLimitOrder)
+ * 也一并比对。有任何不一致时返回1
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <type_traits>
+
+#include "protocol/protocol_encoder.h"
+#include "test/legacy_encoder.h"
+
+using namespace ft::bss;
+
+std::mt19937_64 rng(20200101);
+
+// 单字节的字段多是枚举，取值限制在小范围内，以覆盖依赖取值的出现条件
+template <class T>
+void fill_field(T* value) {
+  if constexpr (std::is_array_v<T>) {
+    std::size_t len = rng() % (sizeof(T) + 1);
+    for (std::size_t i = 0; i < len; ++i) (*value)[i] = 'A' + rng() % 26;
+  } else if constexpr (std::is_arithmetic_v<T> && sizeof(T) == 1) {
+    *value = static_cast<T>(rng() % 6);
+  } else if constexpr (std::is_arithmetic_v<T>) {
+    *value = static_cast<T>(rng());
+  } else {
+    value->len = rng() % (sizeof(value->data) + 1);
+    for (uint16_t i = 0; i < value->len; ++i) value->data[i] = 'a' + rng() % 26;
+  }
+}
+
+// 必填字段总是填充，可选字段一半的概率留空
+template <class Message>
+Message random_msg() {
+  Message msg{};
+  MessageSchema<Message>::for_each_field([&msg](auto field) {
+    using F = decltype(field);
+    if (F::kRequired || rng() % 2 == 0) fill_field(&(msg.*F::kMember));
+  });
+  return msg;
+}
+
+class EncoderCheck {
+ public:
+  template <class Message>
+  void check(const char* name, int rounds) {
+    for (int i = 0; i < rounds; ++i) {
+      auto msg = random_msg<Message>();
+      adjust(&msg);
+      compare(name, msg, msg);
+    }
+  }
+
+  // 按Present构造满足FixedShape的NewOrderRequest
+  template <uint32_t... Present>
+  void check_shape(const char* name, int rounds) {
+    for (int i = 0; i < rounds; ++i) {
+      auto req = random_msg<NewOrderRequest>();
+      req.order_type = ORDER_TYPE_LIMIT;
+      req.lot_type = LOT_TYPE_BOARD;
+      strncpy(req.security_exchange, "XHKG", sizeof(req.security_exchange));
+      memset(req.broker_location_id, 0, sizeof(req.broker_location_id));
+      req.position_effect = 0;
+      memset(req.order_restrictions, 0, sizeof(req.order_restrictions));
+      req.max_price_levels = ((Present == 14) || ...) ? 1 + rng() % 5 : 0;
+      req.order_capacity = 0;
+      req.text.len = 0;
+      memset(req.execution_instructions, 0,
+             sizeof(req.execution_instructions));
+      compare(name, FixedShape<NewOrderRequest, Present...>{req}, req);
+    }
+  }
+
+  int errors() const { return errors_; }
+
+ private:
+  template <class Message>
+  void adjust(Message*) {}
+
+  // 以下字段只由OCG发送，手写的编码器不处理
+  void adjust(LogonMessage* msg) {
+    msg->session_status = 0;
+    msg->text.len = 0;
+    msg->test_message_indicator = 0;
+  }
+
+  void adjust(SequenceResetMessage* msg) {
+    if (rng() % 2 == 0) msg->gap_fill = 'Y';
+  }
+
+  // 3为不支持的TradeReportTransType，两者都不应编码
+  void adjust(TradeCaptureReport* report) {
+    const TradeReportTransType kTransTypes[] = {0, 5, 3};
+    report->trade_report_trans_type = kTransTypes[rng() % 3];
+    report->exec_type = 0;
+    report->trade_report_status = 0;
+    report->exchange_trade_type = 0;
+  }
+
+  template <class Message, class LegacyMessage>
+  void compare(const char* name, const Message& msg,
+               const LegacyMessage& legacy_msg) {
+    std::string comp_id(1 + rng() % sizeof(CompId), 'C');
+    auto seq = static_cast<uint32_t>(rng());
+    PossDupFlag dup = rng() % 2 ? 'Y' : 'N';
+    PossResendFlag resend = rng() % 2 ? 'Y' : 'N';
+    BinaryMessageEncoder* encoders[] = {&encoder_, &legacy_encoder_};
+    for (auto encoder : encoders) {
+      encoder->set_comp_id(comp_id);
+      encoder->set_next_seq_number(seq);
+      encoder->set_poss_dup_flag(dup);
+      encoder->set_poss_resend_flag(resend);
+    }
+
+    memset(&buf_, 0, sizeof(buf_));
+    memset(&legacy_buf_, 0, sizeof(legacy_buf_));
+    encoder_.encode_msg(msg, &buf_);
+    legacy_encoder_.encode_msg(legacy_msg, &legacy_buf_);
+
+    if (buf_.size == legacy_buf_.size &&
+        memcmp(buf_.data, legacy_buf_.data, buf_.size) == 0)
+      return;
+    if (errors_++ >= 10) return;
+
+    uint32_t pos = 0;
+    while (pos < buf_.size && pos < legacy_buf_.size &&
+           buf_.data[pos] == legacy_buf_.data[pos])
+      ++pos;
+    printf("%s mismatch: size=%u legacy_size=%u first diff at %u\n", name,
+           buf_.size, legacy_buf_.size, pos);
+  }
+
+  BinaryMessageEncoder encoder_;
+  LegacyMessageEncoder legacy_encoder_;
+  MsgBuffer buf_;
+  MsgBuffer legacy_buf_;
+  int errors_ = 0;
+};
+
+int main(int argc, char** argv) {
+  int rounds = argc > 1 ? atoi(argv[1]) : 10000;
+  EncoderCheck check;
+
+  check.check<LogonMessage>("Logon", rounds);
+  check.check<LogoutMessage>("Logout", rounds);
+  check.check<SequenceResetMessage>("SequenceReset", rounds);
+  check.check<HeartbeatMessage>("Heartbeat", rounds);
+  check.check<TestRequest>("TestRequest", rounds);
+  check.check<RejectMessage>("Reject", rounds);
+  check.check<ResendRequest>("ResendRequest", rounds);
+  check.check<NewOrderRequest>("NewOrderRequest", rounds);
+  check.check<AmendRequest>("AmendRequest", rounds);
+  check.check<CancelRequest>("CancelRequest", rounds);
+  check.check<MassCancelRequest>("MassCancelRequest", rounds);
+  check.check<OboCancelRequest>("OboCancelRequest", rounds);
+  check.check<OboMassCancelRequest>("OboMassCancelRequest", rounds);
+  check.check<QuoteRequest>("QuoteRequest", rounds);
+  check.check<QuoteCancelRequest>("QuoteCancelRequest", rounds);
+  check.check<TradeCaptureReport>("TradeCaptureReport", rounds);
+  check.check<PartyEntitlementRequest>("PartyEntitlementRequest", rounds);
+  check.check<LookupRequest>("LookupRequest", rounds);
+  check.check_shape<4, 9>("LimitOrder", rounds);
+  check.check_shape<4, 9, 14>("LevelLimitOrder", rounds);
+
+  printf("cross check: %s\n", check.errors() == 0 ? "ok" : "FAILED");
+  return check.errors() == 0 ? 0 : 1;
+}
@@ -0,0 +1,64 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef OCG_BSS_TEST_LEGACY_ENCODER_H_
+#define OCG_BSS_TEST_LEGACY_ENCODER_H_
+
+#include "protocol/protocol_encoder.h"
+
+namespace ft::bss {
+
+/*
+ * 改用MessageSchema之前手写的编码器，逐个字段判断并设置presence bitmap，
+ * 只用于encoder-check与字段表展开的编码结果比对
+ *
+ * 只有消息体的编码是手写的，header及trailer沿用BinaryMessageEncoder
+ */
+class LegacyMessageEncoder : public BinaryMessageEncoder {
+ public:
+  void encode_msg(const LogonMessage& msg, MsgBuffer* buffer);
+
+  void encode_msg(const LogoutMessage& msg, MsgBuffer* buffer);
+
+  void encode_msg(const SequenceResetMessage& msg, MsgBuffer* buffer);
+
+  void encode_msg(const HeartbeatMessage& msg, MsgBuffer* buffer);
+
+  void encode_msg(const TestRequest& msg, MsgBuffer* buffer);
+
+  void encode_msg(const RejectMessage& msg, MsgBuffer* buffer);
+
+  void encode_msg(const ResendRequest& msg, MsgBuffer* buffer);
+
+  void encode_msg(const NewOrderRequest& req, MsgBuffer* buffer);
+
+  void encode_msg(const AmendRequest& req, MsgBuffer* buffer);
+
+  void encode_msg(const CancelRequest& req, MsgBuffer* buffer);
+
+  void encode_msg(const MassCancelRequest& req, MsgBuffer* buffer);
+
+  void encode_msg(const OboCancelRequest& req, MsgBuffer* buffer);
+
+  void encode_msg(const OboMassCancelRequest& req, MsgBuffer* buffer);
+
+  void encode_msg(const QuoteRequest& req, MsgBuffer* buffer);
+
+  void encode_msg(const QuoteCancelRequest& req, MsgBuffer* buffer);
+
+  void encode_msg(const TradeCaptureReport& report, MsgBuffer* buffer);
+
+  void encode_msg(const PartyEntitlementRequest& req, MsgBuffer* buffer);
+
+  void encode_msg(const LookupRequest& req, MsgBuffer* buffer);
+
+ private:
+  void encode_new_trade_capture_report(const TradeCaptureReport& report,
+                                       MsgBuffer* buffer);
+
+  void encode_cancel_trade_capture_report(const TradeCaptureReport& report,
+                                          MsgBuffer* buffer);
+};
+
+}  // namespace ft::bss
+
+#endif  // OCG_BSS_TEST_LEGACY_ENCODER_H_
@@ -13,8 +13,8 @@
 #include <cstdlib>
 #include <cstring>
 
+#include "protocol/protocol_parser.h"
 #include "virtual_ocg/ocg_encoder.h"
-#include "virtual_ocg/ocg_parser.h"
 
 using namespace ft::bss;
 
@@ -82,7 +82,7 @@ void LookupServer::process_request() {
   }
 
   LookupRequest req{};
-  parse_lookup_request(*header, reinterpret_cast<char*>(header + 1), &req);
+  parse_msg(*header, reinterpret_cast<char*>(header + 1), &req);
   if (req.protocol_type != 1 || req.type_of_service != 1) {
     printf("lookup server: invalid request\n");
     return;
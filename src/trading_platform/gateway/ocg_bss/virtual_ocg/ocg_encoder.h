@@ -11,14 +11,6 @@ class OcgEncoder : public BinaryMessageEncoder {
  public:
   void encode_msg(const ExecutionReport& report, MsgBuffer* buffer);
 
-  void encode_msg(const TradeCaptureReportAck& ack, MsgBuffer* buffer);
-
-  void encode_msg(const QuoteStatusReport& report, MsgBuffer* buffer);
-
-  void encode_msg(const OrderMassCancelReport& report, MsgBuffer* buffer);
-
-  void encode_msg(const BusinessRejectMessage& msg, MsgBuffer* buffer);
-
   void encode_msg(const LookupResponse& rsp, MsgBuffer* buffer);
 
   using BinaryMessageEncoder::encode_msg;
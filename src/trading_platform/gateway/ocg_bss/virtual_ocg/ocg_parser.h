@@ -3,8 +3,7 @@
 #ifndef BSS_VIRTUAL_OCG_OCG_PARSER_H_
 #define BSS_VIRTUAL_OCG_OCG_PARSER_H_
 
-#include <vector>
-
+#include "protocol/mirrored_buffer.h"
 #include "protocol/protocol.h"
 #include "virtual_ocg/ocg_handler.h"
 
@@ -19,59 +18,22 @@ class OcgParser {
 
   void set_handler(OcgHandler* handler) { handler_ = handler; }
 
-  void clear() {
-    write_head_ = 0;
-    read_head_ = 0;
-  }
+  void clear() { buffer_.clear(); }
 
   int parse_raw_data(std::size_t new_data_size);
 
-  std::size_t readable() const { return write_head_ - read_head_; }
+  std::size_t readable() const { return buffer_.readable_size(); }
 
-  std::size_t writable() const { return buffer_.size() - write_head_; }
+  std::size_t writable() const { return buffer_.writable_size(); }
 
-  char* writable_start() { return buffer_.data() + write_head_; }
+  char* writable_start() { return buffer_.writable_start(); }
 
-  char* readable_start() { return buffer_.data() + read_head_; }
+  char* readable_start() { return buffer_.readable_start(); }
 
  private:
-  std::vector<char> buffer_;
-  std::size_t read_head_ = 0;
-  std::size_t write_head_ = 0;
+  MirroredBuffer buffer_;
 
   OcgHandler* handler_ = nullptr;
 };
 
-const char* parse_lookup_request(const MessageHeader& header, const char* p,
-                                 LookupRequest* req);
-
-const char* parse_new_order_request(const MessageHeader& header, const char* p,
-                                    NewOrderRequest* req);
-
-const char* parse_amend_request(const MessageHeader& header, const char* p,
-                                AmendRequest* req);
-
-const char* parse_cancel_request(const MessageHeader& header, const char* p,
-                                 CancelRequest* req);
-
-const char* parse_mass_cancel_request(const MessageHeader& header,
-                                      const char* p, MassCancelRequest* req);
-
-const char* parse_obo_cancel_request(const MessageHeader& header, const char* p,
-                                     OboCancelRequest* req);
-
-const char* parse_obo_mass_cancel_request(const MessageHeader& header,
-                                          const char* p,
-                                          OboMassCancelRequest* req);
-
-const char* parse_quote_request(const MessageHeader& header, const char* p,
-                                QuoteRequest* req);
-
-const char* parse_quote_cancel_request(const MessageHeader& header,
-                                       const char* p, QuoteCancelRequest* req);
-
-const char* parse_party_entitlement_request(const MessageHeader& header,
-                                            const char* p,
-                                            PartyEntitlementRequest* req);
-
 #endif  // BSS_VIRTUAL_OCG_OCG_PARSER_H_
@@ -0,0 +1,44 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef FT_SRC_GATEWAY_VIRTUAL_ORDER_MATCHING_H_
+#define FT_SRC_GATEWAY_VIRTUAL_ORDER_MATCHING_H_
+
+#include "core/price.h"
+
+namespace ft {
+
+/*
+ * 模拟撮合规则，VirtualApi与mock交易所共用
+ *
+ * 只与对手方的最优价比较，不模拟盘口深度：
+ * 1. 新订单可以成交时以对手价成交
+ * 2. 挂单被之后的行情穿过时以自己的价格成交
+ * 3. 未能立即成交的部分，限价单挂单等待，FAK/FOK及市价单撤销
+ */
+
+// 对手方最优价，0表示没有该方向的报价
+struct MatchQuote {
+  TickPrice bid = 0;
+  TickPrice ask = 0;
+};
+
+// 没有对手方报价时市价单也不能成交
+inline bool is_marketable(bool is_buy, bool is_market, TickPrice price,
+                          const MatchQuote& quote) {
+  if (is_buy) return quote.ask > 0 && (is_market || price >= quote.ask);
+  return quote.bid > 0 && (is_market || price <= quote.bid);
+}
+
+inline TickPrice match_price(bool is_buy, bool is_resting, TickPrice price,
+                             const MatchQuote& quote) {
+  if (is_resting) return price;
+  return is_buy ? quote.ask : quote.bid;
+}
+
+inline bool rests_on_book(bool is_market, bool immediate) {
+  return !is_market && !immediate;
+}
+
+}  // namespace ft
+
+#endif  // FT_SRC_GATEWAY_VIRTUAL_ORDER_MATCHING_H_
@@ -25,7 +25,7 @@ bool VirtualApi::insert_order(VirtualOrderReq* req) {
     return false;
   }
 
-  if (req->price < 1e-5) {
+  if (req->price <= 0) {
     spdlog::error("[VirtualApi::insert_order] Invalid price");
     return false;
   }
@@ -49,7 +49,8 @@ bool VirtualApi::insert_order(VirtualOrderReq* req) {
   return true;
 }
 
-void VirtualApi::update_quote(uint32_t ticker_index, double ask, double bid) {
+void VirtualApi::update_quote(uint32_t ticker_index, TickPrice ask,
+                              TickPrice bid) {
   std::unique_lock<std::mutex> lock(mutex_);
   auto& quote = lastest_quotes_[ticker_index];
   quote.ask = ask;
@@ -58,20 +59,11 @@ void VirtualApi::update_quote(uint32_t ticker_index, double ask, double bid) {
   auto& order_list = limit_orders_[ticker_index];
   for (auto iter = order_list.begin(); iter != order_list.end();) {
     auto& order = *iter;
-
-    auto quote_iter = lastest_quotes_.find(ticker_index);
-    if (quote_iter == lastest_quotes_.end()) {
-      ++iter;
-      continue;
-    }
-
-    const auto& quote = quote_iter->second;
-    if ((order.direction == Direction::BUY && quote.ask > 0 &&
-         order.price >= quote.ask - 1e-5) ||
-        (order.direction == Direction::SELL && quote.bid > 0 &&
-         order.price <= quote.bid + 1e-5)) {
-      gateway_->on_order_traded(order.engine_order_id, order.volume,
-                                order.price);
+    bool is_buy = order.direction == Direction::BUY;
+    if (is_marketable(is_buy, false, order.price, quote)) {
+      gateway_->on_order_traded(order.engine_order_id, order.ticker_index,
+                                order.volume,
+                                match_price(is_buy, true, order.price, quote));
       iter = order_list.erase(iter);
     } else {
       ++iter;
@@ -126,23 +118,18 @@ void VirtualApi::process_pendings() {
 
       gateway_->on_order_accepted(order.engine_order_id);
 
+      // 还没有行情时视为没有对手方报价
+      MatchQuote quote{};
       auto iter = lastest_quotes_.find(order.ticker_index);
-      if (iter == lastest_quotes_.end()) {
-        if (order.type == OrderType::FAK || order.type == OrderType::FOK) {
-          gateway_->on_order_canceled(order.engine_order_id, order.volume);
-          pending_iter = pendings_.erase(pending_iter);
-          continue;
-        }
-      }
-
-      const auto& quote = iter->second;
-      if ((order.direction == Direction::BUY && quote.ask > 0 &&
-           order.price >= quote.ask - 1e-5) ||
-          (order.direction == Direction::SELL && quote.bid > 0 &&
-           order.price <= quote.bid + 1e-5)) {
-        gateway_->on_order_traded(order.engine_order_id, order.volume,
-                                  quote.ask);
-      } else if (order.type == OrderType::LIMIT) {
+      if (iter != lastest_quotes_.end()) quote = iter->second;
+
+      bool is_buy = order.direction == Direction::BUY;
+      bool is_market = order.type == OrderType::MARKET;
+      if (is_marketable(is_buy, is_market, order.price, quote)) {
+        gateway_->on_order_traded(
+            order.engine_order_id, order.ticker_index, order.volume,
+            match_price(is_buy, false, order.price, quote));
+      } else if (rests_on_book(is_market, order.type != OrderType::LIMIT)) {
         limit_orders_[order.ticker_index].emplace_back(order);
       } else {
         gateway_->on_order_canceled(order.engine_order_id, order.volume);
@@ -160,13 +147,16 @@ void VirtualApi::disseminate_market_data() {
   RandomWalk walker(10000, 1);
 
   for (;;) {
+    auto ask = to_tick_price(walker.next(), contract->params.price_tick);
+    auto bid = ask - 1;
+
     TickData tick{};
-    tick.ticker_index = contract->index;
-    tick.ask[0] = walker.next();
-    tick.bid[0] = tick.ask[0] - 1;
+    tick.ticker_index = contract->params.index;
+    tick.ask[0] = to_real_price(ask, contract->params.price_tick);
+    tick.bid[0] = to_real_price(bid, contract->params.price_tick);
     tick.last_price = (random() & 0xf) >= 8 ? tick.ask[0] : tick.bid[0];
 
-    update_quote(tick.ticker_index, tick.ask[0], tick.bid[0]);
+    update_quote(tick.ticker_index, ask, bid);
     gateway_->on_tick(&tick);
     std::this_thread::sleep_for(std::chrono::milliseconds(15));
   }
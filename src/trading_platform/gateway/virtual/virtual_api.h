@@ -10,6 +10,8 @@
 #include <unordered_map>
 
 #include "core/constants.h"
+#include "core/price.h"
+#include "gateway/virtual/order_matching.h"
 
 namespace ft {
 
@@ -20,7 +22,7 @@ struct VirtualOrderReq {
   uint32_t direction;
   uint32_t offset;
   int volume;
-  double price;
+  TickPrice price;
 
   // used internally
   bool to_canceled;
@@ -42,24 +44,18 @@ class VirtualApi {
 
   bool cancel_order(uint64_t order_id);
 
-  void update_quote(uint32_t ticker_index, double ask, double bid);
+  void update_quote(uint32_t ticker_index, TickPrice ask, TickPrice bid);
 
  private:
   void process_pendings();
 
   void disseminate_market_data();
 
- private:
-  struct LatestQuote {
-    double bid = 0;
-    double ask = 0;
-  };
-
  private:
   VirtualGateway* gateway_;
   std::mutex mutex_;
   std::condition_variable cv_;
-  std::unordered_map<uint32_t, LatestQuote> lastest_quotes_;
+  std::unordered_map<uint32_t, MatchQuote> lastest_quotes_;
   std::list<VirtualOrderReq> pendings_;
   std::unordered_map<uint64_t, std::list<VirtualOrderReq>> limit_orders_;
 };
@@ -24,7 +24,7 @@ void VirtualGateway::logout() {}
 bool VirtualGateway::send_order(const OrderReq& order) {
   VirtualOrderReq req{};
   req.engine_order_id = order.engine_order_id;
-  req.ticker_index = order.contract->index;
+  req.ticker_index = order.params->index;
   req.direction = order.direction;
   req.offset = order.offset;
   req.type = order.type;
@@ -72,13 +72,16 @@ void VirtualGateway::on_order_accepted(uint64_t engine_order_id) {
   engine_->on_order_accepted(&rsp);
 }
 
-void VirtualGateway::on_order_traded(uint64_t engine_order_id, int traded,
-                                     double price) {
+void VirtualGateway::on_order_traded(uint64_t engine_order_id,
+                                     uint32_t ticker_index, int traded,
+                                     TickPrice price) {
+  auto contract = ContractTable::get_params(ticker_index);
+
   OrderTradedRsp rsp{};
   rsp.engine_order_id = engine_order_id;
   rsp.order_id = engine_order_id;
   rsp.volume = traded;
-  rsp.price = price;
+  rsp.price = to_real_price(price, contract->price_tick);
   engine_->on_order_traded(&rsp);
 }
 
@@ -53,7 +53,8 @@ class VirtualGateway : public Gateway {
 
   void on_order_accepted(uint64_t engine_order_id);
 
-  void on_order_traded(uint64_t engine_order_id, int traded, double price);
+  void on_order_traded(uint64_t engine_order_id, uint32_t ticker_index,
+                       int traded, TickPrice price);
 
   void on_order_canceled(uint64_t engine_order_id, int canceled);
 
@@ -25,7 +25,7 @@ inline bool is_error_rsp(XTPRI* error_info) {
   return error_info && error_info->error_id != 0;
 }
 
-inline std::string ft_exchange_type(XTP_EXCHANGE_TYPE exchange) {
+inline std::string_view ft_exchange_type(XTP_EXCHANGE_TYPE exchange) {
   if (exchange == XTP_EXCHANGE_SH)
     return SSE;
   else if (exchange == XTP_EXCHANGE_SZ)
@@ -34,10 +34,10 @@ inline std::string ft_exchange_type(XTP_EXCHANGE_TYPE exchange) {
     return "UNKNOWN";
 }
 
-inline XTP_MARKET_TYPE xtp_market_type(const std::string& type) {
-  if (type == SSE)
+inline XTP_MARKET_TYPE xtp_market_type(Exchange exchange) {
+  if (exchange == Exchange::SSE)
     return XTP_MKT_SH_A;
-  else if (type == SZE)
+  else if (exchange == Exchange::SZE)
     return XTP_MKT_SZ_A;
   else
     return XTP_MKT_UNKNOWN;
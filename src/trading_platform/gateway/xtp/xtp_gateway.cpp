@@ -35,8 +35,9 @@ bool XtpGateway::login(TradingEngineInterface* engine, const Config& config) {
 }
 
 void XtpGateway::logout() {
-  trade_api_->logout();
-  quote_api_->logout();
+  // 只登录了交易或者行情时另一个API为空
+  if (trade_api_) trade_api_->logout();
+  if (quote_api_) quote_api_->logout();
 }
 
 bool XtpGateway::send_order(const OrderReq& order) {
@@ -47,6 +48,14 @@ bool XtpGateway::cancel_order(uint64_t order_id) {
   return trade_api_->cancel_order(order_id);
 }
 
+bool XtpGateway::subscribe(const std::vector<std::string>& tickers) {
+  return quote_api_ && quote_api_->subscribe(tickers);
+}
+
+bool XtpGateway::unsubscribe(const std::vector<std::string>& tickers) {
+  return quote_api_ && quote_api_->unsubscribe(tickers);
+}
+
 bool XtpGateway::query_contract(const std::string& ticker,
                                 const std::string& exchange) {
   return quote_api_->query_contract(ticker, exchange);
@@ -64,6 +73,10 @@ bool XtpGateway::query_positions() { return trade_api_->query_positions(); }
 
 bool XtpGateway::query_trades() { return trade_api_->query_trades(); }
 
+bool XtpGateway::query_batch(uint32_t types) {
+  return trade_api_->query_batch(types);
+}
+
 bool XtpGateway::query_orders() { return trade_api_->query_orders(); }
 
 }  // namespace ft
@@ -8,6 +8,7 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "gateway/xtp/xtp_common.h"
 #include "gateway/xtp/xtp_quote_api.h"
@@ -28,6 +29,10 @@ class XtpGateway : public Gateway {
 
   bool cancel_order(uint64_t order_id) override;
 
+  bool subscribe(const std::vector<std::string>& tickers) override;
+
+  bool unsubscribe(const std::vector<std::string>& tickers) override;
+
   bool query_contract(const std::string& ticker,
                       const std::string& exchange) override;
 
@@ -41,6 +46,8 @@ class XtpGateway : public Gateway {
 
   bool query_trades() override;
 
+  bool query_batch(uint32_t types) override;
+
   bool query_orders();
 
  private:
@@ -4,6 +4,7 @@
 
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
 #include <vector>
 
 #include "core/contract_table.h"
@@ -14,8 +15,9 @@ namespace ft {
 XtpQuoteApi::XtpQuoteApi(TradingEngineInterface* engine) : engine_(engine) {}
 
 XtpQuoteApi::~XtpQuoteApi() {
-  error();
+  reconnector_.stop();
   logout();
+  requests_.fail_all();
 }
 
 bool XtpQuoteApi::login(const Config& config) {
@@ -24,6 +26,8 @@ bool XtpQuoteApi::login(const Config& config) {
     return false;
   }
 
+  timeout_ = RequestTracker::Timeout(config.request_timeout_ms);
+
   uint32_t seed = time(nullptr);
   uint8_t client_id = rand_r(&seed) & 0xff;
   quote_api_.reset(XTP::API::QuoteApi::CreateQuoteApi(client_id, "."));
@@ -45,49 +49,100 @@ bool XtpQuoteApi::login(const Config& config) {
     assert(false);
   }
 
-  XTP_PROTOCOL_TYPE sock_type = XTP_PROTOCOL_TCP;
-  if (strcmp(protocol, "udp") == 0) sock_type = XTP_PROTOCOL_UDP;
+  ip_ = ip;
+  port_ = port;
+  sock_type_ = XTP_PROTOCOL_TCP;
+  if (strcmp(protocol, "udp") == 0) sock_type_ = XTP_PROTOCOL_UDP;
+  investor_id_ = config.investor_id;
+  password_ = config.password;
+  subscribed_list_ = config.subscription_list;
 
   quote_api_->RegisterSpi(this);
-  if (quote_api_->Login(ip, port, config.investor_id.c_str(),
-                        config.password.c_str(), sock_type) != 0) {
-    spdlog::error("[XtpQuoteApi::login] Failed to login: {}",
+  return login_and_subscribe();
+}
+
+bool XtpQuoteApi::login_and_subscribe() {
+  if (quote_api_->Login(ip_.c_str(), port_, investor_id_.c_str(),
+                        password_.c_str(), sock_type_) != 0) {
+    spdlog::error("[XtpQuoteApi::login_and_subscribe] Failed to login: {}",
                   quote_api_->GetApiLastError()->error_msg);
     return false;
   }
 
-  spdlog::debug("[XtpQuoteApi::login] Success");
+  spdlog::debug("[XtpQuoteApi::login_and_subscribe] Success");
   is_logon_ = true;
 
-  subscribed_list_ = config.subscription_list;
+  // is_logon_先于复制subscribed_list_设置，保证同时新增的订阅不会遗漏
+  std::unique_lock<std::mutex> lock(sub_mutex_);
+  auto tickers = subscribed_list_;
+  lock.unlock();
+
+  return subscribe_market_data(tickers, true);
+}
+
+bool XtpQuoteApi::subscribe(const std::vector<std::string>& tickers) {
+  std::unique_lock<std::mutex> lock(sub_mutex_);
+  for (const auto& ticker : tickers) {
+    if (std::find(subscribed_list_.begin(), subscribed_list_.end(), ticker) ==
+        subscribed_list_.end())
+      subscribed_list_.emplace_back(ticker);
+  }
+  lock.unlock();
+
+  if (!is_logon_) return true;
+  return subscribe_market_data(tickers, true);
+}
+
+bool XtpQuoteApi::unsubscribe(const std::vector<std::string>& tickers) {
+  std::unique_lock<std::mutex> lock(sub_mutex_);
+  for (const auto& ticker : tickers) {
+    auto iter =
+        std::find(subscribed_list_.begin(), subscribed_list_.end(), ticker);
+    if (iter != subscribed_list_.end()) subscribed_list_.erase(iter);
+  }
+  lock.unlock();
+
+  if (!is_logon_) return true;
+  return subscribe_market_data(tickers, false);
+}
+
+bool XtpQuoteApi::subscribe_market_data(
+    const std::vector<std::string>& tickers, bool is_subscribe) {
   std::vector<char*> sub_list_sh;
   std::vector<char*> sub_list_sz;
-  for (auto& ticker : subscribed_list_) {
+  for (auto& ticker : tickers) {
     auto contract = ContractTable::get_by_ticker(ticker);
     assert(contract);
-    if (contract->exchange == SSE)
+    if (contract->params.exchange_id == Exchange::SSE)
       sub_list_sh.emplace_back(const_cast<char*>(ticker.c_str()));
-    else if (contract->exchange == SZE)
+    else if (contract->params.exchange_id == Exchange::SZE)
       sub_list_sz.emplace_back(const_cast<char*>(ticker.c_str()));
   }
 
-  if (sub_list_sh.size() > 0) {
-    if (quote_api_->SubscribeMarketData(sub_list_sh.data(), sub_list_sh.size(),
-                                        XTP_EXCHANGE_SH) != 0) {
-      spdlog::error("[XtpQuoteApi::login] 无法订阅行情");
+  auto call = [&](std::vector<char*>* sub_list, XTP_EXCHANGE_TYPE exchange) {
+    if (sub_list->empty()) return true;
+    int ret = is_subscribe ? quote_api_->SubscribeMarketData(
+                                 sub_list->data(), sub_list->size(), exchange)
+                           : quote_api_->UnSubscribeMarketData(
+                                 sub_list->data(), sub_list->size(), exchange);
+    if (ret != 0) {
+      spdlog::error("[XtpQuoteApi::subscribe_market_data] 无法{}行情",
+                    is_subscribe ? "订阅" : "退订");
       return false;
     }
-  }
+    return true;
+  };
 
-  if (sub_list_sz.size() > 0) {
-    if (quote_api_->SubscribeMarketData(sub_list_sz.data(), sub_list_sz.size(),
-                                        XTP_EXCHANGE_SZ) != 0) {
-      spdlog::error("[XtpQuoteApi::login] 无法订阅行情");
-      return false;
-    }
-  }
+  return call(&sub_list_sh, XTP_EXCHANGE_SH) &&
+         call(&sub_list_sz, XTP_EXCHANGE_SZ);
+}
 
-  return true;
+void XtpQuoteApi::OnDisconnected(int reason) {
+  spdlog::error("[XtpQuoteApi::OnDisconnected] Disconnected. Reason: {}",
+                reason);
+  is_logon_ = false;
+  requests_.fail_all();
+  reconnector_.start([this] { return login_and_subscribe(); });
 }
 
 void XtpQuoteApi::logout() {
@@ -110,32 +165,34 @@ bool XtpQuoteApi::query_contracts() {
   }
 
   std::unique_lock<std::mutex> lock(query_mutex_);
-  if (quote_api_->QueryAllTickers(XTP_EXCHANGE_SH) != 0) {
-    spdlog::error("[XtpQuoteApi::query_contract] Failed to query SH stocks");
-    return false;
-  }
-  if (!wait_sync()) {
+  if (!query_all_tickers(XTP_EXCHANGE_SH)) {
     spdlog::error("[XtpQuoteApi::query_contract] Failed to query SH stocks");
     return false;
   }
 
-  if (quote_api_->QueryAllTickers(XTP_EXCHANGE_SZ) != 0) {
+  if (!query_all_tickers(XTP_EXCHANGE_SZ)) {
     spdlog::error("[XtpQuoteApi::query_contract] Failed to query SZ stocks");
     return false;
   }
-  if (!wait_sync()) {
-    spdlog::error("[XtpQuoteApi::query_contract] Failed to query SZ stocks");
+
+  return true;
+}
+
+bool XtpQuoteApi::query_all_tickers(XTP_EXCHANGE_TYPE exchange_id) {
+  requests_.add(kQueryTickersReqId);
+  if (quote_api_->QueryAllTickers(exchange_id) != 0) {
+    requests_.remove(kQueryTickersReqId);
     return false;
   }
 
-  return true;
+  return requests_.wait(kQueryTickersReqId, timeout_);
 }
 
 void XtpQuoteApi::OnQueryAllTickers(XTPQSI* ticker_info, XTPRI* error_info,
                                     bool is_last) {
   if (is_error_rsp(error_info)) {
     spdlog::error("[XtpQuoteApi::OnQueryAllTickers] {}", error_info->error_msg);
-    error();
+    requests_.error(kQueryTickersReqId);
     return;
   }
 
@@ -147,18 +204,18 @@ void XtpQuoteApi::OnQueryAllTickers(XTPQSI* ticker_info, XTPRI* error_info,
     contract.ticker = ticker_info->ticker;
     contract.exchange = ft_exchange_type(ticker_info->exchange_id);
     contract.name = ticker_info->ticker_name;
-    contract.price_tick = ticker_info->price_tick;
-    contract.long_margin_rate = 1.0;
-    contract.short_margin_rate = 1.0;
+    contract.params.price_tick = ticker_info->price_tick;
+    contract.params.long_margin_rate = 1.0;
+    contract.params.short_margin_rate = 1.0;
     if (ticker_info->ticker_type == XTP_TICKER_TYPE_STOCK)
-      contract.product_type = ProductType::STOCK;
+      contract.params.product_type = ProductType::STOCK;
     else if (ticker_info->ticker_type == XTP_TICKER_TYPE_FUND)
-      contract.product_type = ProductType::FUND;
-    contract.size = 1;
+      contract.params.product_type = ProductType::FUND;
+    contract.params.size = 1;
     engine_->on_query_contract(&contract);
   }
 
-  if (is_last) done();
+  if (is_last) requests_.done(kQueryTickersReqId);
 }
 
 void XtpQuoteApi::OnDepthMarketData(XTPMD* market_data, int64_t bid1_qty[],
@@ -179,7 +236,7 @@ void XtpQuoteApi::OnDepthMarketData(XTPMD* market_data, int64_t bid1_qty[],
   }
 
   TickData tick{};
-  tick.ticker_index = contract->index;
+  tick.ticker_index = contract->params.index;
 
   uint64_t sec = (market_data->data_time / 1000) % 100;
   uint64_t min = (market_data->data_time / 100000) % 100;
@@ -205,41 +262,41 @@ void XtpQuoteApi::OnDepthMarketData(XTPMD* market_data, int64_t bid1_qty[],
   tick.ask[2] = market_data->ask[2];
   tick.ask[3] = market_data->ask[3];
   tick.ask[4] = market_data->ask[4];
-  tick.ask[0] = market_data->ask[5];
-  tick.ask[1] = market_data->ask[6];
-  tick.ask[2] = market_data->ask[7];
-  tick.ask[3] = market_data->ask[8];
-  tick.ask[4] = market_data->ask[9];
+  tick.ask[5] = market_data->ask[5];
+  tick.ask[6] = market_data->ask[6];
+  tick.ask[7] = market_data->ask[7];
+  tick.ask[8] = market_data->ask[8];
+  tick.ask[9] = market_data->ask[9];
   tick.ask_volume[0] = market_data->ask_qty[0];
   tick.ask_volume[1] = market_data->ask_qty[1];
   tick.ask_volume[2] = market_data->ask_qty[2];
   tick.ask_volume[3] = market_data->ask_qty[3];
   tick.ask_volume[4] = market_data->ask_qty[4];
-  tick.ask_volume[0] = market_data->ask_qty[5];
-  tick.ask_volume[1] = market_data->ask_qty[6];
-  tick.ask_volume[2] = market_data->ask_qty[7];
-  tick.ask_volume[3] = market_data->ask_qty[8];
-  tick.ask_volume[4] = market_data->ask_qty[9];
+  tick.ask_volume[5] = market_data->ask_qty[5];
+  tick.ask_volume[6] = market_data->ask_qty[6];
+  tick.ask_volume[7] = market_data->ask_qty[7];
+  tick.ask_volume[8] = market_data->ask_qty[8];
+  tick.ask_volume[9] = market_data->ask_qty[9];
   tick.bid[0] = market_data->bid[0];
   tick.bid[1] = market_data->bid[1];
   tick.bid[2] = market_data->bid[2];
   tick.bid[3] = market_data->bid[3];
   tick.bid[4] = market_data->bid[4];
-  tick.bid[0] = market_data->bid[5];
-  tick.bid[1] = market_data->bid[6];
-  tick.bid[2] = market_data->bid[7];
-  tick.bid[3] = market_data->bid[8];
-  tick.bid[4] = market_data->bid[9];
+  tick.bid[5] = market_data->bid[5];
+  tick.bid[6] = market_data->bid[6];
+  tick.bid[7] = market_data->bid[7];
+  tick.bid[8] = market_data->bid[8];
+  tick.bid[9] = market_data->bid[9];
   tick.bid_volume[0] = market_data->bid_qty[0];
   tick.bid_volume[1] = market_data->bid_qty[1];
   tick.bid_volume[2] = market_data->bid_qty[2];
   tick.bid_volume[3] = market_data->bid_qty[3];
   tick.bid_volume[4] = market_data->bid_qty[4];
-  tick.bid_volume[0] = market_data->bid_qty[5];
-  tick.bid_volume[1] = market_data->bid_qty[6];
-  tick.bid_volume[2] = market_data->bid_qty[7];
-  tick.bid_volume[3] = market_data->bid_qty[8];
-  tick.bid_volume[4] = market_data->bid_qty[9];
+  tick.bid_volume[5] = market_data->bid_qty[5];
+  tick.bid_volume[6] = market_data->bid_qty[6];
+  tick.bid_volume[7] = market_data->bid_qty[7];
+  tick.bid_volume[8] = market_data->bid_qty[8];
+  tick.bid_volume[9] = market_data->bid_qty[9];
 
   spdlog::trace(
       "[XtpQuoteApi::OnRtnDepthMarketData] {}, TimeMs: {}, LastPrice:{:.2f}, "
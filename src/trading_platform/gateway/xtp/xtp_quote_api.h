@@ -16,6 +16,8 @@
 #include "core/protocol.h"
 #include "gateway/xtp/xtp_common.h"
 #include "interface/trading_engine_interface.h"
+#include "utils/reconnector.h"
+#include "utils/request_tracker.h"
 
 namespace ft {
 
@@ -29,10 +31,18 @@ class XtpQuoteApi : public XTP::API::QuoteSpi {
 
   void logout();
 
+  // 运行时增减订阅。未登录时只更新subscribed_list_，登录后统一订阅
+  bool subscribe(const std::vector<std::string>& tickers);
+
+  bool unsubscribe(const std::vector<std::string>& tickers);
+
   bool query_contract(const std::string& ticker, const std::string& exchange);
 
   bool query_contracts();
 
+  // XTP不会自动重连，断线后在reconnector_的线程中重新登录并订阅
+  void OnDisconnected(int reason) override;
+
   void OnQueryAllTickers(XTPQSI* ticker_info, XTPRI* error_info,
                          bool is_last) override;
 
@@ -42,29 +52,38 @@ class XtpQuoteApi : public XTP::API::QuoteSpi {
                          int32_t max_ask1_count) override;
 
  private:
-  void done() { is_done_ = true; }
+  bool query_all_tickers(XTP_EXCHANGE_TYPE exchange_id);
 
-  void error() { is_error_ = true; }
+  // 登录并订阅subscribed_list_中的合约
+  bool login_and_subscribe();
 
-  bool wait_sync() {
-    while (!is_done_)
-      if (is_error_) return false;
-
-    is_done_ = false;
-    return true;
-  }
+  // 按交易所分组后订阅或退订
+  bool subscribe_market_data(const std::vector<std::string>& tickers,
+                             bool is_subscribe);
 
  private:
   TradingEngineInterface* engine_;
   std::unique_ptr<XTP::API::QuoteApi, XtpApiDeleter> quote_api_;
 
+  std::string ip_;
+  int port_ = 0;
+  XTP_PROTOCOL_TYPE sock_type_ = XTP_PROTOCOL_TCP;
+  std::string investor_id_;
+  std::string password_;
+  std::mutex sub_mutex_;  // 保护subscribed_list_，重连线程会读取
   std::vector<std::string> subscribed_list_;
 
-  volatile bool is_logon_ = false;
-  volatile bool is_error_ = false;
-  volatile bool is_done_ = false;
+  std::atomic<bool> is_logon_ = false;
 
+  // OnQueryAllTickers中没有request_id，由query_mutex_保证同一时刻只有一个
+  // 合约查询，使用固定的req_id跟踪
+  static constexpr int kQueryTickersReqId = 0;
+  RequestTracker requests_;
+  RequestTracker::Timeout timeout_{10000};
   std::mutex query_mutex_;
+
+  // 最后声明，析构时最先停止重连线程
+  Reconnector reconnector_;
 };
 
 }  // namespace ft
@@ -14,21 +14,38 @@ namespace ft {
 
 XtpTradeApi::XtpTradeApi(TradingEngineInterface* engine) : engine_(engine) {
   uint32_t seed = time(nullptr);
-  uint8_t client_id = rand_r(&seed) & 0xff;
-  trade_api_.reset(XTP::API::TraderApi::CreateTraderApi(client_id, "."));
+  client_id_ = rand_r(&seed) & 0xff;
+  trade_api_.reset(XTP::API::TraderApi::CreateTraderApi(client_id_, "."));
   if (!trade_api_) {
     spdlog::error("[XtpTradeApi::XtpTradeApi] Failed to CreateTraderApi");
     exit(-1);
   }
 }
 
+template <class ReqFunc>
+int XtpTradeApi::send_request(const char* name, ReqFunc&& req_func) {
+  int req_id = next_req_id();
+  requests_.add(req_id);
+  if (req_func(req_id) != 0) {
+    spdlog::error("[XtpTradeApi::send_request] Failed to call {}. {}", name,
+                  trade_api_->GetApiLastError()->error_msg);
+    requests_.remove(req_id);
+    return -1;
+  }
+  return req_id;
+}
+
 XtpTradeApi::~XtpTradeApi() {
-  error();
+  has_logged_in_ = false;
+  requests_.fail_all();
+  reconnector_.stop();
   logout();
+  requests_.fail_all();
 }
 
 bool XtpTradeApi::login(const Config& config) {
   investor_id_ = config.investor_id;
+  timeout_ = RequestTracker::Timeout(config.request_timeout_ms);
 
   char protocol[32]{};
   char ip[32]{};
@@ -48,20 +65,25 @@ bool XtpTradeApi::login(const Config& config) {
     return false;
   }
 
-  XTP_PROTOCOL_TYPE sock_type = XTP_PROTOCOL_TCP;
-  if (strcmp(protocol, "udp") == 0) sock_type = XTP_PROTOCOL_UDP;
+  ip_ = ip;
+  port_ = port;
+  sock_type_ = XTP_PROTOCOL_TCP;
+  if (strcmp(protocol, "udp") == 0) sock_type_ = XTP_PROTOCOL_UDP;
+  password_ = config.password;
 
   trade_api_->SubscribePublicTopic(XTP_TERT_QUICK);
   trade_api_->RegisterSpi(this);
   trade_api_->SetSoftwareKey(config.auth_code.c_str());
-  session_id_ = trade_api_->Login(ip, port, config.investor_id.c_str(),
-                                  config.password.c_str(), sock_type);
+  session_id_ = trade_api_->Login(ip_.c_str(), port_, investor_id_.c_str(),
+                                  password_.c_str(), sock_type_);
   if (session_id_ == 0) {
     spdlog::error("[XtpTradeApi::login] Failed to Call API login: {}",
                   trade_api_->GetApiLastError()->error_msg);
     return false;
   }
 
+  init_order_templates();
+
   if (config.cancel_outstanding_orders_on_startup) {
     spdlog::debug("[XtpTradeApi::login] Cancel outstanding orders on startup");
     if (!query_orders()) {
@@ -72,13 +94,149 @@ bool XtpTradeApi::login(const Config& config) {
     }
   }
 
+  has_logged_in_ = true;
   return true;
 }
 
 void XtpTradeApi::logout() {
-  if (session_id_ != 0) {
-    trade_api_->Logout(session_id_);
-    session_id_ = 0;
+  uint64_t session_id = session_id_.exchange(0);
+  if (session_id != 0) trade_api_->Logout(session_id);
+}
+
+void XtpTradeApi::OnDisconnected(uint64_t session_id, int reason) {
+  if (session_id != session_id_) return;
+
+  spdlog::error(
+      "[XtpTradeApi::OnDisconnected] Disconnected. SessionID: {}, Reason: {}",
+      session_id, reason);
+
+  // 等待中的请求不会再有回报
+  session_id_ = 0;
+  requests_.fail_all();
+  engine_->on_disconnected();
+  if (has_logged_in_)
+    reconnector_.start([this] { return resume_session(); });
+}
+
+bool XtpTradeApi::resume_session() {
+  // 上一次重试可能已经登录成功，只是同步订单失败
+  if (session_id_ == 0) {
+    uint64_t session_id =
+        trade_api_->Login(ip_.c_str(), port_, investor_id_.c_str(),
+                          password_.c_str(), sock_type_);
+    if (session_id == 0) {
+      spdlog::error("[XtpTradeApi::resume_session] Failed to login: {}",
+                    trade_api_->GetApiLastError()->error_msg);
+      return false;
+    }
+    session_id_ = session_id;
+  }
+
+  if (!resync_orders()) {
+    spdlog::error("[XtpTradeApi::resume_session] Failed. Retry later");
+    return false;
+  }
+
+  spdlog::info("[XtpTradeApi::resume_session] Success. SessionID: {}",
+               session_id_.load());
+  return true;
+}
+
+bool XtpTradeApi::resync_orders() {
+  {
+    std::unique_lock<std::mutex> lock(resync_mutex_);
+    resync_trades_.clear();
+  }
+
+  // 先查成交再查订单，订单查询的回报中才能拿到该订单完整的成交记录
+  XTPQueryTraderReq trade_req{};
+  int req_id = send_request("QueryTrades", [&](int req_id) {
+    resync_trade_req_id_ = req_id;
+    return trade_api_->QueryTrades(&trade_req, session_id_, req_id);
+  });
+  if (!wait(req_id)) {
+    spdlog::error("[XtpTradeApi::resync_orders] Failed to query trades");
+    return false;
+  }
+
+  XTPQueryOrderReq order_req{};
+  req_id = send_request("QueryOrders", [&](int req_id) {
+    resync_order_req_id_ = req_id;
+    return trade_api_->QueryOrders(&order_req, session_id_, req_id);
+  });
+  bool ok = wait(req_id);
+  if (!ok) spdlog::error("[XtpTradeApi::resync_orders] Failed to query orders");
+
+  {
+    std::unique_lock<std::mutex> lock(resync_mutex_);
+    resync_trades_.clear();
+  }
+
+  // 查询完整返回后才能确定哪些订单没有到达柜台
+  if (ok) engine_->on_order_sync_finished();
+  return ok;
+}
+
+void XtpTradeApi::on_resync_trade(const XTPQueryTradeRsp& trade) {
+  // ETF申赎的成交由成分股的回报组成，无法按订单对账，只同步普通买卖
+  if (trade.business_type != XTP_BUSINESS_TYPE_CASH) return;
+
+  OrderTradedRsp rsp{};
+  rsp.engine_order_id = trade.order_client_id;
+  rsp.order_id = trade.order_xtp_id;
+  rsp.volume = trade.quantity;
+  rsp.price = trade.price;
+  rsp.trade_type = TradeType::SECONDARY_MARKET;
+
+  std::unique_lock<std::mutex> lock(resync_mutex_);
+  resync_trades_[rsp.order_id].emplace_back(rsp);
+}
+
+void XtpTradeApi::on_resync_order(const XTPQueryOrderRsp& order) {
+  // 同一账户可能有其他进程在交易，client_id不同的订单不是本进程发出的
+  if (trade_api_->GetClientIDByXTPID(order.order_xtp_id) != client_id_) return;
+
+  OrderSyncRsp rsp{};
+  rsp.engine_order_id = order.order_client_id;
+
+  // ETF申赎无法按订单对账，还没有被交易所接受的订单之后的回报会正常推送，
+  // 这两种情况都只告知引擎柜台已经收到该订单
+  if (order.business_type != XTP_BUSINESS_TYPE_CASH ||
+      order.order_status == XTP_ORDER_STATUS_INIT ||
+      order.order_status == XTP_ORDER_STATUS_UNKNOWN) {
+    engine_->on_order_synced(&rsp);
+    return;
+  }
+
+  rsp.order_id = order.order_xtp_id;
+  if (order.order_status == XTP_ORDER_STATUS_REJECTED) {
+    rsp.rejected = true;
+    engine_->on_order_synced(&rsp);
+    return;
+  }
+
+  rsp.accepted = true;
+  if (order.order_status == XTP_ORDER_STATUS_CANCELED ||
+      order.order_status == XTP_ORDER_STATUS_PARTTRADEDNOTQUEUEING)
+    rsp.canceled_volume = static_cast<int>(order.qty_left);
+
+  std::unique_lock<std::mutex> lock(resync_mutex_);
+  auto iter = resync_trades_.find(rsp.order_id);
+  if (iter != resync_trades_.end()) {
+    rsp.trades = iter->second.data();
+    rsp.num_trades = static_cast<int>(iter->second.size());
+  }
+  engine_->on_order_synced(&rsp);
+}
+
+void XtpTradeApi::init_order_templates() {
+  order_templates_.clear();
+  order_templates_.resize(ContractTable::size() + 1);
+  for (uint32_t i = 1; i <= ContractTable::size(); ++i) {
+    auto contract = ContractTable::get_by_index(i);
+    auto& req = order_templates_[i];
+    req.market = xtp_market_type(contract->params.exchange_id);
+    strncpy(req.ticker, contract->ticker.data(), sizeof(req.ticker) - 1);
   }
 }
 
@@ -89,9 +247,18 @@ bool XtpTradeApi::send_order(const OrderReq& order) {
     return false;
   }
 
-  auto contract = order.contract;
+  uint32_t ticker_index = order.params->index;
+  if (ticker_index >= order_templates_.size()) {
+    spdlog::error("[XtpTradeApi::send_order] Contract not found");
+    return false;
+  }
+
+  XTPOrderInsertInfo req = order_templates_[ticker_index];
+  if (req.market == XTP_MKT_UNKNOWN) {
+    spdlog::error("[XtpTradeApi::send_order] Unknown exchange");
+    return false;
+  }
 
-  XTPOrderInsertInfo req{};
   req.side = xtp_side(order.direction);
   if (req.side == XTP_SIDE_UNKNOWN) {
     spdlog::error("[XtpTradeApi::send_order] 不支持的交易类型");
@@ -105,20 +272,13 @@ bool XtpTradeApi::send_order(const OrderReq& order) {
       return false;
     }
     req.business_type = XTP_BUSINESS_TYPE_CASH;
-    req.price = order.price;
+    req.price = order.real_price();
   } else {
     req.price_type = XTP_PRICE_LIMIT;
     req.business_type = XTP_BUSINESS_TYPE_ETF;
   }
 
-  req.market = xtp_market_type(contract->exchange);
-  if (req.market == XTP_MKT_UNKNOWN) {
-    spdlog::error("[XtpTradeApi::send_order] Unknown exchange");
-    return false;
-  }
-
   req.order_client_id = order.engine_order_id;
-  strncpy(req.ticker, contract->ticker.c_str(), sizeof(req.ticker));
   req.quantity = order.volume;
 
   uint64_t xtp_order_id = trade_api_->InsertOrder(&req, session_id_);
@@ -143,13 +303,15 @@ void XtpTradeApi::OnOrderEvent(XTPOrderInfo* order_info, XTPRI* error_info,
   }
 
   if (is_error_rsp(error_info)) {
-    OrderRejectedRsp rsp = {order_info->order_client_id, error_info->error_msg};
+    OrderRejectedRsp rsp = {order_info->order_client_id,
+                            {error_info->error_msg}};
     engine_->on_order_rejected(&rsp);
     return;
   }
 
   if (order_info->order_status == XTP_ORDER_STATUS_REJECTED) {
-    OrderRejectedRsp rsp = {order_info->order_client_id, error_info->error_msg};
+    OrderRejectedRsp rsp = {order_info->order_client_id,
+                            {error_info ? error_info->error_msg : ""}};
     engine_->on_order_rejected(&rsp);
     return;
   }
@@ -202,12 +364,12 @@ void XtpTradeApi::OnTradeEvent(XTPTradeReport* trade_info,
     // 即ETF的普通成交类型
     // 这个信息对我们来说没有用处，反而会扰乱仓位的计算
     // 所以在此处过滤掉该回报
-    if (contract->product_type == ProductType::FUND &&
+    if (contract->params.product_type == ProductType::FUND &&
         trade_info->trade_type == XTP_TRDT_COMMON)
       return;
 
     // 收到成分股回报，需要设置ticker_index, direction等信息
-    rsp.ticker_index = contract->index;
+    rsp.ticker_index = contract->params.index;
     rsp.direction = trade_info->side == XTP_SIDE_PURCHASE ? Direction::PURCHASE
                                                           : Direction::REDEEM;
     rsp.trade_type = ft_trade_type(trade_info->side, trade_info->trade_type);
@@ -250,13 +412,13 @@ void XtpTradeApi::OnCancelOrderError(XTPOrderCancelInfo* cancel_info,
 }
 
 bool XtpTradeApi::query_position(const std::string& ticker) {
-  int res =
-      trade_api_->QueryPosition(ticker.c_str(), session_id_, next_req_id());
-  if (res != 0) {
-    spdlog::error("[XtpTradeApi::query_position] Failed to call QueryPosition");
-    return false;
-  }
-  return wait_sync();
+  return wait(query_position_async(ticker));
+}
+
+int XtpTradeApi::query_position_async(const std::string& ticker) {
+  return send_request("QueryPosition", [&](int req_id) {
+    return trade_api_->QueryPosition(ticker.c_str(), session_id_, req_id);
+  });
 }
 
 bool XtpTradeApi::query_positions() { return query_position(""); }
@@ -268,8 +430,8 @@ void XtpTradeApi::OnQueryPosition(XTPQueryStkPositionRsp* position,
     spdlog::error(
         "[CtpTradeApi::OnRspQryInvestorPosition] Failed. Error Msg: {}",
         error_info->error_msg);
-    pos_cache_.clear();
-    error();
+    pos_cache_.erase(request_id);
+    requests_.error(request_id);
     return;
   }
 
@@ -288,8 +450,8 @@ void XtpTradeApi::OnQueryPosition(XTPQueryStkPositionRsp* position,
       goto check_last;
     }
 
-    auto& pos = pos_cache_[contract->index];
-    pos.ticker_index = contract->index;
+    auto& pos = pos_cache_[request_id][contract->params.index];
+    pos.ticker_index = contract->params.index;
 
     // 暂时只支持普通股票
     auto& pos_detail = pos.long_pos;
@@ -301,41 +463,37 @@ void XtpTradeApi::OnQueryPosition(XTPQueryStkPositionRsp* position,
 
 check_last:
   if (is_last) {
-    for (auto& [ticker_index, pos] : pos_cache_) {
+    for (auto& [ticker_index, pos] : pos_cache_[request_id]) {
       UNUSED(ticker_index);
       engine_->on_query_position(&pos);
     }
-    pos_cache_.clear();
-    done();
+    pos_cache_.erase(request_id);
+    requests_.done(request_id);
   }
 }
 
-bool XtpTradeApi::query_account() {
-  if (trade_api_->QueryAsset(session_id_, next_req_id()) != 0) {
-    spdlog::error("[XtpTradeApi::query_account] {}",
-                  trade_api_->GetApiLastError()->error_msg);
-    return false;
-  }
+bool XtpTradeApi::query_account() { return wait(query_account_async()); }
 
-  return wait_sync();
+int XtpTradeApi::query_account_async() {
+  return send_request("QueryAsset", [&](int req_id) {
+    return trade_api_->QueryAsset(session_id_, req_id);
+  });
 }
 
 void XtpTradeApi::OnQueryAsset(XTPQueryAssetRsp* asset, XTPRI* error_info,
                                int request_id, bool is_last,
                                uint64_t session_id) {
-  UNUSED(request_id);
-
   if (session_id_ != session_id) return;
 
   if (is_error_rsp(error_info)) {
     spdlog::error("[XtpTradeApi::OnQueryAsset] {}", error_info->error_msg);
-    error();
+    requests_.error(request_id);
     return;
   }
 
   if (!asset) {
     spdlog::error("[[XtpTradeApi::OnQueryAsset] nullptr");
-    error();
+    requests_.error(request_id);
     return;
   }
 
@@ -364,31 +522,31 @@ void XtpTradeApi::OnQueryAsset(XTPQueryAssetRsp* asset, XTPRI* error_info,
   account.frozen = asset->withholding_amount;
   engine_->on_query_account(&account);
 
-  if (is_last) done();
+  if (is_last) requests_.done(request_id);
 }
 
 bool XtpTradeApi::query_orders() {
   XTPQueryOrderReq req{};
 
-  if (trade_api_->QueryOrders(&req, session_id_, next_req_id()) != 0) {
-    spdlog::error("[XtpTradeApi::query_orders] {}",
-                  trade_api_->GetApiLastError()->error_msg);
-    return false;
-  }
-
-  return wait_sync();
+  return wait(send_request("QueryOrders", [&](int req_id) {
+    return trade_api_->QueryOrders(&req, session_id_, req_id);
+  }));
 }
 
 void XtpTradeApi::OnQueryOrder(XTPQueryOrderRsp* order_info, XTPRI* error_info,
                                int request_id, bool is_last,
                                uint64_t session_id) {
-  UNUSED(request_id);
-
   if (session_id_ != session_id) return;
 
   if (is_error_rsp(error_info)) {
     spdlog::error("[XtpTradeApi::OnQueryOrder] {}", error_info->error_msg);
-    done();
+    requests_.done(request_id);
+    return;
+  }
+
+  if (request_id == resync_order_req_id_) {
+    if (order_info) on_resync_order(*order_info);
+    if (is_last) requests_.done(request_id);
     return;
   }
 
@@ -400,31 +558,46 @@ void XtpTradeApi::OnQueryOrder(XTPQueryOrderRsp* order_info, XTPRI* error_info,
                     trade_api_->GetApiLastError()->error_msg);
   }
 
-  if (is_last) done();
+  if (is_last) requests_.done(request_id);
 }
 
-bool XtpTradeApi::query_trades() {
+bool XtpTradeApi::query_trades() { return wait(query_trades_async()); }
+
+int XtpTradeApi::query_trades_async() {
   XTPQueryTraderReq req{};
 
-  if (trade_api_->QueryTrades(&req, session_id_, next_req_id()) != 0) {
-    spdlog::error("[XtpTradeApi::query_trades] {}",
-                  trade_api_->GetApiLastError()->error_msg);
-    return false;
-  }
+  return send_request("QueryTrades", [&](int req_id) {
+    return trade_api_->QueryTrades(&req, session_id_, req_id);
+  });
+}
 
-  return wait_sync();
+bool XtpTradeApi::query_batch(uint32_t types) {
+  // 所有请求先发出再一起等待，XTP没有保证金率查询，忽略MARGIN_RATES
+  std::vector<int> req_ids;
+  if (types & QueryType::ACCOUNT) req_ids.emplace_back(query_account_async());
+  if (types & QueryType::POSITIONS)
+    req_ids.emplace_back(query_position_async(""));
+  if (types & QueryType::TRADES) req_ids.emplace_back(query_trades_async());
+
+  bool ok = requests_.wait_all(req_ids, timeout_);
+  if (!ok) spdlog::error("[XtpTradeApi::query_batch] Failed. Types: {}", types);
+  return ok;
 }
 
 void XtpTradeApi::OnQueryTrade(XTPQueryTradeRsp* trade_info, XTPRI* error_info,
                                int request_id, bool is_last,
                                uint64_t session_id) {
-  UNUSED(request_id);
-
   if (session_id_ != session_id) return;
 
   if (is_error_rsp(error_info)) {
     spdlog::error("[XtpTradeApi::OnQueryTrade] {}", error_info->error_msg);
-    done();
+    requests_.done(request_id);
+    return;
+  }
+
+  if (request_id == resync_trade_req_id_) {
+    if (trade_info) on_resync_trade(*trade_info);
+    if (is_last) requests_.done(request_id);
     return;
   }
 
@@ -434,7 +607,7 @@ void XtpTradeApi::OnQueryTrade(XTPQueryTradeRsp* trade_info, XTPRI* error_info,
     assert(contract);
 
     OrderTradedRsp trade{};
-    trade.ticker_index = contract->index;
+    trade.ticker_index = contract->params.index;
     trade.volume = trade_info->quantity;
     trade.price = trade_info->price;
     if (trade_info->side == XTP_SIDE_BUY) {
@@ -448,7 +621,7 @@ void XtpTradeApi::OnQueryTrade(XTPQueryTradeRsp* trade_info, XTPRI* error_info,
     engine_->on_query_trade(&trade);
   }
 
-  if (is_last) done();
+  if (is_last) requests_.done(request_id);
 }
 
 }  // namespace ft
@@ -10,12 +10,17 @@
 #include <memory>
 #include <mutex>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "core/config.h"
 #include "core/position.h"
 #include "core/protocol.h"
 #include "gateway/xtp/xtp_common.h"
+#include "interface/gateway.h"
 #include "interface/trading_engine_interface.h"
+#include "utils/reconnector.h"
+#include "utils/request_tracker.h"
 
 namespace ft {
 
@@ -43,6 +48,21 @@ class XtpTradeApi : public XTP::API::TraderSpi {
 
   bool query_trades();
 
+  bool query_batch(uint32_t types);
+
+  // 下面几个查询只发出请求，成功返回req_id，失败返回-1，通过wait等待结果
+  int query_position_async(const std::string& ticker);
+
+  int query_account_async();
+
+  int query_trades_async();
+
+  // 等待请求完成，超时时间为Config::request_timeout_ms
+  bool wait(int req_id) { return requests_.wait(req_id, timeout_); }
+
+  // XTP不会自动重连，断线后在reconnector_的线程中重新登录并同步订单
+  void OnDisconnected(uint64_t session_id, int reason) override;
+
   void OnOrderEvent(XTPOrderInfo* order_info, XTPRI* error_info,
                     uint64_t session_id) override;
 
@@ -67,30 +87,56 @@ class XtpTradeApi : public XTP::API::TraderSpi {
  private:
   int next_req_id() { return next_req_id_++; }
 
-  void done() { is_done_ = true; }
+  void init_order_templates();
 
-  void error() { is_error_ = true; }
+  // 重新登录并同步订单，失败时按退避时间重试
+  bool resume_session();
 
-  bool wait_sync() {
-    while (!is_done_)
-      if (is_error_) return false;
+  // 查询当日的成交及订单，补齐断线期间丢失的回报
+  bool resync_orders();
 
-    is_done_ = false;
-    return true;
-  }
+  void on_resync_trade(const XTPQueryTradeRsp& trade);
+
+  void on_resync_order(const XTPQueryOrderRsp& order);
+
+  // 登记并发出请求，成功返回req_id，失败返回-1
+  template <class ReqFunc>
+  int send_request(const char* name, ReqFunc&& req_func);
 
  private:
   TradingEngineInterface* engine_;
   std::unique_ptr<XTP::API::TraderApi, XtpApiDeleter> trade_api_;
 
+  uint8_t client_id_;
+  std::string ip_;
+  int port_ = 0;
+  XTP_PROTOCOL_TYPE sock_type_ = XTP_PROTOCOL_TCP;
   std::string investor_id_;
-  uint64_t session_id_ = 0;
+  std::string password_;
+  std::atomic<uint64_t> session_id_ = 0;
   std::atomic<uint32_t> next_req_id_ = 1;
+  std::atomic<bool> has_logged_in_ = false;  // 首次登录成功后才需要重连
+
+  RequestTracker requests_;
+  RequestTracker::Timeout timeout_{10000};
+
+  // 持仓查询的回报按request_id分别缓存，最后一个回报到达时一起推送
+  std::map<int, std::map<uint64_t, Position>> pos_cache_;
+
+  // 按ticker_index预先填充好合约相关字段的报单请求，报单时只需要补充价格、
+  // 数量等字段
+  std::vector<XTPOrderInsertInfo> order_templates_;
+
+  // 同步订单时的查询请求，回报按request_id与普通查询区分
+  std::atomic<int> resync_trade_req_id_ = -1;
+  std::atomic<int> resync_order_req_id_ = -1;
 
-  volatile bool is_done_ = false;
-  volatile bool is_error_ = false;
+  // 同步期间查询到的成交，按order_xtp_id归类，供随后的订单查询使用
+  std::mutex resync_mutex_;
+  std::unordered_map<uint64_t, std::vector<OrderTradedRsp>> resync_trades_;
 
-  std::map<uint64_t, Position> pos_cache_;
+  // 最后声明，析构时最先停止重连线程，保证线程退出前其他成员都还有效
+  Reconnector reconnector_;
 };
 
 }  // namespace ft
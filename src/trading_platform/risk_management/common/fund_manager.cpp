@@ -26,17 +26,18 @@ int FundManager::check_order_req(const Order* order) {
   auto* req = &order->req;
   if (is_offset_close(req->offset)) return NO_ERROR;
 
-  auto contract = ContractTable::get_by_index(req->contract->index);
+  auto contract = req->params;
   assert(contract);
   assert(contract->size > 0);
 
+  double price = to_real_price(req->price, contract->price_tick);
   double estimated = 0;
   if (req->direction == Direction::BUY) {
     estimated =
-        req->price * req->volume * contract->size * contract->long_margin_rate;
+        price * req->volume * contract->size * contract->long_margin_rate;
   } else if (req->direction == Direction::SELL) {
     estimated =
-        req->price * req->volume * contract->size * contract->short_margin_rate;
+        price * req->volume * contract->size * contract->short_margin_rate;
   }
 
   if (account_->cash * 1.1 < estimated) return ERR_FUND_NOT_ENOUGH;
@@ -45,14 +46,8 @@ int FundManager::check_order_req(const Order* order) {
 }
 
 void FundManager::on_order_sent(const Order* order) {
-  auto contract = order->req.contract;
-
   if (is_offset_open(order->req.offset)) {
-    auto margin_rate = order->req.direction == Direction::BUY
-                           ? contract->long_margin_rate
-                           : contract->short_margin_rate;
-    double changed =
-        contract->size * order->req.volume * order->req.price * margin_rate;
+    double changed = frozen_of(order->req, order->req.volume);
     account_->cash -= changed;
     account_->frozen += changed;
     spdlog::debug("Account: balance:{:.3f} frozen:{:.3f} margin:{:.3f}",
@@ -63,14 +58,13 @@ void FundManager::on_order_sent(const Order* order) {
 void FundManager::on_order_traded(const Order* order,
                                   const OrderTradedRsp* trade) {
   if (trade->trade_type == TradeType::SECONDARY_MARKET) {
-    auto contract = order->req.contract;
+    auto contract = order->req.params;
 
     if (is_offset_open(order->req.offset)) {
       auto margin_rate = order->req.direction == Direction::BUY
                              ? contract->long_margin_rate
                              : contract->short_margin_rate;
-      auto frozen_released =
-          contract->size * trade->volume * order->req.price * margin_rate;
+      auto frozen_released = frozen_of(order->req, trade->volume);
       auto margin = contract->size * trade->volume * trade->price * margin_rate;
       account_->frozen -= frozen_released;
       account_->margin += margin;
@@ -100,11 +94,7 @@ void FundManager::on_order_traded(const Order* order,
 
 void FundManager::on_order_canceled(const Order* order, int canceled) {
   if (is_offset_open(order->req.offset)) {
-    auto contract = order->req.contract;
-    auto margin_rate = order->req.direction == Direction::BUY
-                           ? contract->long_margin_rate
-                           : contract->short_margin_rate;
-    double changed = contract->size * canceled * order->req.price * margin_rate;
+    double changed = frozen_of(order->req, canceled);
     account_->frozen -= changed;
     account_->cash += changed;
 
@@ -119,4 +109,42 @@ void FundManager::on_order_rejected(const Order* order, int error_code) {
   on_order_canceled(order, order->req.volume);
 }
 
+int FundManager::check_amend_req(const Order* order, const Order* amended) {
+  if (order->req.direction != Direction::BUY &&
+      order->req.direction != Direction::SELL)
+    return NO_ERROR;
+  if (!is_offset_open(order->req.offset)) return NO_ERROR;
+
+  // 只需要检查新增的冻结资金
+  int done = order->traded_volume + order->canceled_volume;
+  double changed = frozen_of(amended->req, amended->req.volume - done) -
+                   frozen_of(order->req, order->req.volume - done);
+  if (changed > 0 && account_->cash * 1.1 < changed)
+    return ERR_FUND_NOT_ENOUGH;
+
+  return NO_ERROR;
+}
+
+void FundManager::on_order_amended(const Order* order,
+                                   const OrderReq& old_req) {
+  if (!is_offset_open(order->req.offset)) return;
+
+  int done = order->traded_volume + order->canceled_volume;
+  double changed = frozen_of(order->req, order->req.volume - done) -
+                   frozen_of(old_req, old_req.volume - done);
+  account_->cash -= changed;
+  account_->frozen += changed;
+  spdlog::debug("Account: balance:{:.3f} frozen:{:.3f} margin:{:.3f}",
+                account_->total_asset, account_->frozen, account_->margin);
+}
+
+double FundManager::frozen_of(const OrderReq& req, int unfilled) {
+  auto contract = req.params;
+  auto margin_rate = req.direction == Direction::BUY
+                         ? contract->long_margin_rate
+                         : contract->short_margin_rate;
+  double price = to_real_price(req.price, contract->price_tick);
+  return contract->size * unfilled * price * margin_rate;
+}
+
 }  // namespace ft
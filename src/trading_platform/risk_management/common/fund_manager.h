@@ -27,6 +27,15 @@ class FundManager : public RiskRuleInterface {
 
   void on_order_rejected(const Order* order, int error_code) override;
 
+  int check_amend_req(const Order* order, const Order* amended) override;
+
+  void on_order_amended(const Order* order, const OrderReq& old_req) override;
+
+ private:
+  // 订单unfilled手冻结的资金，仅对开仓有效。冻结及释放都通过它计算，
+  // 合约参数只从req.params读取
+  static double frozen_of(const OrderReq& req, int unfilled);
+
  private:
   Account* account_{nullptr};
 };
@@ -20,29 +20,31 @@ int NoSelfTradeRule::check_order_req(const Order* order) {
     return NO_ERROR;
 
   auto req = &order->req;
-  auto contract = req->contract;
+  auto params = req->params;
 
   uint64_t opp_d = opp_direction(req->direction);  // 对手方
   const OrderReq* pending_order;
   for (auto& [engine_order_id, o] : *order_map_) {
     UNUSED(engine_order_id);
     pending_order = &o.req;
+    // 整数价格只在同一个合约内可比
+    if (pending_order->params != params) continue;
     if (pending_order->direction != opp_d) continue;
 
     // 存在市价单直接拒绝
     if (pending_order->type == OrderType::MARKET ||
         (req->direction == Direction::BUY &&
-         req->price > pending_order->price - 1e-5) ||
+         req->price >= pending_order->price) ||
         (req->direction == Direction::SELL &&
-         req->price < pending_order->price + 1e-5)) {
+         req->price <= pending_order->price)) {
       spdlog::error(
           "[RiskMgr] Self trade! Ticker: {}. This Order: "
           "[Direction: {}, Type: {}, Price: {:.2f}]. "
           "Pending Order: [Direction: {}, Type: {}, Price: {:.2f}]",
-          contract->ticker, direction_str(req->direction),
-          ordertype_str(req->type), req->price,
+          req->contract->ticker, direction_str(req->direction),
+          ordertype_str(req->type), req->real_price(),
           direction_str(pending_order->direction),
-          ordertype_str(pending_order->type), pending_order->price);
+          ordertype_str(pending_order->type), pending_order->real_price());
       return ERR_SELF_TRADE;
     }
   }
@@ -50,4 +52,12 @@ int NoSelfTradeRule::check_order_req(const Order* order) {
   return NO_ERROR;
 }
 
+int NoSelfTradeRule::check_amend_req(const Order* order,
+                                     const Order* amended) {
+  // 只改数量不会与对手方的挂单成交
+  if (amended->req.price == order->req.price) return NO_ERROR;
+
+  return check_order_req(amended);
+}
+
 }  // namespace ft
@@ -22,6 +22,8 @@ class NoSelfTradeRule : public RiskRuleInterface {
 
   int check_order_req(const Order* req) override;
 
+  int check_amend_req(const Order* order, const Order* amended) override;
+
  private:
   OrderMap* order_map_;
 };
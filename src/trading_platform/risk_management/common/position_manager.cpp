@@ -24,7 +24,7 @@ int PositionManager::check_order_req(const Order* order) {
   if (is_offset_close(req->offset)) {
     int available = 0;
     auto pos =
-        const_cast<const Portfolio*>(portfolio_)->find(req->contract->index);
+        const_cast<const Portfolio*>(portfolio_)->find(req->params->index);
 
     if (pos) {
       uint32_t d = opp_direction(req->direction);
@@ -45,7 +45,7 @@ int PositionManager::check_order_req(const Order* order) {
 }
 
 void PositionManager::on_order_sent(const Order* order) {
-  portfolio_->update_pending(order->req.contract->index, order->req.direction,
+  portfolio_->update_pending(order->req.params->index, order->req.direction,
                              order->req.offset, order->req.volume);
 }
 
@@ -53,29 +53,67 @@ void PositionManager::on_order_traded(const Order* order,
                                       const OrderTradedRsp* trade) {
   if (trade->trade_type == TradeType::SECONDARY_MARKET ||
       trade->trade_type == TradeType::PRIMARY_MARKET) {
-    portfolio_->update_traded(order->req.contract->index, order->req.direction,
+    portfolio_->update_traded(order->req.params->index, order->req.direction,
                               order->req.offset, trade->volume, trade->price);
   } else if (trade->trade_type == TradeType::ACQUIRED_STOCK) {
-    auto contract = ContractTable::get_by_index(trade->ticker_index);
-    assert(contract);
-    portfolio_->update_component_stock(contract->index, trade->volume, true);
+    assert(ContractTable::get_params(trade->ticker_index));
+    portfolio_->update_component_stock(trade->ticker_index, trade->volume,
+                                       true);
   } else if (trade->trade_type == TradeType::RELEASED_STOCK) {
-    auto contract = ContractTable::get_by_index(trade->ticker_index);
-    assert(contract);
-    portfolio_->update_component_stock(contract->index, trade->volume, false);
+    assert(ContractTable::get_params(trade->ticker_index));
+    portfolio_->update_component_stock(trade->ticker_index, trade->volume,
+                                       false);
   }
 }
 
 void PositionManager::on_order_canceled(const Order* order, int canceled) {
-  portfolio_->update_pending(order->req.contract->index, order->req.direction,
+  portfolio_->update_pending(order->req.params->index, order->req.direction,
                              order->req.offset, 0 - canceled);
 }
 
 void PositionManager::on_order_rejected(const Order* order, int error_code) {
   if (error_code <= ERR_SEND_FAILED) return;
 
-  portfolio_->update_pending(order->req.contract->index, order->req.direction,
+  portfolio_->update_pending(order->req.params->index, order->req.direction,
                              order->req.offset, 0 - order->req.volume);
 }
 
+int PositionManager::check_amend_req(const Order* order,
+                                     const Order* amended) {
+  if (order->req.direction != Direction::BUY &&
+      order->req.direction != Direction::SELL)
+    return NO_ERROR;
+
+  // 平仓单只需要检查增加的部分，减少委托量总是允许的
+  auto* req = &order->req;
+  int added = amended->req.volume - req->volume;
+  if (!is_offset_close(req->offset) || added <= 0) return NO_ERROR;
+
+  int available = 0;
+  auto pos =
+      const_cast<const Portfolio*>(portfolio_)->find(req->params->index);
+  if (pos) {
+    uint32_t d = opp_direction(req->direction);
+    auto& detail = d == Direction::BUY ? pos->long_pos : pos->short_pos;
+    available = detail.holdings - detail.close_pending;
+  }
+
+  if (available < added) {
+    spdlog::error(
+        "[PositionManager::check_amend_req] Not enough volume to close. "
+        "Available: {}, Added: {}",
+        available, added);
+    return ERR_POSITION_NOT_ENOUGH;
+  }
+
+  return NO_ERROR;
+}
+
+void PositionManager::on_order_amended(const Order* order,
+                                       const OrderReq& old_req) {
+  portfolio_->update_pending(order->req.params->index, order->req.direction,
+                             order->req.offset,
+                             order->req.volume - old_req.volume);
+}
+
 }  // namespace ft
@@ -26,6 +26,10 @@ class PositionManager : public RiskRuleInterface {
 
   void on_order_rejected(const Order* order, int error_code) override;
 
+  int check_amend_req(const Order* order, const Order* amended) override;
+
+  void on_order_amended(const Order* order, const OrderReq& old_req) override;
+
  private:
   Portfolio* portfolio_;
 };
@@ -2,29 +2,32 @@
 
 #include "risk_management/common/strategy_notifier.h"
 
+#include "core/wire_codec.h"
+#include "ipc/redis_md_helper.h"
+
 namespace ft {
 
 void StrategyNotifier::on_order_accepted(const Order* order) {
-  if (order->strategy_id[0] != 0) {
-    OrderResponse rsp{};
+  if (order->strategy_id != 0) {
+    WireOrderResponse rsp{};
     rsp.user_order_id = order->user_order_id;
     rsp.order_id = order->order_id;
-    rsp.ticker_index = order->req.contract->index;
+    rsp.ticker_index = order->req.params->index;
     rsp.direction = order->req.direction;
     rsp.offset = order->req.offset;
     rsp.original_volume = order->req.volume;
     rsp.error_code = NO_ERROR;
-    rsp_redis_.publish(order->strategy_id, &rsp, sizeof(rsp));
+    publish(order->strategy_id, rsp);
   }
 }
 
 void StrategyNotifier::on_order_traded(const Order* order,
                                        const OrderTradedRsp* trade) {
-  if (order->strategy_id[0] != 0) {
-    OrderResponse rsp{};
+  if (order->strategy_id != 0) {
+    WireOrderResponse rsp{};
     rsp.user_order_id = order->user_order_id;
     rsp.order_id = order->order_id;
-    rsp.ticker_index = order->req.contract->index;
+    rsp.ticker_index = order->req.params->index;
     rsp.direction = order->req.direction;
     rsp.offset = order->req.offset;
     rsp.original_volume = order->req.volume;
@@ -34,7 +37,7 @@ void StrategyNotifier::on_order_traded(const Order* order,
     rsp.completed =
         order->canceled_volume + order->traded_volume == order->req.volume;
     rsp.error_code = NO_ERROR;
-    rsp_redis_.publish(order->strategy_id, &rsp, sizeof(rsp));
+    publish(order->strategy_id, rsp);
   }
 }
 
@@ -44,18 +47,61 @@ void StrategyNotifier::on_order_canceled(const Order* order, int canceled) {
 }
 
 void StrategyNotifier::on_order_rejected(const Order* order, int error_code) {
-  if (order->strategy_id[0] != 0) {
-    OrderResponse rsp{};
+  if (order->strategy_id != 0) {
+    WireOrderResponse rsp{};
     rsp.user_order_id = order->user_order_id;
     rsp.order_id = order->order_id;
-    rsp.ticker_index = order->req.contract->index;
+    rsp.ticker_index = order->req.params->index;
     rsp.direction = order->req.direction;
     rsp.offset = order->req.offset;
     rsp.original_volume = order->req.volume;
     rsp.completed = true;
     rsp.error_code = error_code;
-    rsp_redis_.publish(order->strategy_id, &rsp, sizeof(rsp));
+    publish(order->strategy_id, rsp);
+  }
+}
+
+void StrategyNotifier::on_order_amended(const Order* order,
+                                        const OrderReq& old_req) {
+  if (order->strategy_id != 0) {
+    WireOrderAmended rsp{};
+    rsp.user_order_id = order->user_order_id;
+    rsp.order_id = order->order_id;
+    rsp.ticker_index = order->req.params->index;
+    rsp.direction = order->req.direction;
+    rsp.offset = order->req.offset;
+    rsp.volume = order->req.volume;
+    rsp.traded_volume = order->traded_volume;
+    rsp.price = order->req.real_price();
+    rsp.completed =
+        order->canceled_volume + order->traded_volume == order->req.volume;
+    publish(order->strategy_id, rsp);
   }
 }
 
+// 改单被拒时订单仍然有效，completed为false
+void StrategyNotifier::on_order_amend_rejected(const Order* order,
+                                               int error_code) {
+  if (order->strategy_id != 0) {
+    WireOrderResponse rsp{};
+    rsp.user_order_id = order->user_order_id;
+    rsp.order_id = order->order_id;
+    rsp.ticker_index = order->req.params->index;
+    rsp.direction = order->req.direction;
+    rsp.offset = order->req.offset;
+    rsp.original_volume = order->req.volume;
+    rsp.traded_volume = order->traded_volume;
+    rsp.error_code = error_code;
+    publish(order->strategy_id, rsp);
+  }
+}
+
+template <class Record>
+void StrategyNotifier::publish(uint32_t strategy_id, const Record& rsp) {
+  WireWriter writer(WIRE_RESPONSES);
+  writer.append(rsp);
+  auto msg = writer.finish(strategy_id, ++rsp_seqs_[strategy_id]);
+  rsp_redis_.publish(order_rsp_topic(strategy_id), msg, writer.size());
+}
+
 }  // namespace ft
@@ -3,6 +3,9 @@
 #ifndef FT_SRC_RISK_MANAGEMENT_COMMON_STRATEGY_NOTIFIER_H_
 #define FT_SRC_RISK_MANAGEMENT_COMMON_STRATEGY_NOTIFIER_H_
 
+#include <unordered_map>
+
+#include "core/wire_protocol.h"
 #include "ipc/redis.h"
 #include "risk_management/risk_rule_interface.h"
 
@@ -19,7 +22,18 @@ class StrategyNotifier : public RiskRuleInterface {
 
   void on_order_rejected(const Order* order, int error_code) override;
 
+  void on_order_amended(const Order* order, const OrderReq& old_req) override;
+
+  void on_order_amend_rejected(const Order* order, int error_code) override;
+
+ private:
+  // Record为WireOrderResponse或WireOrderAmended
+  template <class Record>
+  void publish(uint32_t strategy_id, const Record& rsp);
+
+ private:
   RedisSession rsp_redis_;
+  std::unordered_map<uint32_t, uint64_t> rsp_seqs_;
 };
 
 }  // namespace ft
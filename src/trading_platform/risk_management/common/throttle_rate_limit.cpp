@@ -17,7 +17,17 @@ bool ThrottleRateLimit::init(const Config& config, Account* account,
 }
 
 int ThrottleRateLimit::check_order_req(const Order* order) {
-  auto* req = &order->req;
+  if (order->is_replacement) return NO_ERROR;
+  return check(order->req.engine_order_id, order->req.volume);
+}
+
+int ThrottleRateLimit::check_amend_req(const Order* order,
+                                       const Order* amended) {
+  int added = amended->req.volume - order->req.volume;
+  return check(order->req.engine_order_id, added > 0 ? added : 0);
+}
+
+int ThrottleRateLimit::check(uint64_t engine_order_id, int volume) {
   if ((order_limit_ == 0 && volume_limit_ == 0) || period_ms_ == 0)
     return NO_ERROR;
 
@@ -39,8 +49,7 @@ int ThrottleRateLimit::check_order_req(const Order* order) {
       return ERR_THROTTLE_RATE_LIMIT;
     }
 
-    order_tm_record_.emplace_back(
-        std::make_tuple(current_ms, order->req.engine_order_id));
+    order_tm_record_.emplace_back(std::make_tuple(current_ms, engine_order_id));
   }
 
   if (volume_limit_ > 0) {
@@ -51,34 +60,42 @@ int ThrottleRateLimit::check_order_req(const Order* order) {
       iter = volume_tm_record_.erase(iter);
     }
 
-    if (volume_count_ + req->volume > volume_limit_) {
+    if (volume_count_ + volume > volume_limit_) {
       spdlog::error(
           "[ThrottleRateLimit::check] Volume reach limit within {} ms. "
           "This Order: {}, Current: {}, Limit: {}",
-          period_ms_, req->volume, volume_count_, volume_limit_);
+          period_ms_, volume, volume_count_, volume_limit_);
       return ERR_THROTTLE_RATE_LIMIT;
     }
 
-    volume_count_ += req->volume;
+    volume_count_ += volume;
     volume_tm_record_.emplace_back(
-        std::make_tuple(current_ms, req->volume, order->req.engine_order_id));
+        std::make_tuple(current_ms, volume, engine_order_id));
   }
 
   return NO_ERROR;
 }
 
 void ThrottleRateLimit::on_order_rejected(const Order* order, int error_code) {
-  if (error_code <= ERR_SEND_FAILED) {
-    if (!volume_tm_record_.empty() &&
-        std::get<2>(volume_tm_record_.back()) == order->req.engine_order_id) {
-      volume_count_ -= std::get<1>(volume_tm_record_.back());
-      volume_tm_record_.pop_back();
-    }
+  if (error_code <= ERR_SEND_FAILED) rollback(order->req.engine_order_id);
+}
 
-    if (!order_tm_record_.empty() &&
-        std::get<1>(order_tm_record_.back()) == order->req.engine_order_id) {
-      order_tm_record_.pop_back();
-    }
+void ThrottleRateLimit::on_order_amend_rejected(const Order* order,
+                                                int error_code) {
+  if (error_code <= ERR_SEND_FAILED) rollback(order->req.engine_order_id);
+}
+
+// 只撤销最近一次检查时记录的报单，检查之后发送前被拒的订单不应计入流控
+void ThrottleRateLimit::rollback(uint64_t engine_order_id) {
+  if (!volume_tm_record_.empty() &&
+      std::get<2>(volume_tm_record_.back()) == engine_order_id) {
+    volume_count_ -= std::get<1>(volume_tm_record_.back());
+    volume_tm_record_.pop_back();
+  }
+
+  if (!order_tm_record_.empty() &&
+      std::get<1>(order_tm_record_.back()) == engine_order_id) {
+    order_tm_record_.pop_back();
   }
 }
 
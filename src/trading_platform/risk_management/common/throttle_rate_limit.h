@@ -30,6 +30,16 @@ class ThrottleRateLimit : public RiskRuleInterface {
 
   void on_order_rejected(const Order* order, int error_code) override;
 
+  int check_amend_req(const Order* order, const Order* amended) override;
+
+  void on_order_amend_rejected(const Order* order, int error_code) override;
+
+ private:
+  // 改单与新订单一样计为一个报单，委托量只计增加的部分
+  int check(uint64_t engine_order_id, int volume);
+
+  void rollback(uint64_t engine_order_id);
+
  private:
   uint64_t order_limit_ = 0;
   uint64_t volume_limit_ = 0;
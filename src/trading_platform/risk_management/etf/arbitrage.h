@@ -3,23 +3,62 @@
 #ifndef FT_SRC_RISK_MANAGEMENT_ETF_ARBITRAGE_H_
 #define FT_SRC_RISK_MANAGEMENT_ETF_ARBITRAGE_H_
 
+#include <cstdint>
 #include <unordered_map>
 
+#include "risk_management/etf/etf.h"
+
 namespace ft {
 
+/*
+ * 申购时某一成分股的需求明细
+ * total_demand: 申购所需的成分股总数
+ * volume_to_use_holdings: 使用现有持仓的部分，报单发出后预留，不可再卖出
+ * volume_to_trade: 持仓不足、需要现金替代的部分
+ * current_traded: 交易所已经实际扣除（RELEASED_STOCK）的数量
+ */
 struct DemandDetail {
-  uint32_t total_demand;
+  int total_demand = 0;
 
-  uint32_t volume_to_use_holdings;
-  uint32_t volume_to_trade;
-  uint32_t current_traded;
+  int volume_to_use_holdings = 0;
+  int volume_to_trade = 0;
+  int current_traded = 0;
 };
 
+/*
+ * 一笔申购单对成分股的占用情况，在风控检查时一次性计算好，
+ * 之后的回报只需要按成分股增量更新
+ */
 class Arbitrage {
  public:
-  explicit Arbitrage(uint32_t etf_ticker_index);
+  Arbitrage() = default;
+
+  Arbitrage(const ETF* etf, int units) : etf_(etf), units_(units) {}
+
+  const ETF* etf() const { return etf_; }
+
+  int units() const { return units_; }
+
+  double cash_reserved() const { return cash_reserved_; }
+
+  void set_cash_reserved(double amount) { cash_reserved_ = amount; }
+
+  DemandDetail& demand(uint32_t ticker_index) { return demands_[ticker_index]; }
+
+  DemandDetail* find(uint32_t ticker_index) {
+    auto iter = demands_.find(ticker_index);
+    if (iter == demands_.end()) return nullptr;
+    return &iter->second;
+  }
+
+  const std::unordered_map<uint32_t, DemandDetail>& demands() const {
+    return demands_;
+  }
 
  private:
+  const ETF* etf_ = nullptr;
+  int units_ = 0;
+  double cash_reserved_ = 0;
   std::unordered_map<uint32_t, DemandDetail> demands_;
 };
 
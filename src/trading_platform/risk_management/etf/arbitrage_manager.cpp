@@ -2,6 +2,12 @@
 
 #include "risk_management/etf/arbitrage_manager.h"
 
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <climits>
+
+#include "core/contract_table.h"
 #include "risk_management/etf/etf_table.h"
 
 namespace ft {
@@ -15,10 +21,313 @@ bool ArbitrageManager::init(const Config& config, Account* account,
   portfolio_ = portfolio;
   order_map_ = order_map;
   md_snapshot_ = md_snapshot;
+  reserved_.resize(ContractTable::size() + 1, 0);
+  component_baskets_.resize(ContractTable::size() + 1);
+
+  if (!EtfTable::init(config.arg0, config.arg1)) return false;
+
+  // 每个ETF的一篮子成分股只整理一次，申购检查时顺序访问
+  for (uint32_t i = 1; i <= ContractTable::size(); ++i) {
+    auto etf = EtfTable::get_by_index(i);
+    if (!etf) continue;
 
-  return EtfTable::init(config.arg0, config.arg1);
+    auto& basket = baskets_[i];
+    basket.cash_per_unit =
+        etf->must_cash_substitution + std::max(etf->cash_component, 0.0);
+    for (auto& [ticker_index, component] : etf->components) {
+      basket.components.push_back({ticker_index, component.volume,
+                                   component.replace_type == FORBIDDEN,
+                                   component.contract});
+      component_baskets_[ticker_index].emplace_back(&basket);
+    }
+  }
+
+  return true;
+}
+
+int ArbitrageManager::check_order_req(const Order* order) {
+  switch (order->req.direction) {
+    case Direction::PURCHASE:
+      return check_purchase(order);
+    case Direction::REDEEM:
+      return check_redeem(order);
+    case Direction::SELL:
+      return check_sell(order);
+    default:
+      return NO_ERROR;
+  }
 }
 
-int ArbitrageManager::check_order_req(const Order* order) { return NO_ERROR; }
+int ArbitrageManager::check_purchase(const Order* order) {
+  auto* req = &order->req;
+  auto etf = EtfTable::get_by_index(req->params->index);
+  if (!etf || !etf->purchase_allowed || etf->unit <= 0 ||
+      req->volume % etf->unit != 0) {
+    spdlog::error(
+        "[ArbitrageManager::check_purchase] {} purchase not allowed. "
+        "Volume:{}",
+        req->contract->ticker, req->volume);
+    return ERR_ETF_NOT_ALLOWED;
+  }
+
+  auto& basket = baskets_[req->params->index];
+  if (basket.dirty) refresh(&basket);
+
+  int units = req->volume / etf->unit;
+  Arbitrage arbitrage(etf, units);
+
+  // 持仓足够时全部使用持仓，不需要现金替代，预留在发单后按篮子进行
+  double substitution = 0;
+  if (units > basket.covered_units) {
+    // 逐个成分股计算可用持仓与缺口，缺口部分按最新价估算现金替代金额
+    double basket_value = 0;
+    bool all_priced = true;
+    for (auto& component : basket.components) {
+      auto& demand = arbitrage.demand(component.ticker_index);
+      demand.total_demand = component.volume * units;
+      demand.volume_to_use_holdings =
+          std::min(demand.total_demand,
+                   std::max(available_holdings(component.ticker_index), 0));
+      demand.volume_to_trade =
+          demand.total_demand - demand.volume_to_use_holdings;
+
+      auto tick = md_snapshot_->get(component.ticker_index);
+      TickPrice last_price = tick ? tick->last_price : 0;
+      if (last_price <= 0) all_priced = false;
+      double price = to_real_price(
+          last_price,
+          ContractTable::get_params(component.ticker_index)->price_tick);
+      basket_value += price * demand.total_demand;
+
+      if (demand.volume_to_trade <= 0) continue;
+
+      if (component.forbidden) {
+        spdlog::error(
+            "[ArbitrageManager::check_purchase] {} 禁止现金替代，持仓不足. "
+            "Demand:{}, Available:{}",
+            component.contract->ticker, demand.total_demand,
+            demand.volume_to_use_holdings);
+        return ERR_POSITION_NOT_ENOUGH;
+      }
+
+      if (last_price <= 0) {
+        spdlog::error(
+            "[ArbitrageManager::check_purchase] {} 无行情，无法估算现金替代",
+            component.contract->ticker);
+        return ERR_CASH_SUBSTITUTION_EXCEEDED;
+      }
+
+      substitution += price * demand.volume_to_trade;
+    }
+
+    if (substitution > 0) {
+      double total_value = 0;
+      auto etf_tick = md_snapshot_->get(req->params->index);
+      if (etf_tick && etf_tick->iopv > 1e-5) {
+        total_value = etf_tick->iopv * req->volume;
+      } else if (all_priced) {
+        total_value =
+            basket_value +
+            (etf->cash_component + etf->must_cash_substitution) * units;
+      }
+
+      if (total_value < 1e-5 ||
+          substitution / total_value > etf->max_cash_ratio + 1e-5) {
+        spdlog::error(
+            "[ArbitrageManager::check_purchase] {} 现金替代超限. "
+            "Substitution:{:.3f}, Total:{:.3f}, MaxRatio:{:.3f}",
+            req->contract->ticker, substitution, total_value,
+            etf->max_cash_ratio);
+        return ERR_CASH_SUBSTITUTION_EXCEEDED;
+      }
+    }
+  }
+
+  double cash_needed = substitution + basket.cash_per_unit * units;
+  if (account_->cash < cash_needed) {
+    spdlog::error(
+        "[ArbitrageManager::check_purchase] {} 资金不足. Needed:{:.3f}, "
+        "Cash:{:.3f}",
+        req->contract->ticker, cash_needed, account_->cash);
+    return ERR_FUND_NOT_ENOUGH;
+  }
+
+  arbitrage.set_cash_reserved(cash_needed);
+  pending_ = std::move(arbitrage);
+  pending_order_id_ = req->engine_order_id;
+  return NO_ERROR;
+}
+
+int ArbitrageManager::check_redeem(const Order* order) {
+  auto* req = &order->req;
+  auto etf = EtfTable::get_by_index(req->params->index);
+  if (!etf || !etf->redeem_allowed || etf->unit <= 0 ||
+      req->volume % etf->unit != 0) {
+    spdlog::error(
+        "[ArbitrageManager::check_redeem] {} redeem not allowed. Volume:{}",
+        req->contract->ticker, req->volume);
+    return ERR_ETF_NOT_ALLOWED;
+  }
+
+  int available = 0;
+  auto pos = const_cast<const Portfolio*>(portfolio_)->find(
+      req->params->index);
+  if (pos) available = pos->long_pos.holdings - pos->long_pos.close_pending;
+  if (available < req->volume) {
+    spdlog::error(
+        "[ArbitrageManager::check_redeem] Not enough ETF to redeem. "
+        "Available:{}, OrderVolume:{}",
+        available, req->volume);
+    return ERR_POSITION_NOT_ENOUGH;
+  }
+
+  // 现金差额为负时赎回方需要补足差额
+  int units = req->volume / etf->unit;
+  double cash_needed = std::max(-etf->cash_component, 0.0) * units;
+  if (account_->cash < cash_needed) return ERR_FUND_NOT_ENOUGH;
+
+  return NO_ERROR;
+}
+
+int ArbitrageManager::check_sell(const Order* order) {
+  auto* req = &order->req;
+  if (reserved_[req->params->index] <= 0) return NO_ERROR;
+
+  int available = available_holdings(req->params->index);
+  if (available < req->volume) {
+    spdlog::error(
+        "[ArbitrageManager::check_sell] {} 成分股已被申购占用. "
+        "Available:{}, Reserved:{}, OrderVolume:{}",
+        req->contract->ticker, available, reserved_[req->params->index],
+        req->volume);
+    return ERR_POSITION_NOT_ENOUGH;
+  }
+
+  return NO_ERROR;
+}
+
+int ArbitrageManager::available_holdings(uint32_t ticker_index) const {
+  auto pos = const_cast<const Portfolio*>(portfolio_)->find(ticker_index);
+  if (!pos) return 0 - reserved_[ticker_index];
+
+  return pos->long_pos.holdings - pos->long_pos.close_pending -
+         reserved_[ticker_index];
+}
+
+void ArbitrageManager::on_order_sent(const Order* order) {
+  mark_dirty(order->req.params->index);
+  if (order->req.direction != Direction::PURCHASE) return;
+  if (pending_order_id_ != order->req.engine_order_id) return;
+
+  // 检查时持仓足够的申购没有逐个成分股计算，这里按篮子全部使用持仓
+  if (pending_.demands().empty()) {
+    auto& basket = baskets_[order->req.params->index];
+    for (auto& component : basket.components) {
+      auto& demand = pending_.demand(component.ticker_index);
+      demand.total_demand = component.volume * pending_.units();
+      demand.volume_to_use_holdings = demand.total_demand;
+    }
+  }
+
+  for (auto& [ticker_index, demand] : pending_.demands()) {
+    reserved_[ticker_index] += demand.volume_to_use_holdings;
+    mark_dirty(ticker_index);
+  }
+
+  account_->cash -= pending_.cash_reserved();
+  account_->frozen += pending_.cash_reserved();
+
+  arbitrages_.emplace(pending_order_id_, std::move(pending_));
+  pending_ = Arbitrage();
+  pending_order_id_ = 0;
+}
+
+void ArbitrageManager::on_order_traded(const Order* order,
+                                       const OrderTradedRsp* trade) {
+  mark_dirty(order->req.params->index);
+  mark_dirty(trade->ticker_index);
+  if (order->req.direction != Direction::PURCHASE) return;
+
+  if (trade->trade_type == TradeType::RELEASED_STOCK) {
+    auto iter = arbitrages_.find(order->req.engine_order_id);
+    if (iter == arbitrages_.end()) return;
+
+    auto demand = iter->second.find(trade->ticker_index);
+    if (!demand) return;
+
+    int remain = demand->volume_to_use_holdings - demand->current_traded;
+    int released = std::min(std::max(remain, 0), trade->volume);
+    reserved_[trade->ticker_index] -= released;
+    demand->current_traded += trade->volume;
+  } else if (trade->trade_type == TradeType::PRIMARY_MARKET) {
+    // 引擎收到申购成交后直接删除订单，不会回调on_order_completed
+    release(order->req.engine_order_id);
+  }
+}
+
+void ArbitrageManager::on_order_canceled(const Order* order, int canceled) {
+  mark_dirty(order->req.params->index);
+  if (order->req.direction != Direction::PURCHASE) return;
+  release(order->req.engine_order_id);
+}
+
+void ArbitrageManager::on_order_completed(const Order* order) {
+  mark_dirty(order->req.params->index);
+  if (order->req.direction != Direction::PURCHASE) return;
+  release(order->req.engine_order_id);
+}
+
+void ArbitrageManager::on_order_rejected(const Order* order, int error_code) {
+  mark_dirty(order->req.params->index);
+  if (order->req.direction != Direction::PURCHASE) return;
+
+  if (error_code <= ERR_SEND_FAILED) {
+    if (pending_order_id_ == order->req.engine_order_id) {
+      pending_ = Arbitrage();
+      pending_order_id_ = 0;
+    }
+    return;
+  }
+
+  release(order->req.engine_order_id);
+}
+
+// 卖单改单会改变成分股的待平仓数量
+void ArbitrageManager::on_order_amended(const Order* order,
+                                        const OrderReq& old_req) {
+  mark_dirty(order->req.params->index);
+}
+
+void ArbitrageManager::release(uint64_t engine_order_id) {
+  auto iter = arbitrages_.find(engine_order_id);
+  if (iter == arbitrages_.end()) return;
+
+  auto& arbitrage = iter->second;
+  for (auto& [ticker_index, demand] : arbitrage.demands()) {
+    int remain = demand.volume_to_use_holdings - demand.current_traded;
+    if (remain > 0) reserved_[ticker_index] -= remain;
+    mark_dirty(ticker_index);
+  }
+
+  // 申购的资金只做预留，实际的资金变动以柜台查询结果为准
+  account_->cash += arbitrage.cash_reserved();
+  account_->frozen -= arbitrage.cash_reserved();
+  arbitrages_.erase(iter);
+}
+
+void ArbitrageManager::mark_dirty(uint32_t ticker_index) {
+  for (auto basket : component_baskets_[ticker_index]) basket->dirty = true;
+}
+
+void ArbitrageManager::refresh(Basket* basket) {
+  int covered = INT_MAX;
+  for (auto& component : basket->components) {
+    if (component.volume <= 0) continue;
+    int available = std::max(available_holdings(component.ticker_index), 0);
+    covered = std::min(covered, available / component.volume);
+  }
+  basket->covered_units = covered;
+  basket->dirty = false;
+}
 
 }  // namespace ft
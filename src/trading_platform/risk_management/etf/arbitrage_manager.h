@@ -4,11 +4,23 @@
 #define FT_SRC_RISK_MANAGEMENT_ETF_ARBITRAGE_MANAGER_H_
 
 #include <map>
+#include <unordered_map>
+#include <vector>
 
+#include "risk_management/etf/arbitrage.h"
 #include "risk_management/risk_rule_interface.h"
 
 namespace ft {
 
+/*
+ * ETF申赎风控
+ * 申购：检查成分股持仓是否足够（扣除其他在途申购已预留的部分），
+ *       不足部分按现金替代估算，检查现金替代比例及可用资金。每个ETF
+ *       的一篮子成分股在载入时整理好，可用持仓能覆盖的篮子数缓存下来，
+ *       成分股的可用持仓变化时才重新计算，持仓足够时不需要逐个成分股检查
+ * 赎回：检查ETF持仓及赎回所需的现金差额
+ * 卖出成分股：不能卖出已被在途申购预留的成分股
+ */
 class ArbitrageManager : public RiskRuleInterface {
  public:
   bool init(const Config& config, Account* account, Portfolio* portfolio,
@@ -16,23 +28,63 @@ class ArbitrageManager : public RiskRuleInterface {
 
   int check_order_req(const Order* order) override;
 
-  void on_order_sent(const Order* order) {}
+  void on_order_sent(const Order* order) override;
 
-  void on_order_accepted(const Order* order) {}
+  void on_order_traded(const Order* order,
+                       const OrderTradedRsp* trade) override;
 
-  void on_order_traded(const Order* order, const OrderTradedRsp* trade) {}
+  void on_order_canceled(const Order* order, int canceled) override;
 
-  void on_order_canceled(const Order* order, int canceled) {}
+  void on_order_completed(const Order* order) override;
 
-  void on_order_completed(const Order* order) {}
+  void on_order_rejected(const Order* order, int error_code) override;
 
-  void on_order_rejected(const Order* order, int error_code) {}
+  void on_order_amended(const Order* order, const OrderReq& old_req) override;
+
+ private:
+  int check_purchase(const Order* order);
+
+  int check_redeem(const Order* order);
+
+  int check_sell(const Order* order);
+
+  int available_holdings(uint32_t ticker_index) const;
+
+  void release(uint64_t engine_order_id);
+
+  struct BasketComponent {
+    uint32_t ticker_index;
+    int volume;  // 每篮子所需数量
+    bool forbidden;
+    const Contract* contract;
+  };
+
+  struct Basket {
+    std::vector<BasketComponent> components;
+    double cash_per_unit;  // 每篮子必须以现金支付的部分
+    int covered_units = 0;  // 现有可用持仓能够完全覆盖的篮子数
+    bool dirty = true;
+  };
+
+  // 成分股的可用持仓变化后，包含它的篮子需要重新计算covered_units
+  void mark_dirty(uint32_t ticker_index);
+
+  void refresh(Basket* basket);
 
  private:
   Account* account_;
   Portfolio* portfolio_;
   OrderMap* order_map_;
   const MdSnapshot* md_snapshot_;
+
+  std::vector<int> reserved_;  // 按ticker_index索引，被在途申购预留的成分股
+  Arbitrage pending_;          // 最近一次通过检查的申购，发单后转为在途
+  uint64_t pending_order_id_ = 0;
+  std::unordered_map<uint64_t, Arbitrage> arbitrages_;  // 在途申购
+
+  std::unordered_map<uint32_t, Basket> baskets_;  // ETF的ticker_index -> 篮子
+  // 按成分股的ticker_index索引，包含该成分股的篮子
+  std::vector<std::vector<Basket*>> component_baskets_;
 };
 
 }  // namespace ft
@@ -9,6 +9,7 @@
 #include <fstream>
 #include <map>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "core/contract.h"
@@ -49,8 +50,7 @@ class EtfTable {
       etf->cash_component = std::stod(tokens[6]);
       etf->must_cash_substitution = 0;
 
-      etf_vec_[contract->index] = etf;
-      etf_map_[contract->ticker] = etf;
+      etf_vec_[contract->params.index] = etf;
     }
 
     ifs.close();
@@ -65,10 +65,11 @@ class EtfTable {
       tokens.clear();
       split(line, ",", &tokens);
 
-      auto iter = etf_map_.find(tokens[0]);
-      if (iter == etf_map_.end()) continue;
+      auto etf_contract = ContractTable::get_by_ticker(tokens[0]);
+      if (!etf_contract) continue;
 
-      auto etf = iter->second;
+      auto etf = etf_vec_[etf_contract->params.index];
+      if (!etf) continue;
 
       int replace_type = std::stoul(tokens[4]);
       if (replace_type == MUST || replace_type == RECOMPUTE) {
@@ -79,8 +80,7 @@ class EtfTable {
         if (!contract) {
           spdlog::warn("[etf] {} is not allowed to purchase/redeem",
                        etf->contract->ticker);
-          etf_vec_[etf->contract->index] = nullptr;
-          etf_map_.erase(iter);
+          etf_vec_[etf->contract->params.index] = nullptr;
           delete etf;
           continue;
         }
@@ -90,7 +90,7 @@ class EtfTable {
         component.etf_contract = etf->contract;
         component.replace_type = replace_type;
         component.volume = std::stod(tokens[5]);
-        etf->components.emplace(contract->index, component);
+        etf->components.emplace(contract->params.index, component);
       }
     }
 
@@ -102,15 +102,14 @@ class EtfTable {
     return etf_vec_[ticker_index];
   }
 
-  static const ETF* get_by_ticker(const std::string& ticker) {
-    auto iter = etf_map_.find(ticker);
-    if (iter == etf_map_.end()) return nullptr;
-    return iter->second;
+  static const ETF* get_by_ticker(std::string_view ticker) {
+    auto contract = ContractTable::get_by_ticker(ticker);
+    if (!contract) return nullptr;
+    return etf_vec_[contract->params.index];
   }
 
  private:
   static inline std::vector<ETF*> etf_vec_;
-  static inline std::unordered_map<std::string, ETF*> etf_map_;
 };
 
 }  // namespace ft
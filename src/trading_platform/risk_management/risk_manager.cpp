@@ -71,4 +71,25 @@ void RiskManager::on_order_completed(const Order* order) {
   for (auto& rule : rules_) rule->on_order_completed(order);
 }
 
+int RiskManager::check_amend_req(const Order* order, const Order* amended) {
+  int error_code;
+
+  for (auto& rule : rules_) {
+    error_code = rule->check_amend_req(order, amended);
+    if (error_code != NO_ERROR) return error_code;
+  }
+
+  return NO_ERROR;
+}
+
+void RiskManager::on_order_amended(const Order* order,
+                                   const OrderReq& old_req) {
+  for (auto& rule : rules_) rule->on_order_amended(order, old_req);
+}
+
+void RiskManager::on_order_amend_rejected(const Order* order,
+                                          int error_code) {
+  for (auto& rule : rules_) rule->on_order_amend_rejected(order, error_code);
+}
+
 }  // namespace ft
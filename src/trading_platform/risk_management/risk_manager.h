@@ -42,6 +42,12 @@ class RiskManager {
 
   void on_order_completed(const Order* order);
 
+  int check_amend_req(const Order* order, const Order* amended);
+
+  void on_order_amended(const Order* order, const OrderReq& old_req);
+
+  void on_order_amend_rejected(const Order* order, int error_code);
+
  private:
   std::list<std::shared_ptr<RiskRuleInterface>> rules_;
 };
@@ -41,6 +41,19 @@ class RiskRuleInterface {
   virtual void on_order_completed(const Order* order) {}
 
   virtual void on_order_rejected(const Order* order, int error_code) {}
+
+  /*
+   * 改单只需要处理改单前后的差额。order为当前的订单，amended为改单后的
+   * 订单，除了req.volume及req.price外与order相同
+   */
+  virtual int check_amend_req(const Order* order, const Order* amended) {
+    return NO_ERROR;
+  }
+
+  // 改单成功，order已经更新为改单后的状态，old_req为改单前的请求
+  virtual void on_order_amended(const Order* order, const OrderReq& old_req) {}
+
+  virtual void on_order_amend_rejected(const Order* order, int error_code) {}
 };
 
 }  // namespace ft
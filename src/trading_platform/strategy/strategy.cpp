@@ -2,19 +2,21 @@
 
 #include "strategy/strategy.h"
 
+#include <spdlog/spdlog.h>
+
 namespace ft {
 
 void Strategy::run() {
   on_init();
-  puller_.subscribe_order_rsp(strategy_id_);
+  if (strategy_id_ != 0) puller_.subscribe_order_rsp(strategy_id_);
 
   for (;;) {
     auto reply = puller_.pull();
-    if (reply) {
-      if (strcmp(reply->element[1]->str, strategy_id_) == 0) {
-        auto rsp =
-            reinterpret_cast<const OrderResponse*>(reply->element[2]->str);
-        on_order_rsp(*rsp);
+    // 跳过订阅及退订的确认消息
+    if (reply && reply->type == REDIS_REPLY_ARRAY && reply->elements == 3 &&
+        strcmp(reply->element[0]->str, "message") == 0) {
+      if (rsp_topic_ == reply->element[1]->str) {
+        on_order_rsp_msg(reply->element[2]->str, reply->element[2]->len);
       } else {
         auto tick = reinterpret_cast<TickData*>(reply->element[2]->str);
         on_tick(*tick);
@@ -23,8 +25,39 @@ void Strategy::run() {
   }
 }
 
+void Strategy::on_order_rsp_msg(const char* data, std::size_t size) {
+  WireReader reader;
+  if (!reader.parse(data, size)) {
+    spdlog::error("[Strategy::on_order_rsp_msg] Invalid msg. Size:{}", size);
+    return;
+  }
+
+  uint8_t type;
+  const char* body;
+  std::size_t length;
+  WireOrderResponse rsp;
+  WireOrderAmended amended;
+  while (reader.next(&type, &body, &length)) {
+    if (type == WIRE_ORDER_RESPONSE && WireReader::get(body, length, &rsp))
+      on_order_rsp(to_order_response(rsp));
+    else if (type == WIRE_ORDER_AMENDED &&
+             WireReader::get(body, length, &amended))
+      on_order_amended(to_order_amended_response(amended));
+  }
+}
+
+/*
+ * 除了订阅redis中的行情，还要通知TradingEngine，引擎按策略对每个合约计数，
+ * 只有被策略需要的合约才会向柜台订阅并发布
+ */
 void Strategy::subscribe(const std::vector<std::string>& sub_list) {
   puller_.subscribe_md(sub_list);
+  for (const auto& ticker : sub_list) sender_.subscribe(ticker);
+}
+
+void Strategy::unsubscribe(const std::vector<std::string>& sub_list) {
+  for (const auto& ticker : sub_list) sender_.unsubscribe(ticker);
+  puller_.unsubscribe_md(sub_list);
 }
 
 }  // namespace ft
@@ -17,6 +17,7 @@
 #include "ipc/redis.h"
 #include "ipc/redis_md_helper.h"
 #include "ipc/redis_position_helper.h"
+#include "ipc/redis_send_util_helper.h"
 
 namespace ft {
 
@@ -32,25 +33,32 @@ class Strategy {
 
   virtual void on_order_rsp(const OrderResponse& order) {}
 
+  // 改单成功，改单被拒仍通过on_order_rsp返回
+  virtual void on_order_amended(const OrderAmendedResponse& rsp) {}
+
   virtual void on_exit() {}
 
   /* 仅供加载器调用，内部不可使用 */
   void run();
 
   /* 策略启动后请勿更改id */
-  void set_id(const std::string& name) {
-    strncpy(strategy_id_, name.c_str(), sizeof(strategy_id_) - 1);
-    sender_.set_id(name);
+  void set_id(uint32_t strategy_id) {
+    strategy_id_ = strategy_id;
+    rsp_topic_ = order_rsp_topic(strategy_id);
+    sender_.set_id(strategy_id);
   }
 
   void set_account_id(uint64_t account_id) {
     sender_.set_account(account_id);
     pos_getter_.set_account(account_id);
+    send_util_getter_.set_account(account_id);
   }
 
  protected:
   void subscribe(const std::vector<std::string>& sub_list);
 
+  void unsubscribe(const std::vector<std::string>& sub_list);
+
   void buy_open(const std::string& ticker, int volume, double price,
                 uint64_t type = OrderType::FAK, uint32_t user_order_id = 0) {
     sender_.send_order(ticker, volume, Direction::BUY, Offset::OPEN, type,
@@ -77,6 +85,16 @@ class Strategy {
 
   void cancel_order(uint64_t order_id) { sender_.cancel_order(order_id); }
 
+  /*
+   * 修改订单的委托总量(包括已成交部分)及价格，成功时回调on_order_amended，
+   * 被拒时通过on_order_rsp返回错误码。
+   * 交易所不支持改单时由TradingEngine撤单后重新下单，此时原订单以撤单结束，
+   * 新订单的order_id不同但user_order_id不变
+   */
+  void amend_order(uint64_t order_id, int volume, double price) {
+    sender_.amend_order(order_id, volume, price);
+  }
+
   void cancel_for_ticker(const std::string& ticker) {
     sender_.cancel_for_ticker(ticker);
   }
@@ -89,6 +107,12 @@ class Strategy {
     return pos;
   }
 
+  /*
+   * 账户最近一秒的发送量与柜台流速限制之比，TradingEngine每100毫秒更新一次。
+   * 接近1时新的请求要在柜台排队等待发出，没有流速限制的柜台总是0
+   */
+  double send_utilization() const { return send_util_getter_.get(); }
+
  private:
   void send_order(const std::string& ticker, int volume, uint32_t direction,
                   uint32_t offset, uint32_t type, double price,
@@ -98,9 +122,14 @@ class Strategy {
   }
 
  private:
-  StrategyIdType strategy_id_;
+  void on_order_rsp_msg(const char* data, std::size_t size);
+
+ private:
+  uint32_t strategy_id_{0};
+  std::string rsp_topic_;
   OrderSender sender_;
   RedisPositionGetter pos_getter_;
+  RedisSendUtilGetter send_util_getter_;
   RedisTERspPuller puller_;
 };
 
@@ -18,7 +18,7 @@ static void usage() {
   printf("    --account           账户\n");
   printf("    --contracts         合约列表文件\n");
   printf("    -h, -?, --help      帮助\n");
-  printf("    --id                策略的唯一标识，用于接收订单回报\n");
+  printf("    --id                策略的数字ID，用于接收订单回报，0表示不接收\n");
   printf("    --loglevel          日志等级(info, warn, error, debug, trace)\n");
   printf("    --strategy          要加载的策略的动态库\n");
 }
@@ -28,7 +28,7 @@ int main() {
       getarg("../config/contracts.csv", "--contracts-file");
   std::string strategy_file = getarg("", "--strategy");
   std::string log_level = getarg("info", "--loglevel");
-  std::string strategy_id = getarg("Strategy", "id");
+  uint32_t strategy_id = getarg(0U, "--id");
   uint64_t account_id = getarg(0ULL, "--account");
   bool help = getarg(false, "-h", "--help", "-?");
 
@@ -17,28 +17,58 @@ class ContractCollector : public ft::TradingEngineInterface {
     return gateway_->login(this, config);
   }
 
-  bool dump(const std::string& file = "./contracts.csv") {
+  bool dump(const std::string& file = "./contracts.csv",
+            const std::string& binary_file = "") {
     if (!gateway_->query_contracts()) return false;
     ft::store_contracts(file, contracts_);
+    if (!binary_file.empty())
+      return ft::store_contracts_binary(binary_file, contracts_);
     return true;
   }
 
+  // 回调中的字符串只在回调期间有效，需要驻留后再保存
   void on_query_contract(ft::Contract* contract) override {
-    contracts_.emplace_back(*contract);
+    auto& saved = contracts_.emplace_back(*contract);
+    saved.ticker = strings_.intern(contract->ticker);
+    saved.exchange = strings_.intern(contract->exchange);
+    saved.name = strings_.intern(contract->name);
   }
 
  private:
   std::unique_ptr<ft::Gateway> gateway_;
+  ft::StringPool strings_;
   std::vector<ft::Contract> contracts_;
 };
 
+// 把已有的CSV合约文件转换为二进制合约表，不需要登录柜台
+static int convert(const std::string& input, const std::string& output) {
+  ft::StringPool strings;
+  std::vector<ft::Contract> contracts;
+  if (!ft::load_contracts(input, &contracts, &strings)) {
+    printf("failed to load %s\n", input.c_str());
+    return -1;
+  }
+
+  if (!ft::store_contracts_binary(output, contracts)) {
+    printf("failed to dump\n");
+    return -1;
+  }
+
+  printf("successfully convert %s to %s\n", input.c_str(), output.c_str());
+  return 0;
+}
+
 int main() {
   std::string login_yml = getarg("../config/login.yml", "--config");
   std::string output = getarg("./contracts.csv", "--output");
+  std::string binary_output = getarg("./contracts.bin", "--binary-output");
+  std::string input = getarg("", "--from-csv");
   std::string loglevel = getarg("info", "--loglevel");
 
   spdlog::set_level(spdlog::level::from_str(loglevel));
 
+  if (!input.empty()) exit(convert(input, binary_output));
+
   ContractCollector collector;
   ft::Config config;
   ft::load_config(login_yml, &config);
@@ -47,10 +77,12 @@ int main() {
     exit(-1);
   }
 
-  if (!collector.dump(output)) {
+  if (!collector.dump(output, binary_output)) {
     printf("failed to dump\n");
+    exit(-1);
   }
 
-  printf("successfully dump to %s\n", output.c_str());
+  printf("successfully dump to %s and %s\n", output.c_str(),
+         binary_output.c_str());
   exit(0);
 }
@@ -0,0 +1,323 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+/*
+ * 离线回放CTP的订单及成交回报，用于在没有CTP前置的情况下对
+ * CtpTradeApi的回调路径进行测试及性能评估
+ *
+ * 回报文件由若干条记录组成，每条记录为CtpRecordHeader加上原始的
+ * CThostFtdcOrderField或CThostFtdcTradeField。可以使用--generate生成
+ * 一个模拟的回报序列
+ */
+
+#include <spdlog/spdlog.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <getopt.hpp>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "core/contract_table.h"
+#include "gateway/ctp/ctp_trade_api.h"
+
+namespace {
+
+enum CtpRecordType : uint32_t {
+  CTP_RECORD_ORDER = 1,
+  CTP_RECORD_TRADE = 2,
+};
+
+struct CtpRecordHeader {
+  uint32_t type;
+  uint32_t size;
+};
+
+struct CtpRecord {
+  uint32_t type;
+  union {
+    CThostFtdcOrderField order;
+    CThostFtdcTradeField trade;
+  };
+};
+
+std::atomic<uint64_t> alloc_count = 0;
+
+class ReplayEngine : public ft::TradingEngineInterface {
+ public:
+  void on_order_accepted(ft::OrderAcceptedRsp* rsp) override { ++accepted; }
+
+  void on_order_traded(ft::OrderTradedRsp* rsp) override { ++traded; }
+
+  void on_order_rejected(ft::OrderRejectedRsp* rsp) override { ++rejected; }
+
+  void on_order_canceled(ft::OrderCanceledRsp* rsp) override { ++canceled; }
+
+  void on_order_cancel_rejected(ft::OrderCancelRejectedRsp* rsp) override {
+    ++cancel_rejected;
+  }
+
+  uint64_t accepted = 0;
+  uint64_t traded = 0;
+  uint64_t rejected = 0;
+  uint64_t canceled = 0;
+  uint64_t cancel_rejected = 0;
+};
+
+bool write_records(const std::string& file,
+                   const std::vector<CtpRecord>& records) {
+  std::ofstream ofs(file, std::ios_base::binary | std::ios_base::trunc);
+  if (!ofs) return false;
+
+  for (auto& record : records) {
+    CtpRecordHeader header{record.type, 0};
+    const char* data;
+    if (record.type == CTP_RECORD_ORDER) {
+      header.size = sizeof(record.order);
+      data = reinterpret_cast<const char*>(&record.order);
+    } else {
+      header.size = sizeof(record.trade);
+      data = reinterpret_cast<const char*>(&record.trade);
+    }
+
+    ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    ofs.write(data, header.size);
+  }
+
+  return static_cast<bool>(ofs);
+}
+
+bool read_records(const std::string& file, std::vector<CtpRecord>* records) {
+  std::ifstream ifs(file, std::ios_base::binary);
+  if (!ifs) return false;
+
+  CtpRecordHeader header;
+  while (ifs.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+    CtpRecord record{};
+    record.type = header.type;
+    if (header.type == CTP_RECORD_ORDER &&
+        header.size == sizeof(record.order)) {
+      ifs.read(reinterpret_cast<char*>(&record.order), header.size);
+    } else if (header.type == CTP_RECORD_TRADE &&
+               header.size == sizeof(record.trade)) {
+      ifs.read(reinterpret_cast<char*>(&record.trade), header.size);
+    } else {
+      printf("invalid record. type:%u size:%u\n", header.type, header.size);
+      return false;
+    }
+
+    if (!ifs) return false;
+    records->emplace_back(record);
+  }
+
+  return true;
+}
+
+// 每个订单生成：已提交 -> 未成交在队列中 -> 成交 -> 全部成交
+void generate_records(const std::string& investor_id, const std::string& ticker,
+                      int num_orders, std::vector<CtpRecord>* records) {
+  for (int i = 1; i <= num_orders; ++i) {
+    CtpRecord record{};
+    record.type = CTP_RECORD_ORDER;
+    auto& order = record.order;
+    strncpy(order.InvestorID, investor_id.c_str(),
+            sizeof(order.InvestorID) - 1);
+    strncpy(order.InstrumentID, ticker.c_str(), sizeof(order.InstrumentID) - 1);
+    snprintf(order.OrderRef, sizeof(order.OrderRef), "%d", i);
+    snprintf(order.OrderSysID, sizeof(order.OrderSysID), "%12d", i + 100000);
+    order.VolumeTotalOriginal = 1;
+
+    order.OrderSubmitStatus = THOST_FTDC_OSS_InsertSubmitted;
+    order.OrderStatus = THOST_FTDC_OST_Unknown;
+    records->emplace_back(record);
+
+    order.OrderSubmitStatus = THOST_FTDC_OSS_Accepted;
+    order.OrderStatus = THOST_FTDC_OST_NoTradeQueueing;
+    records->emplace_back(record);
+
+    CtpRecord trade_record{};
+    trade_record.type = CTP_RECORD_TRADE;
+    auto& trade = trade_record.trade;
+    strncpy(trade.InvestorID, investor_id.c_str(),
+            sizeof(trade.InvestorID) - 1);
+    strncpy(trade.InstrumentID, ticker.c_str(), sizeof(trade.InstrumentID) - 1);
+    memcpy(trade.OrderRef, order.OrderRef, sizeof(trade.OrderRef));
+    memcpy(trade.OrderSysID, order.OrderSysID, sizeof(trade.OrderSysID));
+    trade.Volume = 1;
+    trade.Price = 3000 + i % 100;
+    records->emplace_back(trade_record);
+
+    order.OrderStatus = THOST_FTDC_OST_AllTraded;
+    order.VolumeTraded = 1;
+    records->emplace_back(record);
+  }
+}
+
+}  // namespace
+
+/*
+ * 替换全局的operator new/delete以统计回调路径上的内存分配次数
+ * 需要提供完整的一组重载（数组、sized、aligned、nothrow），否则部分分配会
+ * 绕过计数，且分配与释放不匹配。定义为noinline，避免编译器把内联后的
+ * malloc/free与new/delete配对检查而报-Wmismatched-new-delete
+ */
+namespace {
+
+__attribute__((noinline)) void* counted_alloc(std::size_t size,
+                                              std::size_t align) {
+  alloc_count.fetch_add(1, std::memory_order_relaxed);
+  if (size == 0) size = 1;
+  if (align <= alignof(std::max_align_t)) return malloc(size);
+  // aligned_alloc要求size是align的整数倍
+  return aligned_alloc(align, (size + align - 1) / align * align);
+}
+
+__attribute__((noinline)) void counted_free(void* p) noexcept { free(p); }
+
+}  // namespace
+
+__attribute__((noinline)) void* operator new(std::size_t size) {
+  if (void* p = counted_alloc(size, 0)) return p;
+  throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void* operator new[](std::size_t size) {
+  if (void* p = counted_alloc(size, 0)) return p;
+  throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void* operator new(std::size_t size,
+                                             std::align_val_t align) {
+  if (void* p = counted_alloc(size, static_cast<std::size_t>(align))) return p;
+  throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void* operator new[](std::size_t size,
+                                               std::align_val_t align) {
+  if (void* p = counted_alloc(size, static_cast<std::size_t>(align))) return p;
+  throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void* operator new(std::size_t size,
+                                             const std::nothrow_t&) noexcept {
+  return counted_alloc(size, 0);
+}
+
+__attribute__((noinline)) void* operator new[](std::size_t size,
+                                               const std::nothrow_t&) noexcept {
+  return counted_alloc(size, 0);
+}
+
+__attribute__((noinline)) void operator delete(void* p) noexcept {
+  counted_free(p);
+}
+
+__attribute__((noinline)) void operator delete[](void* p) noexcept {
+  counted_free(p);
+}
+
+__attribute__((noinline)) void operator delete(void* p, std::size_t) noexcept {
+  counted_free(p);
+}
+
+__attribute__((noinline)) void operator delete[](void* p,
+                                                 std::size_t) noexcept {
+  counted_free(p);
+}
+
+__attribute__((noinline)) void operator delete(void* p,
+                                               std::align_val_t) noexcept {
+  counted_free(p);
+}
+
+__attribute__((noinline)) void operator delete[](void* p,
+                                                 std::align_val_t) noexcept {
+  counted_free(p);
+}
+
+__attribute__((noinline)) void operator delete(void* p, std::size_t,
+                                               std::align_val_t) noexcept {
+  counted_free(p);
+}
+
+__attribute__((noinline)) void operator delete[](void* p, std::size_t,
+                                                 std::align_val_t) noexcept {
+  counted_free(p);
+}
+
+__attribute__((noinline)) void operator delete(void* p,
+                                               const std::nothrow_t&) noexcept {
+  counted_free(p);
+}
+
+__attribute__((noinline)) void operator delete[](
+    void* p, const std::nothrow_t&) noexcept {
+  counted_free(p);
+}
+
+int main() {
+  std::string contracts_file =
+      getarg("../config/contracts.csv", "--contracts");
+  std::string file = getarg("./ctp_records.bin", "--file");
+  std::string investor_id = getarg("replay", "--investor_id");
+  std::string ticker = getarg("rb2009", "--ticker");
+  int generate = getarg(0, "--generate");
+  int order_ref_base = getarg(0, "--order_ref_base");
+  int loops = getarg(10, "--loops");
+  std::string loglevel = getarg("warn", "--loglevel");
+
+  spdlog::set_level(spdlog::level::from_str(loglevel));
+
+  if (!ft::ContractTable::init(contracts_file)) {
+    printf("ContractTable init failed\n");
+    exit(-1);
+  }
+
+  std::vector<CtpRecord> records;
+  if (generate > 0) {
+    generate_records(investor_id, ticker, generate, &records);
+    if (!write_records(file, records)) {
+      printf("failed to write %s\n", file.c_str());
+      exit(-1);
+    }
+    printf("generate %lu records to %s\n", records.size(), file.c_str());
+  } else if (!read_records(file, &records)) {
+    printf("failed to read %s\n", file.c_str());
+    exit(-1);
+  }
+
+  ReplayEngine engine;
+  ft::CtpTradeApi api(&engine);
+  ft::Config config;
+  config.investor_id = investor_id;
+  api.init_offline(config, order_ref_base);
+
+  uint64_t allocs_before = alloc_count.load();
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < loops; ++i) {
+    for (auto& record : records) {
+      if (record.type == CTP_RECORD_ORDER)
+        api.OnRtnOrder(&record.order);
+      else
+        api.OnRtnTrade(&record.trade);
+    }
+  }
+  auto end = std::chrono::steady_clock::now();
+  uint64_t allocs = alloc_count.load() - allocs_before;
+
+  uint64_t total = records.size() * loops;
+  auto ns =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+  printf("callbacks:%lu avg:%.1fns allocations:%lu\n", total,
+         total > 0 ? static_cast<double>(ns) / total : 0.0, allocs);
+  printf("accepted:%lu traded:%lu rejected:%lu canceled:%lu "
+         "cancel_rejected:%lu\n",
+         engine.accepted, engine.traded, engine.rejected, engine.canceled,
+         engine.cancel_rejected);
+  exit(0);
+}
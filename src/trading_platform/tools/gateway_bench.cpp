@@ -0,0 +1,285 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+/*
+ * Gateway的压力测试工具，配合gateway/mock中模拟的CTP/XTP库使用：
+ *
+ *   LD_LIBRARY_PATH=./mock_api ./gateway-bench --config=ctp_config.yml
+ *
+ * 登录并完成查询后按--rate的速率发送--orders个--volume手的限价单，其中
+ * --cancel-ratio比例的订单远离盘口挂单并在被接受后撤单，其余订单以对手价
+ * 成交，最后统计吞吐量及报单到回报的延迟。默认每单2手，
+ * 配合FT_MOCK_PARTIAL_FILL_RATIO可以覆盖部分成交的回报路径
+ *
+ * 配合FT_MOCK_DISCONNECT_AFTER_MS可以测试断线重连，断线期间发送失败的订单
+ * 不计入sent，重连后同步到的订单状态计入synced，全部订单都结束才算通过
+ */
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <getopt.hpp>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "core/constants.h"
+#include "core/contract_table.h"
+#include "interface/gateway.h"
+#include "trading_engine/config_loader.h"
+
+namespace {
+
+int64_t now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+class BenchEngine : public ft::TradingEngineInterface {
+ public:
+  BenchEngine(int num_orders, int volume, double cancel_ratio)
+      : send_ns_(num_orders + 1),
+        ack_ns_(num_orders + 1),
+        finished_flags_(num_orders + 1),
+        cancel_sent_(num_orders + 1),
+        traded_volume_(num_orders + 1),
+        volume_(volume),
+        cancel_every_(cancel_ratio > 0 ? std::lround(1 / cancel_ratio) : 0) {}
+
+  bool login(const ft::Config& config) {
+    gateway_.reset(ft::create_gateway(config.api));
+    if (!gateway_) return false;
+
+    return gateway_->login(this, config);
+  }
+
+  bool query() {
+    using ft::QueryType::ACCOUNT, ft::QueryType::POSITIONS;
+    using ft::QueryType::TRADES, ft::QueryType::MARGIN_RATES;
+    return gateway_->query_batch(ACCOUNT | POSITIONS | TRADES | MARGIN_RATES);
+  }
+
+  bool send_order(const ft::OrderReq& order) {
+    send_ns_[order.engine_order_id] = now_ns();
+    return gateway_->send_order(order);
+  }
+
+  uint64_t finished() const { return finished_.load(); }
+
+  void report(int64_t elapsed_ns) {
+    std::vector<int64_t> latency;
+    for (std::size_t i = 1; i < ack_ns_.size(); ++i) {
+      if (ack_ns_[i] > 0) latency.emplace_back(ack_ns_[i] - send_ns_[i]);
+    }
+    std::sort(latency.begin(), latency.end());
+
+    auto percentile = [&](double p) -> double {
+      if (latency.empty()) return 0;
+      std::size_t i = static_cast<std::size_t>(p * (latency.size() - 1));
+      return latency[i] / 1000.0;
+    };
+
+    printf("elapsed:%.3fs finished:%lu throughput:%.0f orders/s\n",
+           elapsed_ns / 1e9, finished_.load(),
+           elapsed_ns > 0 ? finished_.load() * 1e9 / elapsed_ns : 0.0);
+    printf("accepted:%lu traded:%lu rejected:%lu canceled:%lu "
+           "cancel_rejected:%lu partial_fills:%lu\n",
+           accepted_.load(), traded_.load(), rejected_.load(),
+           canceled_.load(), cancel_rejected_.load(), partial_fills_.load());
+    printf("ticks:%lu synced:%lu\n", ticks_.load(), synced_.load());
+    printf("ack latency(us) p50:%.1f p90:%.1f p99:%.1f max:%.1f\n",
+           percentile(0.5), percentile(0.9), percentile(0.99),
+           percentile(1.0));
+  }
+
+  void on_tick(ft::TickData* tick) override { ++ticks_; }
+
+  bool should_cancel(uint64_t engine_order_id) const {
+    return cancel_every_ > 0 && engine_order_id % cancel_every_ == 0;
+  }
+
+  void on_order_accepted(ft::OrderAcceptedRsp* rsp) override {
+    ++accepted_;
+    on_ack(rsp->engine_order_id);
+    if (should_cancel(rsp->engine_order_id))
+      cancel(rsp->engine_order_id, rsp->order_id);
+  }
+
+  // 全部成交才结束，之前的每笔成交都计为一次部分成交
+  void on_order_traded(ft::OrderTradedRsp* rsp) override {
+    uint64_t id = rsp->engine_order_id;
+    if (id >= traded_volume_.size()) return;
+
+    traded_volume_[id] += rsp->volume;
+    if (traded_volume_[id] < volume_) {
+      ++partial_fills_;
+      return;
+    }
+
+    if (finish(id)) ++traded_;
+  }
+
+  void on_order_rejected(ft::OrderRejectedRsp* rsp) override {
+    on_ack(rsp->engine_order_id);
+    if (finish(rsp->engine_order_id)) ++rejected_;
+  }
+
+  void on_order_canceled(ft::OrderCanceledRsp* rsp) override {
+    if (finish(rsp->engine_order_id)) ++canceled_;
+  }
+
+  void on_order_cancel_rejected(ft::OrderCancelRejectedRsp* rsp) override {
+    ++cancel_rejected_;
+  }
+
+  // 断线期间丢失的回报在重连后补发，同一个订单的回报可能已经处理过
+  void on_order_synced(ft::OrderSyncRsp* rsp) override {
+    ++synced_;
+    uint64_t id = rsp->engine_order_id;
+    if (rsp->rejected) {
+      on_ack(id);
+      if (finish(id)) ++rejected_;
+    } else if (rsp->num_trades > 0 && synced_volume(rsp) >= volume_) {
+      if (finish(id)) ++traded_;
+    } else if (rsp->canceled_volume > 0) {
+      if (finish(id)) ++canceled_;
+    } else if (rsp->accepted) {
+      // 断线期间没能发出的撤单在这里补发
+      on_ack(id);
+      if (should_cancel(id) && !cancel_sent_[id]) cancel(id, rsp->order_id);
+    }
+  }
+
+ private:
+  void cancel(uint64_t engine_order_id, uint64_t order_id) {
+    if (engine_order_id < cancel_sent_.size() &&
+        gateway_->cancel_order(order_id))
+      cancel_sent_[engine_order_id] = 1;
+  }
+
+  // 回报都在同一个回调线程中，返回false表示该订单已经结束过
+  bool finish(uint64_t engine_order_id) {
+    if (engine_order_id >= finished_flags_.size() ||
+        finished_flags_[engine_order_id])
+      return false;
+
+    finished_flags_[engine_order_id] = 1;
+    ++finished_;
+    return true;
+  }
+
+  int synced_volume(const ft::OrderSyncRsp* rsp) const {
+    int volume = 0;
+    for (int i = 0; i < rsp->num_trades; ++i) volume += rsp->trades[i].volume;
+    return volume;
+  }
+
+  void on_ack(uint64_t engine_order_id) {
+    if (engine_order_id < ack_ns_.size() && ack_ns_[engine_order_id] == 0)
+      ack_ns_[engine_order_id] = now_ns();
+  }
+
+ private:
+  std::unique_ptr<ft::Gateway> gateway_;
+  std::vector<int64_t> send_ns_;
+  std::vector<int64_t> ack_ns_;
+  std::vector<uint8_t> finished_flags_;
+  std::vector<uint8_t> cancel_sent_;
+  std::vector<int> traded_volume_;
+  int volume_;
+  uint64_t cancel_every_;
+
+  std::atomic<uint64_t> accepted_ = 0;
+  std::atomic<uint64_t> traded_ = 0;
+  std::atomic<uint64_t> rejected_ = 0;
+  std::atomic<uint64_t> canceled_ = 0;
+  std::atomic<uint64_t> cancel_rejected_ = 0;
+  std::atomic<uint64_t> partial_fills_ = 0;
+  std::atomic<uint64_t> finished_ = 0;
+  std::atomic<uint64_t> ticks_ = 0;
+  std::atomic<uint64_t> synced_ = 0;
+};
+
+}  // namespace
+
+int main() {
+  std::string login_yml = getarg("../config/ctp_config.yml", "--config");
+  std::string contracts_file =
+      getarg("../config/contracts.csv", "--contracts");
+  std::string ticker = getarg("rb2009", "--ticker");
+  int num_orders = getarg(10000, "--orders");
+  int rate = getarg(50000, "--rate");
+  int volume = getarg(2, "--volume");
+  double price = getarg(0.0, "--price");
+  double cancel_ratio = getarg(0.5, "--cancel-ratio");
+  int timeout_sec = getarg(30, "--timeout");
+  std::string loglevel = getarg("warn", "--loglevel");
+
+  spdlog::set_level(spdlog::level::from_str(loglevel));
+
+  if (!ft::ContractTable::init(contracts_file)) {
+    printf("ContractTable init failed\n");
+    exit(-1);
+  }
+
+  auto contract = ft::ContractTable::get_by_ticker(ticker);
+  if (!contract) {
+    printf("contract not found: %s\n", ticker.c_str());
+    exit(-1);
+  }
+
+  ft::Config config;
+  ft::load_config(login_yml, &config);
+  config.cancel_outstanding_orders_on_startup = false;
+
+  BenchEngine engine(num_orders, volume, cancel_ratio);
+  if (!engine.login(config)) {
+    printf("failed to login\n");
+    exit(-1);
+  }
+
+  if (!engine.query()) {
+    printf("failed to query\n");
+    exit(-1);
+  }
+
+  // 默认为模拟交易所的初始价格，需要撤单的订单远离盘口挂单，
+  // 其余订单以对手价成交
+  if (price <= 0) price = 100;
+  auto tick_price = ft::to_tick_price(price, contract->params.price_tick);
+  auto passive_price = tick_price - 10;
+  auto aggressive_price = tick_price + 10;
+
+  ft::OrderReq order{};
+  order.params = ft::ContractTable::get_params(contract->params.index);
+  order.contract = contract;
+  order.type = ft::OrderType::LIMIT;
+  order.direction = ft::Direction::BUY;
+  order.offset = ft::Offset::OPEN;
+  order.volume = volume;
+
+  int64_t interval_ns = rate > 0 ? 1000000000LL / rate : 0;
+  int64_t start_ns = now_ns();
+  int sent = 0;
+  for (int i = 1; i <= num_orders; ++i) {
+    int64_t due_ns = start_ns + (i - 1) * interval_ns;
+    while (now_ns() < due_ns) continue;
+
+    order.engine_order_id = i;
+    order.price = engine.should_cancel(i) ? passive_price : aggressive_price;
+    if (engine.send_order(order)) ++sent;
+  }
+
+  int64_t deadline_ns = now_ns() + timeout_sec * 1000000000LL;
+  while (engine.finished() < static_cast<uint64_t>(sent) &&
+         now_ns() < deadline_ns)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+  printf("sent:%d/%d\n", sent, num_orders);
+  engine.report(now_ns() - start_ns);
+  exit(0);
+}
@@ -0,0 +1,660 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#include "trading_engine/account_engine.h"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+
+#include "core/contract_table.h"
+#include "core/error_code.h"
+#include "utils/misc.h"
+
+namespace ft {
+
+AccountEngine::AccountEngine(TradingEngineInterface* md_handler,
+                             const MdSnapshot* md_snapshot)
+    : md_handler_(md_handler), md_snapshot_(md_snapshot) {
+  risk_mgr_ = std::make_unique<RiskManager>();
+}
+
+AccountEngine::~AccountEngine() { logout(); }
+
+bool AccountEngine::login(const Config& config) {
+  config_ = config;
+
+  gateway_.reset(create_gateway(config.api));
+  if (!gateway_) {
+    spdlog::error("[AccountEngine::login] Failed. Unknown gateway {}",
+                  config.api);
+    return false;
+  }
+
+  if (!gateway_->login(this, config)) {
+    spdlog::error("[AccountEngine::login] Failed to login as {}",
+                  config.investor_id);
+    return false;
+  }
+  spdlog::info("[AccountEngine::login] Success. Login as {}",
+               config.investor_id);
+
+  if (!gateway_->query_account()) {
+    spdlog::error("[AccountEngine::login] Failed to query account");
+    return false;
+  }
+
+  // 持仓在redis中的key依赖于账户ID，因此账户查询完成后再同时查询持仓及成交
+  account_id_ = account_.account_id;
+  portfolio_.set_account(account_id_);
+  if (!gateway_->query_batch(QueryType::POSITIONS | QueryType::TRADES)) {
+    spdlog::error("[AccountEngine::login] Failed to query positions/trades");
+    return false;
+  }
+
+  if (!risk_mgr_->init(config, &account_, &portfolio_, &order_map_,
+                       md_snapshot_)) {
+    spdlog::error("[AccountEngine::login] 风险管理对象初始化失败");
+    return false;
+  }
+
+  return true;
+}
+
+void AccountEngine::logout() {
+  if (gateway_) gateway_->logout();
+}
+
+bool AccountEngine::query_account() { return gateway_->query_account(); }
+
+bool AccountEngine::send_order(const TraderCommand& cmd,
+                               const Contract* contract) {
+  Order order{};
+  auto& req = order.req;
+  req.engine_order_id = next_engine_order_id();
+  req.params = ContractTable::get_params(contract->params.index);
+  req.contract = contract;
+  req.direction = cmd.order_req.direction;
+  req.offset = cmd.order_req.offset;
+  req.volume = cmd.order_req.volume;
+  req.type = cmd.order_req.type;
+  req.price = to_tick_price(cmd.order_req.price, req.params->price_tick);
+  req.flags = cmd.order_req.flags;
+  order.user_order_id = cmd.order_req.user_order_id;
+  order.status = OrderStatus::SUBMITTING;
+  order.strategy_id = cmd.strategy_id;
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  return send_order(&order, cmd.order_req.without_check);
+}
+
+bool AccountEngine::send_order(Order* order, bool without_check) {
+  auto& req = order->req;
+  auto contract = req.contract;
+  // 增加是否经过风控检查字段，在紧急情况下可以设置该字段绕过风控下单
+  if (!without_check) {
+    int error_code = risk_mgr_->check_order_req(order);
+    if (error_code != NO_ERROR) {
+      spdlog::error("[AccountEngine::send_order] 风控未通过: {}",
+                    error_code_str(error_code));
+      risk_mgr_->on_order_rejected(order, error_code);
+      return false;
+    }
+  }
+
+  if (!gateway_->send_order(req)) {
+    spdlog::error(
+        "[AccountEngine::send_order] Failed to send_order. {}, {}{}, {}, "
+        "Volume:{}, Price:{:.3f}",
+        contract->ticker, direction_str(req.direction), offset_str(req.offset),
+        ordertype_str(req.type), req.volume, req.real_price());
+
+    risk_mgr_->on_order_rejected(order, ERR_SEND_FAILED);
+    return false;
+  }
+
+  order_map_.emplace((uint64_t)req.engine_order_id, *order);
+  risk_mgr_->on_order_sent(order);
+
+  spdlog::debug(
+      "[AccountEngine::send_order] Success. {}, {}{}, {}, EngineOrderID:{}, "
+      "Volume:{}, Price: {:.3f}",
+      contract->ticker, direction_str(req.direction), offset_str(req.offset),
+      ordertype_str(req.type), req.engine_order_id, req.volume,
+      req.real_price());
+  return true;
+}
+
+void AccountEngine::cancel_order(uint64_t order_id) {
+  gateway_->cancel_order(order_id);
+}
+
+void AccountEngine::amend_order(const TraderCommand& cmd) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  auto id_iter = order_ids_.find(cmd.amend_req.order_id);
+  auto iter = id_iter == order_ids_.end() ? order_map_.end()
+                                          : order_map_.find(id_iter->second);
+  if (iter == order_map_.end()) {
+    spdlog::warn("[AccountEngine::amend_order] Order not found. OrderID:{}",
+                 cmd.amend_req.order_id);
+    return;
+  }
+
+  auto& order = iter->second;
+  auto contract = order.req.contract;
+  Order amended = order;
+  amended.req.volume = cmd.amend_req.volume;
+  amended.req.price =
+      to_tick_price(cmd.amend_req.price, order.req.params->price_tick);
+  if (amended.req.volume == order.req.volume &&
+      amended.req.price == order.req.price)
+    return;
+
+  // 委托总量不能小于已经结束的部分，同一时间只能有一个改单请求
+  int done = order.traded_volume + order.canceled_volume;
+  if (!order.accepted || order.amending || amended.req.volume <= done) {
+    spdlog::error(
+        "[AccountEngine::amend_order] Invalid amend. {}, OrderID:{}, "
+        "Accepted:{}, Amending:{}, Volume:{}, Done:{}",
+        contract->ticker, order.order_id, order.accepted, order.amending,
+        amended.req.volume, done);
+    risk_mgr_->on_order_amend_rejected(&order, ERR_AMEND_REJECTED);
+    return;
+  }
+
+  int error_code = risk_mgr_->check_amend_req(&order, &amended);
+  if (error_code != NO_ERROR) {
+    spdlog::error("[AccountEngine::amend_order] 风控未通过: {}",
+                  error_code_str(error_code));
+    risk_mgr_->on_order_amend_rejected(&order, error_code);
+    return;
+  }
+
+  bool res = gateway_->supports_amend()
+                 ? gateway_->amend_order(order.order_id, amended.req)
+                 : gateway_->cancel_order(order.order_id);
+  if (!res) {
+    spdlog::error("[AccountEngine::amend_order] Failed to amend. OrderID:{}",
+                  order.order_id);
+    risk_mgr_->on_order_amend_rejected(&order, ERR_SEND_FAILED);
+    return;
+  }
+
+  order.amending = true;
+  order.amend_volume = amended.req.volume;
+  order.amend_price = amended.req.price;
+
+  spdlog::debug(
+      "[AccountEngine::amend_order] Success. {}, OrderID:{}, Volume:{}->{}, "
+      "Price:{:.3f}->{:.3f}, Emulated:{}",
+      contract->ticker, order.order_id, order.req.volume, amended.req.volume,
+      order.req.real_price(), amended.req.real_price(),
+      !gateway_->supports_amend());
+}
+
+void AccountEngine::send_replacement(const Order& canceled) {
+  Order order{};
+  order.req = canceled.req;
+  order.req.engine_order_id = next_engine_order_id();
+  order.req.volume = canceled.amend_volume - canceled.traded_volume;
+  order.req.price = canceled.amend_price;
+  order.user_order_id = canceled.user_order_id;
+  order.status = OrderStatus::SUBMITTING;
+  order.strategy_id = canceled.strategy_id;
+  order.is_replacement = true;
+  if (order.req.volume <= 0) return;
+
+  // 对柜台来说这是一个新的订单，需要重新经过风控，流控除外
+  send_order(&order, false);
+}
+
+void AccountEngine::set_order_id(Order* order, uint64_t order_id) {
+  if (order->order_id == order_id) return;
+
+  if (order->order_id != 0) order_ids_.erase(order->order_id);
+  order->order_id = order_id;
+  if (order_id != 0) order_ids_[order_id] = order->req.engine_order_id;
+}
+
+OrderMap::iterator AccountEngine::erase_order(OrderMap::iterator iter) {
+  if (iter->second.order_id != 0) order_ids_.erase(iter->second.order_id);
+  return order_map_.erase(iter);
+}
+
+void AccountEngine::cancel_for_ticker(uint32_t ticker_index) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  gateway_->begin_batch();
+  for (const auto& [engine_order_id, order] : order_map_) {
+    UNUSED(engine_order_id);
+    if (ticker_index == order.req.params->index)
+      gateway_->cancel_order(order.order_id);
+  }
+  gateway_->end_batch();
+}
+
+void AccountEngine::cancel_all() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  gateway_->begin_batch();
+  for (const auto& [engine_order_id, order] : order_map_) {
+    UNUSED(engine_order_id);
+    gateway_->cancel_order(order.order_id);
+  }
+  gateway_->end_batch();
+}
+
+void AccountEngine::on_query_contract(Contract* contract) {}
+
+void AccountEngine::on_query_account(Account* account) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  account_ = *account;
+  lock.unlock();
+
+  spdlog::info(
+      "[AccountEngine::on_query_account] total_asset:{:.3f}, frozen:{:.3f}, "
+      "margin:{:.3f}",
+      account->total_asset, account->frozen, account->margin);
+}
+
+void AccountEngine::on_query_position(Position* position) {
+  auto contract = ContractTable::get_by_index(position->ticker_index);
+  assert(contract);
+
+  auto& lp = position->long_pos;
+  auto& sp = position->short_pos;
+  spdlog::info(
+      "[AccountEngine::on_query_position] {}, LongVol:{}, LongYdVol:{}, "
+      "LongPrice:{:.2f}, LongFrozen:{}, LongPNL:{}, ShortVol:{}, "
+      "ShortYdVol:{}, ShortPrice:{:.2f}, ShortFrozen:{}, ShortPNL:{}",
+      contract->ticker, lp.holdings, lp.yd_holdings, lp.cost_price, lp.frozen,
+      lp.float_pnl, sp.holdings, sp.yd_holdings, sp.cost_price, sp.frozen,
+      sp.float_pnl);
+
+  if (lp.holdings == 0 && lp.frozen == 0 && sp.holdings == 0 && sp.frozen == 0)
+    return;
+
+  portfolio_.set_position(*position);
+}
+
+void AccountEngine::on_tick(TickData* tick) { md_handler_->on_tick(tick); }
+
+void AccountEngine::on_query_trade(OrderTradedRsp* trade) {
+  portfolio_.update_on_query_trade(trade->ticker_index, trade->direction,
+                                   trade->offset, trade->volume);
+}
+
+/*
+ * 订单被市场接受后通知策略
+ * 告知策略order_id，策略可通过此order_id撤单
+ */
+void AccountEngine::on_order_accepted(OrderAcceptedRsp* rsp) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  on_order_accepted_locked(rsp);
+}
+
+void AccountEngine::on_order_accepted_locked(OrderAcceptedRsp* rsp) {
+  auto iter = order_map_.find(rsp->engine_order_id);
+  if (iter == order_map_.end()) {
+    spdlog::warn(
+        "[AccountEngine::on_order_accepted] Order not found. OrderID: {}",
+        rsp->engine_order_id);
+    return;
+  }
+
+  auto& order = iter->second;
+  if (order.accepted) return;
+
+  set_order_id(&order, rsp->order_id);
+  order.accepted = true;
+  risk_mgr_->on_order_accepted(&order);
+
+  spdlog::info(
+      "[AccountEngine::on_order_accepted] 报单委托成功. {}, {}{}, Volume:{}, "
+      "Price:{:.2f}, OrderType:{}",
+      order.req.contract->ticker, direction_str(order.req.direction),
+      offset_str(order.req.offset), order.req.volume, order.req.real_price(),
+      ordertype_str(order.req.type));
+}
+
+void AccountEngine::on_order_rejected(OrderRejectedRsp* rsp) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  on_order_rejected_locked(rsp);
+}
+
+void AccountEngine::on_order_rejected_locked(OrderRejectedRsp* rsp) {
+  auto iter = order_map_.find(rsp->engine_order_id);
+  if (iter == order_map_.end()) {
+    spdlog::warn(
+        "[AccountEngine::on_order_rejected] Order not found. OrderID: {}",
+        rsp->engine_order_id);
+    return;
+  }
+
+  auto& order = iter->second;
+  risk_mgr_->on_order_rejected(&order, ERR_REJECTED);
+
+  spdlog::error(
+      "[AccountEngine::on_order_rejected] 报单被拒：{}. {}, {}{}, Volume:{}, "
+      "Price:{:.3f}",
+      rsp->reason, order.req.contract->ticker,
+      direction_str(order.req.direction), offset_str(order.req.offset),
+      order.req.volume, order.req.real_price());
+
+  erase_order(iter);
+}
+
+void AccountEngine::on_order_traded(OrderTradedRsp* rsp) {
+  if (rsp->trade_type == TradeType::SECONDARY_MARKET)
+    on_secondary_market_traded(rsp);
+  else
+    on_primary_market_traded(rsp);
+}
+
+void AccountEngine::on_order_traded_locked(OrderTradedRsp* rsp) {
+  if (rsp->trade_type == TradeType::SECONDARY_MARKET)
+    on_secondary_market_traded_locked(rsp);
+  else
+    on_primary_market_traded_locked(rsp);
+}
+
+void AccountEngine::on_primary_market_traded(OrderTradedRsp* rsp) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  on_primary_market_traded_locked(rsp);
+}
+
+void AccountEngine::on_primary_market_traded_locked(OrderTradedRsp* rsp) {
+  auto iter = order_map_.find(rsp->engine_order_id);
+  if (iter == order_map_.end()) {
+    spdlog::warn(
+        "[AccountEngine::on_primary_market_traded] Order not found. "
+        "OrderID:{}, Traded:{}, Price:{:.3f}",
+        rsp->order_id, rsp->volume, rsp->price);
+    return;
+  }
+
+  auto& order = iter->second;
+  if (!order.accepted) {
+    order.accepted = true;
+    risk_mgr_->on_order_accepted(&order);
+
+    spdlog::info(
+        "[AccountEngine::on_order_accepted] 报单委托成功. {}, {}, "
+        "OrderID:{}, Volume:{}",
+        order.req.contract->ticker, direction_str(order.req.direction),
+        order.order_id, order.req.volume);
+  }
+
+  set_order_id(&order, rsp->order_id);
+  if (rsp->trade_type == TradeType::ACQUIRED_STOCK) {
+    risk_mgr_->on_order_traded(&order, rsp);
+  } else if (rsp->trade_type == TradeType::RELEASED_STOCK) {
+    risk_mgr_->on_order_traded(&order, rsp);
+  } else if (rsp->trade_type == TradeType::CASH_SUBSTITUTION) {
+    risk_mgr_->on_order_traded(&order, rsp);
+  } else if (rsp->trade_type == TradeType::PRIMARY_MARKET) {
+    order.traded_volume = rsp->volume;
+    risk_mgr_->on_order_traded(&order, rsp);
+    // risk_mgr_->on_order_completed(&order);
+    spdlog::info(
+        "[AccountEngine::on_primary_market_traded] done. {}, {}, Volume:{}",
+        order.req.contract->ticker, direction_str(order.req.direction),
+        order.req.volume);
+    erase_order(iter);
+  }
+}
+
+void AccountEngine::on_secondary_market_traded(OrderTradedRsp* rsp) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  on_secondary_market_traded_locked(rsp);
+}
+
+void AccountEngine::on_secondary_market_traded_locked(OrderTradedRsp* rsp) {
+  auto iter = order_map_.find(rsp->engine_order_id);
+  if (iter == order_map_.end()) {
+    spdlog::warn(
+        "[AccountEngine::on_secondary_market_traded] Order not found. "
+        "OrderID:{}, Traded:{}, Price:{:.3f}",
+        rsp->order_id, rsp->volume, rsp->price);
+    return;
+  }
+
+  auto& order = iter->second;
+  if (!order.accepted) {
+    order.accepted = true;
+    risk_mgr_->on_order_accepted(&order);
+
+    spdlog::info(
+        "[AccountEngine::on_order_accepted] 报单委托成功. {}, {}{}, Volume:{}, "
+        "Price:{:.2f}, OrderType:{}",
+        order.req.contract->ticker, direction_str(order.req.direction),
+        offset_str(order.req.offset), order.req.volume, order.req.real_price(),
+        ordertype_str(order.req.type));
+  }
+
+  set_order_id(&order, rsp->order_id);
+  order.traded_volume += rsp->volume;
+
+  spdlog::info(
+      "[AccountEngine::on_order_traded] 报单成交. {}, {}{}, Traded:{}, "
+      "Price:{:.3f}, TotalTraded/Original:{}/{}",
+      order.req.contract->ticker, direction_str(order.req.direction),
+      offset_str(order.req.offset), rsp->volume, rsp->price,
+      order.traded_volume, order.req.volume);
+
+  risk_mgr_->on_order_traded(&order, rsp);
+
+  if (order.traded_volume + order.canceled_volume == order.req.volume) {
+    spdlog::info(
+        "[AccountEngine::on_order_traded] 报单完成. {}, {}{}, OrderID:{}, "
+        "Traded/Original: {}/{}",
+        order.req.contract->ticker, direction_str(order.req.direction),
+        offset_str(order.req.offset), order.order_id, order.traded_volume,
+        order.req.volume);
+
+    // 订单结束，通知风控模块
+    risk_mgr_->on_order_completed(&order);
+    erase_order(iter);
+  }
+}
+
+void AccountEngine::on_order_canceled(OrderCanceledRsp* rsp) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  on_order_canceled_locked(rsp);
+}
+
+void AccountEngine::on_order_canceled_locked(OrderCanceledRsp* rsp) {
+  auto iter = order_map_.find(rsp->engine_order_id);
+  if (iter == order_map_.end()) {
+    spdlog::warn(
+        "[AccountEngine::on_order_canceled] Order not found. EngineOrderID:{}",
+        rsp->engine_order_id);
+    return;
+  }
+
+  auto& order = iter->second;
+  order.canceled_volume = rsp->canceled_volume;
+  bool replace = order.amending && !gateway_->supports_amend();
+
+  spdlog::info(
+      "[AccountEngine::on_order_canceled] 报单已撤. {}, {}{}, OrderID:{}, "
+      "Canceled:{}",
+      order.req.contract->ticker, direction_str(order.req.direction),
+      offset_str(order.req.offset), order.order_id, rsp->canceled_volume);
+
+  risk_mgr_->on_order_canceled(&order, rsp->canceled_volume);
+
+  if (order.traded_volume + order.canceled_volume == order.req.volume) {
+    spdlog::info(
+        "[AccountEngine::on_order_canceled] 报单完成. {}, {}{}, OrderID:{}, "
+        "Traded/Original:{}/{}",
+        order.req.contract->ticker, direction_str(order.req.direction),
+        offset_str(order.req.offset), order.order_id, order.traded_volume,
+        order.req.volume);
+
+    risk_mgr_->on_order_completed(&order);
+    Order canceled = order;
+    erase_order(iter);
+    if (replace) send_replacement(canceled);
+  }
+}
+
+void AccountEngine::on_order_cancel_rejected(OrderCancelRejectedRsp* rsp) {
+  spdlog::warn(
+      "[AccountEngine::on_order_cancel_rejected] 订单不可撤：{}. "
+      "EngineOrderID: {}",
+      rsp->reason, rsp->engine_order_id);
+
+  // 模拟改单时撤单被拒，改单也随之失败
+  std::unique_lock<std::mutex> lock(mutex_);
+  auto iter = order_map_.find(rsp->engine_order_id);
+  if (iter == order_map_.end() || !iter->second.amending) return;
+
+  auto& order = iter->second;
+  order.amending = false;
+  risk_mgr_->on_order_amend_rejected(&order, ERR_AMEND_REJECTED);
+}
+
+void AccountEngine::on_order_amended(OrderAmendedRsp* rsp) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  auto iter = order_map_.find(rsp->engine_order_id);
+  if (iter == order_map_.end()) {
+    spdlog::warn(
+        "[AccountEngine::on_order_amended] Order not found. EngineOrderID:{}",
+        rsp->engine_order_id);
+    return;
+  }
+
+  auto& order = iter->second;
+  if (!order.amending) return;
+
+  auto old_req = order.req;
+  order.req.volume = order.amend_volume;
+  order.req.price = order.amend_price;
+  order.amending = false;
+  if (rsp->order_id != 0) set_order_id(&order, rsp->order_id);
+  risk_mgr_->on_order_amended(&order, old_req);
+
+  spdlog::info(
+      "[AccountEngine::on_order_amended] 改单成功. {}, {}{}, OrderID:{}, "
+      "Volume:{}->{}, Price:{:.3f}->{:.3f}",
+      order.req.contract->ticker, direction_str(order.req.direction),
+      offset_str(order.req.offset), order.order_id, old_req.volume,
+      order.req.volume, old_req.real_price(), order.req.real_price());
+
+  if (order.traded_volume + order.canceled_volume == order.req.volume) {
+    risk_mgr_->on_order_completed(&order);
+    erase_order(iter);
+  }
+}
+
+void AccountEngine::on_order_amend_rejected(OrderAmendRejectedRsp* rsp) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  auto iter = order_map_.find(rsp->engine_order_id);
+  if (iter == order_map_.end()) {
+    spdlog::warn(
+        "[AccountEngine::on_order_amend_rejected] Order not found. "
+        "EngineOrderID:{}",
+        rsp->engine_order_id);
+    return;
+  }
+
+  auto& order = iter->second;
+  order.amending = false;
+  risk_mgr_->on_order_amend_rejected(&order, ERR_AMEND_REJECTED);
+
+  spdlog::error(
+      "[AccountEngine::on_order_amend_rejected] 改单被拒：{}. {}, OrderID:{}",
+      rsp->reason, order.req.contract->ticker, order.order_id);
+}
+
+/*
+ * 断线前发出的订单可能没有到达柜台，重连后只同步这些订单。多次断线而
+ * 中间没有同步成功时取最后一次的订单号，覆盖之前的所有订单
+ */
+void AccountEngine::on_disconnected() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  max_unsynced_order_id_ = next_engine_order_id_ - 1;
+}
+
+/*
+ * 断线期间柜台的回报会丢失，重连后Gateway查询订单的最终状态并通过此接口
+ * 补发。与订单表中的记录对比，只重放引擎还没有处理过的部分，已经结束的
+ * 订单不在订单表中，直接忽略。整个过程持有mutex_，避免与同时到达的实时
+ * 回报交错导致重复计算成交
+ */
+void AccountEngine::on_order_synced(OrderSyncRsp* rsp) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  auto iter = order_map_.find(rsp->engine_order_id);
+  if (iter == order_map_.end()) return;
+
+  synced_orders_.emplace(rsp->engine_order_id);
+  int known_traded = iter->second.traded_volume;
+  int known_canceled = iter->second.canceled_volume;
+
+  spdlog::info(
+      "[AccountEngine::on_order_synced] EngineOrderID:{}, Accepted:{}, "
+      "Rejected:{}, Trades:{}, Canceled:{}, KnownTraded:{}",
+      rsp->engine_order_id, rsp->accepted, rsp->rejected, rsp->num_trades,
+      rsp->canceled_volume, known_traded);
+
+  if (rsp->rejected) {
+    OrderRejectedRsp rejected = {rsp->engine_order_id, rsp->reason};
+    on_order_rejected_locked(&rejected);
+    return;
+  }
+
+  if (rsp->accepted) {
+    OrderAcceptedRsp accepted = {rsp->engine_order_id, rsp->order_id};
+    on_order_accepted_locked(&accepted);
+  }
+
+  // 引擎已经收到了前known_traded手的成交，只补发剩余的部分
+  int total_traded = 0;
+  for (int i = 0; i < rsp->num_trades; ++i) {
+    auto trade = rsp->trades[i];
+    int missed =
+        std::min(trade.volume, total_traded + trade.volume - known_traded);
+    total_traded += trade.volume;
+    if (missed <= 0) continue;
+
+    trade.volume = missed;
+    trade.amount = trade.amount * missed / rsp->trades[i].volume;
+    on_order_traded_locked(&trade);
+  }
+
+  // 成交补齐后订单可能已经结束
+  if (rsp->canceled_volume > 0 && known_canceled == 0 &&
+      order_map_.find(rsp->engine_order_id) != order_map_.end()) {
+    OrderCanceledRsp canceled = {rsp->engine_order_id, rsp->canceled_volume};
+    on_order_canceled_locked(&canceled);
+  }
+}
+
+/*
+ * 柜台没有返回的订单在断线前没能到达柜台，之后也不会再有回报，
+ * 按拒单处理，释放冻结的资金及持仓。重连后新发出的订单可能在查询之后
+ * 才到达柜台，不在查询结果中，不做处理
+ */
+void AccountEngine::on_order_sync_finished() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  for (auto iter = order_map_.begin(); iter != order_map_.end();) {
+    if (iter->first > max_unsynced_order_id_ ||
+        synced_orders_.count(iter->first) > 0) {
+      ++iter;
+      continue;
+    }
+
+    auto& order = iter->second;
+    risk_mgr_->on_order_rejected(&order, ERR_REJECTED);
+    spdlog::error(
+        "[AccountEngine::on_order_sync_finished] 报单被拒：lost on reconnect. "
+        "{}, {}{}, EngineOrderID:{}, Volume:{}, Price:{:.3f}",
+        order.req.contract->ticker, direction_str(order.req.direction),
+        offset_str(order.req.offset), iter->first, order.req.volume,
+        order.req.real_price());
+    iter = erase_order(iter);
+  }
+
+  synced_orders_.clear();
+  max_unsynced_order_id_ = 0;
+}
+
+}  // namespace ft
@@ -0,0 +1,162 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef FT_SRC_TRADING_ENGINE_ACCOUNT_ENGINE_H_
+#define FT_SRC_TRADING_ENGINE_ACCOUNT_ENGINE_H_
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "common/md_snapshot.h"
+#include "common/order.h"
+#include "common/portfolio.h"
+#include "core/account.h"
+#include "core/config.h"
+#include "core/protocol.h"
+#include "interface/gateway.h"
+#include "interface/trading_engine_interface.h"
+#include "risk_management/risk_manager.h"
+
+namespace ft {
+
+/*
+ * TradingEngine中的单个账户
+ *
+ * 每个账户有自己的Gateway、资金、持仓、订单表及风控，订单回报只在账户内部
+ * 处理。行情由所有账户共享，Gateway推送的行情转交给md_handler统一处理，
+ * 风控使用的行情快照也由TradingEngine提供
+ */
+class AccountEngine : public TradingEngineInterface {
+ public:
+  AccountEngine(TradingEngineInterface* md_handler,
+                const MdSnapshot* md_snapshot);
+
+  ~AccountEngine();
+
+  bool login(const Config& config);
+
+  void logout();
+
+  bool query_account();
+
+  uint64_t account_id() const { return account_id_; }
+
+  const Config& config() const { return config_; }
+
+  double send_utilization() { return gateway_->send_utilization(); }
+
+  // contract在路由时已经由TradingEngine查出
+  bool send_order(const TraderCommand& cmd, const Contract* contract);
+
+  void cancel_order(uint64_t order_id);
+
+  // 按order_id查找订单并改单，Gateway不支持改单时以撤单后重新下单模拟
+  void amend_order(const TraderCommand& cmd);
+
+  void cancel_for_ticker(uint32_t ticker_index);
+
+  void cancel_all();
+
+  void begin_batch() { gateway_->begin_batch(); }
+
+  void end_batch() { gateway_->end_batch(); }
+
+  bool subscribe(const std::vector<std::string>& tickers) {
+    return gateway_->subscribe(tickers);
+  }
+
+  bool unsubscribe(const std::vector<std::string>& tickers) {
+    return gateway_->unsubscribe(tickers);
+  }
+
+ private:
+  void on_query_contract(Contract* contract) override;
+
+  void on_query_account(Account* account) override;
+
+  void on_query_position(Position* position) override;
+
+  void on_query_trade(OrderTradedRsp* trade) override;
+
+  void on_tick(TickData* tick) override;
+
+  void on_order_accepted(OrderAcceptedRsp* rsp) override;
+
+  void on_order_rejected(OrderRejectedRsp* rsp) override;
+
+  void on_order_traded(OrderTradedRsp* rsp) override;
+
+  void on_order_canceled(OrderCanceledRsp* rsp) override;
+
+  void on_order_cancel_rejected(OrderCancelRejectedRsp* rsp) override;
+
+  void on_disconnected() override;
+
+  void on_order_synced(OrderSyncRsp* rsp) override;
+
+  void on_order_sync_finished() override;
+
+  void on_order_amended(OrderAmendedRsp* rsp) override;
+
+  void on_order_amend_rejected(OrderAmendRejectedRsp* rsp) override;
+
+ private:
+  // 调用方需持有mutex_
+  bool send_order(Order* order, bool without_check);
+
+  // 模拟改单时原订单撤单完成，按改单后的价格及剩余数量重新下单
+  void send_replacement(const Order& canceled);
+
+  void on_primary_market_traded(OrderTradedRsp* rsp);  // ETF申赎
+
+  void on_secondary_market_traded(OrderTradedRsp* rsp);  // 二级市场买卖
+
+  // 以下回报处理函数的调用方需持有mutex_，供on_order_synced在持锁期间重放
+  void on_order_accepted_locked(OrderAcceptedRsp* rsp);
+
+  void on_order_rejected_locked(OrderRejectedRsp* rsp);
+
+  void on_order_traded_locked(OrderTradedRsp* rsp);
+
+  void on_primary_market_traded_locked(OrderTradedRsp* rsp);
+
+  void on_secondary_market_traded_locked(OrderTradedRsp* rsp);
+
+  void on_order_canceled_locked(OrderCanceledRsp* rsp);
+
+  uint64_t next_engine_order_id() { return next_engine_order_id_++; }
+
+  // 柜台返回或改变订单的order_id时同步更新order_ids_，调用方需持有mutex_
+  void set_order_id(Order* order, uint64_t order_id);
+
+  // 从order_map_及order_ids_中删除订单，调用方需持有mutex_
+  OrderMap::iterator erase_order(OrderMap::iterator iter);
+
+ private:
+  TradingEngineInterface* md_handler_;
+  const MdSnapshot* md_snapshot_;
+
+  Config config_;
+  std::unique_ptr<Gateway> gateway_{nullptr};
+  uint64_t account_id_{0};
+  uint64_t next_engine_order_id_{1};
+
+  Account account_;
+  Portfolio portfolio_;
+  OrderMap order_map_;
+  // 柜台order_id到engine_order_id的索引，改单时按order_id查找订单
+  std::unordered_map<uint64_t, uint64_t> order_ids_;
+  // 重连同步期间柜台返回过的订单，同步结束时不在其中的订单按丢失处理
+  std::unordered_set<uint64_t> synced_orders_;
+  // 断线时已分配的最大订单号，只有不超过它的订单需要与柜台同步
+  uint64_t max_unsynced_order_id_{0};
+  std::unique_ptr<RiskManager> risk_mgr_{nullptr};
+  std::mutex mutex_;
+};
+
+}  // namespace ft
+
+#endif  // FT_SRC_TRADING_ENGINE_ACCOUNT_ENGINE_H_
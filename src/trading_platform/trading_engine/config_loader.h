@@ -6,6 +6,7 @@
 #include <yaml-cpp/yaml.h>
 
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "core/config.h"
@@ -13,48 +14,105 @@
 
 namespace ft {
 
-inline void load_config(const std::string& file, ft::Config* config) {
-  std::ifstream ifs(file);
-  assert(ifs);
-
-  YAML::Node node = YAML::LoadFile(file);
-
-  config->api = node["api"].as<std::string>("");
+/*
+ * 以config中已有的值作为默认值，只覆盖node中出现的字段，这样accounts中
+ * 的每个账户只需要填写与顶层配置不同的部分
+ */
+inline void load_config_node(const YAML::Node& node, ft::Config* config) {
+  config->api = node["api"].as<std::string>(config->api);
   config->trade_server_address =
-      node["trade_server_address"].as<std::string>("");
+      node["trade_server_address"].as<std::string>(
+          config->trade_server_address);
   config->quote_server_address =
-      node["quote_server_address"].as<std::string>("");
-  config->broker_id = node["broker_id"].as<std::string>("");
-  config->investor_id = node["investor_id"].as<std::string>("");
-  config->password = node["password"].as<std::string>("");
-  config->auth_code = node["auth_code"].as<std::string>("");
-  config->app_id = node["app_id"].as<std::string>("");
+      node["quote_server_address"].as<std::string>(
+          config->quote_server_address);
+  config->broker_id = node["broker_id"].as<std::string>(config->broker_id);
+  config->investor_id =
+      node["investor_id"].as<std::string>(config->investor_id);
+  config->password = node["password"].as<std::string>(config->password);
+  config->auth_code = node["auth_code"].as<std::string>(config->auth_code);
+  config->app_id = node["app_id"].as<std::string>(config->app_id);
 
   config->subscription_list =
       node["subscription_list"].as<std::vector<std::string>>(
-          std::vector<std::string>{});
+          config->subscription_list);
+  config->exchanges =
+      node["exchanges"].as<std::vector<std::string>>(config->exchanges);
 
   config->cancel_outstanding_orders_on_startup =
-      node["cancel_outstanding_orders_on_startup"].as<bool>(true);
+      node["cancel_outstanding_orders_on_startup"].as<bool>(
+          config->cancel_outstanding_orders_on_startup);
+  config->request_timeout_ms =
+      node["request_timeout_ms"].as<uint64_t>(config->request_timeout_ms);
 
   config->throttle_rate_limit_period_ms =
-      node["throttle_rate_limit_period_ms"].as<uint64_t>(0);
+      node["throttle_rate_limit_period_ms"].as<uint64_t>(
+          config->throttle_rate_limit_period_ms);
   config->throttle_rate_order_limit =
-      node["throttle_rate_order_limit"].as<uint64_t>(0);
+      node["throttle_rate_order_limit"].as<uint64_t>(
+          config->throttle_rate_order_limit);
   config->throttle_rate_volume_limit =
-      node["throttle_rate_volume_limit"].as<uint64_t>(0);
-
-  config->key_of_cmd_queue = node["key_of_cmd_queue"].as<int>(0);
-
-  config->arg0 = node["arg0"].as<std::string>("");
-  config->arg1 = node["arg1"].as<std::string>("");
-  config->arg2 = node["arg2"].as<std::string>("");
-  config->arg3 = node["arg3"].as<std::string>("");
-  config->arg4 = node["arg4"].as<std::string>("");
-  config->arg5 = node["arg5"].as<std::string>("");
-  config->arg6 = node["arg6"].as<std::string>("");
-  config->arg7 = node["arg7"].as<std::string>("");
-  config->arg8 = node["arg8"].as<std::string>("");
+      node["throttle_rate_volume_limit"].as<uint64_t>(
+          config->throttle_rate_volume_limit);
+
+  config->key_of_cmd_queue =
+      node["key_of_cmd_queue"].as<int>(config->key_of_cmd_queue);
+  config->md_stall_timeout_ms =
+      node["md_stall_timeout_ms"].as<uint64_t>(config->md_stall_timeout_ms);
+
+  config->arg0 = node["arg0"].as<std::string>(config->arg0);
+  config->arg1 = node["arg1"].as<std::string>(config->arg1);
+  config->arg2 = node["arg2"].as<std::string>(config->arg2);
+  config->arg3 = node["arg3"].as<std::string>(config->arg3);
+  config->arg4 = node["arg4"].as<std::string>(config->arg4);
+  config->arg5 = node["arg5"].as<std::string>(config->arg5);
+  config->arg6 = node["arg6"].as<std::string>(config->arg6);
+  config->arg7 = node["arg7"].as<std::string>(config->arg7);
+  config->arg8 = node["arg8"].as<std::string>(config->arg8);
+
+  if (node["sessions"]) {
+    config->sessions.clear();
+    for (const auto& session_node : node["sessions"]) {
+      TradeSessionConfig session{};
+      session.comp_id = session_node["comp_id"].as<std::string>("");
+      session.password = session_node["password"].as<std::string>("");
+      session.new_password = session_node["new_password"].as<std::string>("");
+      session.rsa_pubkey_file =
+          session_node["rsa_pubkey_file"].as<std::string>("");
+      session.msg_limit_per_sec =
+          session_node["msg_limit_per_sec"].as<uint32_t>(0);
+      session.msg_burst = session_node["msg_burst"].as<uint32_t>(1);
+      config->sessions.emplace_back(std::move(session));
+    }
+  }
+}
+
+inline void load_config(const std::string& file, ft::Config* config) {
+  std::ifstream ifs(file);
+  assert(ifs);
+
+  YAML::Node node = YAML::LoadFile(file);
+  *config = Config{};
+  load_config_node(node, config);
+
+  // 多账户及额外的行情源，都继承顶层的配置
+  const Config base = *config;
+  if (node["accounts"]) {
+    for (const auto& account_node : node["accounts"]) {
+      Config account = base;
+      load_config_node(account_node, &account);
+      config->accounts.emplace_back(std::move(account));
+    }
+  }
+
+  if (node["md_sources"]) {
+    for (const auto& source_node : node["md_sources"]) {
+      Config source = base;
+      load_config_node(source_node, &source);
+      source.trade_server_address.clear();  // 行情源不登录交易柜台
+      config->md_sources.emplace_back(std::move(source));
+    }
+  }
 }
 
 }  // namespace ft
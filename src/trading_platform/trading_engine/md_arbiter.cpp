@@ -0,0 +1,134 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#include "trading_engine/md_arbiter.h"
+
+#include <spdlog/spdlog.h>
+
+#include "core/contract_table.h"
+
+namespace ft {
+
+namespace {
+
+// 各行情源之间的乱序远小于1小时，交易所时间回退超过1小时说明是夜盘跨过了
+// 0点或者进入了新的交易时段
+const uint64_t kSessionGapMs = 3600 * 1000;
+const uint64_t kHalfDayMs = 12 * 3600 * 1000;
+
+const int64_t kCheckIntervalNs = 100 * 1000000LL;
+const int64_t kReportIntervalNs = 60 * 1000000000LL;
+
+}  // namespace
+
+MdArbiter::MdArbiter(uint64_t stall_timeout_ms)
+    : stall_timeout_ns_(stall_timeout_ms * 1000000),
+      tickers_(ContractTable::size() + 1, TickerState{}) {}
+
+int MdArbiter::add_source(const std::string& name) {
+  SourceStats source{};
+  source.name = name;
+  sources_.emplace_back(source);
+  return static_cast<int>(sources_.size()) - 1;
+}
+
+MdArbiter::TickOrder MdArbiter::compare(const TickData& tick,
+                                        const TickerState& state) {
+  if (state.recv_ns == 0) return NEWER;
+
+  if (tick.date != 0 && state.date != 0 && tick.date != state.date)
+    return tick.date > state.date ? NEWER : STALE;
+
+  uint64_t time_ms = tick.time_sec * 1000 + tick.time_ms;
+  if (time_ms + kSessionGapMs < state.time_ms) return NEWER;
+  if (time_ms > state.time_ms + kHalfDayMs) return STALE;  // 跨0点前的行情
+
+  // 成交量在新的交易日会清零，只在交易所时间相同时用来区分先后
+  if (time_ms != state.time_ms) return time_ms > state.time_ms ? NEWER : STALE;
+  if (tick.volume != state.volume)
+    return tick.volume > state.volume ? NEWER : STALE;
+  return DUPLICATED;
+}
+
+bool MdArbiter::on_tick(int source_id, const TickData& tick, int64_t now_ns) {
+  if (tick.ticker_index >= tickers_.size()) return false;
+
+  auto& source = sources_[source_id];
+  ++source.received;
+  source.last_recv_ns = now_ns;
+  if (source.stalled) {
+    source.stalled = false;
+    spdlog::info("[MdArbiter::on_tick] 行情源{}恢复", source.name);
+  }
+
+  auto& state = tickers_[tick.ticker_index];
+  auto order = compare(tick, state);
+
+  // 同一个行情源重复推送的同一时刻的行情视为更新，例如只有盘口变化
+  if (order == DUPLICATED && state.source_id == source_id) order = NEWER;
+
+  bool accepted = false;
+  if (order == NEWER) {
+    state.date = tick.date;
+    state.time_ms = tick.time_sec * 1000 + tick.time_ms;
+    state.volume = tick.volume;
+    state.recv_ns = now_ns;
+    state.source_id = source_id;
+
+    ++source.accepted;
+    update_lag(&source, 0);
+    accepted = true;
+  } else if (order == DUPLICATED) {
+    ++source.duplicated;
+    update_lag(&source, now_ns - state.recv_ns);
+  } else {
+    ++source.stale;
+  }
+
+  check_sources(now_ns);
+  return accepted;
+}
+
+void MdArbiter::update_lag(SourceStats* source, int64_t lag_ns) {
+  source->lag_us += (lag_ns / 1000.0 - source->lag_us) / 16;
+}
+
+void MdArbiter::check_sources(int64_t now_ns) {
+  if (now_ns - last_check_ns_ < kCheckIntervalNs) return;
+  last_check_ns_ = now_ns;
+
+  if (stall_timeout_ns_ > 0) {
+    for (auto& source : sources_) {
+      if (source.stalled || source.last_recv_ns == 0 ||
+          now_ns - source.last_recv_ns <= stall_timeout_ns_)
+        continue;
+
+      source.stalled = true;
+      spdlog::warn(
+          "[MdArbiter::check_sources] 行情源{}超过{}ms没有行情，请检查该行情源"
+          "的连接",
+          source.name, stall_timeout_ns_ / 1000000);
+    }
+  }
+
+  if (last_report_ns_ == 0) {
+    last_report_ns_ = now_ns;
+  } else if (now_ns - last_report_ns_ >= kReportIntervalNs) {
+    last_report_ns_ = now_ns;
+    report();
+  }
+}
+
+void MdArbiter::report() const {
+  if (sources_.size() < 2) return;
+
+  for (const auto& source : sources_) {
+    spdlog::info(
+        "[MdArbiter::report] {}: Received:{}, First:{}({:.1f}%), "
+        "Duplicated:{}, Stale:{}, Lag:{:.1f}us, Stalled:{}",
+        source.name, source.received, source.accepted,
+        source.received > 0 ? source.accepted * 100.0 / source.received : 0.0,
+        source.duplicated, source.stale, source.lag_us, source.stalled);
+  }
+}
+
+}  // namespace ft
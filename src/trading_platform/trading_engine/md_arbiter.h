@@ -0,0 +1,84 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef FT_SRC_TRADING_ENGINE_MD_ARBITER_H_
+#define FT_SRC_TRADING_ENGINE_MD_ARBITER_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "core/tick_data.h"
+
+namespace ft {
+
+/*
+ * 多个行情源之间的仲裁
+ *
+ * 同一个合约可以同时从多个行情源订阅，按ticker_index记录已经发布的最新
+ * 行情的交易所时间及成交量，只有更新的行情才会被接受，其他行情源稍后送达
+ * 的同一笔行情作为重复行情丢弃，比已发布的行情更旧的作为过期行情丢弃。
+ * 因此始终是最先送达的行情源胜出，哪个行情源更快不需要事先配置
+ *
+ * 由于始终是最先送达的行情胜出，某个行情源中断后其他行情源的行情自然会
+ * 被采用，不需要额外的切换动作。每个行情源统计落后于最快行情源的平均延迟，
+ * 超过stall_timeout没有收到行情的行情源被标记为中断，该状态只用于日志及
+ * report中的监控，不影响仲裁
+ *
+ * 不是线程安全的，由调用方加锁
+ */
+class MdArbiter {
+ public:
+  explicit MdArbiter(uint64_t stall_timeout_ms = 3000);
+
+  void set_stall_timeout(uint64_t stall_timeout_ms) {
+    stall_timeout_ns_ = stall_timeout_ms * 1000000;
+  }
+
+  // 返回行情源的编号
+  int add_source(const std::string& name);
+
+  // 返回true表示这是该合约最新的行情，应当发布
+  bool on_tick(int source_id, const TickData& tick, int64_t now_ns);
+
+  void report() const;
+
+ private:
+  struct TickerState {
+    uint64_t date;
+    uint64_t time_ms;  // 当天0点起的毫秒数
+    uint64_t volume;
+    int64_t recv_ns;  // 最先送达的时间
+    int source_id;
+  };
+
+  struct SourceStats {
+    std::string name;
+    uint64_t received;
+    uint64_t accepted;
+    uint64_t duplicated;
+    uint64_t stale;
+    double lag_us;  // 落后于最快行情源的平均延迟
+    int64_t last_recv_ns;
+    bool stalled;
+  };
+
+  enum TickOrder { NEWER, DUPLICATED, STALE };
+
+  static TickOrder compare(const TickData& tick, const TickerState& state);
+
+  void update_lag(SourceStats* source, int64_t lag_ns);
+
+  void check_sources(int64_t now_ns);
+
+ private:
+  int64_t stall_timeout_ns_;
+  int64_t last_check_ns_{0};
+  int64_t last_report_ns_{0};
+
+  std::vector<TickerState> tickers_;
+  std::vector<SourceStats> sources_;
+};
+
+}  // namespace ft
+
+#endif  // FT_SRC_TRADING_ENGINE_MD_ARBITER_H_
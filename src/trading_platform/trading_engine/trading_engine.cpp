@@ -4,16 +4,104 @@
 
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <utility>
+
 #include "core/contract_table.h"
-#include "core/error_code.h"
 #include "core/protocol.h"
+#include "core/wire_codec.h"
 #include "ipc/lockfree-queue/queue.h"
+#include "ipc/redis_send_util_helper.h"
 #include "ipc/redis_trader_cmd_helper.h"
-#include "utils/misc.h"
 
 namespace ft {
 
-TradingEngine::TradingEngine() { risk_mgr_ = std::make_unique<RiskManager>(); }
+namespace {
+
+// 配置中的subscription_list使用的订阅者，不会分配给任何策略
+const uint32_t kStaticSubscriber = UINT32_MAX;
+
+// 把wire消息中的一条记录转换为TraderCommand，不认识的记录返回false
+bool decode_cmd(uint8_t type, const char* body, std::size_t length,
+                TraderCommand* cmd) {
+  switch (type) {
+    case WIRE_NEW_ORDER: {
+      WireNewOrder req;
+      if (!WireReader::get(body, length, &req)) return false;
+      cmd->type = CMD_NEW_ORDER;
+      cmd->account_id = req.account_id;
+      cmd->order_req.user_order_id = req.user_order_id;
+      cmd->order_req.ticker_index = req.ticker_index;
+      cmd->order_req.direction = req.direction;
+      cmd->order_req.offset = req.offset;
+      cmd->order_req.type = req.order_type;
+      cmd->order_req.volume = req.volume;
+      cmd->order_req.price = req.price;
+      cmd->order_req.flags = req.flags;
+      cmd->order_req.without_check = req.without_check;
+      return true;
+    }
+    case WIRE_CANCEL_ORDER: {
+      WireCancelOrder req;
+      if (!WireReader::get(body, length, &req)) return false;
+      cmd->type = CMD_CANCEL_ORDER;
+      cmd->account_id = req.account_id;
+      cmd->cancel_req.order_id = req.order_id;
+      return true;
+    }
+    case WIRE_CANCEL_TICKER: {
+      WireCancelTicker req;
+      if (!WireReader::get(body, length, &req)) return false;
+      cmd->type = CMD_CANCEL_TICKER;
+      cmd->account_id = req.account_id;
+      cmd->cancel_ticker_req.ticker_index = req.ticker_index;
+      return true;
+    }
+    case WIRE_CANCEL_ALL: {
+      WireCancelAll req;
+      if (!WireReader::get(body, length, &req)) return false;
+      cmd->type = CMD_CANCEL_ALL;
+      cmd->account_id = req.account_id;
+      return true;
+    }
+    case WIRE_AMEND_ORDER: {
+      WireAmendOrder req;
+      if (!WireReader::get(body, length, &req)) return false;
+      cmd->type = CMD_AMEND_ORDER;
+      cmd->account_id = req.account_id;
+      cmd->amend_req.order_id = req.order_id;
+      cmd->amend_req.volume = req.volume;
+      cmd->amend_req.price = req.price;
+      return true;
+    }
+    case WIRE_SUBSCRIBE:
+    case WIRE_UNSUBSCRIBE: {
+      WireSubscribe req;
+      if (!WireReader::get(body, length, &req)) return false;
+      cmd->type = type == WIRE_SUBSCRIBE ? CMD_SUBSCRIBE : CMD_UNSUBSCRIBE;
+      cmd->subscribe_req.ticker_index = req.ticker_index;
+      return true;
+    }
+    default: {
+      return false;
+    }
+  }
+}
+
+bool serves_exchange(const std::vector<std::string>& exchanges,
+                     const Contract* contract) {
+  return exchanges.empty() ||
+         std::find(exchanges.begin(), exchanges.end(), contract->exchange) !=
+             exchanges.end();
+}
+
+}  // namespace
+
+TradingEngine::TradingEngine()
+    : md_published_(ContractTable::size() + 1, 0) {}
 
 TradingEngine::~TradingEngine() { close(); }
 
@@ -25,59 +113,131 @@ bool TradingEngine::login(const Config& config) {
   config.show();
 
   cmd_queue_key_ = config.key_of_cmd_queue;
+  md_arbiter_.set_stall_timeout(config.md_stall_timeout_ms);
+
+  // 没有配置accounts时只管理顶层配置中的单个账户
+  if (config.accounts.empty()) {
+    if (!add_account(config)) return false;
+  } else {
+    for (const auto& account_config : config.accounts) {
+      if (!add_account(account_config)) return false;
+    }
+  }
 
-  gateway_.reset(create_gateway(config.api));
-  if (!gateway_) {
-    spdlog::error("[TradingEngine::login] Failed. Unknown gateway");
-    return false;
+  // 所有账户都指定了交易所时，未匹配的订单发往第一个账户
+  if (!default_account_) default_account_ = accounts_.front().get();
+
+  for (const auto& source_config : config.md_sources) {
+    if (!add_md_source(source_config)) return false;
   }
 
-  if (!gateway_->login(this, config)) {
-    spdlog::error("[TradingEngine::login] Failed to login");
+  std::thread([this] { publish_md(); }).detach();
+  std::thread([this] { publish_send_utilization(); }).detach();
+
+  // 启动个线程去定时查询资金账户信息
+  std::thread([this]() {
+    for (;;) {
+      std::this_thread::sleep_for(std::chrono::seconds(15));
+      for (auto& account : accounts_) {
+        if (account->config().api != "virtual") account->query_account();
+      }
+    }
+  }).detach();
+
+  spdlog::info("[TradingEngine::login] Init done. {} account(s)",
+               accounts_.size());
+
+  is_logon_ = true;
+  return true;
+}
+
+bool TradingEngine::add_account(const Config& config) {
+  auto md_source = create_md_source(config.api + ":" + config.investor_id);
+  auto account = std::make_unique<AccountEngine>(md_source, &md_snapshot_);
+  if (!account->login(config)) {
+    spdlog::error("[TradingEngine::add_account] Failed to login as {}",
+                  config.investor_id);
     return false;
   }
-  spdlog::info("[TradingEngine::login] Success. Login as {}",
-               config.investor_id);
 
-  if (!gateway_->query_account()) {
-    spdlog::error("[TradingEngine::login] Failed to query account");
+  uint64_t account_id = account->account_id();
+  if (account_map_.find(account_id) != account_map_.end()) {
+    spdlog::error("[TradingEngine::add_account] Duplicated account {}",
+                  account_id);
     return false;
   }
 
-  // query all positions
-  portfolio_.set_account(account_.account_id);
-  if (!gateway_->query_positions()) {
-    spdlog::error("[TradingEngine::login] Failed to query positions");
-    return false;
+  if (config.exchanges.empty() && !default_account_)
+    default_account_ = account.get();
+
+  for (const auto& exchange_name : config.exchanges) {
+    auto exchange = to_exchange(exchange_name);
+    if (exchange == Exchange::UNKNOWN) {
+      spdlog::error("[TradingEngine::add_account] Unknown exchange {}",
+                    exchange_name);
+      return false;
+    }
+
+    auto& route = exchange_routes_[static_cast<uint8_t>(exchange)];
+    if (route) {
+      spdlog::error(
+          "[TradingEngine::add_account] Exchange {} is routed to both {} and "
+          "{}",
+          exchange_name, route->account_id(), account_id);
+      return false;
+    }
+    route = account.get();
   }
 
-  // query trades to update position
-  if (!gateway_->query_trades()) {
-    spdlog::error("[TradingEngine::login] Failed to query trades");
+  spdlog::info("[TradingEngine::add_account] Account {} ready. api:{}",
+               account_id, config.api);
+  account_map_.emplace(account_id, account.get());
+  accounts_.emplace_back(std::move(account));
+  add_static_subscriptions(config.subscription_list);
+  return true;
+}
+
+bool TradingEngine::add_md_source(const Config& config) {
+  auto name = config.api + ":" + config.quote_server_address;
+  std::unique_ptr<Gateway> gateway(create_gateway(config.api));
+  if (!gateway) {
+    spdlog::error("[TradingEngine::add_md_source] Unknown gateway {}",
+                  config.api);
     return false;
   }
 
-  // init risk manager
-  if (!risk_mgr_->init(config, &account_, &portfolio_, &order_map_,
-                       &md_snapshot_)) {
-    spdlog::error("[TradingEngine::login] 风险管理对象初始化失败");
+  if (!gateway->login(create_md_source(name), config)) {
+    spdlog::error("[TradingEngine::add_md_source] Failed to login into {}",
+                  name);
     return false;
   }
 
-  // 启动个线程去定时查询资金账户信息
-  if (config.api != "virtual") {
-    std::thread([this]() {
-      for (;;) {
-        std::this_thread::sleep_for(std::chrono::seconds(15));
-        gateway_->query_account();
-      }
-    }).detach();
-  }
+  spdlog::info("[TradingEngine::add_md_source] Md source {} ready", name);
+  md_gateways_.emplace_back(MdGateway{std::move(gateway), config.exchanges});
+  add_static_subscriptions(config.subscription_list);
+  return true;
+}
 
-  spdlog::info("[TradingEngine::login] Init done");
+void TradingEngine::add_static_subscriptions(
+    const std::vector<std::string>& tickers) {
+  std::unique_lock<std::mutex> lock(md_mutex_);
+  for (const auto& ticker : tickers) {
+    auto contract = ContractTable::get_by_ticker(ticker);
+    if (!contract) continue;
+
+    auto& subscribers = md_subscribers_[contract->params.index];
+    if (subscribers.count(kStaticSubscriber) == 0)
+      subscribers.emplace(kStaticSubscriber);
+    md_published_[contract->params.index] = 1;
+  }
+}
 
-  is_logon_ = true;
-  return true;
+TradingEngine::MdSource* TradingEngine::create_md_source(
+    const std::string& name) {
+  std::unique_lock<std::mutex> lock(md_mutex_);
+  int source_id = md_arbiter_.add_source(name);
+  md_sources_.emplace_back(std::make_unique<MdSource>(this, source_id));
+  return md_sources_.back().get();
 }
 
 void TradingEngine::process_cmd() {
@@ -89,16 +249,17 @@ void TradingEngine::process_cmd() {
 
 void TradingEngine::process_cmd_from_redis() {
   RedisTraderCmdPuller cmd_puller;
-  cmd_puller.set_account(account_.account_id);
-  spdlog::info("[TradingEngine::run] Start to recv cmd from topic: {}",
-               cmd_puller.get_topic());
+  for (const auto& account : accounts_)
+    cmd_puller.add_account(account->account_id());
+  for (const auto& topic : cmd_puller.get_topics())
+    spdlog::info("[TradingEngine::run] Start to recv cmd from topic: {}",
+                 topic);
 
   for (;;) {
     auto reply = cmd_puller.pull();
     if (!reply) continue;
 
-    auto cmd = reinterpret_cast<const TraderCommand*>(reply->element[2]->str);
-    execute_cmd(*cmd);
+    process_cmd_msg(reply->element[2]->str, reply->element[2]->len);
   }
 }
 
@@ -113,7 +274,7 @@ void TradingEngine::process_cmd_from_queue() {
   uint32_t te_user_id = static_cast<uint32_t>(version());
   LFQueue* cmd_queue;
   if ((cmd_queue = LFQueue_open(cmd_queue_key_, te_user_id)) == nullptr) {
-    int res = LFQueue_create(cmd_queue_key_, te_user_id, sizeof(TraderCommand),
+    int res = LFQueue_create(cmd_queue_key_, te_user_id, kWireMaxMessageSize,
                              4096 * 4, false);
     if (res != 0) {
       spdlog::info("TradingEngine::run_with_queue] Failed to create cmd queue");
@@ -130,27 +291,80 @@ void TradingEngine::process_cmd_from_queue() {
   spdlog::info("[TradingEngine::run] Start to recv cmd from queue: {:#x}",
                cmd_queue_key_);
 
-  TraderCommand cmd{};
+  char msg[kWireMaxMessageSize];
   int res;
   for (;;) {
     // 这里没有使用零拷贝的方式，性能影响甚微
-    res = LFQueue_pop(cmd_queue, &cmd, nullptr, nullptr);
+    res = LFQueue_pop(cmd_queue, msg, nullptr, nullptr);
     if (res != 0) continue;
 
+    process_cmd_msg(msg, sizeof(msg));
+  }
+}
+
+void TradingEngine::process_cmd_msg(const char* data, std::size_t size) {
+  WireReader reader;
+  if (!reader.parse(data, size)) {
+    spdlog::error("[TradingEngine::process_cmd_msg] Invalid msg. Size:{}",
+                  size);
+    return;
+  }
+
+  auto& header = reader.header();
+  if (header.msg_type != WIRE_COMMANDS) return;
+
+  // 策略重启后序号从1开始。strategy_id为0的消息可能来自多个策略，
+  // 它们的序号互不相关，不做检查
+  if (header.strategy_id != 0) {
+    auto& last_seq = cmd_seqs_[header.strategy_id];
+    if (header.seq != 1 && header.seq <= last_seq) {
+      spdlog::warn(
+          "[TradingEngine::process_cmd_msg] Duplicated msg. Strategy:{}, "
+          "Seq:{}, LastSeq:{}",
+          header.strategy_id, header.seq, last_seq);
+      return;
+    }
+    if (last_seq != 0 && header.seq != 1 && header.seq != last_seq + 1) {
+      spdlog::warn(
+          "[TradingEngine::process_cmd_msg] Msg lost. Strategy:{}, Seq:{}, "
+          "LastSeq:{}",
+          header.strategy_id, header.seq, last_seq);
+    }
+    last_seq = header.seq;
+  }
+
+  // 同一个消息中的多条指令由Gateway合并发送，单条指令直接发送
+  bool batch = header.count > 1;
+  if (batch) {
+    for (auto& account : accounts_) account->begin_batch();
+  }
+
+  uint8_t type;
+  const char* body;
+  std::size_t length;
+  while (reader.next(&type, &body, &length)) {
+    TraderCommand cmd{};
+    if (!decode_cmd(type, body, length, &cmd)) {
+      spdlog::error("[TradingEngine::process_cmd_msg] Unknown record: {}",
+                    type);
+      continue;
+    }
+
+    cmd.strategy_id = header.strategy_id;
     execute_cmd(cmd);
   }
+
+  if (batch) {
+    for (auto& account : accounts_) account->end_batch();
+  }
 }
 
 void TradingEngine::close() {
-  if (gateway_) gateway_->logout();
+  for (auto& account : accounts_) account->logout();
+  for (auto& md_gateway : md_gateways_) md_gateway.gateway->logout();
 }
 
 void TradingEngine::execute_cmd(const TraderCommand& cmd) {
-  if (cmd.magic != TRADER_CMD_MAGIC) {
-    spdlog::error("[TradingEngine::run] Recv unknown cmd: error magic num");
-    return;
-  }
-
   switch (cmd.type) {
     case CMD_NEW_ORDER: {
       spdlog::debug("new order");
@@ -159,17 +373,32 @@ void TradingEngine::execute_cmd(const TraderCommand& cmd) {
     }
     case CMD_CANCEL_ORDER: {
       spdlog::debug("cancel order");
-      cancel_order(cmd.cancel_req.order_id);
+      cancel_order(cmd);
+      break;
+    }
+    case CMD_AMEND_ORDER: {
+      spdlog::debug("amend order");
+      amend_order(cmd);
       break;
     }
     case CMD_CANCEL_TICKER: {
       spdlog::debug("cancel all for ticker");
-      cancel_for_ticker(cmd.cancel_ticker_req.ticker_index);
+      cancel_for_ticker(cmd);
       break;
     }
     case CMD_CANCEL_ALL: {
       spdlog::debug("cancel all");
-      cancel_all();
+      cancel_all(cmd);
+      break;
+    }
+    case CMD_SUBSCRIBE: {
+      spdlog::debug("subscribe");
+      subscribe(cmd);
+      break;
+    }
+    case CMD_UNSUBSCRIBE: {
+      spdlog::debug("unsubscribe");
+      unsubscribe(cmd);
       break;
     }
     default: {
@@ -186,315 +415,241 @@ bool TradingEngine::send_order(const TraderCommand& cmd) {
     return false;
   }
 
-  Order order{};
-  auto& req = order.req;
-  req.engine_order_id = next_engine_order_id();
-  req.contract = contract;
-  req.direction = cmd.order_req.direction;
-  req.offset = cmd.order_req.offset;
-  req.volume = cmd.order_req.volume;
-  req.type = cmd.order_req.type;
-  req.price = cmd.order_req.price;
-  req.flags = cmd.order_req.flags;
-  order.user_order_id = cmd.order_req.user_order_id;
-  order.status = OrderStatus::SUBMITTING;
-  order.strategy_id = cmd.strategy_id;
-
-  std::unique_lock<std::mutex> lock(mutex_);
-  // 增加是否经过风控检查字段，在紧急情况下可以设置该字段绕过风控下单
-  if (!cmd.order_req.without_check) {
-    int error_code = risk_mgr_->check_order_req(&order);
-    if (error_code != NO_ERROR) {
-      spdlog::error("[TradingEngine::send_order] 风控未通过: {}",
-                    error_code_str(error_code));
-      risk_mgr_->on_order_rejected(&order, error_code);
-      return false;
-    }
-  }
-
-  if (!gateway_->send_order(req)) {
+  // 指令中指定了账户时发往该账户，否则按合约所在的交易所路由
+  auto account = cmd.account_id != 0
+                     ? find_account(cmd.account_id)
+                     : route_by_exchange(contract->params.exchange_id);
+  if (!account) {
     spdlog::error(
-        "[StrategyEngine::send_order] Failed to send_order. {}, {}{}, {}, "
-        "Volume:{}, Price:{:.3f}",
-        contract->ticker, direction_str(req.direction), offset_str(req.offset),
-        ordertype_str(req.type), req.volume, req.price);
-
-    risk_mgr_->on_order_rejected(&order, ERR_SEND_FAILED);
+        "[TradingEngine::send_order] No account for the order. AccountID:{}, "
+        "Ticker:{}",
+        cmd.account_id, contract->ticker);
     return false;
   }
 
-  order_map_.emplace((uint64_t)req.engine_order_id, order);
-  risk_mgr_->on_order_sent(&order);
-
-  spdlog::debug(
-      "[StrategyEngine::send_order] Success. {}, {}{}, {}, EngineOrderID:{}, "
-      "Volume:{}, Price: {:.3f}",
-      contract->ticker, direction_str(req.direction), offset_str(req.offset),
-      ordertype_str(req.type), req.engine_order_id, req.volume, req.price);
-  return true;
-}
-
-void TradingEngine::cancel_order(uint64_t order_id) {
-  gateway_->cancel_order(order_id);
+  return account->send_order(cmd, contract);
 }
 
-void TradingEngine::cancel_for_ticker(uint32_t ticker_index) {
-  std::unique_lock<std::mutex> lock(mutex_);
-  for (const auto& [engine_order_id, order] : order_map_) {
-    UNUSED(engine_order_id);
-    if (ticker_index == order.req.contract->index)
-      gateway_->cancel_order(order.order_id);
+void TradingEngine::cancel_order(const TraderCommand& cmd) {
+  uint64_t order_id = cmd.cancel_req.order_id;
+  if (cmd.account_id != 0) {
+    auto account = find_account(cmd.account_id);
+    if (account) account->cancel_order(order_id);
+    return;
   }
-}
 
-void TradingEngine::cancel_all() {
-  std::unique_lock<std::mutex> lock(mutex_);
-  for (const auto& [engine_order_id, order] : order_map_) {
-    UNUSED(engine_order_id);
-    gateway_->cancel_order(order.order_id);
+  // order_id由各个Gateway分配，不同账户之间可能重复，多账户时必须指定账户
+  if (accounts_.size() > 1) {
+    spdlog::error(
+        "[TradingEngine::cancel_order] AccountID is required with multiple "
+        "accounts. OrderID:{}",
+        order_id);
+    return;
   }
-}
 
-void TradingEngine::on_query_contract(Contract* contract) {}
-
-void TradingEngine::on_query_account(Account* account) {
-  std::unique_lock<std::mutex> lock(mutex_);
-  account_ = *account;
-  lock.unlock();
-
-  spdlog::info(
-      "[TradingEngine::on_query_account] total_asset:{:.3f}, frozen:{:.3f}, "
-      "margin:{:.3f}",
-      account->total_asset, account->frozen, account->margin);
+  accounts_.front()->cancel_order(order_id);
 }
 
-void TradingEngine::on_query_position(Position* position) {
-  auto contract = ContractTable::get_by_index(position->ticker_index);
-  assert(contract);
+// 与撤单一样，多账户时必须指定账户
+void TradingEngine::amend_order(const TraderCommand& cmd) {
+  if (cmd.account_id != 0) {
+    auto account = find_account(cmd.account_id);
+    if (account) account->amend_order(cmd);
+    return;
+  }
 
-  auto& lp = position->long_pos;
-  auto& sp = position->short_pos;
-  spdlog::info(
-      "[TradingEngine::on_query_position] {}, LongVol:{}, LongYdVol:{}, "
-      "LongPrice:{:.2f}, LongFrozen:{}, LongPNL:{}, ShortVol:{}, "
-      "ShortYdVol:{}, ShortPrice:{:.2f}, ShortFrozen:{}, ShortPNL:{}",
-      contract->ticker, lp.holdings, lp.yd_holdings, lp.cost_price, lp.frozen,
-      lp.float_pnl, sp.holdings, sp.yd_holdings, sp.cost_price, sp.frozen,
-      sp.float_pnl);
-
-  if (lp.holdings == 0 && lp.frozen == 0 && sp.holdings == 0 && sp.frozen == 0)
+  if (accounts_.size() > 1) {
+    spdlog::error(
+        "[TradingEngine::amend_order] AccountID is required with multiple "
+        "accounts. OrderID:{}",
+        cmd.amend_req.order_id);
     return;
+  }
 
-  portfolio_.set_position(*position);
+  accounts_.front()->amend_order(cmd);
 }
 
-void TradingEngine::on_tick(TickData* tick) {
-  if (!is_logon_) return;
-
-  auto contract = ContractTable::get_by_index(tick->ticker_index);
-  assert(contract);
-  md_pusher_.push(contract->ticker, *tick);
+void TradingEngine::cancel_for_ticker(const TraderCommand& cmd) {
+  uint32_t ticker_index = cmd.cancel_ticker_req.ticker_index;
+  if (cmd.account_id != 0) {
+    auto account = find_account(cmd.account_id);
+    if (account) account->cancel_for_ticker(ticker_index);
+    return;
+  }
 
-  md_snapshot_.update_snapshot(*tick);
-  spdlog::trace("[TradingEngine::process_tick] {}  ask:{:.3f}  bid:{:.3f}",
-                contract->ticker, tick->ask[0], tick->bid[0]);
+  for (auto& account : accounts_) account->cancel_for_ticker(ticker_index);
 }
 
-void TradingEngine::on_query_trade(OrderTradedRsp* trade) {
-  portfolio_.update_on_query_trade(trade->ticker_index, trade->direction,
-                                   trade->offset, trade->volume);
+void TradingEngine::cancel_all(const TraderCommand& cmd) {
+  if (cmd.account_id != 0) {
+    auto account = find_account(cmd.account_id);
+    if (account) account->cancel_all();
+    return;
+  }
+
+  for (auto& account : accounts_) account->cancel_all();
 }
 
 /*
- * 订单被市场接受后通知策略
- * 告知策略order_id，策略可通过此order_id撤单
+ * 同一个策略重复订阅只计一次（strategy_id为0的策略无法区分，每次都计数，
+ * 需要与退订配对），合约的第一个订阅者到来时才向柜台订阅，
+ * 最后一个订阅者退订后向柜台退订并停止发布
  */
-void TradingEngine::on_order_accepted(OrderAcceptedRsp* rsp) {
-  std::unique_lock<std::mutex> lock(mutex_);
-  auto iter = order_map_.find(rsp->engine_order_id);
-  if (iter == order_map_.end()) {
-    spdlog::warn(
-        "[TradingEngine::on_order_accepted] Order not found. OrderID: {}",
-        rsp->engine_order_id);
+void TradingEngine::subscribe(const TraderCommand& cmd) {
+  auto contract = ContractTable::get_by_index(cmd.subscribe_req.ticker_index);
+  if (!contract) {
+    spdlog::error("[TradingEngine::subscribe] Contract not found");
     return;
   }
 
-  auto& order = iter->second;
-  if (order.accepted) return;
+  auto strategy_id = cmd.strategy_id;
+  auto& subscribers = md_subscribers_[contract->params.index];
+  bool is_first = subscribers.empty();
+  if (strategy_id != 0 && subscribers.count(strategy_id) > 0) return;
+  subscribers.emplace(strategy_id);
 
-  order.order_id = rsp->order_id;
-  order.accepted = true;
-  risk_mgr_->on_order_accepted(&order);
+  spdlog::info("[TradingEngine::subscribe] {} subscribed {}. Subscribers:{}",
+               strategy_id, contract->ticker, subscribers.size());
+  if (!is_first) return;
 
-  spdlog::info(
-      "[TradingEngine::on_order_accepted] 报单委托成功. {}, {}{}, Volume:{}, "
-      "Price:{:.2f}, OrderType:{}",
-      order.req.contract->ticker, direction_str(order.req.direction),
-      offset_str(order.req.offset), order.req.volume, order.req.price,
-      ordertype_str(order.req.type));
+  // 先标记再订阅，避免丢掉最开始的几笔行情
+  std::unique_lock<std::mutex> lock(md_mutex_);
+  md_published_[contract->params.index] = 1;
+  lock.unlock();
+
+  update_md_subscription(contract, true);
 }
 
-void TradingEngine::on_order_rejected(OrderRejectedRsp* rsp) {
-  std::unique_lock<std::mutex> lock(mutex_);
-  auto iter = order_map_.find(rsp->engine_order_id);
-  if (iter == order_map_.end()) {
-    spdlog::warn(
-        "[TradingEngine::on_order_rejected] Order not found. OrderID: {}",
-        rsp->engine_order_id);
+void TradingEngine::unsubscribe(const TraderCommand& cmd) {
+  auto contract = ContractTable::get_by_index(cmd.subscribe_req.ticker_index);
+  if (!contract) {
+    spdlog::error("[TradingEngine::unsubscribe] Contract not found");
     return;
   }
 
-  auto& order = iter->second;
-  risk_mgr_->on_order_rejected(&order, ERR_REJECTED);
+  auto strategy_id = cmd.strategy_id;
+  auto iter = md_subscribers_.find(contract->params.index);
+  if (iter == md_subscribers_.end()) return;
+  // strategy_id为0时只去掉一次订阅，不影响其他同为0的策略
+  auto subscriber = iter->second.find(strategy_id);
+  if (subscriber == iter->second.end()) return;
+  iter->second.erase(subscriber);
 
-  spdlog::error(
-      "[TradingEngine::on_order_rejected] 报单被拒：{}. {}, {}{}, Volume:{}, "
-      "Price:{:.3f}",
-      rsp->reason, order.req.contract->ticker,
-      direction_str(order.req.direction), offset_str(order.req.offset),
-      order.req.volume, order.req.price);
+  spdlog::info(
+      "[TradingEngine::unsubscribe] {} unsubscribed {}. Subscribers:{}",
+      strategy_id, contract->ticker, iter->second.size());
+  if (!iter->second.empty()) return;
+  md_subscribers_.erase(iter);
 
-  order_map_.erase(iter);
-}
+  std::unique_lock<std::mutex> lock(md_mutex_);
+  md_published_[contract->params.index] = 0;
+  lock.unlock();
 
-void TradingEngine::on_order_traded(OrderTradedRsp* rsp) {
-  if (rsp->trade_type == TradeType::SECONDARY_MARKET)
-    on_secondary_market_traded(rsp);
-  else
-    on_primary_market_traded(rsp);
+  update_md_subscription(contract, false);
 }
 
-void TradingEngine::on_primary_market_traded(OrderTradedRsp* rsp) {
-  std::unique_lock<std::mutex> lock(mutex_);
-  auto iter = order_map_.find(rsp->engine_order_id);
-  if (iter == order_map_.end()) {
-    spdlog::warn(
-        "[TradingEngine::on_primary_market_traded] Order not found. "
-        "OrderID:{}, Traded:{}, Price:{:.3f}",
-        rsp->order_id, rsp->volume, rsp->price);
-    return;
+void TradingEngine::update_md_subscription(const Contract* contract,
+                                           bool is_subscribe) {
+  std::vector<std::string> tickers{std::string(contract->ticker)};
+
+  for (auto& account : accounts_) {
+    const auto& config = account->config();
+    if (config.quote_server_address.empty() ||
+        !serves_exchange(config.exchanges, contract))
+      continue;
+
+    bool ok = is_subscribe ? account->subscribe(tickers)
+                           : account->unsubscribe(tickers);
+    if (!ok)
+      spdlog::warn("[TradingEngine::update_md_subscription] {} failed. {}@{}",
+                   is_subscribe ? "Subscribe" : "Unsubscribe",
+                   contract->ticker, account->account_id());
   }
 
-  auto& order = iter->second;
-  if (!order.accepted) {
-    order.accepted = true;
-    risk_mgr_->on_order_accepted(&order);
-
-    spdlog::info(
-        "[TradingEngine::on_order_accepted] 报单委托成功. {}, {}, "
-        "OrderID:{}, Volume:{}",
-        order.req.contract->ticker, direction_str(order.req.direction),
-        order.order_id, order.req.volume);
-  }
-
-  order.order_id = rsp->order_id;
-  if (rsp->trade_type == TradeType::ACQUIRED_STOCK) {
-    risk_mgr_->on_order_traded(&order, rsp);
-  } else if (rsp->trade_type == TradeType::RELEASED_STOCK) {
-    risk_mgr_->on_order_traded(&order, rsp);
-  } else if (rsp->trade_type == TradeType::CASH_SUBSTITUTION) {
-    risk_mgr_->on_order_traded(&order, rsp);
-  } else if (rsp->trade_type == TradeType::PRIMARY_MARKET) {
-    order.traded_volume = rsp->volume;
-    risk_mgr_->on_order_traded(&order, rsp);
-    // risk_mgr_->on_order_completed(&order);
-    spdlog::info(
-        "[TradingEngine::on_primary_market_traded] done. {}, {}, Volume:{}",
-        order.req.contract->ticker, direction_str(order.req.direction),
-        order.req.volume);
-    order_map_.erase(iter);
+  for (auto& md_gateway : md_gateways_) {
+    if (!serves_exchange(md_gateway.exchanges, contract)) continue;
+
+    auto gateway = md_gateway.gateway.get();
+    bool ok = is_subscribe ? gateway->subscribe(tickers)
+                           : gateway->unsubscribe(tickers);
+    if (!ok)
+      spdlog::warn("[TradingEngine::update_md_subscription] {} failed. {}",
+                   is_subscribe ? "Subscribe" : "Unsubscribe",
+                   contract->ticker);
   }
 }
 
-void TradingEngine::on_secondary_market_traded(OrderTradedRsp* rsp) {
-  std::unique_lock<std::mutex> lock(mutex_);
-  auto iter = order_map_.find(rsp->engine_order_id);
-  if (iter == order_map_.end()) {
-    spdlog::warn(
-        "[TradingEngine::on_secondary_market_traded] Order not found. "
-        "OrderID:{}, Traded:{}, Price:{:.3f}",
-        rsp->order_id, rsp->volume, rsp->price);
-    return;
+AccountEngine* TradingEngine::find_account(uint64_t account_id) {
+  auto iter = account_map_.find(account_id);
+  if (iter == account_map_.end()) {
+    spdlog::error("[TradingEngine::find_account] Unknown account {}",
+                  account_id);
+    return nullptr;
   }
+  return iter->second;
+}
 
-  auto& order = iter->second;
-  if (!order.accepted) {
-    order.accepted = true;
-    risk_mgr_->on_order_accepted(&order);
+void TradingEngine::on_tick(int source_id, TickData* tick) {
+  if (!is_logon_) return;
 
-    spdlog::info(
-        "[TradingEngine::on_order_accepted] 报单委托成功. {}, {}{}, Volume:{}, "
-        "Price:{:.2f}, OrderType:{}",
-        order.req.contract->ticker, direction_str(order.req.direction),
-        offset_str(order.req.offset), order.req.volume, order.req.price,
-        ordertype_str(order.req.type));
-  }
+  auto contract = ContractTable::get_by_index(tick->ticker_index);
+  assert(contract);
 
-  order.order_id = rsp->order_id;
-  order.traded_volume += rsp->volume;
+  auto now_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch())
+                    .count();
 
-  spdlog::info(
-      "[TradingEngine::on_order_traded] 报单成交. {}, {}{}, Traded:{}, "
-      "Price:{:.3f}, TotalTraded/Original:{}/{}",
-      order.req.contract->ticker, direction_str(order.req.direction),
-      offset_str(order.req.offset), rsp->volume, rsp->price,
-      order.traded_volume, order.req.volume);
-
-  risk_mgr_->on_order_traded(&order, rsp);
-
-  if (order.traded_volume + order.canceled_volume == order.req.volume) {
-    spdlog::info(
-        "[TradingEngine::on_order_traded] 报单完成. {}, {}{}, OrderID:{}, "
-        "Traded/Original: {}/{}",
-        order.req.contract->ticker, direction_str(order.req.direction),
-        offset_str(order.req.offset), order.order_id, order.traded_volume,
-        order.req.volume);
-
-    // 订单结束，通知风控模块
-    risk_mgr_->on_order_completed(&order);
-    order_map_.erase(iter);
-  }
-}
+  // 仲裁和入队在同一个锁内完成，发布线程按入队顺序发布，保证发布出去的
+  // 行情是按时间先后排列的，redis的往返则不占用md_mutex_
+  std::unique_lock<std::mutex> lock(md_mutex_);
+  if (!md_arbiter_.on_tick(source_id, *tick, now_ns)) return;
 
-void TradingEngine::on_order_canceled(OrderCanceledRsp* rsp) {
-  std::unique_lock<std::mutex> lock(mutex_);
-  auto iter = order_map_.find(rsp->engine_order_id);
-  if (iter == order_map_.end()) {
-    spdlog::warn(
-        "[TradingEngine::on_order_canceled] Order not found. EngineOrderID:{}",
-        rsp->engine_order_id);
-    return;
+  // 风控依赖行情快照，所以快照总是更新，只有发布到redis受订阅控制
+  md_snapshot_.update_snapshot(*tick);
+  if (!md_published_[tick->ticker_index]) return;  // 没有策略需要
+  {
+    std::unique_lock<std::mutex> pub_lock(md_pub_mutex_);
+    md_pub_queue_.emplace_back(*tick);
   }
+  lock.unlock();
+  md_pub_cv_.notify_one();
 
-  auto& order = iter->second;
-  order.canceled_volume = rsp->canceled_volume;
-
-  spdlog::info(
-      "[TradingEngine::on_order_canceled] 报单已撤. {}, {}{}, OrderID:{}, "
-      "Canceled:{}",
-      order.req.contract->ticker, direction_str(order.req.direction),
-      offset_str(order.req.offset), order.order_id, rsp->canceled_volume);
-
-  risk_mgr_->on_order_canceled(&order, rsp->canceled_volume);
+  spdlog::trace("[TradingEngine::process_tick] {}  ask:{:.3f}  bid:{:.3f}",
+                contract->ticker, tick->ask[0], tick->bid[0]);
+}
 
-  if (order.traded_volume + order.canceled_volume == order.req.volume) {
-    spdlog::info(
-        "[TradingEngine::on_order_canceled] 报单完成. {}, {}{}, OrderID:{}, "
-        "Traded/Original:{}/{}",
-        order.req.contract->ticker, direction_str(order.req.direction),
-        offset_str(order.req.offset), order.order_id, order.traded_volume,
-        order.req.volume);
+void TradingEngine::publish_md() {
+  std::vector<TickData> ticks;
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(md_pub_mutex_);
+      md_pub_cv_.wait(lock, [this] { return !md_pub_queue_.empty(); });
+      ticks.swap(md_pub_queue_);
+    }
 
-    risk_mgr_->on_order_completed(&order);
-    order_map_.erase(iter);
+    for (const auto& tick : ticks) {
+      auto contract = ContractTable::get_by_index(tick.ticker_index);
+      md_pusher_.push(contract->ticker, tick);
+    }
+    ticks.clear();
   }
 }
 
-void TradingEngine::on_order_cancel_rejected(OrderCancelRejectedRsp* rsp) {
-  spdlog::warn(
-      "[TradingEngine::on_order_cancel_rejected] 订单不可撤：{}. "
-      "EngineOrderID: {}",
-      rsp->reason, rsp->engine_order_id);
+void TradingEngine::publish_send_utilization() {
+  std::vector<RedisSendUtilSetter> setters(accounts_.size());
+  std::vector<double> published(accounts_.size(), -1.0);
+  for (std::size_t i = 0; i < accounts_.size(); ++i)
+    setters[i].set_account(accounts_[i]->account_id());
+
+  for (;;) {
+    for (std::size_t i = 0; i < accounts_.size(); ++i) {
+      double utilization = accounts_[i]->send_utilization();
+      if (utilization == published[i]) continue;
+      setters[i].set(utilization);
+      published[i] = utilization;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
 }
 
 }  // namespace ft
@@ -3,28 +3,37 @@
 #ifndef FT_SRC_TRADING_SYSTEM_TRADING_ENGINE_H_
 #define FT_SRC_TRADING_SYSTEM_TRADING_ENGINE_H_
 
-#include <list>
+#include <condition_variable>
 #include <map>
 #include <memory>
 #include <mutex>
+#include <set>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "common/md_snapshot.h"
-#include "common/order.h"
-#include "common/portfolio.h"
-#include "common/types.h"
-#include "core/account.h"
 #include "core/config.h"
-#include "core/error_code.h"
+#include "core/constants.h"
+#include "core/protocol.h"
 #include "interface/gateway.h"
 #include "interface/trading_engine_interface.h"
 #include "ipc/redis_md_helper.h"
-#include "risk_management/risk_manager.h"
+#include "trading_engine/account_engine.h"
+#include "trading_engine/md_arbiter.h"
 
 namespace ft {
 
-class TradingEngine : public TradingEngineInterface {
+/*
+ * TradingEngine可以同时管理多个账户（例如CTP期货账户加XTP股票账户），
+ * 每个账户由一个AccountEngine负责，拥有独立的Gateway、持仓及风控。
+ * TradingEngine负责把策略的指令路由到对应的账户，以及汇总所有账户推送的
+ * 行情，行情快照由所有账户的风控共享
+ *
+ * 除了各个账户的Gateway，还可以配置只登录行情服务器的额外行情源，同一个
+ * 合约的行情经过MdArbiter仲裁，只发布最先送达的那一份
+ */
+class TradingEngine {
  public:
   TradingEngine();
 
@@ -39,62 +48,111 @@ class TradingEngine : public TradingEngineInterface {
   static uint64_t version() { return 202006222311; }
 
  private:
+  bool add_account(const Config& config);
+
+  bool add_md_source(const Config& config);
+
   void process_cmd_from_redis();
 
   void process_cmd_from_queue();
 
+  // 解码一个wire消息并依次执行其中的指令
+  void process_cmd_msg(const char* data, std::size_t size);
+
   void execute_cmd(const TraderCommand& cmd);
 
   bool send_order(const TraderCommand& cmd);
 
-  void cancel_order(uint64_t order_id);
+  void cancel_order(const TraderCommand& cmd);
 
-  void cancel_for_ticker(uint32_t ticker_index);
+  void amend_order(const TraderCommand& cmd);
 
-  void cancel_all();
+  void cancel_for_ticker(const TraderCommand& cmd);
 
-  void on_query_contract(Contract* contract) override;
+  void cancel_all(const TraderCommand& cmd);
 
-  void on_query_account(Account* account) override;
+  void subscribe(const TraderCommand& cmd);
 
-  void on_query_position(Position* position) override;
+  void unsubscribe(const TraderCommand& cmd);
 
-  void on_query_trade(OrderTradedRsp* trade) override;
+  // 配置中的subscription_list在登录时已经订阅，作为常驻的订阅计数
+  void add_static_subscriptions(const std::vector<std::string>& tickers);
 
-  void on_tick(TickData* tick) override;
+  // 向所有支持该合约所在交易所的Gateway订阅或退订
+  void update_md_subscription(const Contract* contract, bool is_subscribe);
 
-  void on_order_accepted(OrderAcceptedRsp* rsp) override;
+  AccountEngine* find_account(uint64_t account_id);
 
-  void on_order_rejected(OrderRejectedRsp* rsp) override;
+  AccountEngine* route_by_exchange(Exchange exchange) {
+    auto account = exchange_routes_[static_cast<uint8_t>(exchange)];
+    return account ? account : default_account_;
+  }
 
-  void on_order_traded(OrderTradedRsp* rsp) override;
+  void on_tick(int source_id, TickData* tick);
 
-  void on_order_canceled(OrderCanceledRsp* rsp) override;
+ private:
+  // 在单独的线程中按入队顺序发布行情，行情线程不必等待redis的往返
+  void publish_md();
 
-  void on_order_cancel_rejected(OrderCancelRejectedRsp* rsp) override;
+  // 每100毫秒把各个账户的流速占用写入redis，见RedisSendUtilGetter
+  void publish_send_utilization();
 
- private:
-  void on_primary_market_traded(OrderTradedRsp* rsp);  // ETF申赎
+  // Gateway推送的行情带上行情源的编号交给TradingEngine仲裁
+  class MdSource : public TradingEngineInterface {
+   public:
+    MdSource(TradingEngine* engine, int source_id)
+        : engine_(engine), source_id_(source_id) {}
 
-  void on_secondary_market_traded(OrderTradedRsp* rsp);  // 二级市场买卖
+    void on_tick(TickData* tick) override {
+      engine_->on_tick(source_id_, tick);
+    }
 
-  uint64_t next_engine_order_id() { return next_engine_order_id_++; }
+   private:
+    TradingEngine* engine_;
+    int source_id_;
+  };
+
+  MdSource* create_md_source(const std::string& name);
 
  private:
-  std::unique_ptr<Gateway> gateway_{nullptr};
+  static constexpr std::size_t kNumExchanges =
+      static_cast<std::size_t>(Exchange::SZE) + 1;
 
   volatile bool is_logon_{false};
-  uint64_t next_engine_order_id_{1};
 
-  Account account_;
-  Portfolio portfolio_;
-  OrderMap order_map_;
-  std::unique_ptr<RiskManager> risk_mgr_{nullptr};
+  struct MdGateway {
+    std::unique_ptr<Gateway> gateway;
+    std::vector<std::string> exchanges;
+  };
+
+  // Gateway持有MdSource的指针，因此MdSource要在Gateway之后析构
+  std::vector<std::unique_ptr<MdSource>> md_sources_;
+  std::vector<MdGateway> md_gateways_;
+  std::vector<std::unique_ptr<AccountEngine>> accounts_;
+  std::map<uint64_t, AccountEngine*> account_map_;
+  AccountEngine* exchange_routes_[kNumExchanges]{};
+  AccountEngine* default_account_{nullptr};
+
   RedisMdPusher md_pusher_;
   MdSnapshot md_snapshot_;
-  std::mutex mutex_;
+  MdArbiter md_arbiter_;
+  std::mutex md_mutex_;  // 多个Gateway的行情线程会同时推送行情
+
+  // 仲裁通过、等待发布的行情，只有发布线程访问md_pusher_
+  std::mutex md_pub_mutex_;
+  std::condition_variable md_pub_cv_;
+  std::vector<TickData> md_pub_queue_;
+
+  // 每个合约有哪些策略订阅，只在处理指令的线程中访问。md_published_标记
+  // 需要发布到redis的合约，由md_mutex_保护，不影响行情快照的更新
+  // strategy_id为0的策略无法区分，每次订阅都计一次
+  std::map<uint32_t, std::multiset<uint32_t>> md_subscribers_;
+  std::vector<uint8_t> md_published_;
 
   int cmd_queue_key_ = 0;
+  // 每个策略最近一个指令消息的序号，用于发现丢失或重复的消息。strategy_id
+  // 为0的多个策略共用同一个ID，不检查序号
+  std::unordered_map<uint32_t, uint64_t> cmd_seqs_;
 };
 
 }  // namespace ft